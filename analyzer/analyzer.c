@@ -508,6 +508,82 @@ suscan_analyzer_register_baseband_filter(
     SUSCAN_ANALYZER_BBFILT_PRIO_DEFAULT);
 }
 
+SUBOOL
+suscan_analyzer_register_baseband_filter_ex(
+    suscan_analyzer_t *self,
+    suscan_analyzer_baseband_filter_func_t func,
+    void *privdata,
+    int64_t prio,
+    const struct suscan_analyzer_baseband_filter_params *params)
+{
+  if (self->iface->register_baseband_filter_ex == NULL) {
+    SU_ERROR("This type of analyzer object does not support custom baseband filtering\n");
+    return SU_FALSE;
+  }
+
+  CHECK_PERMISSION(self, SUSCAN_ANALYZER_PERM_SET_BB_FILTER);
+
+  return (self->iface->register_baseband_filter_ex) (
+    self->impl,
+    func,
+    privdata,
+    prio,
+    params);
+}
+
+SUBOOL
+suscan_analyzer_get_baseband_filter_stats(
+    suscan_analyzer_t *self,
+    int64_t prio,
+    struct suscan_analyzer_baseband_filter_stats *stats)
+{
+  if (self->iface->get_baseband_filter_stats == NULL) {
+    SU_ERROR("This type of analyzer object does not support custom baseband filtering\n");
+    return SU_FALSE;
+  }
+
+  return (self->iface->get_baseband_filter_stats) (self->impl, prio, stats);
+}
+
+SUBOOL
+suscan_analyzer_add_source(
+    suscan_analyzer_t *self,
+    suscan_source_config_t *config,
+    unsigned int *index)
+{
+  unsigned int dummy;
+
+  if (self->iface->add_source == NULL) {
+    SU_ERROR("This type of analyzer object does not support multiple sources\n");
+    return SU_FALSE;
+  }
+
+  return (self->iface->add_source) (
+    self->impl,
+    config,
+    index == NULL ? &dummy : index);
+}
+
+SUBOOL
+suscan_analyzer_set_source_freq(
+    suscan_analyzer_t *self,
+    unsigned int index,
+    SUFREQ freq,
+    SUFREQ lnb)
+{
+  CHECK_PERMISSION(self, SUSCAN_ANALYZER_PERM_SET_FREQ);
+
+  if (index == 0)
+    return (self->iface->set_frequency) (self->impl, freq, lnb);
+
+  if (self->iface->set_source_frequency == NULL) {
+    SU_ERROR("This type of analyzer object does not support multiple sources\n");
+    return SU_FALSE;
+  }
+
+  return (self->iface->set_source_frequency) (self->impl, index, freq, lnb);
+}
+
 /* Worker-specific methods */
 SUBOOL
 suscan_analyzer_set_sweep_stratrgy(
@@ -160,6 +160,65 @@ struct suscan_analyzer_baseband_filter {
   void *privdata;
 };
 
+/*!
+ * \brief Baseband filter execution mode
+ *
+ * Synchronous filters are called from the source thread. Asynchronous
+ * filters run in their own worker and receive a reference to the sample
+ * buffer, so they do not delay other consumers.
+ * \author Gonzalo José Carracedo Carballal
+ */
+enum suscan_analyzer_baseband_filter_mode {
+  SUSCAN_ANALYZER_BBFILT_MODE_SYNC,
+  SUSCAN_ANALYZER_BBFILT_MODE_ASYNC
+};
+
+/*!
+ * \brief Baseband filter overflow policy
+ *
+ * Describes what happens when the queue of an asynchronous filter is full:
+ * either the new buffer is dropped or the source thread waits for the
+ * filter to catch up.
+ * \author Gonzalo José Carracedo Carballal
+ */
+enum suscan_analyzer_baseband_filter_overflow {
+  SUSCAN_ANALYZER_BBFILT_OVERFLOW_DROP,
+  SUSCAN_ANALYZER_BBFILT_OVERFLOW_BLOCK
+};
+
+/*!
+ * \brief Baseband filter registration parameters
+ * \author Gonzalo José Carracedo Carballal
+ */
+struct suscan_analyzer_baseband_filter_params {
+  enum suscan_analyzer_baseband_filter_mode     mode;
+  enum suscan_analyzer_baseband_filter_overflow overflow;
+  unsigned int queue_depth; /* Asynchronous mode only */
+};
+
+#define suscan_analyzer_baseband_filter_params_INITIALIZER \
+{                                                          \
+  SUSCAN_ANALYZER_BBFILT_MODE_SYNC,                        \
+  SUSCAN_ANALYZER_BBFILT_OVERFLOW_DROP,                    \
+  4, /* queue_depth */                                     \
+}
+
+/*!
+ * \brief Baseband filter statistics
+ *
+ * Latency is measured from the moment the samples were delivered to the
+ * filter (or queued, in asynchronous mode) until the filter returned.
+ * \author Gonzalo José Carracedo Carballal
+ */
+struct suscan_analyzer_baseband_filter_stats {
+  uint64_t processed;    /* Buffers processed */
+  uint64_t dropped;      /* Buffers dropped due to queue overflow */
+  unsigned int queued;   /* Buffers currently queued */
+  unsigned int max_queued;
+  SUFLOAT  mean_latency; /* In seconds */
+  SUFLOAT  max_latency;  /* In seconds */
+};
+
 struct suscan_analyzer_interface {
   const char *name;
   void  *(*ctor) (struct suscan_analyzer *, va_list);
@@ -196,6 +255,22 @@ struct suscan_analyzer_interface {
     suscan_analyzer_baseband_filter_func_t func,
     void *privdata,
     int64_t priority);
+  SUBOOL   (*register_baseband_filter_ex) (
+    void *,
+    suscan_analyzer_baseband_filter_func_t func,
+    void *privdata,
+    int64_t priority,
+    const struct suscan_analyzer_baseband_filter_params *params);
+  SUBOOL   (*get_baseband_filter_stats) (
+    void *,
+    int64_t priority,
+    struct suscan_analyzer_baseband_filter_stats *stats);
+  SUBOOL   (*add_source) (void *, suscan_source_config_t *, unsigned int *);
+  SUBOOL   (*set_source_frequency) (
+    void *,
+    unsigned int index,
+    SUFREQ freq,
+    SUFREQ lnb);
   
   struct suscan_source_info *(*get_source_info_pointer) (const void *);
   SUBOOL   (*commit_source_info) (void *);
@@ -746,6 +821,74 @@ SUBOOL suscan_analyzer_register_baseband_filter_with_prio(
     void *privdata,
     int64_t prio);
 
+/*!
+ * Registers a baseband filter with a given priority and execution
+ * parameters. Asynchronous filters run in a dedicated worker thread, and
+ * receive samples through a queue of limited depth. When the queue is full,
+ * the overflow policy decides whether the samples are dropped or the
+ * source waits for the filter.
+ * \param analyzer pointer to the analyzer object
+ * \param func pointer to the baseband filter function
+ * \param privdata pointer to its private data
+ * \param prio priority index or SUSCAN_ANALYZER_BBFILT_PRIO_DEFAULT
+ * \param params pointer to the execution parameters
+ * \return SU_TRUE for success or SU_FALSE on failure
+ * \author Gonzalo José Carracedo Carballal
+ */
+SUBOOL suscan_analyzer_register_baseband_filter_ex(
+    suscan_analyzer_t *analyzer,
+    suscan_analyzer_baseband_filter_func_t func,
+    void *privdata,
+    int64_t prio,
+    const struct suscan_analyzer_baseband_filter_params *params);
+
+/*!
+ * Retrieves the processing statistics of the baseband filter installed with
+ * a given priority.
+ * \param analyzer pointer to the analyzer object
+ * \param prio priority of the baseband filter
+ * \param stats pointer to the statistics structure to fill
+ * \return SU_TRUE for success or SU_FALSE on failure
+ * \author Gonzalo José Carracedo Carballal
+ */
+SUBOOL suscan_analyzer_get_baseband_filter_stats(
+    suscan_analyzer_t *analyzer,
+    int64_t prio,
+    struct suscan_analyzer_baseband_filter_stats *stats);
+
+/*!
+ * Adds an additional source to a channel mode analyzer. The new source has
+ * its own tuner and PSD, but inspectors opened on it share the inspector
+ * worker pool of the analyzer. Source info and PSD messages of the new source
+ * are tagged with its index (the primary source has index 0).
+ * \param analyzer pointer to the analyzer object
+ * \param config configuration of the new source
+ * \param index pointer to the index of the new source (may be NULL)
+ * 
+eturn SU_TRUE for success or SU_FALSE on failure
+ * uthor Gonzalo José Carracedo Carballal
+ */
+SUBOOL suscan_analyzer_add_source(
+    suscan_analyzer_t *analyzer,
+    suscan_source_config_t *config,
+    unsigned int *index);
+
+/*!
+ * Sets the frequency of a given source of the analyzer.
+ * \param analyzer pointer to the analyzer object
+ * \param index source index (0 is the primary source)
+ * \param freq new frequency
+ * \param lnb new LNB frequency
+ * 
+eturn SU_TRUE for success or SU_FALSE on failure
+ * uthor Gonzalo José Carracedo Carballal
+ */
+SUBOOL suscan_analyzer_set_source_freq(
+    suscan_analyzer_t *analyzer,
+    unsigned int index,
+    SUFREQ freq,
+    SUFREQ lnb);
+
 
 /************************ Client interface methods ****************************/
 /*
@@ -815,6 +958,38 @@ SUBOOL suscan_analyzer_replay_async(
     SUBOOL replay,
     uint32_t req_id);
 
+struct suscan_analyzer_panorama_params;
+
+/*!
+ * In wide spectrum mode, configures the analyzer-side panorama. When enabled,
+ * the PSD of every hop is merged into a spectrum buffer covering the sweep
+ * range, which is delivered as SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA
+ * messages (either whole or only the changed bin ranges).
+ * \param analyzer a pointer to the analyzer object
+ * \param params pointer to the panorama parameters
+ * \param req_id arbitrary request identifier used to match responses
+ * \return SU_TRUE if the request was delivered, SU_FALSE otherwise
+ * \author Gonzalo José Carracedo Carballal
+ */
+SUBOOL suscan_analyzer_set_panorama_params_async(
+    suscan_analyzer_t *analyzer,
+    const struct suscan_analyzer_panorama_params *params,
+    uint32_t req_id);
+
+/*!
+ * Asks the analyzer to send the whole panorama in the next update, e.g.
+ * because some delta updates never reached their destination.
+ * \param analyzer a pointer to the analyzer object
+ * \param epoch epoch of the panorama that needs the keyframe
+ * \param req_id arbitrary request identifier used to match responses
+ * \return SU_TRUE if the request was delivered, SU_FALSE otherwise
+ * \author Gonzalo José Carracedo Carballal
+ */
+SUBOOL suscan_analyzer_req_panorama_keyframe_async(
+    suscan_analyzer_t *analyzer,
+    uint32_t epoch,
+    uint32_t req_id);
+
 
 /*!
  * For seekable sources (e.g. file replay), sets the current read position
@@ -851,6 +1026,28 @@ SUBOOL suscan_analyzer_open_ex_async(
     SUHANDLE parent,
     uint32_t req_id);
 
+/*!
+ * For channel analyzers with several sources, open a new baseband inspector
+ * of a given class on a given source (asynchronous). The channel frequencies
+ * are relative to the frequency of that source.
+ * \param analyzer pointer to the analyzer object
+ * \param source_index source index (0 is the primary source)
+ * \param classname inspector class name
+ * \param channel pointer to the channel structure describing the inspector
+ * frequency and bandwidth
+ * \param precise whether to use precise channel centering
+ * \param req_id arbitrary request identifier used to match responses
+ * \return SU_TRUE for success or SU_FALSE on failure
+ * \author Gonzalo José Carracedo Carballal
+ */
+SUBOOL suscan_analyzer_open_source_async(
+    suscan_analyzer_t *analyzer,
+    unsigned int source_index,
+    const char *classname,
+    const struct sigutils_channel *channel,
+    SUBOOL precise,
+    uint32_t req_id);
+
 /*!
  * For channel analyzers, open a new inspector of a given class at a given
  * frequency (asynchronous). Equivalent to suscan_analyzer_open_ex_async(
@@ -1008,10 +1205,12 @@ SUBOOL suscan_analyzer_set_inspector_bandwidth_overridable(
 /*!
  * For channel analyzers, set the sampler watermark of an inspector, i.e. the
  * minimum number of samples that must be stored in a sample batch before
- * delivering a sample batch message to the user.
+ * delivering a sample batch message to the user. A watermark of 0 disables
+ * sample batches altogether, and inspectors with no other output enabled
+ * are suspended until they are requested again.
  * \param analyzer pointer to the analyzer object
  * \param handle inspector handle
- * \param watermark new watermark in samples
+ * \param watermark new watermark in samples, 0 to disable sample batches
  * \param req_id arbitrary request identifier used to match responses
  * \return SU_TRUE for success or SU_FALSE on failure
  * \author Gonzalo José Carracedo Carballal
@@ -1022,6 +1221,22 @@ SUBOOL suscan_analyzer_set_inspector_watermark_async(
     SUSCOUNT watermark,
     uint32_t req_id);
 
+/*!
+ * For channel analyzers, notify an inspector whether the consumer of its
+ * messages is able to keep up with them. Inspectors whose consumer is
+ * stalled suspend their demodulation chain until this is cleared.
+ * \param analyzer pointer to the analyzer object
+ * \param handle inspector handle
+ * \param stalled SU_TRUE if the consumer cannot keep up, SU_FALSE otherwise
+ * \param req_id arbitrary request identifier used to match responses
+ * \return SU_TRUE for success or SU_FALSE on failure
+ */
+SUBOOL suscan_analyzer_set_inspector_stalled_async(
+    suscan_analyzer_t *analyzer,
+    SUHANDLE handle,
+    SUBOOL stalled,
+    uint32_t req_id);
+
 /*!
  * For channel analyzer, enable or disable a channel parameter estimator
  * associated to an inspector (asynchronous).
@@ -1057,6 +1272,27 @@ SUBOOL suscan_analyzer_inspector_set_spectrum_async(
     uint32_t spectsrc_id,
     uint32_t req_id);
 
+/*!
+ * For channel analyzers, subscribe to (or unsubscribe from) a spectrum
+ * source of an inspector in addition to the one selected with
+ * suscan_analyzer_inspector_set_spectrum_async. Subscribed sources are
+ * computed in the same pass over the samples as the selected one, and
+ * their spectra are delivered as SPECTRUM messages tagged with their own
+ * spectsrc_id (asynchronous).
+ * \param analyzer pointer to the analyzer object
+ * \param handle inspector handle
+ * \param spectsrc_id spectrum source index as found in the inspector message
+ * \param subscribed SU_TRUE to receive this source, SU_FALSE to stop it
+ * \param req_id arbitrary request identifier used to match responses
+ * \return SU_TRUE for success or SU_FALSE on failure
+ */
+SUBOOL suscan_analyzer_inspector_subscribe_spectrum_async(
+    suscan_analyzer_t *analyzer,
+    SUHANDLE handle,
+    uint32_t spectsrc_id,
+    SUBOOL subscribed,
+    uint32_t req_id);
+
 /*!
  * For channel analyzers, configure the Doppler correction of a satellital
  * signal by providing the orbital parameters of the source (asynchronous).
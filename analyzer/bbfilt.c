@@ -0,0 +1,338 @@
+/*
+
+  Copyright (C) 2023 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "bbfilt"
+
+#include <sigutils/log.h>
+#include <string.h>
+
+#include "bbfilt.h"
+#include "realtime.h"
+
+SUPRIVATE void
+suscan_bbfilt_account(suscan_bbfilt_t *self, uint64_t latency)
+{
+  ++self->processed;
+  self->total_latency += latency;
+
+  if (latency > self->max_latency)
+    self->max_latency = latency;
+}
+
+/*
+ * Worker callback: consumes the job at the head of the ring. The slot is
+ * released after the filter returns, so job_count also accounts for the
+ * buffer being processed.
+ */
+SUPRIVATE SUBOOL
+suscan_bbfilt_worker_cb(
+    struct suscan_mq *mq_out,
+    void *wk_private,
+    void *cb_private)
+{
+  suscan_bbfilt_t *self = (suscan_bbfilt_t *) wk_private;
+  struct suscan_bbfilt_job job;
+  SUBOOL failed;
+  SUBOOL ok = SU_TRUE;
+
+  pthread_mutex_lock(&self->mutex);
+  job    = self->job_ring[self->job_head];
+  failed = self->failed;
+  pthread_mutex_unlock(&self->mutex);
+
+  /* After a failure, we just release the pending buffers */
+  if (!failed)
+    ok = (self->desc.func) (
+        self->desc.privdata,
+        self->analyzer,
+        job.samples,
+        job.length,
+        job.consumed);
+
+  if (!suscan_sample_buffer_pool_give(self->pool, job.buffer))
+    SU_ERROR("Failed to give buffer!\n");
+
+  pthread_mutex_lock(&self->mutex);
+  self->job_head = (self->job_head + 1) % self->params.queue_depth;
+  --self->job_count;
+
+  if (!failed)
+    suscan_bbfilt_account(self, suscan_gettime_raw() - job.enqueued);
+
+  if (!ok)
+    self->failed = SU_TRUE;
+
+  pthread_cond_signal(&self->cond);
+  pthread_mutex_unlock(&self->mutex);
+
+  return SU_FALSE;
+}
+
+SU_INSTANCER(
+  suscan_bbfilt,
+  suscan_analyzer_t *analyzer,
+  suscan_sample_buffer_pool_t *pool,
+  suscan_analyzer_baseband_filter_func_t func,
+  void *privdata,
+  const struct suscan_analyzer_baseband_filter_params *params)
+{
+  suscan_bbfilt_t *self = NULL;
+
+  SU_ALLOCATE_FAIL(self, suscan_bbfilt_t);
+
+  self->analyzer      = analyzer;
+  self->pool          = pool;
+  self->desc.func     = func;
+  self->desc.privdata = privdata;
+  self->params        = *params;
+
+  SU_TRYZ_FAIL(pthread_mutex_init(&self->mutex, NULL));
+  if (pthread_cond_init(&self->cond, NULL) != 0) {
+    pthread_mutex_destroy(&self->mutex);
+    goto fail;
+  }
+  self->sync_init = SU_TRUE;
+
+  if (suscan_bbfilt_is_async(self)) {
+    if (self->params.queue_depth == 0
+      || self->params.queue_depth > SUSCAN_BBFILT_MAX_QUEUE_DEPTH) {
+      SU_ERROR(
+        "Invalid queue depth %u (must be between 1 and %d)\n",
+        self->params.queue_depth,
+        SUSCAN_BBFILT_MAX_QUEUE_DEPTH);
+      goto fail;
+    }
+
+    SU_ALLOCATE_MANY_FAIL(
+      self->job_ring,
+      self->params.queue_depth,
+      struct suscan_bbfilt_job);
+
+    SU_TRY_FAIL(suscan_mq_init(&self->worker_mq));
+    self->worker_mq_init = SU_TRUE;
+
+    SU_TRY_FAIL(
+      self->worker = suscan_worker_new_ex(
+        "bbfilt-worker",
+        &self->worker_mq,
+        self));
+  }
+
+  return self;
+
+fail:
+  if (self != NULL)
+    suscan_bbfilt_destroy(self);
+
+  return NULL;
+}
+
+SU_COLLECTOR(suscan_bbfilt)
+{
+  unsigned int i, ndx;
+
+  if (self->worker != NULL)
+    if (!suscan_analyzer_halt_worker(self->worker))
+      SU_ERROR("Baseband filter worker destruction failed, memory leak ahead\n");
+
+  /* Return buffers of jobs that were never processed */
+  if (self->job_ring != NULL) {
+    for (i = 0; i < self->job_count; ++i) {
+      ndx = (self->job_head + i) % self->params.queue_depth;
+      suscan_sample_buffer_pool_give(self->pool, self->job_ring[ndx].buffer);
+    }
+
+    free(self->job_ring);
+  }
+
+  if (self->worker_mq_init)
+    suscan_mq_finalize(&self->worker_mq);
+
+  if (self->sync_init) {
+    pthread_cond_destroy(&self->cond);
+    pthread_mutex_destroy(&self->mutex);
+  }
+
+  free(self);
+}
+
+SUPRIVATE suscan_sample_buffer_t *
+suscan_bbfilt_ref_buffer(
+  suscan_bbfilt_t *self,
+  suscan_sample_buffer_t *buffer,
+  SUCOMPLEX **samples)
+{
+  suscan_sample_buffer_t *ref = NULL;
+  SUBOOL may_block =
+    self->params.overflow == SUSCAN_ANALYZER_BBFILT_OVERFLOW_BLOCK;
+
+  if (suscan_sample_buffer_is_circular(buffer)) {
+    /* Circular buffers are reused by the source: we need a copy */
+    if (may_block) {
+      if ((ref = suscan_sample_buffer_pool_acquire(self->pool)) != NULL)
+        memcpy(
+          suscan_sample_buffer_data(ref),
+          *samples,
+          self->pool->params.alloc_size * sizeof(SUCOMPLEX));
+    } else {
+      ref = suscan_sample_buffer_pool_try_dup(self->pool, buffer);
+    }
+
+    if (ref != NULL)
+      *samples = suscan_sample_buffer_data(ref);
+  } else if (may_block || suscan_sample_buffer_pool_free_num(self->pool) > 0) {
+    /* Regular buffers are simply referenced */
+    suscan_sample_buffer_inc_ref(buffer);
+    ref = buffer;
+  }
+
+  return ref;
+}
+
+SU_METHOD(suscan_bbfilt, void, wait_room)
+{
+  if (!suscan_bbfilt_is_async(self)
+    || self->params.overflow != SUSCAN_ANALYZER_BBFILT_OVERFLOW_BLOCK)
+    return;
+
+  pthread_mutex_lock(&self->mutex);
+
+  while (self->job_count == self->params.queue_depth && !self->failed)
+    pthread_cond_wait(&self->cond, &self->mutex);
+
+  pthread_mutex_unlock(&self->mutex);
+}
+
+SU_METHOD(
+  suscan_bbfilt,
+  SUBOOL,
+  feed,
+  suscan_sample_buffer_t *buffer,
+  SUCOMPLEX *samples,
+  SUSCOUNT length,
+  SUSCOUNT consumed)
+{
+  struct suscan_bbfilt_job *job;
+  suscan_sample_buffer_t *ref = NULL;
+  uint64_t t0 = suscan_gettime_raw();
+  SUBOOL mutex_acquired = SU_FALSE;
+  SUBOOL ok = SU_FALSE;
+
+  if (!suscan_bbfilt_is_async(self)) {
+    ok = (self->desc.func) (
+        self->desc.privdata,
+        self->analyzer,
+        samples,
+        length,
+        consumed);
+
+    pthread_mutex_lock(&self->mutex);
+    suscan_bbfilt_account(self, suscan_gettime_raw() - t0);
+    pthread_mutex_unlock(&self->mutex);
+
+    return ok;
+  }
+
+  SU_TRYZ(pthread_mutex_lock(&self->mutex));
+  mutex_acquired = SU_TRUE;
+
+  /* Asynchronous failures are reported on the next delivery */
+  if (self->failed) {
+    SU_ERROR("Asynchronous baseband filter failed\n");
+    goto done;
+  }
+
+  /* Blocking filters should have waited already (see wait_room) */
+  while (self->job_count == self->params.queue_depth) {
+    if (self->params.overflow == SUSCAN_ANALYZER_BBFILT_OVERFLOW_DROP) {
+      ++self->dropped;
+      ok = SU_TRUE;
+      goto done;
+    }
+
+    pthread_cond_wait(&self->cond, &self->mutex);
+  }
+
+  pthread_mutex_unlock(&self->mutex);
+  mutex_acquired = SU_FALSE;
+
+  /* Only we enqueue jobs, the reserved slot cannot be taken meanwhile */
+  if ((ref = suscan_bbfilt_ref_buffer(self, buffer, &samples)) == NULL) {
+    pthread_mutex_lock(&self->mutex);
+    ++self->dropped;
+    pthread_mutex_unlock(&self->mutex);
+    return SU_TRUE;
+  }
+
+  SU_TRYZ(pthread_mutex_lock(&self->mutex));
+  mutex_acquired = SU_TRUE;
+
+  job = self->job_ring
+    + (self->job_head + self->job_count) % self->params.queue_depth;
+
+  job->buffer   = ref;
+  job->samples  = samples;
+  job->length   = length;
+  job->consumed = consumed;
+  job->enqueued = t0;
+
+  if (++self->job_count > self->max_queued)
+    self->max_queued = self->job_count;
+
+  pthread_mutex_unlock(&self->mutex);
+  mutex_acquired = SU_FALSE;
+
+  if (!suscan_worker_push(self->worker, suscan_bbfilt_worker_cb, NULL)) {
+    /* Undo enqueue. The worker cannot have seen this job. */
+    pthread_mutex_lock(&self->mutex);
+    --self->job_count;
+    pthread_mutex_unlock(&self->mutex);
+
+    suscan_sample_buffer_pool_give(self->pool, ref);
+    goto done;
+  }
+
+  ok = SU_TRUE;
+
+done:
+  if (mutex_acquired)
+    pthread_mutex_unlock(&self->mutex);
+
+  return ok;
+}
+
+SU_METHOD(
+  suscan_bbfilt,
+  void,
+  get_stats,
+  struct suscan_analyzer_baseband_filter_stats *stats)
+{
+  pthread_mutex_lock(&self->mutex);
+
+  stats->processed    = self->processed;
+  stats->dropped      = self->dropped;
+  stats->queued       = self->job_count;
+  stats->max_queued   = self->max_queued;
+  stats->max_latency  = self->max_latency * SUSCAN_REALTIME_NS;
+  stats->mean_latency = self->processed > 0
+    ? (SUFLOAT) self->total_latency / self->processed * SUSCAN_REALTIME_NS
+    : 0;
+
+  pthread_mutex_unlock(&self->mutex);
+}
@@ -0,0 +1,123 @@
+/*
+
+  Copyright (C) 2023 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SUSCAN_BBFILT_H
+#define _SUSCAN_BBFILT_H
+
+#include <sigutils/types.h>
+#include <sigutils/defs.h>
+#include <pthread.h>
+
+#include "analyzer.h"
+#include "pool.h"
+#include "worker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define SUSCAN_BBFILT_MAX_QUEUE_DEPTH 64
+
+struct suscan_bbfilt_job {
+  suscan_sample_buffer_t *buffer;
+  SUCOMPLEX *samples;
+  SUSCOUNT length;
+  SUSCOUNT consumed;
+  uint64_t enqueued; /* In nanoseconds */
+};
+
+/*
+ * Baseband filter instance of the local analyzer. Synchronous filters
+ * are called directly. Asynchronous filters own a worker and a ring of
+ * pending jobs, each holding a reference to a sample buffer of the pool.
+ */
+struct suscan_bbfilt {
+  struct suscan_analyzer_baseband_filter        desc;
+  struct suscan_analyzer_baseband_filter_params params;
+  suscan_analyzer_t           *analyzer;
+  suscan_sample_buffer_pool_t *pool;
+
+  /* Asynchronous execution */
+  suscan_worker_t          *worker;
+  struct suscan_mq          worker_mq;
+  SUBOOL                    worker_mq_init;
+  struct suscan_bbfilt_job *job_ring;
+  unsigned int              job_head;
+  unsigned int              job_count;
+  pthread_mutex_t           mutex;
+  pthread_cond_t            cond;
+  SUBOOL                    sync_init;
+  SUBOOL                    failed;
+
+  /* Statistics */
+  uint64_t     processed;
+  uint64_t     dropped;
+  unsigned int max_queued;
+  uint64_t     total_latency;
+  uint64_t     max_latency;
+};
+
+typedef struct suscan_bbfilt suscan_bbfilt_t;
+
+SU_INSTANCER(
+  suscan_bbfilt,
+  suscan_analyzer_t *,
+  suscan_sample_buffer_pool_t *,
+  suscan_analyzer_baseband_filter_func_t,
+  void *,
+  const struct suscan_analyzer_baseband_filter_params *);
+SU_COLLECTOR(suscan_bbfilt);
+
+SUINLINE SU_GETTER(suscan_bbfilt, SUBOOL, is_async)
+{
+  return self->params.mode == SUSCAN_ANALYZER_BBFILT_MODE_ASYNC;
+}
+
+/*
+ * Deliver a buffer of samples to the filter. The buffer is referenced
+ * (or duplicated, if circular) only for asynchronous filters.
+ */
+SU_METHOD(
+  suscan_bbfilt,
+  SUBOOL,
+  feed,
+  suscan_sample_buffer_t *buffer,
+  SUCOMPLEX *samples,
+  SUSCOUNT length,
+  SUSCOUNT consumed);
+
+/*
+ * Blocking filters: wait until the queue has room for another buffer.
+ * This may take as long as the filter takes to process a buffer, so it
+ * must be called without holding the loop mutex of the analyzer. As
+ * only the source thread enqueues jobs, the next feed will not block.
+ */
+SU_METHOD(suscan_bbfilt, void, wait_room);
+
+SU_METHOD(
+  suscan_bbfilt,
+  void,
+  get_stats,
+  struct suscan_analyzer_baseband_filter_stats *);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SUSCAN_BBFILT_H */
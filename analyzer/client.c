@@ -172,6 +172,74 @@ done:
   return ok;
 }
 
+SUBOOL
+suscan_analyzer_set_panorama_params_async(
+    suscan_analyzer_t *analyzer,
+    const struct suscan_analyzer_panorama_params *params,
+    uint32_t req_id)
+{
+  struct suscan_analyzer_panorama_params *msg = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(
+      msg = malloc(sizeof(struct suscan_analyzer_panorama_params)),
+      goto done);
+
+  *msg = *params;
+
+  if (!suscan_analyzer_write(
+      analyzer,
+      SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_PARAMS,
+      msg)) {
+    SU_ERROR("Failed to send panorama command\n");
+    goto done;
+  }
+
+  msg = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (msg != NULL)
+    free(msg);
+
+  return ok;
+}
+
+SUBOOL
+suscan_analyzer_req_panorama_keyframe_async(
+    suscan_analyzer_t *analyzer,
+    uint32_t epoch,
+    uint32_t req_id)
+{
+  struct suscan_analyzer_panorama_keyframe_msg *msg = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(
+      msg = malloc(sizeof(struct suscan_analyzer_panorama_keyframe_msg)),
+      goto done);
+
+  msg->epoch = epoch;
+
+  if (!suscan_analyzer_write(
+      analyzer,
+      SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_KEYFRAME,
+      msg)) {
+    SU_ERROR("Failed to send panorama keyframe request\n");
+    goto done;
+  }
+
+  msg = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (msg != NULL)
+    free(msg);
+
+  return ok;
+}
+
 SUBOOL
 suscan_analyzer_replay_async(
     suscan_analyzer_t *analyzer,
@@ -207,9 +275,10 @@ done:
 }
 
 /****************************** Inspector methods ****************************/
-SUBOOL
-suscan_analyzer_open_ex_async(
+SUPRIVATE SUBOOL
+suscan_analyzer_open_internal_async(
     suscan_analyzer_t *analyzer,
+    unsigned int source_index,
     const char *class,
     const struct sigutils_channel *channel,
     SUBOOL precise,
@@ -227,9 +296,10 @@ suscan_analyzer_open_ex_async(
 
   SU_TRYCATCH(req->class_name = strdup(class), goto done);
 
-  req->channel = *channel;
-  req->precise = precise;
-  req->handle  = parent;
+  req->channel      = *channel;
+  req->precise      = precise;
+  req->handle       = parent;
+  req->source_index = source_index;
 
   if (!suscan_analyzer_write(
       analyzer,
@@ -250,6 +320,44 @@ done:
   return ok;
 }
 
+SUBOOL
+suscan_analyzer_open_ex_async(
+    suscan_analyzer_t *analyzer,
+    const char *class,
+    const struct sigutils_channel *channel,
+    SUBOOL precise,
+    SUHANDLE parent,
+    uint32_t req_id)
+{
+  return suscan_analyzer_open_internal_async(
+      analyzer,
+      0,
+      class,
+      channel,
+      precise,
+      parent,
+      req_id);
+}
+
+SUBOOL
+suscan_analyzer_open_source_async(
+    suscan_analyzer_t *analyzer,
+    unsigned int source_index,
+    const char *class,
+    const struct sigutils_channel *channel,
+    SUBOOL precise,
+    uint32_t req_id)
+{
+  return suscan_analyzer_open_internal_async(
+      analyzer,
+      source_index,
+      class,
+      channel,
+      precise,
+      -1,
+      req_id);
+}
+
 SUBOOL
 suscan_analyzer_open_async(
     suscan_analyzer_t *analyzer,
@@ -730,4 +838,82 @@ done:
   return ok;
 }
 
+SUBOOL
+suscan_analyzer_inspector_subscribe_spectrum_async(
+    suscan_analyzer_t *analyzer,
+    SUHANDLE handle,
+    uint32_t spectsrc_id,
+    SUBOOL subscribed,
+    uint32_t req_id)
+{
+  struct suscan_analyzer_inspector_msg *req = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(
+      req = suscan_analyzer_inspector_msg_new(
+          SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SUBSCRIBE_SPECTRUM,
+          req_id),
+      goto done);
+
+  req->handle              = handle;
+  req->spectsrc_id         = spectsrc_id;
+  req->spectsrc_subscribed = subscribed;
+
+  if (!suscan_analyzer_write(
+      analyzer,
+      SUSCAN_ANALYZER_MESSAGE_TYPE_INSPECTOR,
+      req)) {
+    SU_ERROR("Failed to send subscribe_spectrum command\n");
+    goto done;
+  }
+
+  req = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (req != NULL)
+    suscan_analyzer_inspector_msg_destroy(req);
+
+  return ok;
+}
+
+SUBOOL
+suscan_analyzer_set_inspector_stalled_async(
+    suscan_analyzer_t *analyzer,
+    SUHANDLE handle,
+    SUBOOL stalled,
+    uint32_t req_id)
+{
+  struct suscan_analyzer_inspector_msg *req = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(
+      req = suscan_analyzer_inspector_msg_new(
+          SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SET_STALLED,
+          req_id),
+      goto done);
+
+  req->handle  = handle;
+  req->stalled = stalled;
+
+  if (!suscan_analyzer_write(
+      analyzer,
+      SUSCAN_ANALYZER_MESSAGE_TYPE_INSPECTOR,
+      req)) {
+    SU_ERROR("Failed to send set_stalled command\n");
+    goto done;
+  }
+
+  req = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (req != NULL)
+    suscan_analyzer_inspector_msg_destroy(req);
+
+  return ok;
+}
+
 
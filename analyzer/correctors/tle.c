@@ -24,6 +24,7 @@
 #include "corrector.h"
 #include "tle.h"
 #include <sgdp4/sgdp4.h>
+#include <math.h>
 
 SUPRIVATE struct suscan_frequency_corrector_class g_tle_corrector_class;
 
@@ -114,15 +115,234 @@ done:
   return new;
 }
 
+/****************************** Doppler model ********************************/
+/*
+ * Full SGP4 propagations are expensive, and corrections are queried by
+ * every inspector on every update. Instead, the range rate and position
+ * of the satellite are fitted by Chebyshev polynomials over spans of up
+ * to SUSCAN_TLE_CORRECTOR_MAX_SPAN seconds, which costs MODEL_ORDER + 1
+ * propagations per span. Spans are halved until the model agrees with
+ * the propagator within the error bounds (fast passes near the zenith),
+ * and are allowed to grow back afterwards.
+ */
+SUPRIVATE SUDOUBLE
+suscan_tle_corrector_timeval_to_secs(const struct timeval *tv)
+{
+  return tv->tv_sec + 1e-6 * tv->tv_usec;
+}
+
+SUPRIVATE SUBOOL
+suscan_tle_corrector_propagate(
+  suscan_tle_corrector_t *self,
+  SUDOUBLE t,
+  xyz_t *pos_azel,
+  xyz_t *vel_azel)
+{
+  struct timeval tv;
+  SUDOUBLE secs = floor(t);
+
+  tv.tv_sec  = secs;
+  tv.tv_usec = (t - secs) * 1e6;
+
+  if (!sgdp4_prediction_update(&self->prediction, &tv))
+    return SU_FALSE;
+
+  sgdp4_prediction_get_azel(&self->prediction, pos_azel);
+  sgdp4_prediction_get_vel_azel(&self->prediction, vel_azel);
+
+  return SU_TRUE;
+}
+
+/* Clenshaw evaluation of a Chebyshev series in u = [-1, 1] */
+SUPRIVATE SUDOUBLE
+suscan_tle_corrector_chebyshev(const SUDOUBLE *c, SUDOUBLE u)
+{
+  SUDOUBLE b0 = 0, b1 = 0, b2;
+  int j;
+
+  for (j = SUSCAN_TLE_CORRECTOR_MODEL_ORDER - 1; j >= 1; --j) {
+    b2 = b1;
+    b1 = b0;
+    b0 = 2 * u * b1 - b2 + c[j];
+  }
+
+  return u * b0 - b1 + .5 * c[0];
+}
+
+SUPRIVATE void
+suscan_tle_corrector_model_eval(
+  const struct suscan_tle_corrector_model *model,
+  SUDOUBLE t,
+  xyz_t *pos_azel,
+  SUDOUBLE *range_rate)
+{
+  SUDOUBLE u = (2 * t - model->t0 - model->t1) / (model->t1 - model->t0);
+
+  pos_azel->azimuth   =
+    fmod(suscan_tle_corrector_chebyshev(model->azimuth, u), 2 * M_PI);
+  if (pos_azel->azimuth < 0)
+    pos_azel->azimuth += 2 * M_PI;
+
+  pos_azel->elevation = suscan_tle_corrector_chebyshev(model->elevation, u);
+  pos_azel->distance  = suscan_tle_corrector_chebyshev(model->distance, u);
+  *range_rate         = suscan_tle_corrector_chebyshev(model->range_rate, u);
+}
+
+SUPRIVATE SUBOOL
+suscan_tle_corrector_model_fit(
+  suscan_tle_corrector_t *self,
+  struct suscan_tle_corrector_model *model,
+  SUDOUBLE t0,
+  SUDOUBLE span)
+{
+  const unsigned int N = SUSCAN_TLE_CORRECTOR_MODEL_ORDER;
+  SUDOUBLE rate[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+  SUDOUBLE dist[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+  SUDOUBLE az[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+  SUDOUBLE el[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+  SUDOUBLE x, w, prev_az = 0;
+  xyz_t pos, vel;
+  unsigned int i, j, k;
+
+  model->valid = SU_FALSE;
+  model->t0    = t0;
+  model->t1    = t0 + span;
+
+  /* Chebyshev nodes, from the earliest (i = N - 1) to the latest (i = 0) */
+  for (i = N; i-- > 0; ) {
+    x = cos(M_PI * (i + .5) / N);
+    if (!suscan_tle_corrector_propagate(
+      self,
+      t0 + .5 * span * (x + 1),
+      &pos,
+      &vel))
+      return SU_FALSE;
+
+    rate[i] = vel.distance;
+    dist[i] = pos.distance;
+    el[i]   = pos.elevation;
+
+    /* Unwrap azimuth with respect to the previous node */
+    az[i] = pos.azimuth;
+    if (i != N - 1)
+      az[i] -= 2 * M_PI * floor((az[i] - prev_az) / (2 * M_PI) + .5);
+    prev_az = az[i];
+  }
+
+  for (j = 0; j < N; ++j) {
+    model->range_rate[j] = model->distance[j] = 0;
+    model->azimuth[j]    = model->elevation[j] = 0;
+
+    for (k = 0; k < N; ++k) {
+      w = 2. / N * cos(M_PI * j * (k + .5) / N);
+      model->range_rate[j] += w * rate[k];
+      model->distance[j]   += w * dist[k];
+      model->azimuth[j]    += w * az[k];
+      model->elevation[j]  += w * el[k];
+    }
+  }
+
+  model->valid = SU_TRUE;
+
+  return SU_TRUE;
+}
+
+/* Check the model against the propagator between the last two nodes */
+SUPRIVATE SUBOOL
+suscan_tle_corrector_model_check(
+  suscan_tle_corrector_t *self,
+  const struct suscan_tle_corrector_model *model,
+  SUBOOL *accurate)
+{
+  SUDOUBLE t = model->t0 + .97 * (model->t1 - model->t0);
+  SUDOUBLE rate, daz;
+  xyz_t pos, vel, model_pos;
+
+  if (!suscan_tle_corrector_propagate(self, t, &pos, &vel))
+    return SU_FALSE;
+
+  suscan_tle_corrector_model_eval(model, t, &model_pos, &rate);
+
+  daz = remainder(model_pos.azimuth - pos.azimuth, 2 * M_PI);
+
+  *accurate =
+       fabs(rate - vel.distance) <= SUSCAN_TLE_CORRECTOR_MAX_RATE_ERROR
+    && fabs(model_pos.elevation - pos.elevation)
+      <= SUSCAN_TLE_CORRECTOR_MAX_ANGLE_ERROR
+    && fabs(daz) * cos(pos.elevation) <= SUSCAN_TLE_CORRECTOR_MAX_ANGLE_ERROR;
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+suscan_tle_corrector_update_model(suscan_tle_corrector_t *self, SUDOUBLE t)
+{
+  SUBOOL accurate = SU_FALSE;
+
+  if (self->model.valid && t >= self->model.t0 && t <= self->model.t1)
+    return SU_TRUE;
+
+  /* Let the span grow back after a fast segment */
+  if (self->span <= 0)
+    self->span = SUSCAN_TLE_CORRECTOR_MAX_SPAN;
+  else
+    self->span = SU_MIN(2 * self->span, SUSCAN_TLE_CORRECTOR_MAX_SPAN);
+
+  for (;;) {
+    if (!suscan_tle_corrector_model_fit(self, &self->model, t, self->span))
+      return SU_FALSE;
+
+    if (self->span <= SUSCAN_TLE_CORRECTOR_MIN_SPAN)
+      break;
+
+    if (!suscan_tle_corrector_model_check(self, &self->model, &accurate))
+      return SU_FALSE;
+
+    if (accurate)
+      break;
+
+    self->span *= .5;
+  }
+
+  return SU_TRUE;
+}
+
+/*
+ * Satellite position and range rate at a given time. Falls back to
+ * propagating directly if the model cannot be fitted.
+ */
+SUPRIVATE void
+suscan_tle_corrector_get_state(
+  suscan_tle_corrector_t *self,
+  const struct timeval *tv,
+  xyz_t *pos_azel,
+  SUDOUBLE *range_rate)
+{
+  SUDOUBLE t = suscan_tle_corrector_timeval_to_secs(tv);
+  xyz_t vel_azel;
+
+  if (suscan_tle_corrector_update_model(self, t)) {
+    suscan_tle_corrector_model_eval(&self->model, t, pos_azel, range_rate);
+  } else {
+    self->model.valid = SU_FALSE;
+
+    sgdp4_prediction_update(&self->prediction, tv);
+    sgdp4_prediction_get_azel(&self->prediction, pos_azel);
+    sgdp4_prediction_get_vel_azel(&self->prediction, &vel_azel);
+
+    *range_rate = vel_azel.distance;
+  }
+}
+
 SUBOOL
 suscan_tle_corrector_visible(
   suscan_tle_corrector_t *self,
   const struct timeval *tv)
 {
   xyz_t azel;
+  SUDOUBLE range_rate;
 
-  sgdp4_prediction_update(&self->prediction, tv);
-  sgdp4_prediction_get_azel(&self->prediction, &azel);
+  suscan_tle_corrector_get_state(self, tv, &azel, &range_rate);
 
   return azel.elevation >= 0;
 }
@@ -135,20 +355,19 @@ suscan_frequency_corrector_tle_get_report(
   struct suscan_orbit_report *report)
 {
   suscan_tle_corrector_t *self;
-  xyz_t pos_azel, vel_azel;
+  xyz_t pos_azel;
+  SUDOUBLE range_rate;
 
   if (suscan_frequency_corrector_get_class(fc) != &g_tle_corrector_class)
     return SU_FALSE;
 
   self = suscan_frequency_corrector_get_userdata(fc);
 
-  sgdp4_prediction_update(&self->prediction, tv);
-  sgdp4_prediction_get_azel(&self->prediction, &pos_azel);
-  sgdp4_prediction_get_vel_azel(&self->prediction, &vel_azel);
+  suscan_tle_corrector_get_state(self, tv, &pos_azel, &range_rate);
 
-  report->freq_corr = vel_azel.distance / SPEED_OF_LIGHT_KM_S * freq;
+  report->freq_corr = range_rate / SPEED_OF_LIGHT_KM_S * freq;
   report->rx_time   = *tv;
-  report->vlos_vel  = vel_azel.distance;
+  report->vlos_vel  = range_rate;
   report->satpos    = pos_azel;
 
   return SU_TRUE;
@@ -162,13 +381,12 @@ suscan_tle_corrector_correct_freq(
   SUFREQ freq,
   SUFLOAT *delta_freq)
 {
-  xyz_t pos_azel, vel_azel;
+  xyz_t pos_azel;
+  SUDOUBLE range_rate;
 
-  sgdp4_prediction_update(&self->prediction, tv);
-  sgdp4_prediction_get_azel(&self->prediction, &pos_azel);
-  sgdp4_prediction_get_vel_azel(&self->prediction, &vel_azel);
+  suscan_tle_corrector_get_state(self, tv, &pos_azel, &range_rate);
   
-  *delta_freq = -vel_azel.distance / SPEED_OF_LIGHT_KM_S * freq;
+  *delta_freq = -range_rate / SPEED_OF_LIGHT_KM_S * freq;
 
   return SU_TRUE;
 }
@@ -32,8 +32,31 @@ enum suscan_tle_corrector_mode {
   SUSCAN_TLE_CORRECTOR_MODE_ORBIT
 };
 
+#define SUSCAN_TLE_CORRECTOR_MODEL_ORDER    8
+#define SUSCAN_TLE_CORRECTOR_MAX_SPAN       120.   /* Seconds */
+#define SUSCAN_TLE_CORRECTOR_MIN_SPAN       2.     /* Seconds */
+#define SUSCAN_TLE_CORRECTOR_MAX_RATE_ERROR 1e-4   /* km/s (10 cm/s) */
+#define SUSCAN_TLE_CORRECTOR_MAX_ANGLE_ERROR 1e-3  /* Radians */
+
+/*
+ * Chebyshev model of the satellite as seen from the site, valid in
+ * [t0, t1] (seconds since the epoch). The azimuth is unwrapped.
+ */
+struct suscan_tle_corrector_model {
+  SUBOOL   valid;
+  SUDOUBLE t0, t1;
+  SUDOUBLE range_rate[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+  SUDOUBLE distance[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+  SUDOUBLE azimuth[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+  SUDOUBLE elevation[SUSCAN_TLE_CORRECTOR_MODEL_ORDER];
+};
+
 struct suscan_tle_corrector {
   sgdp4_prediction_t prediction;
+
+  /* Propagations are only needed to fit a new model */
+  struct suscan_tle_corrector_model model;
+  SUDOUBLE span;
 };
 
 typedef struct suscan_tle_corrector suscan_tle_corrector_t;
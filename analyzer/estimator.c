@@ -22,6 +22,7 @@
 #define SU_LOG_DOMAIN "estimator"
 
 #include "estimator.h"
+#include "source.h"
 
 PTR_LIST_CONST(struct suscan_estimator_class, estimator_class);
 SUPRIVATE SUBOOL estimators_init = SU_FALSE;
@@ -44,10 +45,17 @@ suscan_estimator_class_register(const struct suscan_estimator_class *class)
   SU_TRYCATCH(class->name  != NULL, return SU_FALSE);
   SU_TRYCATCH(class->desc  != NULL, return SU_FALSE);
   SU_TRYCATCH(class->field != NULL, return SU_FALSE);
-  SU_TRYCATCH(class->ctor  != NULL, return SU_FALSE);
-  SU_TRYCATCH(class->dtor  != NULL, return SU_FALSE);
   SU_TRYCATCH(class->read  != NULL, return SU_FALSE);
-  SU_TRYCATCH(class->feed  != NULL, return SU_FALSE);
+  SU_TRYCATCH(
+      class->product < SUSCAN_ESTIMATOR_PRODUCT_COUNT,
+      return SU_FALSE);
+
+  /* Estimators reading from a product may be stateless */
+  if (class->product == SUSCAN_ESTIMATOR_PRODUCT_NONE) {
+    SU_TRYCATCH(class->ctor  != NULL, return SU_FALSE);
+    SU_TRYCATCH(class->dtor  != NULL, return SU_FALSE);
+    SU_TRYCATCH(class->feed  != NULL, return SU_FALSE);
+  }
 
   SU_TRYCATCH(
       suscan_estimator_class_lookup(class->name) == NULL,
@@ -69,7 +77,8 @@ suscan_estimator_new(const struct suscan_estimator_class *class, SUSCOUNT fs)
 
   new->classptr = class;
 
-  SU_TRYCATCH(new->privdata = (class->ctor) (fs), goto fail);
+  if (class->ctor != NULL)
+    SU_TRYCATCH(new->privdata = (class->ctor) (fs), goto fail);
 
   return new;
 
@@ -90,20 +99,207 @@ suscan_estimator_feed(
 }
 
 SUBOOL
-suscan_estimator_read(const suscan_estimator_t *estimator, SUFLOAT *out)
+suscan_estimator_read(
+    const suscan_estimator_t *estimator,
+    const su_channel_detector_t *product,
+    SUFLOAT *out)
 {
-  return (estimator->classptr->read) (estimator->privdata, out);
+  return (estimator->classptr->read) (estimator->privdata, product, out);
 }
 
 void
 suscan_estimator_destroy(suscan_estimator_t *estimator)
 {
-  if (estimator != NULL)
+  if (estimator != NULL
+    && estimator->privdata != NULL
+    && estimator->classptr->dtor != NULL)
     (estimator->classptr->dtor) (estimator->privdata);
 
   free(estimator);
 }
 
+/***************************** Estimator engine ******************************/
+SU_INSTANCER(suscan_estimator_engine, SUSCOUNT samp_rate)
+{
+  suscan_estimator_engine_t *new = NULL;
+
+  SU_ALLOCATE_FAIL(new, suscan_estimator_engine_t);
+
+  new->samp_rate = samp_rate;
+
+  return new;
+
+fail:
+  if (new != NULL)
+    suscan_estimator_engine_destroy(new);
+
+  return NULL;
+}
+
+SU_COLLECTOR(suscan_estimator_engine)
+{
+  unsigned int i;
+
+  for (i = 0; i < self->estimator_count; ++i)
+    suscan_estimator_destroy(self->estimator_list[i]);
+
+  if (self->estimator_list != NULL)
+    free(self->estimator_list);
+
+  for (i = 0; i < SUSCAN_ESTIMATOR_PRODUCT_COUNT; ++i)
+    if (self->product[i] != NULL)
+      su_channel_detector_destroy(self->product[i]);
+
+  free(self);
+}
+
+SU_METHOD(
+  suscan_estimator_engine,
+  SUBOOL,
+  add_class,
+  const struct suscan_estimator_class *classdef)
+{
+  suscan_estimator_t *estimator = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(estimator = suscan_estimator_new(classdef, self->samp_rate));
+  SU_TRYC(PTR_LIST_APPEND_CHECK(self->estimator, estimator));
+  estimator = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (estimator != NULL)
+    suscan_estimator_destroy(estimator);
+
+  return ok;
+}
+
+SUPRIVATE su_channel_detector_t *
+suscan_estimator_engine_make_product(
+    suscan_estimator_engine_t *self,
+    enum suscan_estimator_product product)
+{
+  struct sigutils_channel_detector_params cd_params =
+      sigutils_channel_detector_params_INITIALIZER;
+
+  cd_params.samp_rate = self->samp_rate;
+  cd_params.tune = SU_FALSE; /* Estimators expect baseband signals */
+
+  switch (product) {
+    case SUSCAN_ESTIMATOR_PRODUCT_AUTOCORRELATION:
+      cd_params.window_size = SUSCAN_SOURCE_DEFAULT_BUFSIZ;
+      cd_params.mode = SU_CHANNEL_DETECTOR_MODE_AUTOCORRELATION;
+      break;
+
+    case SUSCAN_ESTIMATOR_PRODUCT_NONLINEAR_DIFF:
+      cd_params.window_size = SUSCAN_DEFAULT_ESTIMATOR_BUFSIZ;
+      cd_params.mode = SU_CHANNEL_DETECTOR_MODE_NONLINEAR_DIFF;
+      break;
+
+    default:
+      return NULL;
+  }
+
+  return su_channel_detector_new(&cd_params);
+}
+
+SUPRIVATE SUBOOL
+suscan_estimator_engine_feed_product(
+    su_channel_detector_t *detector,
+    const SUCOMPLEX *x,
+    SUSCOUNT size)
+{
+  SUSCOUNT got;
+
+  while (size > 0) {
+    SU_TRYCATCH(
+        (got = su_channel_detector_feed_bulk(detector, x, size)) > 0,
+        return SU_FALSE);
+
+    size -= got;
+    x += got;
+  }
+
+  return SU_TRUE;
+}
+
+/*
+ * Every product needed by an enabled estimator is computed once per
+ * block, no matter how many estimators read from it. Products no longer
+ * needed are released, so disabled estimators cost nothing.
+ */
+SU_METHOD(
+  suscan_estimator_engine,
+  SUBOOL,
+  feed,
+  const SUCOMPLEX *samples,
+  SUSCOUNT size)
+{
+  const suscan_estimator_t *estimator;
+  SUBOOL needed[SUSCAN_ESTIMATOR_PRODUCT_COUNT] = {SU_FALSE};
+  unsigned int i;
+
+  for (i = 0; i < self->estimator_count; ++i) {
+    estimator = self->estimator_list[i];
+
+    if (!suscan_estimator_is_enabled(estimator))
+      continue;
+
+    if (estimator->classptr->product == SUSCAN_ESTIMATOR_PRODUCT_NONE)
+      SU_TRYCATCH(
+          suscan_estimator_feed(self->estimator_list[i], samples, size),
+          return SU_FALSE);
+    else
+      needed[estimator->classptr->product] = SU_TRUE;
+  }
+
+  for (i = 1; i < SUSCAN_ESTIMATOR_PRODUCT_COUNT; ++i) {
+    if (needed[i]) {
+      if (self->product[i] == NULL)
+        SU_TRYCATCH(
+            self->product[i] = suscan_estimator_engine_make_product(self, i),
+            return SU_FALSE);
+
+      SU_TRYCATCH(
+          suscan_estimator_engine_feed_product(
+              self->product[i],
+              samples,
+              size),
+          return SU_FALSE);
+    } else if (self->product[i] != NULL) {
+      su_channel_detector_destroy(self->product[i]);
+      self->product[i] = NULL;
+    }
+  }
+
+  return SU_TRUE;
+}
+
+SU_GETTER(
+  suscan_estimator_engine,
+  SUBOOL,
+  read,
+  unsigned int index,
+  SUFLOAT *out)
+{
+  const suscan_estimator_t *estimator;
+  const su_channel_detector_t *product = NULL;
+
+  if (index >= self->estimator_count)
+    return SU_FALSE;
+
+  estimator = self->estimator_list[index];
+
+  if (estimator->classptr->product != SUSCAN_ESTIMATOR_PRODUCT_NONE) {
+    /* Enabled after the last feed: nothing to read yet */
+    if ((product = self->product[estimator->classptr->product]) == NULL)
+      return SU_FALSE;
+  }
+
+  return suscan_estimator_read(estimator, product, out);
+}
+
 SUBOOL
 suscan_estimators_initialized(void)
 {
@@ -25,9 +25,22 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include <sigutils/sigutils.h>
+#include <sigutils/detect.h>
 
 #define SUSCAN_DEFAULT_ESTIMATOR_BUFSIZ 1024
 
+/*
+ * Intermediate products estimators may share. Every product is a channel
+ * detector fed once per block, and only while some enabled estimator
+ * needs it.
+ */
+enum suscan_estimator_product {
+  SUSCAN_ESTIMATOR_PRODUCT_NONE,
+  SUSCAN_ESTIMATOR_PRODUCT_AUTOCORRELATION,  /* Signal autocorrelation */
+  SUSCAN_ESTIMATOR_PRODUCT_NONLINEAR_DIFF,   /* Spectrum of |x'|^2 */
+  SUSCAN_ESTIMATOR_PRODUCT_COUNT
+};
+
 struct suscan_estimator_class {
   const char *name;
   const char *desc;
@@ -35,9 +48,15 @@ struct suscan_estimator_class {
 
   void * (*ctor) (SUSCOUNT fs);
 
+  /* Estimators with a product are not fed, they read from the product */
+  enum suscan_estimator_product product;
+
   SUBOOL (*feed) (void *privdata, const SUCOMPLEX *samples, SUSCOUNT size);
 
-  SUBOOL (*read) (const void *privdata, SUFLOAT *out);
+  SUBOOL (*read) (
+      const void *privdata,
+      const su_channel_detector_t *product,
+      SUFLOAT *out);
 
   void (*dtor) (void *privdata);
 };
@@ -79,10 +98,49 @@ SUBOOL suscan_estimator_feed(
 
 SUBOOL suscan_estimator_read(
     const suscan_estimator_t *estimator,
+    const su_channel_detector_t *product,
     SUFLOAT *out);
 
 void suscan_estimator_destroy(suscan_estimator_t *estimator);
 
+/*
+ * Estimator engine: all the estimators of an inspector, along with the
+ * products they share. Products are created when the first estimator
+ * needing them is enabled and released when the last one is disabled.
+ */
+struct suscan_estimator_engine {
+  SUSCOUNT samp_rate;
+
+  PTR_LIST(suscan_estimator_t, estimator);
+  su_channel_detector_t *product[SUSCAN_ESTIMATOR_PRODUCT_COUNT];
+};
+
+typedef struct suscan_estimator_engine suscan_estimator_engine_t;
+
+SU_INSTANCER(suscan_estimator_engine, SUSCOUNT samp_rate);
+SU_COLLECTOR(suscan_estimator_engine);
+
+SU_METHOD(
+  suscan_estimator_engine,
+  SUBOOL,
+  add_class,
+  const struct suscan_estimator_class *classdef);
+
+/* Must be called from the thread reading the estimators */
+SU_METHOD(
+  suscan_estimator_engine,
+  SUBOOL,
+  feed,
+  const SUCOMPLEX *samples,
+  SUSCOUNT size);
+
+SU_GETTER(
+  suscan_estimator_engine,
+  SUBOOL,
+  read,
+  unsigned int index,
+  SUFLOAT *out);
+
 /******************** Builtin channel estimators *****************************/
 SUBOOL suscan_estimator_fac_register(void);
 SUBOOL suscan_estimator_nonlinear_register(void);
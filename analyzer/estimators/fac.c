@@ -22,50 +22,19 @@
 #define SU_LOG_DOMAIN "fac-estimator"
 
 #include <sigutils/detect.h>
-#include "source.h"
 #include "estimator.h"
 
-SUPRIVATE void *
-suscan_estimator_fac_ctor(SUSCOUNT fs)
-{
-  struct sigutils_channel_detector_params cd_params =
-      sigutils_channel_detector_params_INITIALIZER;
-
-  cd_params.samp_rate = fs;
-  cd_params.window_size = SUSCAN_SOURCE_DEFAULT_BUFSIZ;
-  cd_params.tune = SU_FALSE; /* Estimators expect baseband signals */
-  cd_params.mode = SU_CHANNEL_DETECTOR_MODE_AUTOCORRELATION;
-
-  return su_channel_detector_new(&cd_params);
-}
-
-SUPRIVATE SUBOOL
-suscan_estimator_fac_feed(void *private, const SUCOMPLEX *x, SUSCOUNT size)
-{
-  SU_TRYCATCH(
-      su_channel_detector_feed_bulk(
-          (su_channel_detector_t *) private,
-          x,
-          size) == size,
-      return SU_FALSE);
-
-  return SU_TRUE;
-}
-
 SUPRIVATE SUBOOL
-suscan_estimator_fac_read(const void *private, SUFLOAT *out)
+suscan_estimator_fac_read(
+    const void *private,
+    const su_channel_detector_t *product,
+    SUFLOAT *out)
 {
-  *out = su_channel_detector_get_baud((const su_channel_detector_t *) private);
+  *out = su_channel_detector_get_baud(product);
 
   return SU_TRUE;
 }
 
-SUPRIVATE void
-suscan_estimator_fac_dtor(void *private)
-{
-  su_channel_detector_destroy((su_channel_detector_t *) private);
-}
-
 SUBOOL
 suscan_estimator_fac_register(void)
 {
@@ -73,10 +42,8 @@ suscan_estimator_fac_register(void)
       .name  = "baud-fac",
       .desc  = "FAC baud estimator",
       .field = "clock.baud",
-      .ctor  = suscan_estimator_fac_ctor,
-      .feed  = suscan_estimator_fac_feed,
-      .read  = suscan_estimator_fac_read,
-      .dtor  = suscan_estimator_fac_dtor
+      .product = SUSCAN_ESTIMATOR_PRODUCT_AUTOCORRELATION,
+      .read  = suscan_estimator_fac_read
   };
 
   SU_TRYCATCH(suscan_estimator_class_register(&class), return SU_FALSE);
@@ -54,31 +54,6 @@ suscan_local_analyzer_unlock_loop(suscan_local_analyzer_t *self)
   (void) pthread_mutex_unlock(&self->loop_mutex);
 }
 
-/************************* Baseband filter API *******************************/
-SUPRIVATE struct suscan_analyzer_baseband_filter *
-suscan_analyzer_baseband_filter_new(
-    suscan_analyzer_baseband_filter_func_t func,
-    void *privdata)
-{
-  struct suscan_analyzer_baseband_filter *filter;
-
-  SU_TRYCATCH(
-      filter = malloc(sizeof (struct suscan_analyzer_baseband_filter)),
-      return NULL);
-
-  filter->func = func;
-  filter->privdata = privdata;
-
-  return filter;
-}
-
-SUPRIVATE void
-suscan_analyzer_baseband_filter_destroy(
-    struct suscan_analyzer_baseband_filter *filter)
-{
-  free(filter);
-}
-
 /************************ Local analyzer thread ******************************/
 SUPRIVATE void
 suscan_local_analyzer_ack_halt(suscan_local_analyzer_t *self)
@@ -212,6 +187,8 @@ suscan_analyzer_thread(void *data)
   const struct suscan_analyzer_seek_msg *seek;
   const struct suscan_analyzer_history_size_msg *history_size;
   const struct suscan_analyzer_replay_msg *replay;
+  const struct suscan_analyzer_panorama_params *panorama;
+  const struct suscan_analyzer_panorama_keyframe_msg *keyframe;
 
   void *private = NULL;
   uint32_t type;
@@ -290,6 +267,26 @@ suscan_analyzer_thread(void *data)
             suscan_local_analyzer_slow_set_replay(self, replay->replay),
             goto done);
           break;
+
+        case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_PARAMS:
+          panorama = (const struct suscan_analyzer_panorama_params *) private;
+          if (self->parent->params.mode == SUSCAN_ANALYZER_MODE_WIDE_SPECTRUM) {
+            if (!suscan_local_analyzer_set_panorama_params(self, panorama))
+              SU_WARNING("Failed to apply panorama parameters\n");
+          } else {
+            SU_WARNING("Panorama is only available in wide spectrum mode\n");
+          }
+          break;
+
+        case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_KEYFRAME:
+          keyframe = (const struct suscan_analyzer_panorama_keyframe_msg *) private;
+          if (self->parent->params.mode == SUSCAN_ANALYZER_MODE_WIDE_SPECTRUM)
+            SU_TRYCATCH(
+              suscan_local_analyzer_req_panorama_keyframe(
+                self,
+                keyframe->epoch),
+              goto done);
+          break;
         
         /* Forward these messages to output */
         case SUSCAN_ANALYZER_MESSAGE_TYPE_EOS:
@@ -441,7 +438,7 @@ SUPRIVATE void suscan_local_analyzer_dtor(void *ptr);
 SUPRIVATE void
 suscan_local_analyzer_bbfilt_dtor(void *obj, void *userdata)
 {
-  suscan_analyzer_baseband_filter_destroy(obj);
+  suscan_bbfilt_destroy(obj);
 }
 
 void *
@@ -570,6 +567,13 @@ suscan_local_analyzer_ctor(suscan_analyzer_t *parent, va_list ap)
   SU_TRYCATCH(pthread_mutex_init(&new->stuner_mutex, &attr) == 0, goto fail);
   new->stuner_init = SU_TRUE;
 
+  /* Additional sources */
+  SU_TRYZ_FAIL(pthread_mutex_init(&new->subsource_mutex, NULL));
+  new->subsource_init = SU_TRUE;
+
+  SU_TRYZ_FAIL(pthread_mutex_init(&new->sched_mutex, NULL));
+  new->sched_init = SU_TRUE;
+
   /* Initialization of the inspector handling API */
   if (suscan_inspector_factory_class_lookup("local-analyzer") == NULL)
     SU_TRYCATCH(
@@ -655,6 +659,7 @@ SUPRIVATE void
 suscan_local_analyzer_dtor(void *ptr)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) ptr;
+  unsigned int i;
 
   /* Prevent source from entering in timeout loops */
   if (self->source != NULL)
@@ -681,6 +686,10 @@ suscan_local_analyzer_dtor(void *ptr)
       return;
     }
 
+  /* Stop additional sources. Their tuners are released later. */
+  for (i = 0; i < self->subsource_count; ++i)
+    suscan_local_subsource_stop(self->subsource_list[i]);
+
   /* Stop capture source, now that workers using it have stopped */
   if (self->source != NULL && suscan_source_is_capturing(self->source))
     suscan_source_stop_capture(self->source);
@@ -692,6 +701,10 @@ suscan_local_analyzer_dtor(void *ptr)
   if (self->detector != NULL)
     su_channel_detector_destroy(self->detector);
 
+  /* Free panorama */
+  if (self->panorama != NULL)
+    suscan_panorama_destroy(self->panorama);
+
   if (self->psd_worker != NULL) {
     if (!suscan_analyzer_halt_worker(self->psd_worker)) {
       SU_ERROR("Failed to destroy PSD worker.\n");
@@ -728,6 +741,15 @@ suscan_local_analyzer_dtor(void *ptr)
   
   if (self->stuner != NULL)
     su_specttuner_destroy(self->stuner);
+
+  for (i = 0; i < self->subsource_count; ++i)
+    suscan_local_subsource_destroy(self->subsource_list[i]);
+
+  if (self->subsource_init)
+    pthread_mutex_destroy(&self->subsource_mutex);
+
+  if (self->sched_init)
+    pthread_mutex_destroy(&self->sched_mutex);
   
   /* Free read buffer */
   if (self->read_buf != NULL)
@@ -758,6 +780,10 @@ suscan_local_analyzer_dtor(void *ptr)
   suscan_mq_finalize(&self->mq_in);
 
   free(self);
+
+  /* Keep the wisdom of the plans we created */
+  if (!suscan_sync_fft_wisdom(SU_FALSE))
+    SU_WARNING("Failed to save FFT wisdom\n");
 }
 
 /* Source-related methods */
@@ -840,7 +866,9 @@ suscan_local_analyzer_set_iq_reverse(void *ptr, SUBOOL value)
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) ptr;
 
   if (self->iq_rev != value) {
+    /* IQ reversal is performed by the source, along with DC removal */
     self->iq_rev = value;
+    suscan_source_set_iq_reverse(self->source, value);
     self->source_info.iq_reverse = self->iq_rev;
     return suscan_analyzer_send_source_info(self->parent, &self->source_info);
   }
@@ -1052,13 +1080,14 @@ done:
 }
 
 SUPRIVATE SUBOOL
-suscan_local_analyzer_register_baseband_filter(
+suscan_local_analyzer_register_baseband_filter_ex(
     void *ptr,
     suscan_analyzer_baseband_filter_func_t func,
     void *privdata,
-    int64_t prio)
+    int64_t prio,
+    const struct suscan_analyzer_baseband_filter_params *params)
 {
-  struct suscan_analyzer_baseband_filter *new = NULL;
+  suscan_bbfilt_t *new = NULL;
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) ptr;
   SUBOOL automatic_priority = prio == SUSCAN_ANALYZER_BBFILT_PRIO_DEFAULT;
   
@@ -1066,13 +1095,6 @@ suscan_local_analyzer_register_baseband_filter(
       self->parent->params.mode == SUSCAN_ANALYZER_MODE_CHANNEL,
       goto fail);
 
-  SU_TRYCATCH(
-      new = suscan_analyzer_baseband_filter_new(func, privdata),
-      goto fail);
-
-  new->func = func;
-  new->privdata = privdata;
-
   if (automatic_priority) {
     prio = 0;
     while (rbtree_search(self->bbfilt_tree, prio, RB_EXACT) != NULL)
@@ -1086,17 +1108,149 @@ suscan_local_analyzer_register_baseband_filter(
     goto fail;
   }
 
+  SU_MAKE_FAIL(
+      new,
+      suscan_bbfilt,
+      self->parent,
+      self->bufpool,
+      func,
+      privdata,
+      params);
+
   SU_TRYC_FAIL(rbtree_insert(self->bbfilt_tree, prio, new));
 
   return SU_TRUE;
 
 fail:
   if (new != NULL)
-    suscan_analyzer_baseband_filter_destroy(new);
+    suscan_bbfilt_destroy(new);
 
   return SU_FALSE;
 }
 
+SUPRIVATE SUBOOL
+suscan_local_analyzer_register_baseband_filter(
+    void *ptr,
+    suscan_analyzer_baseband_filter_func_t func,
+    void *privdata,
+    int64_t prio)
+{
+  struct suscan_analyzer_baseband_filter_params params =
+    suscan_analyzer_baseband_filter_params_INITIALIZER;
+
+  return suscan_local_analyzer_register_baseband_filter_ex(
+      ptr,
+      func,
+      privdata,
+      prio,
+      &params);
+}
+
+SUPRIVATE SUBOOL
+suscan_local_analyzer_get_baseband_filter_stats(
+    void *ptr,
+    int64_t prio,
+    struct suscan_analyzer_baseband_filter_stats *stats)
+{
+  suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) ptr;
+  struct rbtree_node *node;
+
+  if ((node = rbtree_search(self->bbfilt_tree, prio, RB_EXACT)) == NULL
+    || rbtree_node_data(node) == NULL) {
+    SU_ERROR("No baseband filter with priority %lld\n", prio);
+    return SU_FALSE;
+  }
+
+  suscan_bbfilt_get_stats(rbtree_node_data(node), stats);
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+suscan_local_analyzer_add_source(
+    void *ptr,
+    suscan_source_config_t *config,
+    unsigned int *index)
+{
+  suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) ptr;
+  suscan_local_subsource_t *subsource = NULL;
+  SUBOOL mutex_acquired = SU_FALSE;
+  SUBOOL ok = SU_FALSE;
+
+  if (self->parent->params.mode != SUSCAN_ANALYZER_MODE_CHANNEL) {
+    SU_ERROR("Additional sources are only supported in channel mode\n");
+    goto done;
+  }
+
+  SU_TRYZ(pthread_mutex_lock(&self->subsource_mutex));
+  mutex_acquired = SU_TRUE;
+
+  if (self->subsource_count + 1 >= SUSCAN_LOCAL_ANALYZER_MAX_SOURCES) {
+    SU_ERROR(
+      "Too many sources (max is %d)\n",
+      SUSCAN_LOCAL_ANALYZER_MAX_SOURCES);
+    goto done;
+  }
+
+  SU_MAKE(
+    subsource,
+    suscan_local_subsource,
+    self,
+    config,
+    self->subsource_count + 1);
+
+  self->subsource_list[self->subsource_count++] = subsource;
+
+  /*
+   * Started with the mutex held: nobody can look up this source (or
+   * register another one) until we know whether it runs.
+   */
+  if (!suscan_local_subsource_start(subsource)) {
+    SU_ERROR("Failed to start source #%u\n", subsource->index);
+
+    /* Still the last one. Unregister it, so no dead entries remain */
+    --self->subsource_count;
+    goto done;
+  }
+
+  /* Registered: from now on, it is released by the analyzer */
+  *index = subsource->index;
+  subsource = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (mutex_acquired)
+    pthread_mutex_unlock(&self->subsource_mutex);
+
+  if (subsource != NULL)
+    suscan_local_subsource_destroy(subsource);
+
+  return ok;
+}
+
+SUPRIVATE SUBOOL
+suscan_local_analyzer_set_source_frequency(
+    void *ptr,
+    unsigned int index,
+    SUFREQ freq,
+    SUFREQ lnb)
+{
+  suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) ptr;
+  suscan_local_subsource_t *subsource;
+
+  if ((subsource = suscan_local_analyzer_get_subsource(self, index)) == NULL) {
+    SU_ERROR("No such source (%u)\n", index);
+    return SU_FALSE;
+  }
+
+  return suscan_local_analyzer_slow_set_source_freq(
+    self,
+    subsource,
+    freq,
+    lnb);
+}
+
 /* Fast methods */
 SUPRIVATE SUBOOL
 suscan_local_analyzer_set_inspector_frequency(
@@ -1177,6 +1331,10 @@ suscan_local_analyzer_get_interface(void)
     SET_CALLBACK(set_history_size);
     SET_CALLBACK(replay);
     SET_CALLBACK(register_baseband_filter);
+    SET_CALLBACK(register_baseband_filter_ex);
+    SET_CALLBACK(get_baseband_filter_stats);
+    SET_CALLBACK(add_source);
+    SET_CALLBACK(set_source_frequency);
     SET_CALLBACK(get_measured_samp_rate);
     SET_CALLBACK(get_source_info_pointer);
     SET_CALLBACK(commit_source_info);
@@ -25,6 +25,8 @@
 #include <analyzer/inspector/factory.h>
 #include <analyzer/inspector/overridable.h>
 #include <analyzer/pool.h>
+#include <analyzer/panorama.h>
+#include <analyzer/bbfilt.h>
 
 #include <rbtree.h>
 
@@ -38,6 +40,42 @@ extern "C" {
 #define SULIMPL(analyzer) ((suscan_local_analyzer_t *) ((analyzer)->impl))
 #define SUSCAN_LOCAL_ANALYZER_AS_ANALYZER(local) ((local)->parent)
 
+/* Including the primary source */
+#define SUSCAN_LOCAL_ANALYZER_MAX_SOURCES 8
+
+struct suscan_local_analyzer;
+
+/*
+ * Additional sources of a channel mode analyzer (index 1 onwards). Each
+ * of them has its own reader worker, PSD and spectral tuner, but channels
+ * opened on them are delivered to the inspector factory (and therefore
+ * the inspector scheduler) of the analyzer.
+ */
+struct suscan_local_subsource {
+  struct suscan_local_analyzer *owner;
+  unsigned int index;
+
+  suscan_source_t *source;
+  struct suscan_source_info source_info;
+  SUBOOL capturing;
+
+  /* Frequency request (processed by the slow worker) */
+  SUBOOL freq_req;
+  SUFREQ freq_req_value;
+  SUFREQ lnb_req_value;
+
+  suscan_sample_buffer_pool_t *bufpool;
+  su_smoothpsd_t  *smooth_psd;
+  suscan_worker_t *psd_worker;
+  suscan_worker_t *source_wk;
+
+  su_specttuner_t *stuner;
+  pthread_mutex_t  stuner_mutex;
+  SUBOOL           stuner_init;
+};
+
+typedef struct suscan_local_subsource suscan_local_subsource_t;
+
 struct suscan_local_analyzer {
   suscan_analyzer_t *parent;
   struct suscan_mq mq_in;   /* Input queue */
@@ -141,6 +179,20 @@ struct suscan_local_analyzer {
   SUSCOUNT fft_samples; /* Number of FFT frames */
   SUSCOUNT hop_samples;
 
+  /* Wide spectrum panorama (protected by the loop mutex) */
+  suscan_panorama_t *panorama;
+  uint32_t           panorama_epoch;
+
+  /* Additional sources. Never removed before destruction. */
+  suscan_local_subsource_t *subsource_list[SUSCAN_LOCAL_ANALYZER_MAX_SOURCES - 1];
+  unsigned int              subsource_count;
+  pthread_mutex_t           subsource_mutex;
+  SUBOOL                    subsource_init;
+
+  /* Serializes source workers feeding the inspector scheduler */
+  pthread_mutex_t sched_mutex;
+  SUBOOL          sched_init;
+
   suscan_inspector_factory_t         *insp_factory;
   suscan_inspector_request_manager_t  insp_reqmgr;
 
@@ -310,6 +362,44 @@ SUBOOL suscan_local_analyzer_slow_set_gain(
     const char *name,
     SUFLOAT value);
 
+/* Internal */
+SU_INSTANCER(
+  suscan_local_subsource,
+  suscan_local_analyzer_t *,
+  suscan_source_config_t *,
+  unsigned int);
+
+/* Internal */
+SU_COLLECTOR(suscan_local_subsource);
+
+/* Internal */
+SU_METHOD(suscan_local_subsource, SUBOOL, start);
+
+/* Internal */
+SU_METHOD(suscan_local_subsource, void, stop);
+
+/* Internal */
+suscan_local_subsource_t *suscan_local_analyzer_get_subsource(
+    suscan_local_analyzer_t *self,
+    unsigned int index);
+
+/* Internal */
+SUBOOL suscan_local_analyzer_slow_set_source_freq(
+    suscan_local_analyzer_t *analyzer,
+    suscan_local_subsource_t *subsource,
+    SUFREQ freq,
+    SUFREQ lnb);
+
+/* Internal */
+SUBOOL suscan_local_analyzer_set_panorama_params(
+    suscan_local_analyzer_t *self,
+    const struct suscan_analyzer_panorama_params *params);
+
+/* Internal */
+SUBOOL suscan_local_analyzer_req_panorama_keyframe(
+    suscan_local_analyzer_t *self,
+    uint32_t epoch);
+
 /* Iternal */
 SUBOOL suscan_local_analyzer_readjust_detector(
     suscan_local_analyzer_t *self,
@@ -0,0 +1,657 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "pducomp"
+
+#include <sigutils/log.h>
+#include <sigutils/util/compat-inet.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+
+#ifdef HAVE_LZ4
+#  include <lz4.h>
+#  include <lz4hc.h>
+#endif /* HAVE_LZ4 */
+
+#ifdef HAVE_ZSTD
+#  include <zstd.h>
+#endif /* HAVE_ZSTD */
+
+#include "pducomp.h"
+#include "remote.h"
+#include <analyzer/realtime.h>
+
+#define SUSCAN_REMOTE_COMPRESSION_ZLIB_DEFAULT_LEVEL 1
+#define SUSCAN_REMOTE_COMPRESSION_LZ4_DEFAULT_LEVEL  1
+#define SUSCAN_REMOTE_COMPRESSION_ZSTD_DEFAULT_LEVEL 3
+
+SUPRIVATE const char *g_remote_compression_names[] = {
+  "zlib",
+  "lz4",
+  "zstd"
+};
+
+const char *
+suscan_remote_compression_to_string(enum suscan_remote_compression codec)
+{
+  if (codec < 0 || codec >= SUSCAN_REMOTE_COMPRESSION_COUNT)
+    return NULL;
+
+  return g_remote_compression_names[codec];
+}
+
+SUBOOL
+suscan_remote_compression_from_string(
+  const char *string,
+  enum suscan_remote_compression *codec)
+{
+  unsigned int i;
+
+  for (i = 0; i < SUSCAN_REMOTE_COMPRESSION_COUNT; ++i)
+    if (strcasecmp(string, g_remote_compression_names[i]) == 0) {
+      *codec = i;
+      return SU_TRUE;
+    }
+
+  return SU_FALSE;
+}
+
+uint32_t
+suscan_remote_compression_get_supported(void)
+{
+  uint32_t mask = 1 << SUSCAN_REMOTE_COMPRESSION_ZLIB;
+
+#ifdef HAVE_LZ4
+  mask |= 1 << SUSCAN_REMOTE_COMPRESSION_LZ4;
+#endif /* HAVE_LZ4 */
+
+#ifdef HAVE_ZSTD
+  mask |= 1 << SUSCAN_REMOTE_COMPRESSION_ZSTD;
+#endif /* HAVE_ZSTD */
+
+  return mask;
+}
+
+void
+suscan_remote_compression_get_level_range(
+  enum suscan_remote_compression codec,
+  int *min,
+  int *max)
+{
+  switch (codec) {
+    case SUSCAN_REMOTE_COMPRESSION_LZ4:
+      /* 1 is LZ4 proper, the rest are LZ4HC levels */
+      *min = 1;
+      *max = 12;
+      break;
+
+    case SUSCAN_REMOTE_COMPRESSION_ZSTD:
+      *min = 1;
+      *max = 19;
+      break;
+
+    default:
+      *min = 1;
+      *max = 9;
+  }
+}
+
+SUBOOL
+suscan_remote_compression_params_is_valid(
+  const struct suscan_remote_compression_params *params)
+{
+  int min, max;
+
+  if (!suscan_remote_compression_is_supported(params->codec))
+    return SU_FALSE;
+
+  if (params->level == SUSCAN_REMOTE_COMPRESSION_DEFAULT_LEVEL)
+    return SU_TRUE;
+
+  suscan_remote_compression_get_level_range(params->codec, &min, &max);
+
+  return params->level >= min && params->level <= max;
+}
+
+uint32_t
+suscan_remote_compression_get_magic(enum suscan_remote_compression codec)
+{
+  switch (codec) {
+    case SUSCAN_REMOTE_COMPRESSION_LZ4:
+      return SUSCAN_REMOTE_LZ4_PDU_HEADER_MAGIC;
+
+    case SUSCAN_REMOTE_COMPRESSION_ZSTD:
+      return SUSCAN_REMOTE_ZSTD_PDU_HEADER_MAGIC;
+
+    default:
+      return SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC;
+  }
+}
+
+SUBOOL
+suscan_remote_compression_from_magic(
+  uint32_t magic,
+  enum suscan_remote_compression *codec)
+{
+  switch (magic) {
+    case SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC:
+      *codec = SUSCAN_REMOTE_COMPRESSION_ZLIB;
+      break;
+
+    case SUSCAN_REMOTE_LZ4_PDU_HEADER_MAGIC:
+      *codec = SUSCAN_REMOTE_COMPRESSION_LZ4;
+      break;
+
+    case SUSCAN_REMOTE_ZSTD_PDU_HEADER_MAGIC:
+      *codec = SUSCAN_REMOTE_COMPRESSION_ZSTD;
+      break;
+
+    default:
+      return SU_FALSE;
+  }
+
+  return SU_TRUE;
+}
+
+SUPRIVATE int
+suscan_remote_compression_get_level(
+  const struct suscan_remote_compression_params *params)
+{
+  if (params->level != SUSCAN_REMOTE_COMPRESSION_DEFAULT_LEVEL)
+    return params->level;
+
+  switch (params->codec) {
+    case SUSCAN_REMOTE_COMPRESSION_LZ4:
+      return SUSCAN_REMOTE_COMPRESSION_LZ4_DEFAULT_LEVEL;
+
+    case SUSCAN_REMOTE_COMPRESSION_ZSTD:
+      return SUSCAN_REMOTE_COMPRESSION_ZSTD_DEFAULT_LEVEL;
+
+    default:
+      return SUSCAN_REMOTE_COMPRESSION_ZLIB_DEFAULT_LEVEL;
+  }
+}
+
+/******************************* Compressor ***********************************/
+SUPRIVATE void
+suscan_remote_compressor_release_contexts(struct suscan_remote_compressor *self)
+{
+  if (self->zlib_ctx != NULL) {
+    deflateEnd(self->zlib_ctx);
+    free(self->zlib_ctx);
+    self->zlib_ctx = NULL;
+  }
+
+  if (self->lz4_ctx != NULL) {
+    free(self->lz4_ctx);
+    self->lz4_ctx = NULL;
+  }
+
+#ifdef HAVE_ZSTD
+  if (self->zstd_ctx != NULL) {
+    ZSTD_freeCCtx(self->zstd_ctx);
+    self->zstd_ctx = NULL;
+  }
+#endif /* HAVE_ZSTD */
+}
+
+SUBOOL
+suscan_remote_compressor_init(
+  struct suscan_remote_compressor *self,
+  const struct suscan_remote_compression_params *params)
+{
+  memset(self, 0, sizeof(struct suscan_remote_compressor));
+
+  return suscan_remote_compressor_set_params(self, params);
+}
+
+SUBOOL
+suscan_remote_compressor_set_params(
+  struct suscan_remote_compressor *self,
+  const struct suscan_remote_compression_params *params)
+{
+  if (!suscan_remote_compression_params_is_valid(params)) {
+    SU_ERROR(
+      "Unsupported PDU compression (%s, level %d)\n",
+      suscan_remote_compression_to_string(params->codec),
+      params->level);
+    return SU_FALSE;
+  }
+
+  /* Contexts are bound to a level, recreate them on demand */
+  if (self->params.codec != params->codec
+    || self->params.level != params->level)
+    suscan_remote_compressor_release_contexts(self);
+
+  self->params = *params;
+
+  return SU_TRUE;
+}
+
+SUPRIVATE ssize_t
+suscan_remote_compressor_zlib(
+  struct suscan_remote_compressor *self,
+  int level,
+  const uint8_t *data,
+  size_t size,
+  grow_buf_t *dest)
+{
+  z_stream *stream;
+  uint8_t *output;
+  uLong bound;
+
+  if (self->zlib_ctx == NULL) {
+    SU_TRYCATCH(stream = calloc(1, sizeof(z_stream)), return -1);
+
+    if (deflateInit(stream, level) != Z_OK) {
+      free(stream);
+      return -1;
+    }
+
+    self->zlib_ctx = stream;
+  } else {
+    stream = self->zlib_ctx;
+    SU_TRYCATCH(deflateReset(stream) == Z_OK, return -1);
+  }
+
+  /* Allocate the worst case at once and compress in a single call */
+  bound = deflateBound(stream, size);
+  SU_TRYCATCH(output = grow_buf_alloc(dest, bound), return -1);
+
+  stream->next_in   = (Bytef *) data;
+  stream->avail_in  = size;
+  stream->next_out  = output;
+  stream->avail_out = bound;
+
+  SU_TRYCATCH(deflate(stream, Z_FINISH) == Z_STREAM_END, return -1);
+
+  return stream->total_out;
+}
+
+#ifdef HAVE_LZ4
+SUPRIVATE ssize_t
+suscan_remote_compressor_lz4(
+  struct suscan_remote_compressor *self,
+  int level,
+  const uint8_t *data,
+  size_t size,
+  grow_buf_t *dest)
+{
+  uint8_t *output;
+  int bound;
+  int result;
+
+  SU_TRYCATCH(size <= LZ4_MAX_INPUT_SIZE, return -1);
+
+  if (self->lz4_ctx == NULL)
+    SU_TRYCATCH(
+      self->lz4_ctx = malloc(level > 1 ? LZ4_sizeofStateHC() : LZ4_sizeofState()),
+      return -1);
+
+  bound = LZ4_compressBound(size);
+  SU_TRYCATCH(output = grow_buf_alloc(dest, bound), return -1);
+
+  if (level > 1)
+    result = LZ4_compress_HC_extStateHC(
+      self->lz4_ctx,
+      (const char *) data,
+      (char *) output,
+      size,
+      bound,
+      level);
+  else
+    result = LZ4_compress_fast_extState(
+      self->lz4_ctx,
+      (const char *) data,
+      (char *) output,
+      size,
+      bound,
+      1);
+
+  SU_TRYCATCH(result > 0, return -1);
+
+  return result;
+}
+#endif /* HAVE_LZ4 */
+
+#ifdef HAVE_ZSTD
+SUPRIVATE ssize_t
+suscan_remote_compressor_zstd(
+  struct suscan_remote_compressor *self,
+  int level,
+  const uint8_t *data,
+  size_t size,
+  grow_buf_t *dest)
+{
+  uint8_t *output;
+  size_t bound;
+  size_t result;
+
+  if (self->zstd_ctx == NULL)
+    SU_TRYCATCH(self->zstd_ctx = ZSTD_createCCtx(), return -1);
+
+  bound = ZSTD_compressBound(size);
+  SU_TRYCATCH(output = grow_buf_alloc(dest, bound), return -1);
+
+  result = ZSTD_compressCCtx(self->zstd_ctx, output, bound, data, size, level);
+  if (ZSTD_isError(result)) {
+    SU_ERROR("ZSTD compression failed: %s\n", ZSTD_getErrorName(result));
+    return -1;
+  }
+
+  return result;
+}
+#endif /* HAVE_ZSTD */
+
+SUBOOL
+suscan_remote_compressor_compress(
+  struct suscan_remote_compressor *self,
+  const grow_buf_t *pdu,
+  grow_buf_t *dest,
+  uint32_t *magic)
+{
+  const uint8_t *data = grow_buf_get_buffer(pdu);
+  size_t size = grow_buf_get_size(pdu);
+  int level = suscan_remote_compression_get_level(&self->params);
+  uint32_t be_size = htonl(size);
+  uint64_t t0;
+  ssize_t result = -1;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(grow_buf_get_size(dest) == 0, goto done);
+  SU_TRYCATCH(
+    grow_buf_append(dest, &be_size, sizeof(uint32_t)) != -1,
+    goto done);
+
+  t0 = suscan_gettime_raw();
+
+  switch (self->params.codec) {
+    case SUSCAN_REMOTE_COMPRESSION_ZLIB:
+      result = suscan_remote_compressor_zlib(self, level, data, size, dest);
+      break;
+
+#ifdef HAVE_LZ4
+    case SUSCAN_REMOTE_COMPRESSION_LZ4:
+      result = suscan_remote_compressor_lz4(self, level, data, size, dest);
+      break;
+#endif /* HAVE_LZ4 */
+
+#ifdef HAVE_ZSTD
+    case SUSCAN_REMOTE_COMPRESSION_ZSTD:
+      result = suscan_remote_compressor_zstd(self, level, data, size, dest);
+      break;
+#endif /* HAVE_ZSTD */
+
+    default:
+      SU_ERROR("PDU compression codec not supported\n");
+  }
+
+  if (result < 0)
+    goto done;
+
+  /* Drop the unused part of the worst-case allocation */
+  dest->size = result + sizeof(uint32_t);
+
+  ++self->stats.pdus;
+  self->stats.bytes_in  += size;
+  self->stats.bytes_out += dest->size;
+  self->stats.time_ns   += suscan_gettime_raw() - t0;
+
+  *magic = suscan_remote_compression_get_magic(self->params.codec);
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+void
+suscan_remote_compressor_finalize(struct suscan_remote_compressor *self)
+{
+  suscan_remote_compressor_release_contexts(self);
+}
+
+/****************************** Decompressor **********************************/
+SUPRIVATE SUBOOL
+suscan_remote_decompressor_zlib(
+  struct suscan_remote_decompressor *self,
+  const uint8_t *data,
+  size_t size,
+  uint8_t *output,
+  size_t out_size)
+{
+  z_stream *stream;
+  int last_err;
+
+  if (self->zlib_ctx == NULL) {
+    SU_TRYCATCH(stream = calloc(1, sizeof(z_stream)), return SU_FALSE);
+
+    if (inflateInit(stream) != Z_OK) {
+      free(stream);
+      return SU_FALSE;
+    }
+
+    self->zlib_ctx = stream;
+  } else {
+    stream = self->zlib_ctx;
+    SU_TRYCATCH(inflateReset(stream) == Z_OK, return SU_FALSE);
+  }
+
+  stream->next_in   = (Bytef *) data;
+  stream->avail_in  = size;
+  stream->next_out  = output;
+  stream->avail_out = out_size;
+
+  last_err = inflate(stream, Z_FINISH);
+
+  if (last_err != Z_STREAM_END) {
+    SU_ERROR(
+      "Inflate error %d (%lu/%lu bytes decompressed, corrupted data?)\n",
+      last_err,
+      (unsigned long) stream->total_out,
+      (unsigned long) out_size);
+    return SU_FALSE;
+  }
+
+  return stream->total_out == out_size;
+}
+
+#ifdef HAVE_LZ4
+SUPRIVATE SUBOOL
+suscan_remote_decompressor_lz4(
+  struct suscan_remote_decompressor *self,
+  const uint8_t *data,
+  size_t size,
+  uint8_t *output,
+  size_t out_size)
+{
+  int result;
+
+  SU_TRYCATCH(size <= LZ4_MAX_INPUT_SIZE, return SU_FALSE);
+
+  result = LZ4_decompress_safe(
+    (const char *) data,
+    (char *) output,
+    size,
+    out_size);
+
+  return result >= 0 && (size_t) result == out_size;
+}
+#endif /* HAVE_LZ4 */
+
+#ifdef HAVE_ZSTD
+SUPRIVATE SUBOOL
+suscan_remote_decompressor_zstd(
+  struct suscan_remote_decompressor *self,
+  const uint8_t *data,
+  size_t size,
+  uint8_t *output,
+  size_t out_size)
+{
+  size_t result;
+
+  if (self->zstd_ctx == NULL)
+    SU_TRYCATCH(self->zstd_ctx = ZSTD_createDCtx(), return SU_FALSE);
+
+  result = ZSTD_decompressDCtx(self->zstd_ctx, output, out_size, data, size);
+  if (ZSTD_isError(result)) {
+    SU_ERROR("ZSTD decompression failed: %s\n", ZSTD_getErrorName(result));
+    return SU_FALSE;
+  }
+
+  return result == out_size;
+}
+#endif /* HAVE_ZSTD */
+
+SUBOOL
+suscan_remote_decompressor_decompress_data(
+  struct suscan_remote_decompressor *self,
+  uint32_t magic,
+  const void *data,
+  size_t cmpsize,
+  grow_buf_t *dest)
+{
+  enum suscan_remote_compression codec;
+  const uint8_t *cmpbytes = data;
+  uint32_t size;
+  uint8_t *output = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  if (!suscan_remote_compression_from_magic(magic, &codec)
+    || !suscan_remote_compression_is_supported(codec)) {
+    SU_ERROR("Unsupported compressed PDU (magic 0x%08x)\n", magic);
+    goto done;
+  }
+
+  SU_TRYCATCH(grow_buf_get_size(dest) == 0, goto done);
+
+  if (cmpsize <= sizeof(uint32_t)) {
+    SU_ERROR("Compressed frame too short\n");
+    goto done;
+  }
+
+  memcpy(&size, cmpbytes, sizeof(uint32_t));
+  size = ntohl(size);
+
+  cmpsize  -= sizeof(uint32_t);
+  cmpbytes += sizeof(uint32_t);
+
+  if (size == 0 || size > SUSCAN_REMOTE_MAX_PDU_SIZE) {
+    SU_ERROR("Invalid uncompressed PDU size (%u bytes)\n", size);
+    goto done;
+  }
+
+  SU_TRYCATCH(output = grow_buf_alloc(dest, size), goto done);
+
+  switch (codec) {
+    case SUSCAN_REMOTE_COMPRESSION_ZLIB:
+      ok = suscan_remote_decompressor_zlib(
+        self,
+        cmpbytes,
+        cmpsize,
+        output,
+        size);
+      break;
+
+#ifdef HAVE_LZ4
+    case SUSCAN_REMOTE_COMPRESSION_LZ4:
+      ok = suscan_remote_decompressor_lz4(
+        self,
+        cmpbytes,
+        cmpsize,
+        output,
+        size);
+      break;
+#endif /* HAVE_LZ4 */
+
+#ifdef HAVE_ZSTD
+    case SUSCAN_REMOTE_COMPRESSION_ZSTD:
+      ok = suscan_remote_decompressor_zstd(
+        self,
+        cmpbytes,
+        cmpsize,
+        output,
+        size);
+      break;
+#endif /* HAVE_ZSTD */
+
+    default:
+      break;
+  }
+
+  if (!ok)
+    SU_ERROR(
+      "Failed to decompress %s PDU (corrupted data?)\n",
+      suscan_remote_compression_to_string(codec));
+
+done:
+  return ok;
+}
+
+SUBOOL
+suscan_remote_decompressor_decompress(
+  struct suscan_remote_decompressor *self,
+  uint32_t magic,
+  grow_buf_t *buffer)
+{
+  grow_buf_t tmpbuf = grow_buf_INITIALIZER;
+  grow_buf_t swapbuf;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRYCATCH(
+    suscan_remote_decompressor_decompress_data(
+      self,
+      magic,
+      grow_buf_get_buffer(buffer),
+      grow_buf_get_size(buffer),
+      &tmpbuf),
+    goto done);
+
+  /* Swap these */
+  swapbuf = *buffer;
+  *buffer = tmpbuf;
+  tmpbuf  = swapbuf;
+
+  ok = SU_TRUE;
+
+done:
+  grow_buf_finalize(&tmpbuf);
+
+  return ok;
+}
+
+void
+suscan_remote_decompressor_finalize(struct suscan_remote_decompressor *self)
+{
+  if (self->zlib_ctx != NULL) {
+    inflateEnd(self->zlib_ctx);
+    free(self->zlib_ctx);
+    self->zlib_ctx = NULL;
+  }
+
+#ifdef HAVE_ZSTD
+  if (self->zstd_ctx != NULL) {
+    ZSTD_freeDCtx(self->zstd_ctx);
+    self->zstd_ctx = NULL;
+  }
+#endif /* HAVE_ZSTD */
+}
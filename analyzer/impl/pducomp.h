@@ -0,0 +1,180 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SUSCAN_ANALYZER_IMPL_PDUCOMP_H
+#define _SUSCAN_ANALYZER_IMPL_PDUCOMP_H
+
+#include <sigutils/types.h>
+#include <sigutils/defs.h>
+#include <util/cbor.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Compression of remote PDUs. Compressed PDUs are identified by the magic
+ * of their header, and their body is the size of the uncompressed PDU
+ * (32 bit, network byte order) followed by the compressed data. Every
+ * PDU is compressed independently, so that they can be discarded or
+ * shared among clients after compression.
+ */
+enum suscan_remote_compression {
+  SUSCAN_REMOTE_COMPRESSION_ZLIB,
+  SUSCAN_REMOTE_COMPRESSION_LZ4,
+  SUSCAN_REMOTE_COMPRESSION_ZSTD,
+  SUSCAN_REMOTE_COMPRESSION_COUNT
+};
+
+/* Upper bound of PDU sizes, compressed or not */
+#define SUSCAN_REMOTE_MAX_PDU_SIZE (1 << 28)
+
+/* Level 0 is the default level of the codec */
+#define SUSCAN_REMOTE_COMPRESSION_DEFAULT_LEVEL 0
+
+struct suscan_remote_compression_params {
+  enum suscan_remote_compression codec;
+  int level;
+};
+
+#define suscan_remote_compression_params_INITIALIZER          \
+{                                                             \
+  SUSCAN_REMOTE_COMPRESSION_ZLIB, /* codec */                 \
+  SUSCAN_REMOTE_COMPRESSION_DEFAULT_LEVEL, /* level */        \
+}
+
+const char *suscan_remote_compression_to_string(
+  enum suscan_remote_compression codec);
+
+SUBOOL suscan_remote_compression_from_string(
+  const char *string,
+  enum suscan_remote_compression *codec);
+
+/* Codecs available in this build, as a bitmask of 1 << codec */
+uint32_t suscan_remote_compression_get_supported(void);
+
+SUINLINE SUBOOL
+suscan_remote_compression_is_supported(enum suscan_remote_compression codec)
+{
+  return codec >= 0
+      && codec < SUSCAN_REMOTE_COMPRESSION_COUNT
+      && (suscan_remote_compression_get_supported() & (1 << codec));
+}
+
+void suscan_remote_compression_get_level_range(
+  enum suscan_remote_compression codec,
+  int *min,
+  int *max);
+
+SUBOOL suscan_remote_compression_params_is_valid(
+  const struct suscan_remote_compression_params *params);
+
+uint32_t suscan_remote_compression_get_magic(
+  enum suscan_remote_compression codec);
+
+SUBOOL suscan_remote_compression_from_magic(
+  uint32_t magic,
+  enum suscan_remote_compression *codec);
+
+struct suscan_remote_compressor_stats {
+  uint64_t pdus;
+  uint64_t bytes_in;
+  uint64_t bytes_out;
+  uint64_t time_ns;
+};
+
+SUINLINE void
+suscan_remote_compressor_stats_add(
+  struct suscan_remote_compressor_stats *self,
+  const struct suscan_remote_compressor_stats *other)
+{
+  self->pdus      += other->pdus;
+  self->bytes_in  += other->bytes_in;
+  self->bytes_out += other->bytes_out;
+  self->time_ns   += other->time_ns;
+}
+
+SUINLINE SUFLOAT
+suscan_remote_compressor_stats_get_ratio(
+  const struct suscan_remote_compressor_stats *self)
+{
+  return self->bytes_out > 0
+    ? (SUFLOAT) self->bytes_in / (SUFLOAT) self->bytes_out
+    : 1;
+}
+
+/*
+ * Compression contexts are kept between PDUs, and only allocated for the
+ * codecs actually used. A zeroed compressor is a valid compressor using
+ * zlib at its default level.
+ */
+struct suscan_remote_compressor {
+  struct suscan_remote_compression_params params;
+  struct suscan_remote_compressor_stats stats;
+
+  void *zlib_ctx;
+  void *lz4_ctx;
+  void *zstd_ctx;
+};
+
+SUBOOL suscan_remote_compressor_init(
+  struct suscan_remote_compressor *self,
+  const struct suscan_remote_compression_params *params);
+
+SUBOOL suscan_remote_compressor_set_params(
+  struct suscan_remote_compressor *self,
+  const struct suscan_remote_compression_params *params);
+
+/* dest must be empty. Returns the header magic of the compressed PDU */
+SUBOOL suscan_remote_compressor_compress(
+  struct suscan_remote_compressor *self,
+  const grow_buf_t *pdu,
+  grow_buf_t *dest,
+  uint32_t *magic);
+
+void suscan_remote_compressor_finalize(struct suscan_remote_compressor *self);
+
+struct suscan_remote_decompressor {
+  void *zlib_ctx;
+  void *zstd_ctx;
+};
+
+/* Decompresses the body of a compressed PDU into dest, which must be empty */
+SUBOOL suscan_remote_decompressor_decompress_data(
+  struct suscan_remote_decompressor *self,
+  uint32_t magic,
+  const void *data,
+  size_t size,
+  grow_buf_t *dest);
+
+/* Replaces the body of a compressed PDU by its uncompressed contents */
+SUBOOL suscan_remote_decompressor_decompress(
+  struct suscan_remote_decompressor *self,
+  uint32_t magic,
+  grow_buf_t *buffer);
+
+void suscan_remote_decompressor_finalize(
+  struct suscan_remote_decompressor *self);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SUSCAN_ANALYZER_IMPL_PDUCOMP_H */
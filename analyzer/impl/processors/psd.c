@@ -17,8 +17,12 @@
 
 */
 
+#define SU_LOG_DOMAIN "mc-psd-processor"
+
 #include "psd.h"
 #include <analyzer/msg.h>
+#include <analyzer/psdcodec.h>
+#include <string.h>
 
 SUPRIVATE void
 suscli_multicast_processor_psd_dtor(void *userdata)
@@ -52,6 +56,10 @@ suscli_multicast_processor_psd_on_fragment(
   struct suscli_multicast_processor_psd *self =
     (struct suscli_multicast_processor_psd *) userdata;
   const struct suscan_analyzer_psd_sf_fragment *frag;
+  enum suscan_psd_encoding encoding;
+  const uint8_t *bins;
+  SUSINGLE q_offset = 0, q_scale = 0;
+  uint32_t as_u32;
 
   uint32_t full_size = ntohl(header->sf_size);
   uint32_t offset    = ntohl(header->sf_offset);
@@ -75,9 +83,34 @@ suscli_multicast_processor_psd_on_fragment(
   /* The true number of fragments is obtained by subtracting
      the fragment header */
   size -= sizeof(struct suscan_analyzer_psd_sf_fragment);
-  size /= sizeof(SUFLOAT);
 
   frag = (struct suscan_analyzer_psd_sf_fragment *) header->sf_data;
+  bins = frag->bytes;
+
+  encoding = (su_ntohll(frag->flags) >> SUSCAN_ANALYZER_PSD_SF_ENCODING_SHIFT)
+    & SUSCAN_ANALYZER_PSD_SF_ENCODING_MASK;
+
+  /* Quantized fragments carry their own offset and scale */
+  if (suscan_psd_encoding_is_quantized(encoding)) {
+    if (size < SUSCAN_PSD_CODEC_FRAME_HEADER_SIZE)
+      return SU_TRUE;
+
+    memcpy(&as_u32, bins, sizeof(uint32_t));
+    as_u32 = ntohl(as_u32);
+    memcpy(&q_offset, &as_u32, sizeof(uint32_t));
+
+    memcpy(&as_u32, bins + sizeof(uint32_t), sizeof(uint32_t));
+    as_u32 = ntohl(as_u32);
+    memcpy(&q_scale, &as_u32, sizeof(uint32_t));
+
+    bins += SUSCAN_PSD_CODEC_FRAME_HEADER_SIZE;
+    size -= SUSCAN_PSD_CODEC_FRAME_HEADER_SIZE;
+  } else if (encoding != SUSCAN_PSD_ENCODING_FLOAT32) {
+    SU_WARNING("Unsupported PSD encoding %d, fragment ignored\n", encoding);
+    return SU_TRUE;
+  }
+
+  size /= suscan_psd_encoding_get_bin_size(encoding);
 
   reallocate = 
     (full_size != self->psd_size) || (frag->fc != self->sf_header.fc);
@@ -109,10 +142,23 @@ suscli_multicast_processor_psd_on_fragment(
     return SU_TRUE;
   }
 
-  memcpy(
-    self->psd_data + offset,
-    frag->bytes,
-    size * sizeof(SUFLOAT));
+  if (suscan_psd_encoding_is_quantized(encoding)) {
+    if (!suscan_psd_dequantize(
+      encoding,
+      q_offset,
+      q_scale,
+      bins,
+      size,
+      self->psd_data + offset)) {
+      SU_WARNING("Malformed quantized PSD fragment\n");
+      return SU_TRUE;
+    }
+  } else {
+    memcpy(
+      self->psd_data + offset,
+      bins,
+      size * sizeof(SUFLOAT));
+  }
 
   /* Fragment header is updated only once */
   if (self->updates == 0)
@@ -66,78 +66,84 @@ suscan_remote_partial_pdu_state_read(
   const char *remote,
   int sfd)
 {
-  size_t chunksize;
-  size_t ret;
-  SUBOOL do_close = SU_TRUE;
+  struct suscan_analyzer_remote_pdu_header header;
+  enum suscan_remote_compression codec;
+  size_t pending, needed;
+  uint8_t *tmp;
+  ssize_t ret;
   SUBOOL ok = SU_FALSE;
 
-  if (!self->have_header) {
-    chunksize =
-        sizeof(struct suscan_analyzer_remote_pdu_header) - self->header_ptr;
+  if (self->failed)
+    goto done;
 
-    ret = read(sfd, self->header_bytes + self->header_ptr, chunksize);
+  pending = self->rx_tail - self->rx_head;
 
-    if (ret == 0) {
-      SU_INFO("%s: peer left\n", remote);
-    } else if (ret == -1) {
-      SU_INFO("%s: read error: %s\n", remote, strerror(errno));
-    } else {
-      do_close = SU_FALSE;
-    }
+  /* Move the PDUs not taken yet to the beginning of the buffer */
+  if (self->rx_head > 0) {
+    if (pending > 0)
+      memmove(self->rx_buffer, self->rx_buffer + self->rx_head, pending);
 
-    if (do_close)
-      goto done;
+    self->rx_checked -= self->rx_head;
+    self->rx_tail     = pending;
+    self->rx_head     = 0;
+  }
 
-    self->header_ptr += ret;
+  /*
+   * Keep some free room for the next read, doubling the buffer if needed.
+   * The buffer grows with the data actually received, never with the PDU
+   * size announced by the peer: otherwise, a single (unauthenticated)
+   * header would be enough to make us allocate SUSCAN_REMOTE_MAX_PDU_SIZE.
+   */
+  if (self->rx_alloc - self->rx_tail < SUSCAN_REMOTE_RX_BUFFER_MIN_FREE) {
+    needed = 2 * self->rx_alloc;
+    if (needed < self->rx_tail + SUSCAN_REMOTE_RX_BUFFER_MIN_FREE)
+      needed = self->rx_tail + SUSCAN_REMOTE_RX_BUFFER_MIN_FREE;
+
+    SU_TRYCATCH(tmp = realloc(self->rx_buffer, needed), goto done);
+    self->rx_buffer = tmp;
+    self->rx_alloc  = needed;
+  }
 
-    if (self->header_ptr == sizeof(struct suscan_analyzer_remote_pdu_header)) {
-      /* Full header received */
-      self->header.magic = ntohl(self->header.magic);
-      self->header.size  = ntohl(self->header.size);
-      self->header_ptr   = 0;
+  ret = read(sfd, self->rx_buffer + self->rx_tail, self->rx_alloc - self->rx_tail);
 
-      if (self->header.magic != SUSCAN_REMOTE_PDU_HEADER_MAGIC
-      && self->header.magic != SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC) {
-        SU_ERROR("Protocol error: invalid remote PDU header magic\n");
-        goto done;
-      }
+  if (ret == 0) {
+    SU_INFO("%s: peer left\n", remote);
+    goto done;
+  } else if (ret == -1) {
+    SU_INFO("%s: read error: %s\n", remote, strerror(errno));
+    goto done;
+  }
 
-      self->have_header = self->header.size != 0;
+  self->rx_tail += ret;
 
-      grow_buf_shrink(&self->incoming_pdu);
-    }
-  } else if (!self->have_body) {
-    if ((chunksize = self->header.size) > SUSCAN_REMOTE_READ_BUFFER)
-      chunksize = SUSCAN_REMOTE_READ_BUFFER;
+  /* Validate every header received so far */
+  while (self->rx_checked + sizeof(header) <= self->rx_tail) {
+    memcpy(&header, self->rx_buffer + self->rx_checked, sizeof(header));
+    header.magic = ntohl(header.magic);
+    header.size  = ntohl(header.size);
 
-    if ((ret = read(sfd, self->read_buffer, chunksize)) < 1) {
-      SU_ERROR("Failed to read from socket: %s\n", strerror(errno));
+    if (header.magic != SUSCAN_REMOTE_PDU_HEADER_MAGIC
+      && !suscan_remote_compression_from_magic(header.magic, &codec)) {
+      SU_ERROR("Protocol error: invalid remote PDU header magic\n");
       goto done;
     }
 
-    SU_TRYCATCH(
-        grow_buf_append(&self->incoming_pdu, self->read_buffer, ret) != -1,
-        goto done);
-
-    self->header.size -= ret;
-
-    if (self->header.size == 0) {
-      if (self->header.magic == SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC)
-        SU_TRYCATCH(
-          suscan_remote_inflate_pdu(&self->incoming_pdu), 
-          goto done);
-
-      grow_buf_seek(&self->incoming_pdu, 0, SEEK_SET);
-      self->have_body = SU_TRUE;
+    if (header.size > SUSCAN_REMOTE_MAX_PDU_SIZE) {
+      SU_ERROR(
+        "Protocol error: remote PDU too big (%u bytes)\n",
+        header.size);
+      goto done;
     }
-  } else {
-    SU_ERROR("BUG: Current PDU not consumed yet\n");
-    goto done;
+
+    self->rx_checked += sizeof(header) + header.size;
   }
 
   ok = SU_TRUE;
 
 done:
+  if (!ok)
+    self->failed = SU_TRUE;
+
   return ok;
 }
 
@@ -146,13 +152,40 @@ suscan_remote_partial_pdu_state_take(
   struct suscan_remote_partial_pdu_state *self,
   grow_buf_t *pdu)
 {
-  if (self->have_header && self->have_body) {
-    *pdu = self->incoming_pdu;
-    memset(&self->incoming_pdu, 0, sizeof(grow_buf_t));
+  struct suscan_analyzer_remote_pdu_header header;
+  const uint8_t *body;
+
+  while (!self->failed
+    && self->rx_head + sizeof(header) <= self->rx_tail) {
+    memcpy(&header, self->rx_buffer + self->rx_head, sizeof(header));
+    header.magic = ntohl(header.magic);
+    header.size  = ntohl(header.size);
+
+    if (self->rx_tail - self->rx_head - sizeof(header) < header.size)
+      break;
+
+    body = self->rx_buffer + self->rx_head + sizeof(header);
+    self->rx_head += sizeof(header) + header.size;
+
+    /* Empty PDUs are ignored */
+    if (header.size == 0)
+      continue;
+
+    grow_buf_finalize(pdu);
+
+    if (header.magic == SUSCAN_REMOTE_PDU_HEADER_MAGIC) {
+      grow_buf_init_loan(pdu, body, header.size, header.size);
+    } else if (!suscan_remote_decompressor_decompress_data(
+        &self->decompressor,
+        header.magic,
+        body,
+        header.size,
+        pdu)) {
+      self->failed = SU_TRUE;
+      break;
+    }
 
-    self->header_ptr  = 0;
-    self->have_header = SU_FALSE;
-    self->have_body   = SU_FALSE;
+    grow_buf_seek(pdu, 0, SEEK_SET);
 
     return SU_TRUE;
   }
@@ -164,7 +197,10 @@ void
 suscan_remote_partial_pdu_state_finalize(
   struct suscan_remote_partial_pdu_state *self)
 {
-  grow_buf_finalize(&self->incoming_pdu);
+  if (self->rx_buffer != NULL)
+    free(self->rx_buffer);
+
+  suscan_remote_decompressor_finalize(&self->decompressor);
 }
 
 SUSCAN_SERIALIZER_PROTO(suscan_analyzer_multicast_info) {
@@ -202,6 +238,9 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_server_hello) {
       suscan_analyzer_multicast_info_serialize(&self->mc_info, buffer),
       goto fail);
 
+  if (self->flags & SUSCAN_REMOTE_FLAGS_COMPRESSION)
+    SUSCAN_PACK(uint, self->compression_mask);
+
   SUSCAN_PACK_BOILERPLATE_END;
 }
 
@@ -227,6 +266,9 @@ SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_server_hello) {
       suscan_analyzer_multicast_info_deserialize(&self->mc_info, buffer),
       goto fail);
 
+  if (self->flags & SUSCAN_REMOTE_FLAGS_COMPRESSION)
+    SUSCAN_UNPACK(uint32, self->compression_mask);
+
   SUSCAN_UNPACK_BOILERPLATE_END;
 }
 
@@ -248,6 +290,15 @@ suscan_analyzer_server_hello_init(
 
   self->auth_mode = SUSCAN_REMOTE_AUTH_MODE_USER_PASSWORD;
   self->enc_type  = SUSCAN_REMOTE_ENC_TYPE_NONE;
+  self->flags     =
+    SUSCAN_REMOTE_FLAGS_PSD_ENCODING
+    | SUSCAN_REMOTE_FLAGS_PSD_DELTAS
+    | SUSCAN_REMOTE_FLAGS_COMPRESSION
+    | SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING
+    | SUSCAN_REMOTE_FLAGS_LE_ARRAYS
+    | SUSCAN_REMOTE_FLAGS_MULTI_CALL;
+
+  self->compression_mask = suscan_remote_compression_get_supported();
 
   srand(suscan_gettime_raw());
 
@@ -285,12 +336,35 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_server_client_auth) {
   SUSCAN_PACK(blob, self->sha256buf, SHA256_BLOCK_SIZE);
   SUSCAN_PACK(uint, self->flags);
 
+  if (self->flags & SUSCAN_REMOTE_FLAGS_PSD_ENCODING) {
+    SUSCAN_PACK(uint,   self->psd_codec.encoding);
+    SUSCAN_PACK(single, self->psd_codec.min_db);
+    SUSCAN_PACK(single, self->psd_codec.max_db);
+
+    if (self->flags & SUSCAN_REMOTE_FLAGS_PSD_DELTAS)
+      SUSCAN_PACK(uint, self->psd_codec.keyframe_int);
+  }
+
+  if (self->flags & SUSCAN_REMOTE_FLAGS_COMPRESSION) {
+    SUSCAN_PACK(uint, self->compression.codec);
+    SUSCAN_PACK(uint, self->compression.level);
+  }
+
+  if (self->flags & SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING) {
+    SUSCAN_PACK(uint, self->sample_codec.iq);
+    SUSCAN_PACK(uint, self->sample_codec.audio);
+  }
+
   SUSCAN_PACK_BOILERPLATE_END;
 }
 
 SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_server_client_auth) {
   SUSCAN_UNPACK_BOILERPLATE_START;
   size_t size = 0;
+  uint8_t encoding = 0;
+  uint8_t codec = 0, level = 0;
+  uint8_t iq_encoding = 0, audio_encoding = 0;
+  SUSINGLE min_db = 0, max_db = 0;
 
   SUSCAN_UNPACK(str,   self->client_name);
   SUSCAN_UNPACK(uint8, self->protocol_version_major);
@@ -305,6 +379,50 @@ SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_server_client_auth) {
 
   SUSCAN_UNPACK(uint32, self->flags);
 
+  if (self->flags & SUSCAN_REMOTE_FLAGS_PSD_ENCODING) {
+    SUSCAN_UNPACK(uint8,  encoding);
+    SUSCAN_UNPACK(single, min_db);
+    SUSCAN_UNPACK(single, max_db);
+
+    self->psd_codec.encoding = encoding;
+    self->psd_codec.min_db   = min_db;
+    self->psd_codec.max_db   = max_db;
+
+    if (self->flags & SUSCAN_REMOTE_FLAGS_PSD_DELTAS)
+      SUSCAN_UNPACK(uint32, self->psd_codec.keyframe_int);
+
+    if (!suscan_psd_codec_params_is_valid(&self->psd_codec)) {
+      SU_ERROR("Invalid PSD encoding requested by client\n");
+      goto fail;
+    }
+  }
+
+  if (self->flags & SUSCAN_REMOTE_FLAGS_COMPRESSION) {
+    SUSCAN_UNPACK(uint8, codec);
+    SUSCAN_UNPACK(uint8, level);
+
+    self->compression.codec = codec;
+    self->compression.level = level;
+
+    if (!suscan_remote_compression_params_is_valid(&self->compression)) {
+      SU_ERROR("Unsupported compression requested by client\n");
+      goto fail;
+    }
+  }
+
+  if (self->flags & SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING) {
+    SUSCAN_UNPACK(uint8, iq_encoding);
+    SUSCAN_UNPACK(uint8, audio_encoding);
+
+    self->sample_codec.iq    = iq_encoding;
+    self->sample_codec.audio = audio_encoding;
+
+    if (!suscan_sample_codec_params_is_valid(&self->sample_codec)) {
+      SU_ERROR("Invalid sample encodings requested by client\n");
+      goto fail;
+    }
+  }
+
   SUSCAN_UNPACK_BOILERPLATE_END;
 }
 
@@ -376,6 +494,7 @@ suscan_analyzer_server_client_auth_finalize(
 
 SUSCAN_SERIALIZER_PROTO(suscan_analyzer_remote_call)
 {
+  unsigned int i;
   SUSCAN_PACK_BOILERPLATE_START;
 
   SUSCAN_PACK(uint, self->type);
@@ -468,6 +587,16 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_remote_call)
     case SUSCAN_ANALYZER_REMOTE_STARTUP_ERROR:
       break;
 
+    case SUSCAN_ANALYZER_REMOTE_MULTI_CALL:
+      SUSCAN_PACK(uint, self->multi.count);
+      for (i = 0; i < self->multi.count; ++i)
+        SU_TRYCATCH(
+            suscan_analyzer_remote_call_serialize(
+                self->multi.calls + i,
+                buffer),
+            goto fail);
+      break;
+
     default:
       SU_ERROR("Invalid remote call `%d'\n", self->type);
       break;
@@ -487,12 +616,18 @@ SUSCAN_PARTIAL_DESERIALIZER_PROTO(suscan_analyzer_remote_call)
 }
 
 
-SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_remote_call)
+SUPRIVATE SUBOOL suscan_analyzer_remote_call_deserialize_multi(
+    struct suscan_analyzer_remote_call *self,
+    grow_buf_t *buffer);
+
+/* Arguments of a call whose type has already been deserialized */
+SUPRIVATE SUBOOL
+suscan_analyzer_remote_call_deserialize_args(
+    struct suscan_analyzer_remote_call *self,
+    grow_buf_t *buffer)
 {
   SUSCAN_UNPACK_BOILERPLATE_START;
 
-  SU_TRY_FAIL(suscan_analyzer_remote_call_deserialize_partial(self, buffer));
-
   switch (self->type) {
     case SUSCAN_ANALYZER_REMOTE_AUTH_INFO:
       SU_TRYCATCH(
@@ -590,6 +725,10 @@ SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_remote_call)
     case SUSCAN_ANALYZER_REMOTE_STARTUP_ERROR:
       break;
 
+    case SUSCAN_ANALYZER_REMOTE_MULTI_CALL:
+      SU_TRY_FAIL(suscan_analyzer_remote_call_deserialize_multi(self, buffer));
+      break;
+
     default:
       SU_ERROR("Invalid remote call `%d'\n", self->type);
       break;
@@ -598,6 +737,68 @@ SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_remote_call)
   SUSCAN_UNPACK_BOILERPLATE_END;
 }
 
+/*
+ * Multi-calls only contain settings (hence, they do not nest), and are
+ * either deserialized whole or not at all.
+ */
+SUPRIVATE SUBOOL
+suscan_analyzer_remote_call_deserialize_multi(
+    struct suscan_analyzer_remote_call *self,
+    grow_buf_t *buffer)
+{
+  struct suscan_analyzer_remote_call *calls = NULL;
+  uint32_t count = 0;
+  unsigned int i;
+  SUSCAN_UNPACK_BOILERPLATE_START;
+
+  SUSCAN_UNPACK(uint32, count);
+
+  if (count == 0 || count > SUSCAN_REMOTE_MULTI_CALL_MAX) {
+    SU_ERROR("Invalid multi-call size %u\n", count);
+    goto fail;
+  }
+
+  SU_ALLOCATE_MANY_FAIL(calls, count, struct suscan_analyzer_remote_call);
+
+  for (i = 0; i < count; ++i) {
+    SU_TRY_FAIL(
+        suscan_analyzer_remote_call_deserialize_partial(calls + i, buffer));
+
+    if (!suscan_analyzer_remote_call_is_setting(calls + i)) {
+      SU_ERROR("Call `%d' not allowed in multi-calls\n", calls[i].type);
+      calls[i].type = SUSCAN_ANALYZER_REMOTE_NONE;
+      goto fail;
+    }
+
+    SU_TRY_FAIL(
+        suscan_analyzer_remote_call_deserialize_args(calls + i, buffer));
+  }
+
+  self->multi.count = count;
+  self->multi.calls = calls;
+  calls = NULL;
+
+  SUSCAN_UNPACK_BOILERPLATE_FINALLY;
+
+  if (calls != NULL) {
+    for (i = 0; i < count; ++i)
+      suscan_analyzer_remote_call_finalize(calls + i);
+    free(calls);
+  }
+
+  SUSCAN_UNPACK_BOILERPLATE_RETURN;
+}
+
+SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_remote_call)
+{
+  SUSCAN_UNPACK_BOILERPLATE_START;
+
+  SU_TRY_FAIL(suscan_analyzer_remote_call_deserialize_partial(self, buffer));
+  SU_TRY_FAIL(suscan_analyzer_remote_call_deserialize_args(self, buffer));
+
+  SUSCAN_UNPACK_BOILERPLATE_END;
+}
+
 void
 suscan_analyzer_remote_call_init(
     struct suscan_analyzer_remote_call *self,
@@ -624,6 +825,97 @@ suscan_analyzer_remote_call_take_source_info(
   return SU_TRUE;
 }
 
+SUBOOL
+suscan_analyzer_remote_call_is_setting(
+    const struct suscan_analyzer_remote_call *self)
+{
+  switch (self->type) {
+    case SUSCAN_ANALYZER_REMOTE_SET_FREQUENCY:
+    case SUSCAN_ANALYZER_REMOTE_SET_GAIN:
+    case SUSCAN_ANALYZER_REMOTE_SET_ANTENNA:
+    case SUSCAN_ANALYZER_REMOTE_SET_PPM:
+    case SUSCAN_ANALYZER_REMOTE_SET_BANDWIDTH:
+    case SUSCAN_ANALYZER_REMOTE_SET_DC_REMOVE:
+    case SUSCAN_ANALYZER_REMOTE_SET_IQ_REVERSE:
+    case SUSCAN_ANALYZER_REMOTE_SET_AGC:
+    case SUSCAN_ANALYZER_REMOTE_SET_SWEEP_STRATEGY:
+    case SUSCAN_ANALYZER_REMOTE_SET_SPECTRUM_PARTITIONING:
+    case SUSCAN_ANALYZER_REMOTE_SET_HOP_RANGE:
+    case SUSCAN_ANALYZER_REMOTE_SET_REL_BANDWIDTH:
+    case SUSCAN_ANALYZER_REMOTE_SET_BUFFERING_SIZE:
+      return SU_TRUE;
+  }
+
+  return SU_FALSE;
+}
+
+SUBOOL
+suscan_analyzer_remote_call_same_setting(
+    const struct suscan_analyzer_remote_call *self,
+    const struct suscan_analyzer_remote_call *other)
+{
+  if (self->type != other->type)
+    return SU_FALSE;
+
+  if (!suscan_analyzer_remote_call_is_setting(self))
+    return SU_FALSE;
+
+  /* Gains are independent settings */
+  if (self->type == SUSCAN_ANALYZER_REMOTE_SET_GAIN)
+    return self->gain.name != NULL
+        && other->gain.name != NULL
+        && strcmp(self->gain.name, other->gain.name) == 0;
+
+  return SU_TRUE;
+}
+
+/*
+ * Size the receive buffer of the control socket so that it can hold a
+ * fraction of a second worth of PSD data. It is only ever enlarged.
+ */
+SUPRIVATE void
+suscan_remote_analyzer_update_rcvbuf(
+  suscan_remote_analyzer_t *self,
+  const struct suscan_analyzer_params *params)
+{
+  SUFLOAT rate;
+  int current, wanted;
+  socklen_t len = sizeof(int);
+
+  if (self->peer.control_fd == -1 || params->psd_update_int <= 0)
+    return;
+
+  rate = params->detector_params.window_size
+    * suscan_psd_encoding_get_bin_size(self->peer.psd_codec.encoding)
+    / params->psd_update_int;
+
+  if (rate * SUSCAN_REMOTE_RCVBUF_SECONDS > SUSCAN_REMOTE_RCVBUF_MAX)
+    wanted = SUSCAN_REMOTE_RCVBUF_MAX;
+  else if (rate * SUSCAN_REMOTE_RCVBUF_SECONDS < SUSCAN_REMOTE_RCVBUF_MIN)
+    wanted = SUSCAN_REMOTE_RCVBUF_MIN;
+  else
+    wanted = rate * SUSCAN_REMOTE_RCVBUF_SECONDS;
+
+  if (getsockopt(
+        self->peer.control_fd,
+        SOL_SOCKET,
+        SO_RCVBUF,
+        (char *) &current,
+        &len) == 0 && current >= wanted)
+    return;
+
+  if (setsockopt(
+        self->peer.control_fd,
+        SOL_SOCKET,
+        SO_RCVBUF,
+        (char *) &wanted,
+        sizeof(int)) == -1)
+    SU_WARNING(
+      "Cannot set receive buffer size to %d bytes: %s\n",
+      wanted,
+      strerror(errno));
+}
+
 SUBOOL
 suscan_analyzer_remote_call_deliver_message(
     struct suscan_analyzer_remote_call *self,
@@ -652,6 +944,10 @@ suscan_analyzer_remote_call_deliver_message(
       as_source_info = priv;
       as_source_info->permissions = old_permissions;
 
+      /* Additional sources do not change the state of the analyzer */
+      if (as_source_info->source_index != 0)
+        break;
+
       suscan_source_info_finalize(&analyzer->source_info);
 
       SU_TRYCATCH(
@@ -660,10 +956,39 @@ suscan_analyzer_remote_call_deliver_message(
 
       break;
 
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PARAMS:
+      /* PSD rate may have changed */
+      suscan_remote_analyzer_update_rcvbuf(analyzer, priv);
+      break;
+
     case SUSCAN_ANALYZER_MESSAGE_TYPE_PSD:
-      /* Timestamp is also important */
       psd_msg = priv;
-      analyzer->source_info.source_time = psd_msg->timestamp;
+
+      /* Delta frames are decoded against the previous PSD of the source */
+      if (psd_msg->frame != NULL) {
+        if (psd_msg->source_index >= SUSCAN_PSD_STREAM_MAX
+          || !suscan_psd_stream_decode(
+            analyzer->peer.psd_streams + psd_msg->source_index,
+            psd_msg->codec.encoding,
+            psd_msg->fc,
+            psd_msg->frame,
+            &psd_msg->psd_data,
+            &psd_msg->psd_size)) {
+          /* Out of sync. Drop it and wait for the next keyframe. */
+          suscan_analyzer_dispose_message(type, priv);
+          self->type = SUSCAN_ANALYZER_REMOTE_NONE;
+          priv = NULL;
+          ok = SU_TRUE;
+          goto done;
+        }
+
+        suscan_psd_frame_destroy(psd_msg->frame);
+        psd_msg->frame = NULL;
+      }
+
+      /* Timestamp is also important */
+      if (psd_msg->source_index == 0)
+        analyzer->source_info.source_time = psd_msg->timestamp;
       break;
   }
   
@@ -686,6 +1011,8 @@ done:
 void
 suscan_analyzer_remote_call_finalize(struct suscan_analyzer_remote_call *self)
 {
+  unsigned int i;
+
   switch (self->type) {
     case SUSCAN_ANALYZER_REMOTE_AUTH_INFO:
       suscan_analyzer_server_client_auth_finalize(&self->client_auth);
@@ -710,6 +1037,14 @@ suscan_analyzer_remote_call_finalize(struct suscan_analyzer_remote_call *self)
       if (self->msg.ptr != NULL)
         suscan_analyzer_dispose_message(self->msg.type, self->msg.ptr);
       break;
+
+    case SUSCAN_ANALYZER_REMOTE_MULTI_CALL:
+      if (self->multi.calls != NULL) {
+        for (i = 0; i < self->multi.count; ++i)
+          suscan_analyzer_remote_call_finalize(self->multi.calls + i);
+        free(self->multi.calls);
+      }
+      break;
   }
 
   self->type = SUSCAN_ANALYZER_REMOTE_NONE;
@@ -769,77 +1104,26 @@ done:
   return got;
 }
 
+/* One-shot zlib compression, for PDUs sent without a compressor at hand */
 SUBOOL
 suscan_remote_deflate_pdu(grow_buf_t *buffer, grow_buf_t *dest)
 {
-  z_stream stream;
-  grow_buf_t tmpbuf      = grow_buf_INITIALIZER;
+  struct suscan_remote_compressor compressor;
+  grow_buf_t tmpbuf = grow_buf_INITIALIZER;
   grow_buf_t swapbuf;
-  uint8_t *buffer_bytes  = grow_buf_get_buffer(buffer);
-  size_t   buffer_size   = grow_buf_get_size(buffer);
-  uint8_t *output        = NULL;
-  uint32_t avail_size;
-  SUBOOL   deflate_init  = SU_TRUE;
-  int      last_err      = Z_OK;
-  int      flush         = Z_NO_FLUSH;
-  SUBOOL   ok = SU_FALSE;
+  uint32_t magic;
+  SUBOOL ok = SU_FALSE;
+
+  /* Zeroed compressors are zlib compressors */
+  memset(&compressor, 0, sizeof(struct suscan_remote_compressor));
 
   if (dest == NULL)
     dest = &tmpbuf;
 
-  SU_TRYCATCH(grow_buf_get_size(dest) == 0, goto done);
-  SU_TRYCATCH(output = grow_buf_alloc(dest, sizeof(uint32_t) + 5), goto done);
-
-  /* Step 1: allocate and compress */
-  stream.zalloc   = Z_NULL;
-  stream.zfree    = Z_NULL;
-  stream.opaque   = Z_NULL;
-
-  stream.next_in   = buffer_bytes;
-  stream.avail_in  = buffer_size;
-
-  stream.next_out  = output + sizeof(uint32_t);
-  stream.avail_out = grow_buf_get_size(dest) - sizeof(uint32_t);
-
   SU_TRYCATCH(
-    deflateInit(&stream, 9) == Z_OK,
+    suscan_remote_compressor_compress(&compressor, buffer, dest, &magic),
     goto done);
 
-  deflate_init     = SU_TRUE;
-  /* Begin compression */
-  while ((last_err = deflate(&stream, flush)) == Z_OK) {
-    /* Buffer was not completely consumed, reallocate */
-
-    if (stream.avail_out == 0) {
-      avail_size = grow_buf_get_size(dest);
-
-      if (avail_size > 4 * buffer_size) {
-        SU_ERROR("Compressed buffer grew beyond a reasonable size.\n");
-        goto done;
-      }
-
-      SU_TRYCATCH(
-          output = grow_buf_alloc(dest, avail_size), 
-          goto done);
-
-      /* Update stream properties */
-      stream.next_out  = output;
-      stream.avail_out = avail_size;
-    }
-
-    if (stream.total_in == buffer_size)
-      flush = Z_FINISH;
-  }
-
-  SU_TRYCATCH(last_err == Z_STREAM_END, goto done);
-
-  /* TODO: Expose API!! */
-  dest->size = stream.total_out + sizeof(uint32_t);
-
-  /* Step 2: update PDU size */
-  output = grow_buf_get_buffer(dest);
-  *(uint32_t *) output = htonl(buffer_size);
-
   if (dest == &tmpbuf) {
     swapbuf = tmpbuf;
     tmpbuf  = *buffer;
@@ -849,9 +1133,7 @@ suscan_remote_deflate_pdu(grow_buf_t *buffer, grow_buf_t *dest)
   ok = SU_TRUE;
 
 done:
-  if (deflate_init)
-    deflateEnd(&stream);
-
+  suscan_remote_compressor_finalize(&compressor);
   grow_buf_finalize(&tmpbuf);
 
   return ok;
@@ -860,109 +1142,17 @@ done:
 SUBOOL
 suscan_remote_inflate_pdu(grow_buf_t *buffer)
 {
-  uint32_t cmpsize;
-  uint8_t *cmpbytes;
-  uint32_t size;
-  z_stream stream;
-  uint8_t *output;
-  uint32_t out_alloc;
-  grow_buf_t swapbuf;
-  grow_buf_t tmpbuf = grow_buf_INITIALIZER;
-  int last_err;
-  int flush = Z_NO_FLUSH;
-  SUBOOL inflate_init = SU_FALSE;
-  SUBOOL ok = SU_FALSE;
-
-  cmpsize  = grow_buf_get_size(buffer);
-  cmpbytes = grow_buf_get_buffer(buffer);
-
-  if (cmpsize <= sizeof(uint32_t)) {
-    SU_ERROR("Compressed frame too short\n");
-    goto done;
-  }
-
-  size = ntohl(*(uint32_t *) cmpbytes);
-
-  cmpsize  -= sizeof(uint32_t);
-  cmpbytes += sizeof(uint32_t);
-
-  /* Initialize buffers */
-  stream.zalloc = Z_NULL;
-  stream.zfree  = Z_NULL;
-  stream.opaque = Z_NULL;
-
-  out_alloc = cmpsize;
-  
-  SU_TRYCATCH(
-    output = grow_buf_alloc(&tmpbuf, out_alloc), 
-    goto done);
+  struct suscan_remote_decompressor decompressor;
+  SUBOOL ok;
 
-  stream.next_in   = cmpbytes;
-  stream.avail_in  = cmpsize;
+  memset(&decompressor, 0, sizeof(struct suscan_remote_decompressor));
 
-  stream.next_out  = output;
-  stream.avail_out = out_alloc;
+  ok = suscan_remote_decompressor_decompress(
+    &decompressor,
+    SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC,
+    buffer);
 
-  /* Initialize inflate */
-  SU_TRYCATCH(inflateInit(&stream) == Z_OK, goto done);
-  inflate_init     = SU_TRUE;
-
-  /* Begin decompression */
-  while ((last_err = inflate(&stream, flush)) == Z_OK) {
-    if (stream.avail_out == 0) {
-      /* Buffer was not completely consumed, reallocate */
-      out_alloc = grow_buf_get_size(&tmpbuf);
-
-      if (grow_buf_get_size(&tmpbuf) + out_alloc > size)
-        out_alloc = size - grow_buf_get_size(&tmpbuf);
-
-      if (out_alloc > 0) {
-        SU_TRYCATCH(
-        output = grow_buf_alloc(&tmpbuf, out_alloc), 
-        goto done);
-      } else {
-        output = Z_NULL;
-      }
-      
-      stream.next_out  = output;
-      stream.avail_out = out_alloc;
-    }
-
-    if (stream.total_in == cmpsize)
-      flush = Z_FINISH;
-  }
-
-  if (last_err != Z_STREAM_END) {
-    SU_ERROR(
-      "Inflate error %d (%d/%d bytes decompressed, corrupted data?)\n", 
-      last_err,
-      stream.total_out,
-      size);
-    SU_ERROR("%02x %02x %02x %02x\n", cmpbytes[0], cmpbytes[1], cmpbytes[2], cmpbytes[3]);
-    SU_ERROR("Consumed: %d/%d\n", cmpsize - stream.avail_in, cmpsize);
-    goto done;
-  }
-
-  if (size != stream.total_out) {
-    SU_ERROR(
-      "Inflated packet size mismatch (%d != %d)\n", 
-      stream.total_out, 
-      size);
-    goto done;
-  }
-
-  /* Swap these */
-  swapbuf = *buffer;
-  *buffer = tmpbuf;
-  tmpbuf  = swapbuf;
-
-  ok = SU_TRUE;
-
-done:
-  if (inflate_init)
-    inflateEnd(&stream);
-
-  grow_buf_finalize(&tmpbuf);
+  suscan_remote_decompressor_finalize(&decompressor);
 
   return ok;
 }
@@ -976,11 +1166,15 @@ suscan_remote_read_pdu(
 {
   uint32_t chunksiz;
   struct suscan_analyzer_remote_pdu_header header;
+  struct suscan_remote_decompressor decompressor;
+  enum suscan_remote_compression codec;
   SUBOOL compressed = SU_FALSE;
   void *chunk;
   size_t got;
   SUBOOL ok = SU_FALSE;
 
+  memset(&decompressor, 0, sizeof(struct suscan_remote_decompressor));
+
   grow_buf_clear(buffer);
 
   /* Attempt to read header */
@@ -1005,17 +1199,13 @@ suscan_remote_read_pdu(
   header.size  = ntohl(header.size);
   header.magic = ntohl(header.magic);
 
-  switch (header.magic) {
-    case SUSCAN_REMOTE_PDU_HEADER_MAGIC:
-      break;
-
-    case SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC:
-      compressed = SU_TRUE;
-      break;
-
-    default:
+  if (header.magic != SUSCAN_REMOTE_PDU_HEADER_MAGIC) {
+    if (!suscan_remote_compression_from_magic(header.magic, &codec)) {
       SU_ERROR("Protocol error (unrecognized PDU magic)\n");
       goto done;
+    }
+
+    compressed = SU_TRUE;
   }
 
   /* Start to read */
@@ -1051,11 +1241,18 @@ suscan_remote_read_pdu(
   }
 
   if (compressed)
-    SU_TRYCATCH(suscan_remote_inflate_pdu(buffer), goto done);
+    SU_TRYCATCH(
+      suscan_remote_decompressor_decompress(
+        &decompressor,
+        header.magic,
+        buffer),
+      goto done);
     
   ok = SU_TRUE;
 
 done:
+  suscan_remote_decompressor_finalize(&decompressor);
+
   return ok;
 }
 
@@ -1153,7 +1350,7 @@ suscan_remote_analyzer_receive_call(
 {
   struct suscan_analyzer_remote_call *call = NULL, *qcall = NULL;
   uint32_t type;
-  uint8_t *read_buf = self->peer.pdu_state.read_buffer;
+  uint8_t read_buf[SUSCAN_REMOTE_READ_BUFFER];
   struct sockaddr_in addr;
   grow_buf_t buf = grow_buf_INITIALIZER;
   int n = 2, active;
@@ -1195,6 +1392,20 @@ suscan_remote_analyzer_receive_call(
       break;
     }
 
+    /* PDUs left in the receive buffer by the last read */
+    if (suscan_remote_partial_pdu_state_take(&self->peer.pdu_state, &buf)) {
+      call = suscan_remote_analyzer_acquire_call(
+            self,
+            SUSCAN_ANALYZER_REMOTE_NONE);
+      SU_TRY(suscan_analyzer_remote_call_deserialize(call, &buf));
+      break;
+    }
+
+    if (suscan_remote_partial_pdu_state_is_failed(&self->peer.pdu_state)) {
+      SU_ERROR("Protocol error: failed to decompress remote PDU\n");
+      goto done;
+    }
+
     /* No calls. Wait for data. */
     SU_TRYC(active = poll(fds, n, timeout_ms));
 
@@ -1206,23 +1417,13 @@ suscan_remote_analyzer_receive_call(
     if (fds[0].revents & POLLIN)
       return NULL;
 
-    /* Data from the control socket */
-    if (fds[1].revents & POLLIN) {
+    /* Data from the control socket. Complete PDUs are taken above. */
+    if (fds[1].revents & POLLIN)
       SU_TRY(suscan_remote_partial_pdu_state_read(
         &self->peer.pdu_state,
         self->peer.hostname,
         sfd));
 
-      /* Complete PDU */
-      if (suscan_remote_partial_pdu_state_take(&self->peer.pdu_state, &buf)) {
-          call = suscan_remote_analyzer_acquire_call(
-                self,
-                SUSCAN_ANALYZER_REMOTE_NONE);
-          SU_TRY(suscan_analyzer_remote_call_deserialize(call, &buf));
-          break;
-      }
-    }
-
     /* Data from the multicast interface */
     if (n > 2 && (fds[2].revents & POLLIN)) {
       ret = recvfrom(
@@ -1396,6 +1597,7 @@ suscan_remote_analyzer_auth_peer(suscan_remote_analyzer_t *self)
   struct suscan_analyzer_remote_call *call = NULL;
   struct suscan_analyzer_server_hello hello;
   char hostname[64];
+  unsigned int i;
   SUBOOL write_ok = SU_FALSE;
   enum suscan_remote_analyzer_auth_result result =
       SUSCAN_REMOTE_ANALYZER_AUTH_RESULT_INVALID_SERVER;
@@ -1470,6 +1672,8 @@ suscan_remote_analyzer_auth_peer(suscan_remote_analyzer_t *self)
           SUSCAN_ANALYZER_REMOTE_AUTH_INFO),
       goto done);
 
+  self->peer.multi_call = !!(hello.flags & SUSCAN_REMOTE_FLAGS_MULTI_CALL);
+
   /* Prepare authentication message */
   (void) gethostname(hostname, sizeof(hostname));
   hostname[sizeof(hostname) - 1] = '\0';
@@ -1486,6 +1690,54 @@ suscan_remote_analyzer_auth_peer(suscan_remote_analyzer_t *self)
   if (self->peer.mc_processor != NULL)
     call->client_auth.flags |= SUSCAN_REMOTE_FLAGS_MULTICAST;
 
+  /* Arrays in either byte order are understood: ask for ours */
+  if (!SUSCAN_HOST_IS_BIG_ENDIAN
+    && (hello.flags & SUSCAN_REMOTE_FLAGS_LE_ARRAYS))
+    call->client_auth.flags |= SUSCAN_REMOTE_FLAGS_LE_ARRAYS;
+
+  /* Delta streams never survive a connection */
+  for (i = 0; i < SUSCAN_PSD_STREAM_MAX; ++i)
+    suscan_psd_stream_reset(self->peer.psd_streams + i);
+
+  if (self->peer.psd_codec.encoding != SUSCAN_PSD_ENCODING_FLOAT32) {
+    if (hello.flags & SUSCAN_REMOTE_FLAGS_PSD_ENCODING) {
+      call->client_auth.flags    |= SUSCAN_REMOTE_FLAGS_PSD_ENCODING;
+      call->client_auth.psd_codec = self->peer.psd_codec;
+
+      if (self->peer.psd_codec.keyframe_int > 0) {
+        if (hello.flags & SUSCAN_REMOTE_FLAGS_PSD_DELTAS) {
+          call->client_auth.flags |= SUSCAN_REMOTE_FLAGS_PSD_DELTAS;
+        } else {
+          SU_WARNING("Server does not support PSD deltas, disabled\n");
+          call->client_auth.psd_codec.keyframe_int = 0;
+        }
+      }
+    } else {
+      SU_WARNING("Server does not support PSD encodings, using float32\n");
+    }
+  }
+
+  if (self->peer.compression_requested) {
+    if ((hello.flags & SUSCAN_REMOTE_FLAGS_COMPRESSION)
+      && (hello.compression_mask & (1 << self->peer.compression.codec))) {
+      call->client_auth.flags      |= SUSCAN_REMOTE_FLAGS_COMPRESSION;
+      call->client_auth.compression = self->peer.compression;
+    } else {
+      SU_WARNING(
+        "Server does not support %s compression, using server defaults\n",
+        suscan_remote_compression_to_string(self->peer.compression.codec));
+    }
+  }
+
+  if (self->peer.sample_codec_requested) {
+    if (hello.flags & SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING) {
+      call->client_auth.flags       |= SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING;
+      call->client_auth.sample_codec = self->peer.sample_codec;
+    } else {
+      SU_WARNING("Server does not support sample encodings, using float32\n");
+    }
+  }
+
   write_ok = suscan_remote_analyzer_deliver_call(
       self,
       self->peer.control_fd,
@@ -1790,6 +2042,8 @@ suscan_remote_analyzer_connect_to_peer(suscan_remote_analyzer_t *self)
       break;
   }
 
+  suscan_remote_analyzer_update_rcvbuf(self, &self->parent->params);
+
   SU_TRYCATCH(
     suscan_analyzer_send_status(
         self->parent,
@@ -1866,10 +2120,50 @@ done:
   return NULL;
 }
 
+SUPRIVATE SUBOOL suscan_remote_analyzer_flush_calls(
+    suscan_remote_analyzer_t *self);
+
+SUPRIVATE SUBOOL suscan_remote_analyzer_get_flush_deadline(
+    suscan_remote_analyzer_t *self,
+    struct timeval *deadline);
+
+/*
+ * Waits for the next PDU. While deferred settings are pending, the wait
+ * ends when they are due, and they are sent right away.
+ */
+SUPRIVATE struct suscan_msg *
+suscan_remote_analyzer_tx_thread_wait(
+    suscan_remote_analyzer_t *self,
+    SUBOOL *flush_pending,
+    const struct timeval *flush_deadline)
+{
+  struct suscan_msg *msg = NULL;
+  struct timeval now, timeout;
+
+  while (*flush_pending) {
+    gettimeofday(&now, NULL);
+
+    if (!timercmp(&now, flush_deadline, <)) {
+      *flush_pending = SU_FALSE;
+      SU_TRYCATCH(suscan_remote_analyzer_flush_calls(self), return NULL);
+      break;
+    }
+
+    timersub(flush_deadline, &now, &timeout);
+    if ((msg = suscan_mq_read_msg_timeout(&self->pdu_queue, &timeout)) != NULL)
+      return msg;
+  }
+
+  return suscan_mq_read_msg(&self->pdu_queue);
+}
+
 SUPRIVATE void *
 suscan_remote_analyzer_tx_thread(void *ptr)
 {
   suscan_remote_analyzer_t *self = (suscan_remote_analyzer_t *) ptr;
+  struct suscan_msg *msg = NULL;
+  struct timeval flush_deadline;
+  SUBOOL flush_pending = SU_FALSE;
   uint32_t is_ctl = 0;
   grow_buf_t *as_growbuf = NULL;
   void *msgptr = NULL;
@@ -1885,7 +2179,14 @@ suscan_remote_analyzer_tx_thread(void *ptr)
       goto done);
   self->rx_thread_init = SU_TRUE;
 
-  while ((msgptr = suscan_mq_read(&self->pdu_queue, &is_ctl)) != NULL) {
+  while ((msg = suscan_remote_analyzer_tx_thread_wait(
+      self,
+      &flush_pending,
+      &flush_deadline)) != NULL) {
+    is_ctl = msg->type;
+    msgptr = msg->privdata;
+    suscan_msg_destroy(msg);
+
     switch (is_ctl) {
       case SU_TRUE:
       case SU_FALSE:
@@ -1904,6 +2205,14 @@ suscan_remote_analyzer_tx_thread(void *ptr)
         as_growbuf = NULL;
         break;
 
+      case SUSCAN_REMOTE_FLUSH:
+        /* Deferred settings are queued as regular PDUs once they are due */
+        SU_TRYCATCH(
+            suscan_remote_analyzer_get_flush_deadline(self, &flush_deadline),
+            goto done);
+        flush_pending = SU_TRUE;
+        break;
+
       case SUSCAN_REMOTE_HALT:
         goto done;
     }
@@ -1953,19 +2262,17 @@ suscan_remote_analyzer_release_call(
 }
 
 
-SUBOOL
-suscan_remote_analyzer_queue_call(
+SUPRIVATE SUBOOL
+suscan_remote_analyzer_queue_pdu(
     suscan_remote_analyzer_t *self,
-    struct suscan_analyzer_remote_call *call,
+    const struct suscan_analyzer_remote_call *call,
     SUBOOL is_control)
 {
   grow_buf_t *buf = NULL;
   SUBOOL ok = SU_FALSE;
 
   SU_TRYCATCH(buf = calloc(1, sizeof(grow_buf_t)), goto done);
-  SU_TRYCATCH(
-      suscan_analyzer_remote_call_serialize(&self->call, buf),
-      goto done);
+  SU_TRYCATCH(suscan_analyzer_remote_call_serialize(call, buf), goto done);
 
   SU_TRYCATCH(suscan_mq_write(&self->pdu_queue, is_control, buf), goto done);
 
@@ -1979,6 +2286,154 @@ done:
   return ok;
 }
 
+/*
+ * Settings are not sent right away: they wait for the TX thread, which
+ * sends them after SUSCAN_REMOTE_COALESCE_WINDOW_MS. In the meantime,
+ * newer values of a setting replace the older ones in place, so settings
+ * are still sent in the order they were first made. The call mutex must
+ * be held.
+ */
+SUPRIVATE SUBOOL
+suscan_remote_analyzer_defer_call_unsafe(
+    suscan_remote_analyzer_t *self,
+    struct suscan_analyzer_remote_call *call)
+{
+  struct suscan_analyzer_remote_call *tmp, *prev;
+  unsigned int i, alloc;
+  SUBOOL first = self->pending_count == 0;
+
+  for (i = 0; i < self->pending_count; ++i) {
+    prev = self->pending_calls + i;
+    if (suscan_analyzer_remote_call_same_setting(prev, call)) {
+      suscan_analyzer_remote_call_finalize(prev);
+      *prev = *call;
+      call->type = SUSCAN_ANALYZER_REMOTE_NONE;
+      return SU_TRUE;
+    }
+  }
+
+  if (self->pending_count == self->pending_alloc) {
+    alloc = self->pending_alloc > 0 ? 2 * self->pending_alloc : 8;
+    SU_TRYCATCH(
+        tmp = realloc(
+          self->pending_calls,
+          alloc * sizeof(struct suscan_analyzer_remote_call)),
+        return SU_FALSE);
+
+    self->pending_calls = tmp;
+    self->pending_alloc = alloc;
+  }
+
+  /* The pending list takes the contents of the call */
+  self->pending_calls[self->pending_count++] = *call;
+  call->type = SUSCAN_ANALYZER_REMOTE_NONE;
+
+  if (first) {
+    gettimeofday(&self->pending_since, NULL);
+    SU_TRYCATCH(
+        suscan_mq_write(&self->pdu_queue, SUSCAN_REMOTE_FLUSH, self),
+        return SU_FALSE);
+  }
+
+  return SU_TRUE;
+}
+
+/*
+ * Queues the deferred settings, as multi-calls if the server accepts
+ * them. The call mutex must be held.
+ */
+SUPRIVATE SUBOOL
+suscan_remote_analyzer_flush_calls_unsafe(suscan_remote_analyzer_t *self)
+{
+  struct suscan_analyzer_remote_call multi;
+  unsigned int i = 0, count;
+  SUBOOL ok = SU_FALSE;
+
+  while (i < self->pending_count) {
+    count = 1;
+    if (self->peer.multi_call)
+      count = SU_MIN(self->pending_count - i, SUSCAN_REMOTE_MULTI_CALL_MAX);
+
+    if (count > 1) {
+      suscan_analyzer_remote_call_init(
+          &multi,
+          SUSCAN_ANALYZER_REMOTE_MULTI_CALL);
+      multi.multi.count = count;
+      multi.multi.calls = self->pending_calls + i;
+
+      SU_TRY(suscan_remote_analyzer_queue_pdu(self, &multi, SU_TRUE));
+    } else {
+      SU_TRY(
+          suscan_remote_analyzer_queue_pdu(
+            self,
+            self->pending_calls + i,
+            SU_TRUE));
+    }
+
+    i += count;
+  }
+
+  ok = SU_TRUE;
+
+done:
+  if (i < self->pending_count)
+    SU_WARNING(
+        "Failed to queue deferred settings, %u of them dropped\n",
+        self->pending_count - i);
+
+  for (i = 0; i < self->pending_count; ++i)
+    suscan_analyzer_remote_call_finalize(self->pending_calls + i);
+
+  self->pending_count = 0;
+
+  return ok;
+}
+
+/* Deferred settings are due SUSCAN_REMOTE_COALESCE_WINDOW_MS after the first */
+SUPRIVATE SUBOOL
+suscan_remote_analyzer_get_flush_deadline(
+    suscan_remote_analyzer_t *self,
+    struct timeval *deadline)
+{
+  struct timeval window;
+
+  window.tv_sec  = SUSCAN_REMOTE_COALESCE_WINDOW_MS / 1000;
+  window.tv_usec = (SUSCAN_REMOTE_COALESCE_WINDOW_MS % 1000) * 1000;
+
+  SU_TRYCATCH(pthread_mutex_lock(&self->call_mutex) == 0, return SU_FALSE);
+  timeradd(&self->pending_since, &window, deadline);
+  pthread_mutex_unlock(&self->call_mutex);
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+suscan_remote_analyzer_flush_calls(suscan_remote_analyzer_t *self)
+{
+  SUBOOL ok;
+
+  SU_TRYCATCH(pthread_mutex_lock(&self->call_mutex) == 0, return SU_FALSE);
+  ok = suscan_remote_analyzer_flush_calls_unsafe(self);
+  pthread_mutex_unlock(&self->call_mutex);
+
+  return ok;
+}
+
+SUBOOL
+suscan_remote_analyzer_queue_call(
+    suscan_remote_analyzer_t *self,
+    struct suscan_analyzer_remote_call *call,
+    SUBOOL is_control)
+{
+  if (suscan_analyzer_remote_call_is_setting(call))
+    return suscan_remote_analyzer_defer_call_unsafe(self, call);
+
+  /* Deferred settings go first, so that calls are never reordered */
+  SU_TRYCATCH(suscan_remote_analyzer_flush_calls_unsafe(self), return SU_FALSE);
+
+  return suscan_remote_analyzer_queue_pdu(self, call, is_control);
+}
+
 /*************************** Analyzer interface *******************************/
 SUPRIVATE void suscan_remote_analyzer_dtor(void *ptr);
 
@@ -1989,7 +2444,7 @@ suscan_remote_analyzer_consume_pdu_queue(suscan_remote_analyzer_t *self)
   uint32_t type;
 
   while (suscan_mq_poll(&self->pdu_queue, &type, (void **) &buffer)) {
-    if (type != SUSCAN_REMOTE_HALT) {
+    if (type != SUSCAN_REMOTE_HALT && type != SUSCAN_REMOTE_FLUSH) {
       grow_buf_finalize(buffer);
       free(buffer);
     }
@@ -2004,6 +2459,7 @@ suscan_remote_analyzer_ctor(suscan_analyzer_t *parent, va_list ap)
   const char *val;
   const char *portstr;
   unsigned int port;
+  unsigned int i;
 
   config = va_arg(ap, suscan_source_config_t *);
 
@@ -2080,6 +2536,117 @@ suscan_remote_analyzer_ctor(suscan_analyzer_t *parent, va_list ap)
   val = suscan_source_config_get_param(config, "mc_if");
   if (val != NULL)
     SU_TRYCATCH(new->peer.mc_if = strdup(val), goto fail);
+
+  /* Optional: PSD encoding and its dynamic range */
+  new->peer.psd_codec.encoding = SUSCAN_PSD_ENCODING_FLOAT32;
+  new->peer.psd_codec.min_db   = SUSCAN_PSD_CODEC_DEFAULT_MIN_DB;
+  new->peer.psd_codec.max_db   = SUSCAN_PSD_CODEC_DEFAULT_MAX_DB;
+
+  val = suscan_source_config_get_param(config, "psd_encoding");
+  if (val != NULL
+    && !suscan_psd_encoding_from_string(val, &new->peer.psd_codec.encoding)) {
+    SU_ERROR("Invalid PSD encoding `%s'\n", val);
+    goto fail;
+  }
+
+  val = suscan_source_config_get_param(config, "psd_min_db");
+  if (val != NULL
+    && sscanf(val, SUFLOAT_FMT, &new->peer.psd_codec.min_db) < 1) {
+    SU_ERROR("Invalid PSD dynamic range floor `%s'\n", val);
+    goto fail;
+  }
+
+  val = suscan_source_config_get_param(config, "psd_max_db");
+  if (val != NULL
+    && sscanf(val, SUFLOAT_FMT, &new->peer.psd_codec.max_db) < 1) {
+    SU_ERROR("Invalid PSD dynamic range ceiling `%s'\n", val);
+    goto fail;
+  }
+
+  /* Optional: send PSDs as deltas, with a keyframe every so many frames */
+  val = suscan_source_config_get_param(config, "psd_keyframe_int");
+  if (val != NULL
+    && sscanf(val, "%u", &new->peer.psd_codec.keyframe_int) < 1) {
+    SU_ERROR("Invalid PSD keyframe interval `%s'\n", val);
+    goto fail;
+  }
+
+  for (i = 0; i < SUSCAN_PSD_STREAM_MAX; ++i)
+    suscan_psd_stream_init(new->peer.psd_streams + i);
+
+  if (!suscan_psd_codec_params_is_valid(&new->peer.psd_codec)) {
+    SU_ERROR("Invalid PSD encoding parameters\n");
+    goto fail;
+  }
+
+  /* Optional: encodings of sample batches (any inspector / audio) */
+  new->peer.sample_codec.iq    = SUSCAN_SAMPLE_ENCODING_FLOAT32;
+  new->peer.sample_codec.audio = SUSCAN_SAMPLE_ENCODING_FLOAT32;
+
+  val = suscan_source_config_get_param(config, "sample_encoding");
+  if (val != NULL) {
+    if (!suscan_sample_encoding_from_string(
+      val,
+      &new->peer.sample_codec.iq)) {
+      SU_ERROR("Invalid sample encoding `%s'\n", val);
+      goto fail;
+    }
+
+    /* Audio inspectors follow, unless told otherwise */
+    new->peer.sample_codec.audio = new->peer.sample_codec.iq;
+    new->peer.sample_codec_requested = SU_TRUE;
+  }
+
+  val = suscan_source_config_get_param(config, "audio_encoding");
+  if (val != NULL) {
+    if (!suscan_sample_encoding_from_string(
+      val,
+      &new->peer.sample_codec.audio)) {
+      SU_ERROR("Invalid audio sample encoding `%s'\n", val);
+      goto fail;
+    }
+
+    new->peer.sample_codec_requested = SU_TRUE;
+  }
+
+  if (!suscan_sample_codec_params_is_valid(&new->peer.sample_codec)) {
+    SU_ERROR("Real sample encodings are only allowed for audio\n");
+    goto fail;
+  }
+
+  /* Optional: compression of the PDUs sent by the server */
+  new->peer.compression.codec = SUSCAN_REMOTE_COMPRESSION_ZLIB;
+  new->peer.compression.level = SUSCAN_REMOTE_COMPRESSION_DEFAULT_LEVEL;
+
+  val = suscan_source_config_get_param(config, "compression");
+  if (val != NULL) {
+    if (!suscan_remote_compression_from_string(
+      val,
+      &new->peer.compression.codec)) {
+      SU_ERROR("Invalid compression codec `%s'\n", val);
+      goto fail;
+    }
+
+    new->peer.compression_requested = SU_TRUE;
+  }
+
+  val = suscan_source_config_get_param(config, "compression_level");
+  if (val != NULL) {
+    if (sscanf(val, "%d", &new->peer.compression.level) < 1) {
+      SU_ERROR("Invalid compression level `%s'\n", val);
+      goto fail;
+    }
+
+    new->peer.compression_requested = SU_TRUE;
+  }
+
+  if (!suscan_remote_compression_params_is_valid(&new->peer.compression)) {
+    SU_ERROR(
+      "Compression `%s' (level %d) is not supported by this build\n",
+      suscan_remote_compression_to_string(new->peer.compression.codec),
+      new->peer.compression.level);
+    goto fail;
+  }
   
   SU_TRYCATCH(pthread_mutex_init(&new->call_mutex, NULL) == 0, goto fail);
   new->call_mutex_initialized = SU_TRUE;
@@ -2110,6 +2677,7 @@ suscan_remote_analyzer_dtor(void *ptr)
   suscan_remote_analyzer_t *self = (suscan_remote_analyzer_t *) ptr;
   struct suscan_analyzer_remote_call *call;
   uint32_t type;
+  unsigned int i;
   char b = 1;
 
   if (self->tx_thread_init) {
@@ -2153,6 +2721,9 @@ suscan_remote_analyzer_dtor(void *ptr)
 
   suscan_remote_partial_pdu_state_finalize(&self->peer.pdu_state);
 
+  for (i = 0; i < SUSCAN_PSD_STREAM_MAX; ++i)
+    suscan_psd_stream_finalize(self->peer.psd_streams + i);
+
   if (self->peer.mc_processor != NULL)
     suscli_multicast_processor_destroy(self->peer.mc_processor);
 
@@ -2161,6 +2732,12 @@ suscan_remote_analyzer_dtor(void *ptr)
 
   suscan_remote_analyzer_consume_pdu_queue(self);
 
+  if (self->pending_calls != NULL) {
+    for (i = 0; i < self->pending_count; ++i)
+      suscan_analyzer_remote_call_finalize(self->pending_calls + i);
+    free(self->pending_calls);
+  }
+
   if (self->cancel_pipe[0] != -1)
     close(self->cancel_pipe[0]);
 
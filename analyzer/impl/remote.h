@@ -21,6 +21,9 @@
 #define _SUSCAN_ANALYZER_IMPL_REMOTE_H
 
 #include <analyzer/analyzer.h>
+#include <analyzer/psdcodec.h>
+#include <analyzer/samplecodec.h>
+#include <analyzer/impl/pducomp.h>
 #include <sigutils/util/compat-in.h>
 #include <util/sha256.h>
 
@@ -31,16 +34,30 @@ extern "C" {
 #define SUSCAN_REMOTE_PDU_HEADER_MAGIC             0xf5005ca9
 #define SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC  0xf5005caa
 #define SUSCAN_REMOTE_FRAGMENT_HEADER_MAGIC        0xf5005cab
+#define SUSCAN_REMOTE_LZ4_PDU_HEADER_MAGIC         0xf5005cac
+#define SUSCAN_REMOTE_ZSTD_PDU_HEADER_MAGIC        0xf5005cad
 #define SUSCAN_REMOTE_ANALYZER_CONNECT_TIMEOUT_MS       30000
 #define SUSCAN_REMOTE_ANALYZER_AUTH_TIMEOUT_MS          30000
 #define SUSCAN_REMOTE_ANALYZER_PDU_BODY_TIMEOUT_MS      15000
 #define SUSCAN_REMOTE_READ_BUFFER                        1400
+#define SUSCAN_REMOTE_RX_BUFFER_MIN_FREE                (64 * 1024)
+#define SUSCAN_REMOTE_RCVBUF_MIN                       (256 * 1024)
+#define SUSCAN_REMOTE_RCVBUF_MAX                  (16 * 1024 * 1024)
+#define SUSCAN_REMOTE_RCVBUF_SECONDS                          .25
 
 #define SUSCAN_REMOTE_HALT                                  2
+#define SUSCAN_REMOTE_FLUSH                                 3
+
+/*
+ * Settings (frequency, gains...) are coalesced for this long before
+ * sending them, so only the last value of every setting is sent.
+ */
+#define SUSCAN_REMOTE_COALESCE_WINDOW_MS                   20
+#define SUSCAN_REMOTE_MULTI_CALL_MAX                       64
 
 #define SUSCAN_REMOTE_PROTOCOL_TOKEN_SIZE   SHA256_BLOCK_SIZE
 #define SUSCAN_REMOTE_PROTOCOL_MAJOR_VERSION                0
-#define SUSCAN_REMOTE_PROTOCOL_MINOR_VERSION               12
+#define SUSCAN_REMOTE_PROTOCOL_MINOR_VERSION               19
 
 #define SUSCAN_REMOTE_AUTH_MODE_NONE                        0
 #define SUSCAN_REMOTE_AUTH_MODE_USER_PASSWORD               1
@@ -48,6 +65,12 @@ extern "C" {
 #define SUSCAN_REMOTE_ENC_TYPE_NONE                         0
 
 #define SUSCAN_REMOTE_FLAGS_MULTICAST                       1
+#define SUSCAN_REMOTE_FLAGS_PSD_ENCODING                    2
+#define SUSCAN_REMOTE_FLAGS_PSD_DELTAS                      4
+#define SUSCAN_REMOTE_FLAGS_COMPRESSION                     8
+#define SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING                16
+#define SUSCAN_REMOTE_FLAGS_LE_ARRAYS                      32
+#define SUSCAN_REMOTE_FLAGS_MULTI_CALL                     64
 
 struct suscan_analyzer_remote_pdu_header {
   uint32_t magic;
@@ -76,6 +99,7 @@ enum suscan_analyzer_remote_type {
   SUSCAN_ANALYZER_REMOTE_REQ_HALT,
   SUSCAN_ANALYZER_REMOTE_AUTH_REJECTED,
   SUSCAN_ANALYZER_REMOTE_STARTUP_ERROR,
+  SUSCAN_ANALYZER_REMOTE_MULTI_CALL,
 };
 
 enum suscan_analyzer_superframe_type {
@@ -107,6 +131,15 @@ struct suscan_analyzer_psd_sf_fragment {
   uint8_t   bytes[0]; /* Remainder of the message is just PSD data */
 };
 
+/*
+ * Quantized PSD fragments (encoding != FLOAT32 in the flags) start with
+ * the offset and scale of the frame (as big-endian float32), followed by
+ * the quantized bins. This makes every fragment decodable on its own.
+ */
+#define SUSCAN_ANALYZER_PSD_SF_FLAG_LOOPED        1
+#define SUSCAN_ANALYZER_PSD_SF_ENCODING_SHIFT     8
+#define SUSCAN_ANALYZER_PSD_SF_ENCODING_MASK   0xff
+
 /*
  * Multicast support requires that every specific packet type
  * is treated spearately, since every packet uses a different
@@ -142,6 +175,9 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_server_hello) {
 
   uint32_t flags;
   struct suscan_analyzer_multicast_info mc_info;
+
+  /* Only if flags & SUSCAN_REMOTE_FLAGS_COMPRESSION */
+  uint32_t compression_mask; /* Supported codecs, 1 << codec */
 };
 
 SUBOOL suscan_analyzer_server_hello_init(
@@ -163,6 +199,16 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_server_client_auth) {
   };
 
   uint32_t flags;
+
+  /* Only if flags & SUSCAN_REMOTE_FLAGS_PSD_ENCODING. keyframe_int is
+     only transmitted if flags & SUSCAN_REMOTE_FLAGS_PSD_DELTAS */
+  struct suscan_psd_codec_params psd_codec;
+
+  /* Only if flags & SUSCAN_REMOTE_FLAGS_COMPRESSION */
+  struct suscan_remote_compression_params compression;
+
+  /* Only if flags & SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING */
+  struct suscan_sample_codec_params sample_codec;
 };
 
 void suscan_analyzer_server_compute_auth_token(
@@ -217,6 +263,12 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_remote_call) {
       uint32_t type;
       void *ptr;
     } msg;
+
+    /* Settings applied together (SUSCAN_REMOTE_FLAGS_MULTI_CALL) */
+    struct {
+      uint32_t count;
+      struct suscan_analyzer_remote_call *calls;
+    } multi;
   };
 };
 
@@ -239,6 +291,15 @@ SUBOOL suscan_analyzer_remote_call_take_source_info(
     struct suscan_analyzer_remote_call *self,
     struct suscan_source_info *info);
 
+/* Calls that just change a setting, and may be coalesced or batched */
+SUBOOL suscan_analyzer_remote_call_is_setting(
+    const struct suscan_analyzer_remote_call *self);
+
+/* Both calls change the same setting (e.g. the same gain) */
+SUBOOL suscan_analyzer_remote_call_same_setting(
+    const struct suscan_analyzer_remote_call *self,
+    const struct suscan_analyzer_remote_call *other);
+
 struct suscan_remote_analyzer;
 
 SUBOOL suscan_analyzer_remote_call_deliver_message(
@@ -274,19 +335,21 @@ size_t suscan_remote_read(
 
 struct suscli_multicast_processor;
 
+/*
+ * Buffered PDU reader. Reads take as much as the socket has to offer, and
+ * complete PDUs are parsed (and decompressed) straight from the receive
+ * buffer. The buffer is linear and compacted before every read, so that
+ * PDUs are always contiguous in memory.
+ */
 struct suscan_remote_partial_pdu_state {
-  grow_buf_t incoming_pdu;
-
-  uint8_t read_buffer[SUSCAN_REMOTE_READ_BUFFER];
-
-  union {
-    struct suscan_analyzer_remote_pdu_header header;
-    uint8_t header_bytes[0];
-  };
-
-  uint32_t header_ptr;
-  SUBOOL   have_header;
-  SUBOOL   have_body;
+  uint8_t *rx_buffer;
+  size_t   rx_alloc;
+  size_t   rx_head;    /* Start of the first PDU not taken yet */
+  size_t   rx_tail;    /* End of received data */
+  size_t   rx_checked; /* Headers before this offset have been validated */
+  SUBOOL   failed;
+
+  struct suscan_remote_decompressor decompressor;
 };
 
 SUBOOL suscan_remote_partial_pdu_state_read(
@@ -294,10 +357,22 @@ SUBOOL suscan_remote_partial_pdu_state_read(
   const char *remote,
   int sfd);
 
+/*
+ * Extracts the next complete PDU, if any. Uncompressed PDUs borrow the
+ * receive buffer, and are only valid until the next read. PDUs that
+ * cannot be decompressed leave the state failed.
+ */
 SUBOOL suscan_remote_partial_pdu_state_take(
   struct suscan_remote_partial_pdu_state *self,
   grow_buf_t *pdu);
 
+SUINLINE SUBOOL
+suscan_remote_partial_pdu_state_is_failed(
+  const struct suscan_remote_partial_pdu_state *self)
+{
+  return self->failed;
+}
+
 void suscan_remote_partial_pdu_state_finalize(
   struct suscan_remote_partial_pdu_state *self);
 
@@ -309,6 +384,17 @@ struct suscan_remote_analyzer_peer_info {
   char *password;
   char *mc_if;
 
+  struct suscan_psd_codec_params psd_codec;
+  struct suscan_psd_stream psd_streams[SUSCAN_PSD_STREAM_MAX];
+
+  /* Encodings of sample batches, if requested by the user */
+  SUBOOL sample_codec_requested;
+  struct suscan_sample_codec_params sample_codec;
+
+  /* Compression of server PDUs, if requested by the user */
+  SUBOOL compression_requested;
+  struct suscan_remote_compression_params compression;
+
   struct in_addr hostaddr;
 
   int control_fd;
@@ -322,6 +408,8 @@ struct suscan_remote_analyzer_peer_info {
   grow_buf_t read_buffer;
   grow_buf_t write_buffer;
 
+  SUBOOL multi_call; /* Server accepts multi-calls. Guarded by call_mutex */
+
   struct suscli_multicast_processor *mc_processor;
 };
 
@@ -334,6 +422,12 @@ struct suscan_remote_analyzer {
   struct suscan_source_info      source_info;
   struct suscan_analyzer_remote_call      call;
   struct suscan_remote_analyzer_peer_info peer;
+
+  /* Settings waiting for the TX thread, last value only (call_mutex) */
+  struct suscan_analyzer_remote_call *pending_calls;
+  unsigned int   pending_count;
+  unsigned int   pending_alloc;
+  struct timeval pending_since;
   struct suscan_mq pdu_queue;
 
   int cancel_pipe[2];
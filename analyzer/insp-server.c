@@ -199,10 +199,11 @@ suscan_local_analyzer_insp_from_msg(
   suscan_inspector_t *insp = NULL;
   
   insp = suscan_local_analyzer_acquire_inspector(self, msg->handle);
-  if (insp == NULL)
+  if (insp == NULL) {
     msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_WRONG_HANDLE;
-  else
+  } else {
     msg->inspector_id = suscan_inspector_get_id(insp);
+  }
 
   return insp;
 }
@@ -220,11 +221,24 @@ DEF_MSGCB(OPEN)
   SUFREQ ft;
   struct suscan_inspector_sampling_info samp_info;
   suscan_inspector_factory_t *factory = NULL;
+  const struct suscan_source_info *info = &self->source_info;
+  suscan_local_subsource_t *subsource = NULL;
   char *dup = NULL;
   unsigned int i;
   SUHANDLE handle;
   SUBOOL ok = SU_FALSE;
 
+  if (msg->source_index != 0) {
+    subsource = suscan_local_analyzer_get_subsource(self, msg->source_index);
+    if (subsource == NULL || msg->handle != -1) {
+      msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_INVALID_ARGUMENT;
+      ok = SU_TRUE;
+      goto done;
+    }
+
+    info = &subsource->source_info;
+  }
+
   if (msg->handle != -1) {
     /* Subcarrier inspector */
     insp = suscan_local_analyzer_acquire_inspector(self, msg->handle);
@@ -247,9 +261,11 @@ DEF_MSGCB(OPEN)
       goto done;
     }
   } else {
-    /* Baseband inspector */
-    fs = suscan_analyzer_get_samp_rate(self->parent);
-    ft = self->source_info.frequency;
+    /* Baseband inspector, of any of the sources */
+    fs = subsource != NULL
+      ? suscan_source_get_samp_rate(subsource->source)
+      : suscan_analyzer_get_samp_rate(self->parent);
+    ft = info->frequency;
     factory = self->insp_factory;
   }
 
@@ -258,7 +274,8 @@ DEF_MSGCB(OPEN)
     factory,
     msg->class_name,
     &msg->channel,
-    msg->precise)) == NULL) {
+    msg->precise,
+    (unsigned int) msg->source_index)) == NULL) {
     SU_ERROR("Failed to open inspector\n");
     msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_INVALID_CHANNEL;
     ok = SU_TRUE;
@@ -267,8 +284,8 @@ DEF_MSGCB(OPEN)
 
   suscan_inspector_set_throttle_factor(
     new_insp,
-    SU_ASFLOAT(self->source_info.effective_samp_rate) / 
-    SU_ASFLOAT(self->source_info.source_samp_rate));
+    SU_ASFLOAT(info->effective_samp_rate) / 
+    SU_ASFLOAT(info->source_samp_rate));
 
   handle = suscan_local_analyzer_register_inspector(self, new_insp);
   
@@ -296,16 +313,18 @@ DEF_MSGCB(OPEN)
   msg->channel.ft = ft;
 
   /* Add applicable estimators */
-  for (i = 0; i < new_insp->estimator_count; ++i) {
-    SU_TRY(dup = strdup(new_insp->estimator_list[i]->classptr->name));
+  for (i = 0; i < new_insp->estimator_engine->estimator_count; ++i) {
+    SU_TRY(
+      dup = strdup(
+        new_insp->estimator_engine->estimator_list[i]->classptr->name));
     SU_TRYC(PTR_LIST_APPEND_CHECK(msg->estimator, dup));
   }
 
   dup = NULL;
 
   /* Add applicable spectrum sources */
-  for (i = 0; i < new_insp->spectsrc_count; ++i) {
-    SU_TRY(dup = strdup(new_insp->spectsrc_list[i]->classptr->name));
+  for (i = 0; i < new_insp->spect_engine->class_count; ++i) {
+    SU_TRY(dup = strdup(new_insp->spect_engine->class_list[i]->name));
     SU_TRYC(PTR_LIST_APPEND_CHECK(msg->spectsrc, dup));
   }
 
@@ -353,9 +372,9 @@ DEF_MSGCB(ESTIMATOR)
   if ((insp = suscan_local_analyzer_insp_from_msg(self, msg)) == NULL)
     goto done;
   
-  if (msg->estimator_id < insp->estimator_count)
+  if (msg->estimator_id < insp->estimator_engine->estimator_count)
     suscan_estimator_set_enabled(
-      insp->estimator_list[msg->estimator_id],
+      insp->estimator_engine->estimator_list[msg->estimator_id],
       msg->enabled);
   else
     msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_WRONG_OBJECT;
@@ -374,7 +393,7 @@ DEF_MSGCB(SPECTRUM)
   if ((insp = suscan_local_analyzer_insp_from_msg(self, msg)) == NULL)
     goto done;
   
-  if (msg->spectsrc_id <= insp->spectsrc_count)
+  if (msg->spectsrc_id <= insp->spect_engine->class_count)
     insp->spectsrc_index = msg->spectsrc_id;
   else
     msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_WRONG_OBJECT;
@@ -497,8 +516,58 @@ DEF_MSGCB(SET_WATERMARK)
   if ((insp = suscan_local_analyzer_insp_from_msg(self, msg)) == NULL)
     goto done;
   
-  if (!suscan_inspector_set_msg_watermark(insp, msg->watermark))
-      msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_INVALID_ARGUMENT;
+  /* A zero watermark disables sample batches */
+  if (msg->watermark == 0)
+    suscan_inspector_set_sample_output(insp, SU_FALSE);
+  else if (suscan_inspector_set_msg_watermark(insp, msg->watermark))
+    suscan_inspector_set_sample_output(insp, SU_TRUE);
+  else
+    msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_INVALID_ARGUMENT;
+
+done:
+  if (insp != NULL)
+    suscan_local_analyzer_return_inspector(self, insp);
+  
+  return SU_TRUE;
+}
+
+DEF_MSGCB(SUBSCRIBE_SPECTRUM)
+{
+  suscan_inspector_t *insp = NULL;
+  uint32_t mask;
+
+  if ((insp = suscan_local_analyzer_insp_from_msg(self, msg)) == NULL)
+    goto done;
+
+  if (msg->spectsrc_id == 0
+      || msg->spectsrc_id > insp->spect_engine->class_count
+      || msg->spectsrc_id > SUSCAN_INSPECTOR_MAX_SPECTSRC_SUBSCRIPTIONS) {
+    msg->kind = SUSCAN_ANALYZER_INSPECTOR_MSGKIND_WRONG_OBJECT;
+    goto done;
+  }
+
+  /* Applied to the spectrum engine by the feed thread */
+  mask = 1u << (msg->spectsrc_id - 1);
+  if (msg->spectsrc_subscribed)
+    insp->spectsrc_subscriptions |= mask;
+  else
+    insp->spectsrc_subscriptions &= ~mask;
+
+done:
+  if (insp != NULL)
+    suscan_local_analyzer_return_inspector(self, insp);
+
+  return SU_TRUE;
+}
+
+DEF_MSGCB(SET_STALLED)
+{
+  suscan_inspector_t *insp = NULL;
+  
+  if ((insp = suscan_local_analyzer_insp_from_msg(self, msg)) == NULL)
+    goto done;
+  
+  suscan_inspector_set_consumer_stalled(insp, msg->stalled);
 
 done:
   if (insp != NULL)
@@ -717,6 +786,8 @@ suscan_insp_server_init(void)
   INIT_MSGCB(SET_TLE);
   INIT_MSGCB(RESET_EQUALIZER);
   INIT_MSGCB(SET_WATERMARK);
+  INIT_MSGCB(SET_STALLED);
+  INIT_MSGCB(SUBSCRIBE_SPECTRUM);
   INIT_MSGCB(SET_FREQ);
   INIT_MSGCB(SET_BANDWIDTH);
   INIT_MSGCB(CLOSE);
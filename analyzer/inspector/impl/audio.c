@@ -56,27 +56,70 @@ struct suscan_audio_inspector_params {
 
 #define SUSCAN_AUDIO_INSPECTOR_MIN_TS             1e-1
 
-#define SUSCAN_AUDIO_INSPECTOR_BRICKWALL_LEN      200
 #define SUSCAN_AUDIO_AM_LPF_SECONDS               .1
 #define SUSCAN_AUDIO_AM_ATTENUATION               .25
 #define SUSCAN_AUDIO_AM_CARRIER_AVERAGING_SECONDS .2
 #define SUSCAN_AUDIO_RAW_GAIN                     1e3
 #define SUSCAN_AUDIO_SQUELCH_AVG_SECONDS          1e-2
 
+#define SUSCAN_AUDIO_INSPECTOR_BLOCK_SIZE         1024
+
+/*
+ * Polyphase resampler parameters. The length of the resampling filter is
+ * given in lobes of the sinc function (at each side of the main lobe).
+ * SSB needs much more selectivity than the rest of demodulators.
+ */
+#define SUSCAN_AUDIO_RESAMPLER_PHASES             32
+#define SUSCAN_AUDIO_RESAMPLER_LOBES              8
+#define SUSCAN_AUDIO_RESAMPLER_SSB_LOBES          24
+#define SUSCAN_AUDIO_RESAMPLER_MAX_TAPS           1024
+
+/*
+ * Polyphase resampler. It combines the audio filter and the fractional
+ * sampler: the filter (a Blackman-windowed sinc) is only evaluated at the
+ * output instants, using the branch of the fractional part of the sampling
+ * time truncated to 1 / SUSCAN_AUDIO_RESAMPLER_PHASES of a sample (i.e.
+ * the nearest branch below it). Every branch is stored in reverse order,
+ * so that each output sample is a contiguous dot product against the
+ * delay line.
+ */
+struct suscan_audio_resampler {
+  SUFLOAT   *taps;        /* One branch per phase, SIZE taps each */
+  SUSCOUNT   size;
+  SUDOUBLE   step;        /* Input samples per output sample */
+  SUDOUBLE   pos;         /* Next output, relative to the first new sample */
+  SUCOMPLEX *buf;         /* size - 1 past samples + one block */
+
+  SUFLOAT    fs_in;
+  SUFLOAT    fs_out;
+  SUFLOAT    cutoff;
+  unsigned int lobes;
+};
+
+struct suscan_audio_inspector;
+
+typedef void (*suscan_audio_inspector_kernel_t) (
+  struct suscan_audio_inspector *self,
+  suscan_inspector_t *insp,
+  SUCOMPLEX *x,
+  SUSCOUNT len);
+
 struct suscan_audio_inspector {
   struct suscan_inspector_sampling_info samp_info;
   struct suscan_audio_inspector_params req_params;
   struct suscan_audio_inspector_params cur_params;
 
+  /* Demodulator kernel, selected in commit_config */
+  suscan_audio_inspector_kernel_t kernel;
+
   /* Blocks */
   su_agc_t  agc;          /* AGC, for AM-like modulations */
-  su_iir_filt_t filt;     /* Input filter */
+  struct suscan_audio_resampler resampler; /* Audio filter and resampler */
 
   su_iir_filt_t fm_lpf;   /* FM low pass filter */
 
   su_pll_t pll;           /* Carrier tracking PLL */
   su_ncqo_t lo;           /* Oscillator */
-  su_sampler_t sampler;   /* Fixed rate sampler */
 
   SUFLOAT beta;           /* Coefficient for single pole IIR filter */
   SUCOMPLEX last;         /* Last processed sample (for quad demod) */
@@ -88,8 +131,145 @@ struct suscan_audio_inspector {
   SUFLOAT am_power_carr;  /* Measure of AM power carrier */
 
   SUFLOAT ssb_power_chan; /* Measure of SSB power */
+
+  /* Work buffers */
+  SUCOMPLEX  block[SUSCAN_AUDIO_INSPECTOR_BLOCK_SIZE];
+  SUCOMPLEX *output;      /* Resampler output */
+  SUSCOUNT   output_alloc;
+  SUSCOUNT   output_ptr;  /* Pending samples start here */
+  SUSCOUNT   output_size;
 };
 
+/*************************** Polyphase resampler *****************************/
+SUPRIVATE void
+suscan_audio_resampler_finalize(struct suscan_audio_resampler *self)
+{
+  if (self->taps != NULL)
+    free(self->taps);
+
+  if (self->buf != NULL)
+    free(self->buf);
+
+  memset(self, 0, sizeof(struct suscan_audio_resampler));
+}
+
+SUPRIVATE SUBOOL
+suscan_audio_resampler_init(
+  struct suscan_audio_resampler *self,
+  SUFLOAT fs_in,
+  SUFLOAT fs_out,
+  SUFLOAT cutoff,
+  unsigned int lobes)
+{
+  SUSCOUNT size, total, m, k;
+  unsigned int phase;
+  SUFLOAT fc, t, tc, w, h;
+  SUBOOL ok = SU_FALSE;
+
+  memset(self, 0, sizeof(struct suscan_audio_resampler));
+
+  self->fs_in  = fs_in;
+  self->fs_out = fs_out;
+  self->cutoff = cutoff;
+  self->lobes  = lobes;
+
+  /* Cutoff frequency, in cycles per input sample */
+  fc = cutoff;
+  if (fc > .5 * fs_out)
+    fc = .5 * fs_out;
+  if (fc > .5 * fs_in)
+    fc = .5 * fs_in;
+  fc /= fs_in;
+
+  size = SU_CEIL(lobes / fc);
+  if (size < 2)
+    size = 2;
+  if (size > SUSCAN_AUDIO_RESAMPLER_MAX_TAPS)
+    size = SUSCAN_AUDIO_RESAMPLER_MAX_TAPS;
+
+  total = size * SUSCAN_AUDIO_RESAMPLER_PHASES;
+
+  SU_ALLOCATE_MANY(self->taps, total, SUFLOAT);
+  SU_ALLOCATE_MANY(
+    self->buf,
+    size - 1 + SUSCAN_AUDIO_INSPECTOR_BLOCK_SIZE,
+    SUCOMPLEX);
+
+  tc = .5 * (total - 1);
+
+  for (m = 0; m < total; ++m) {
+    t = (m - tc) / SUSCAN_AUDIO_RESAMPLER_PHASES; /* In input samples */
+    w = .42
+      - .5  * SU_COS(2 * M_PI * m / (total - 1))
+      + .08 * SU_COS(4 * M_PI * m / (total - 1));
+    h = 2 * fc * w;
+    if (t != 0)
+      h *= SU_SIN(2 * M_PI * fc * t) / (2 * M_PI * fc * t);
+
+    k     = m / SUSCAN_AUDIO_RESAMPLER_PHASES;
+    phase = m % SUSCAN_AUDIO_RESAMPLER_PHASES;
+
+    self->taps[phase * size + size - 1 - k] = h;
+  }
+
+  self->size = size;
+  self->step = (SUDOUBLE) fs_in / fs_out;
+
+  ok = SU_TRUE;
+
+done:
+  if (!ok)
+    suscan_audio_resampler_finalize(self);
+
+  return ok;
+}
+
+SUINLINE SUSCOUNT
+suscan_audio_resampler_max_output(const struct suscan_audio_resampler *self)
+{
+  return SU_CEIL(SUSCAN_AUDIO_INSPECTOR_BLOCK_SIZE / self->step) + 1;
+}
+
+/* Resample at most one block. Returns the number of output samples. */
+SUPRIVATE SUSCOUNT
+suscan_audio_resampler_feed(
+  struct suscan_audio_resampler *self,
+  const SUCOMPLEX *x,
+  SUSCOUNT len,
+  SUCOMPLEX *out)
+{
+  const SUFLOAT *__restrict h;
+  const SUFLOAT *__restrict v;
+  SUSCOUNT size = self->size;
+  SUSCOUNT hist = size - 1;
+  SUSCOUNT n, j, count = 0;
+  unsigned int phase;
+  SUFLOAT re, im;
+
+  memcpy(self->buf + hist, x, len * sizeof(SUCOMPLEX));
+
+  while (self->pos < len) {
+    n     = (SUSCOUNT) self->pos;
+    phase = (self->pos - n) * SUSCAN_AUDIO_RESAMPLER_PHASES;
+    h     = self->taps + phase * size;
+    v     = (const SUFLOAT *) (self->buf + n);
+    re    = im = 0;
+
+    for (j = 0; j < size; ++j) {
+      re += h[j] * v[2 * j];
+      im += h[j] * v[2 * j + 1];
+    }
+
+    out[count++] = re + I * im;
+    self->pos   += self->step;
+  }
+
+  self->pos -= len;
+  memmove(self->buf, self->buf + len, hist * sizeof(SUCOMPLEX));
+
+  return count;
+}
+
 SUPRIVATE void
 suscan_audio_inspector_params_initialize(
     struct suscan_audio_inspector_params *params,
@@ -109,7 +289,7 @@ suscan_audio_inspector_params_initialize(
 SUPRIVATE void
 suscan_audio_inspector_destroy(struct suscan_audio_inspector *insp)
 {
-  su_iir_filt_finalize(&insp->filt);
+  suscan_audio_resampler_finalize(&insp->resampler);
 
   su_iir_filt_finalize(&insp->fm_lpf);
 
@@ -117,11 +297,62 @@ suscan_audio_inspector_destroy(struct suscan_audio_inspector *insp)
 
   su_agc_finalize(&insp->agc);
 
-  su_sampler_finalize(&insp->sampler);
+  if (insp->output != NULL)
+    free(insp->output);
 
   free(insp);
 }
 
+SUPRIVATE SUBOOL
+suscan_audio_inspector_update_resampler(
+  struct suscan_audio_inspector *self,
+  const struct suscan_inspector_audio_params *params)
+{
+  struct suscan_audio_resampler resampler;
+  SUCOMPLEX *output = NULL;
+  SUSCOUNT alloc;
+  unsigned int lobes = SUSCAN_AUDIO_RESAMPLER_LOBES;
+  SUBOOL ok = SU_FALSE;
+
+  if (params->demod == SUSCAN_INSPECTOR_AUDIO_DEMOD_LSB
+      || params->demod == SUSCAN_INSPECTOR_AUDIO_DEMOD_USB)
+    lobes = SUSCAN_AUDIO_RESAMPLER_SSB_LOBES;
+
+  /* Nothing changed, keep the state of the resampler */
+  if (self->resampler.taps != NULL
+      && self->resampler.fs_out == params->sample_rate
+      && self->resampler.cutoff == params->cutoff
+      && self->resampler.lobes  == lobes)
+    return SU_TRUE;
+
+  SU_TRY(
+    suscan_audio_resampler_init(
+      &resampler,
+      self->samp_info.equiv_fs,
+      params->sample_rate,
+      params->cutoff,
+      lobes));
+
+  alloc = suscan_audio_resampler_max_output(&resampler);
+  if (alloc > self->output_alloc) {
+    if ((output = realloc(self->output, alloc * sizeof(SUCOMPLEX))) == NULL) {
+      suscan_audio_resampler_finalize(&resampler);
+      goto done;
+    }
+
+    self->output       = output;
+    self->output_alloc = alloc;
+  }
+
+  suscan_audio_resampler_finalize(&self->resampler);
+  self->resampler = resampler;
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
 SUINLINE SUBOOL
 suscan_audio_inspector_update_agc(
   struct suscan_audio_inspector *self,
@@ -158,6 +389,221 @@ done:
   return ok;
 }
 
+/**************************** Demodulator kernels ****************************/
+SUINLINE void
+suscan_audio_inspector_gain_control(
+    struct suscan_audio_inspector *self,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  SUFLOAT gain;
+  SUSCOUNT i;
+
+  switch (self->cur_params.gc.gc_ctrl) {
+    case SUSCAN_INSPECTOR_GAIN_CONTROL_MANUAL:
+      gain = 2 * self->cur_params.gc.gc_gain;
+      for (i = 0; i < len; ++i)
+        x[i] *= gain;
+      break;
+
+    case SUSCAN_INSPECTOR_GAIN_CONTROL_AUTOMATIC:
+      for (i = 0; i < len; ++i)
+        x[i] = 2 * su_agc_feed(&self->agc, x[i]);
+      break;
+  }
+}
+
+SUPRIVATE void
+suscan_audio_inspector_fm_kernel(
+    struct suscan_audio_inspector *self,
+    suscan_inspector_t *insp,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  SUCOMPLEX last, ylp;
+  SUFLOAT output;
+  SUSCOUNT i;
+
+  suscan_audio_inspector_gain_control(self, x, len);
+
+  /* Quadrature discriminator. Going backwards allows doing it in place */
+  last = x[len - 1];
+
+  for (i = len - 1; i > 0; --i)
+    x[i] *= SU_C_CONJ(x[i - 1]);
+  x[0] *= SU_C_CONJ(self->last);
+
+  self->last = last;
+
+  for (i = 0; i < len; ++i)
+    x[i] = SU_C_ARG(x[i]) / M_PI;
+
+  /*
+   * FM squelch compares the output in lower frequencies
+   * with the output of the full channel.
+   */
+  if (self->cur_params.audio.squelch) {
+    for (i = 0; i < len; ++i) {
+      output = SU_C_REAL(x[i]);
+      ylp    = su_iir_filt_feed(&self->fm_lpf, output);
+
+      SU_SPLPF_FEED(
+          self->fm_power_low,
+          SU_C_REAL(ylp * SU_C_CONJ(ylp)),
+          self->sql_alpha);
+
+      SU_SPLPF_FEED(
+          self->fm_power_chan,
+          output * output,
+          self->sql_alpha);
+
+      if (!sufreleq(self->fm_power_chan, self->fm_power_low, 1e-1))
+        x[i] = 0;
+    }
+  }
+}
+
+SUPRIVATE void
+suscan_audio_inspector_am_kernel(
+    struct suscan_audio_inspector *self,
+    suscan_inspector_t *insp,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  SUCOMPLEX last = self->last;
+  SUCOMPLEX output;
+  SUSCOUNT i;
+
+  suscan_audio_inspector_gain_control(self, x, len);
+
+  for (i = 0; i < len; ++i) {
+    /* Synchronous detection */
+    output = su_pll_track(&self->pll, x[i]);
+
+    /* Carrier removal */
+    SU_SPLPF_FEED(last, output, self->beta);
+
+    if (self->cur_params.audio.squelch) {
+      SU_SPLPF_FEED(
+          self->am_power_carr,
+          SU_C_REAL(last * SU_C_CONJ(last)),
+          self->sql_alpha);
+
+      if (self->am_power_carr < self->cur_params.audio.squelch_level)
+        output = 0;
+      else
+        output -= last;
+    } else {
+      output -= last;
+    }
+
+    /* Volume attenuation */
+    x[i] = SUSCAN_AUDIO_AM_ATTENUATION * output;
+  }
+
+  self->last = last;
+}
+
+SUINLINE void
+suscan_audio_inspector_ssb_squelch(
+    struct suscan_audio_inspector *self,
+    suscan_inspector_t *insp,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  SUFLOAT level;
+  SUSCOUNT i;
+
+  if (!self->cur_params.audio.squelch)
+    return;
+
+  /* The squelch level refers to the power spectral density */
+  level = self->cur_params.audio.squelch_level
+    * suscan_inspector_get_equiv_bw(insp)
+    / suscan_inspector_get_equiv_fs(insp);
+
+  for (i = 0; i < len; ++i) {
+    SU_SPLPF_FEED(
+        self->ssb_power_chan,
+        SU_C_REAL(x[i] * SU_C_CONJ(x[i])),
+        self->sql_alpha);
+
+    if (self->ssb_power_chan < level)
+      x[i] = 0;
+  }
+}
+
+SUPRIVATE void
+suscan_audio_inspector_usb_kernel(
+    struct suscan_audio_inspector *self,
+    suscan_inspector_t *insp,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  SUSCOUNT i;
+
+  suscan_audio_inspector_ssb_squelch(self, insp, x, len);
+  suscan_audio_inspector_gain_control(self, x, len);
+
+  for (i = 0; i < len; ++i)
+    x[i] *= su_ncqo_read(&self->lo);
+}
+
+SUPRIVATE void
+suscan_audio_inspector_lsb_kernel(
+    struct suscan_audio_inspector *self,
+    suscan_inspector_t *insp,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  SUSCOUNT i;
+
+  suscan_audio_inspector_ssb_squelch(self, insp, x, len);
+  suscan_audio_inspector_gain_control(self, x, len);
+
+  for (i = 0; i < len; ++i)
+    x[i] *= SU_C_CONJ(su_ncqo_read(&self->lo));
+}
+
+SUPRIVATE void
+suscan_audio_inspector_raw_kernel(
+    struct suscan_audio_inspector *self,
+    suscan_inspector_t *insp,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  SUSCOUNT i;
+
+  /* Pass thru */
+  for (i = 0; i < len; ++i)
+    x[i] *= SUSCAN_AUDIO_RAW_GAIN;
+}
+
+SUPRIVATE suscan_audio_inspector_kernel_t
+suscan_audio_inspector_select_kernel(
+    const struct suscan_inspector_audio_params *params)
+{
+  switch (params->demod) {
+    case SUSCAN_INSPECTOR_AUDIO_DEMOD_FM:
+      return suscan_audio_inspector_fm_kernel;
+
+    case SUSCAN_INSPECTOR_AUDIO_DEMOD_AM:
+      return suscan_audio_inspector_am_kernel;
+
+    case SUSCAN_INSPECTOR_AUDIO_DEMOD_USB:
+      return suscan_audio_inspector_usb_kernel;
+
+    case SUSCAN_INSPECTOR_AUDIO_DEMOD_LSB:
+      return suscan_audio_inspector_lsb_kernel;
+
+    case SUSCAN_INSPECTOR_AUDIO_DEMOD_RAW:
+      return suscan_audio_inspector_raw_kernel;
+
+    default:
+      return NULL;
+  }
+}
+
 SUPRIVATE struct suscan_audio_inspector *
 suscan_audio_inspector_new(const struct suscan_inspector_sampling_info *sinfo)
 {
@@ -176,11 +622,9 @@ suscan_audio_inspector_new(const struct suscan_inspector_sampling_info *sinfo)
   /* PLL init, this is an experimental optimum that works rather well for AM */
   su_pll_init(&new->pll, 0, .005f * bw);
 
-  /* Filter init */
-  SU_TRY_FAIL(su_iir_bwlpf_init(
-      &new->filt,
-      5,
-      SU_ABS2NORM_FREQ(sinfo->equiv_fs, new->cur_params.audio.cutoff)));
+  /* Audio filter and resampler init */
+  SU_TRY_FAIL(
+    suscan_audio_inspector_update_resampler(new, &new->cur_params.audio));
 
   /* NCQO init, used to sideband adjustment */
   su_ncqo_init(&new->lo, .5 * bw);
@@ -195,6 +639,8 @@ suscan_audio_inspector_new(const struct suscan_inspector_sampling_info *sinfo)
   new->sql_alpha = SU_SPLPF_ALPHA(
       SUSCAN_AUDIO_SQUELCH_AVG_SECONDS * sinfo->equiv_fs);
 
+  new->kernel = suscan_audio_inspector_select_kernel(&new->cur_params.audio);
+
   return new;
 
 fail:
@@ -289,9 +735,6 @@ suscan_audio_inspector_commit_config(void *private)
 {
   struct suscan_audio_inspector *self =
       (struct suscan_audio_inspector *) private;
-  su_iir_filt_t filt;
-  SUBOOL filt_initialized;
-  SUFLOAT fs = self->samp_info.equiv_fs;
 
   self->last  = 0;
 
@@ -304,73 +747,48 @@ suscan_audio_inspector_commit_config(void *private)
     }
   }
 
-  /* Configure demod */
-  if (self->req_params.audio.demod != SUSCAN_INSPECTOR_AUDIO_DEMOD_DISABLED) {
-    switch (self->req_params.audio.demod) {
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_FM:
-        /*
-         * FM transmissions are rather wide (up to 15 kHz), and pilot tones
-         * are at around 19 kHz. We prefer to attenuate the pilot tone instead
-         * of providing high stability at lower cutoff frequencies.
-         */
-        filt_initialized = su_iir_bwlpf_init(
-            &filt,
-            5,
-            SU_ABS2NORM_FREQ(fs, self->req_params.audio.cutoff));
-
-        break;
-
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_RAW:
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_AM:
-        /*
-         * AM transmissions are around 12 kHz (6 per sideband). In this case,
-         * it is okay to provide a filter with lower Q but stable at lower
-         * cutoff frequencies.
-         */
-        filt_initialized = su_iir_bwlpf_init(
-            &filt,
-            3,
-            SU_ABS2NORM_FREQ(fs, self->req_params.audio.cutoff));
-
-        break;
-
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_LSB:
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_USB:
-        /*
-         * SSB transmissions are usually very narrow, and require great
-         * selectivity, even at low cutoffs. We sacrifice CPU in order
-         * to attain this.
-         */
-        filt_initialized = su_iir_brickwall_lp_init(
-            &filt,
-            SUSCAN_AUDIO_INSPECTOR_BRICKWALL_LEN,
-            SU_ABS2NORM_FREQ(fs, self->req_params.audio.cutoff));
-        break;
-
-      default:
-        filt_initialized = SU_FALSE;
-        break;
-    }
-
-    if (!filt_initialized) {
-      SU_ERROR("No memory left to initialize audio filter");
-    } else {
-      su_iir_filt_finalize(&self->filt);
-      self->filt = filt;
+  /* Configure audio filter and resampler */
+  if (self->req_params.audio.demod != SUSCAN_INSPECTOR_AUDIO_DEMOD_DISABLED
+      && self->req_params.audio.sample_rate > 0) {
+    if (!suscan_audio_inspector_update_resampler(
+      self,
+      &self->req_params.audio)) {
+      SU_ERROR("No memory left to initialize audio filter\n");
     }
   }
 
-  /* Set sampling info */
-  if (self->req_params.audio.sample_rate > 0) {
-    su_sampler_finalize(&self->sampler);
-    su_sampler_init(
-        &self->sampler,
-        SU_ABS2NORM_BAUD(fs, self->req_params.audio.sample_rate));
-  }
-
   self->cur_params = self->req_params;
+  self->kernel = suscan_audio_inspector_select_kernel(&self->cur_params.audio);
 }
 
+/*
+ * Deliver output samples, but no further than the sample message
+ * watermark: the inspector loop sends a message as soon as it is reached,
+ * and the remaining samples are delivered on the next call.
+ */
+SUPRIVATE SUSCOUNT
+suscan_audio_inspector_push(
+    suscan_inspector_t *insp,
+    const SUCOMPLEX *x,
+    SUSCOUNT count)
+{
+  SUSCOUNT length = suscan_inspector_get_output_length(insp);
+
+  if (length >= insp->sample_msg_watermark)
+    return 0;
+
+  if (count > insp->sample_msg_watermark - length)
+    count = insp->sample_msg_watermark - length;
+
+  return suscan_inspector_push_sample_buffer(insp, x, count);
+}
+
+/*
+ * Audio is demodulated in blocks, by a kernel specific to the current
+ * demodulator. Gain control is applied to the whole block before the
+ * kernel runs, and the kernel output is then filtered and resampled to
+ * the audio rate by the polyphase resampler.
+ */
 SUSDIFF
 suscan_audio_inspector_feed(
     void *private,
@@ -378,141 +796,47 @@ suscan_audio_inspector_feed(
     const SUCOMPLEX *x,
     SUSCOUNT count)
 {
-  SUCOMPLEX last, det_x, output = 0;
-  SUSCOUNT i;
-  SUCOMPLEX lo;
-  SUCOMPLEX ylp;
   struct suscan_audio_inspector *self =
       (struct suscan_audio_inspector *) private;
-  SUBOOL raw = self->cur_params.audio.demod == SUSCAN_INSPECTOR_AUDIO_DEMOD_RAW;
+  SUCOMPLEX *y = self->block;
+  SUCOMPLEX *out;
+  SUFLOAT gain;
+  SUSCOUNT i, len, got;
 
-  if (self->cur_params.audio.demod == SUSCAN_INSPECTOR_AUDIO_DEMOD_DISABLED)
+  if (self->kernel == NULL)
     return count;
 
-  last = self->last;
-
-  for (i = 0; i < count && suscan_inspector_sampler_buf_avail(insp) > 0; ++i) {
-    det_x = SU_C_VALID(x[i]) ? x[i] : 0;
+  /* Deliver samples of the previous block first */
+  if (self->output_ptr < self->output_size) {
+    self->output_ptr += suscan_audio_inspector_push(
+      insp,
+      self->output + self->output_ptr,
+      self->output_size - self->output_ptr);
 
-    if (!raw
-        && self->cur_params.audio.squelch
-        && (self->cur_params.audio.demod
-              == SUSCAN_INSPECTOR_AUDIO_DEMOD_LSB
-            || self->cur_params.audio.demod
-                == SUSCAN_INSPECTOR_AUDIO_DEMOD_USB)) {
-      SU_SPLPF_FEED(
-          self->ssb_power_chan,
-          SU_C_REAL(det_x * SU_C_CONJ(det_x)),
-          self->sql_alpha);
-
-      if (self->ssb_power_chan
-          * suscan_inspector_get_equiv_fs(insp)
-            / suscan_inspector_get_equiv_bw(insp)
-            < self->cur_params.audio.squelch_level)
-        det_x = 0;
-    }
-
-    if (!raw) {
-      /* Perform gain control */
-      switch (self->cur_params.gc.gc_ctrl) {
-        case SUSCAN_INSPECTOR_GAIN_CONTROL_MANUAL:
-          det_x = 2 * self->cur_params.gc.gc_gain * det_x;
-          break;
-
-        case SUSCAN_INSPECTOR_GAIN_CONTROL_AUTOMATIC:
-          det_x  = 2 * su_agc_feed(&self->agc, det_x);
-          break;
-      }
-    }
+    if (self->output_ptr < self->output_size)
+      return 0;
+  }
 
-    switch (self->cur_params.audio.demod) {
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_FM:
-        output = SU_C_ARG(det_x * SU_C_CONJ(last)) / M_PI;
-        last   = det_x;
-
-        /*
-         * FM squelch compares the output in lower frequencies
-         * with the output of the full channel.
-         */
-        if (self->cur_params.audio.squelch) {
-          ylp = su_iir_filt_feed(&self->fm_lpf, output);
-
-          SU_SPLPF_FEED(
-              self->fm_power_low,
-              SU_C_REAL(ylp * SU_C_CONJ(ylp)),
-              self->sql_alpha);
-
-          SU_SPLPF_FEED(
-              self->fm_power_chan,
-              SU_C_REAL(output * SU_C_CONJ(output)),
-              self->sql_alpha);
-
-          if (!sufreleq(self->fm_power_chan, self->fm_power_low, 1e-1))
-            output = 0;
-        }
-
-        break;
-
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_AM:
-        /* Synchronous detection */
-        output  = su_pll_track(&self->pll, det_x);
-
-        /* Carrier removal */
-        SU_SPLPF_FEED(last, output, self->beta);
-
-        if (self->cur_params.audio.squelch) {
-          SU_SPLPF_FEED(
-              self->am_power_carr,
-              SU_C_REAL(last * SU_C_CONJ(last)),
-              self->sql_alpha);
-
-          if (self->am_power_carr < self->cur_params.audio.squelch_level)
-            output = 0;
-          else
-            output -= last;
-        } else {
-          output -= last;
-        }
-
-        /* Volume attenuation */
-        output *= SUSCAN_AUDIO_AM_ATTENUATION;
-        break;
-
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_USB:
-        lo = su_ncqo_read(&self->lo);
-        output  = det_x * lo;
-        break;
-
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_LSB:
-        lo = su_ncqo_read(&self->lo);
-        output = det_x * SU_C_CONJ(lo);
-        break;
-
-      /* Pass thru */
-      case SUSCAN_INSPECTOR_AUDIO_DEMOD_RAW:
-        output = SUSCAN_AUDIO_RAW_GAIN * det_x;
-
-      default:
-        break;
-    }
+  len = SU_MIN(count, SUSCAN_AUDIO_INSPECTOR_BLOCK_SIZE);
+  if (len == 0)
+    return 0;
 
-    output *= self->cur_params.audio.volume;
+  for (i = 0; i < len; ++i)
+    y[i] = SU_C_VALID(x[i]) ? x[i] : 0;
 
-    output = su_iir_filt_feed(&self->filt, output);
+  (self->kernel) (self, insp, y, len);
 
-    if (su_sampler_feed(&self->sampler, &output)) {
-      suscan_inspector_push_sample(insp, output * .75);
-      if (suscan_inspector_get_output_length(insp) == insp->sample_msg_watermark) {
-        ++i; /* Important! We have consumed this sample too! */
-        break;
-      }
-    }
-  }
+  out  = self->output;
+  got  = suscan_audio_resampler_feed(&self->resampler, y, len, out);
+  gain = .75 * self->cur_params.audio.volume;
 
+  for (i = 0; i < got; ++i)
+    out[i] *= gain;
 
-  self->last = last;
+  self->output_size = got;
+  self->output_ptr  = suscan_audio_inspector_push(insp, out, got);
 
-  return i;
+  return len;
 }
 
 void
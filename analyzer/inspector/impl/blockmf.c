@@ -0,0 +1,106 @@
+/*
+
+  Copyright (C) 2018 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#include <string.h>
+
+#define SU_LOG_DOMAIN "block-mf"
+
+#include <sigutils/sigutils.h>
+#include <sigutils/taps.h>
+
+#include "blockmf.h"
+
+void
+suscan_inspector_block_mf_finalize(struct suscan_inspector_block_mf *mf)
+{
+  if (mf->taps != NULL)
+    free(mf->taps);
+
+  if (mf->buf != NULL)
+    free(mf->buf);
+
+  memset(mf, 0, sizeof(struct suscan_inspector_block_mf));
+}
+
+SUBOOL
+suscan_inspector_block_mf_init(
+    struct suscan_inspector_block_mf *mf,
+    SUSCOUNT size,
+    SUSCOUNT block_size,
+    SUFLOAT T,
+    SUFLOAT beta)
+{
+  SUFLOAT *h = NULL;
+  SUSCOUNT i;
+  SUBOOL ok = SU_FALSE;
+
+  memset(mf, 0, sizeof(struct suscan_inspector_block_mf));
+
+  SU_ALLOCATE_MANY(h, size, SUFLOAT);
+  SU_ALLOCATE_MANY(mf->taps, size, SUFLOAT);
+  SU_ALLOCATE_MANY(mf->buf, size - 1 + block_size, SUCOMPLEX);
+
+  su_taps_rrc_init(h, T, beta, size);
+
+  for (i = 0; i < size; ++i)
+    mf->taps[i] = h[size - i - 1];
+
+  mf->size = size;
+
+  ok = SU_TRUE;
+
+done:
+  if (h != NULL)
+    free(h);
+
+  if (!ok)
+    suscan_inspector_block_mf_finalize(mf);
+
+  return ok;
+}
+
+void
+suscan_inspector_block_mf_feed(
+    struct suscan_inspector_block_mf *mf,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  const SUFLOAT *__restrict h = mf->taps;
+  const SUFLOAT *__restrict v;
+  SUSCOUNT size = mf->size;
+  SUSCOUNT hist = size - 1;
+  SUSCOUNT n, k;
+  SUFLOAT re, im;
+
+  memcpy(mf->buf + hist, x, len * sizeof(SUCOMPLEX));
+
+  for (n = 0; n < len; ++n) {
+    v  = (const SUFLOAT *) (mf->buf + n);
+    re = im = 0;
+
+    for (k = 0; k < size; ++k) {
+      re += h[k] * v[2 * k];
+      im += h[k] * v[2 * k + 1];
+    }
+
+    x[n] = re + I * im;
+  }
+
+  memmove(mf->buf, mf->buf + len, hist * sizeof(SUCOMPLEX));
+}
@@ -0,0 +1,52 @@
+/*
+
+  Copyright (C) 2018 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _INSPECTOR_IMPL_BLOCKMF_H
+#define _INSPECTOR_IMPL_BLOCKMF_H
+
+#include <sigutils/types.h>
+
+/*
+ * Block matched filter (Root Raised Cosine), shared by the PSK and FSK
+ * inspectors. Taps are stored in reverse order, and the delay line is
+ * kept right before the block being filtered, so that every output
+ * sample is a contiguous dot product.
+ */
+struct suscan_inspector_block_mf {
+  SUFLOAT   *taps;
+  SUSCOUNT   size;
+  SUCOMPLEX *buf;                 /* size - 1 past samples + one block */
+};
+
+SUBOOL suscan_inspector_block_mf_init(
+    struct suscan_inspector_block_mf *mf,
+    SUSCOUNT size,
+    SUSCOUNT block_size,
+    SUFLOAT T,
+    SUFLOAT beta);
+
+/* Filter at most block_size samples (as passed to init), in place */
+void suscan_inspector_block_mf_feed(
+    struct suscan_inspector_block_mf *mf,
+    SUCOMPLEX *x,
+    SUSCOUNT len);
+
+void suscan_inspector_block_mf_finalize(struct suscan_inspector_block_mf *mf);
+
+#endif /* _INSPECTOR_IMPL_BLOCKMF_H */
@@ -0,0 +1,212 @@
+/*
+
+  Copyright (C) 2018 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+/*
+ * Compares the per-sample discriminator + argument stage of the FSK
+ * inspector against the block kernels in fskdisc.h, in both discriminator
+ * modes. Reports throughput for both paths and the largest difference
+ * between their outputs, and fails if it exceeds the atan2 approximation
+ * bound. Build with -DENABLE_BENCHMARKS=ON.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fskdisc.h"
+
+#define FSK_BENCH_BLOCK_SIZE    512
+#define FSK_BENCH_SIGNAL_BLOCKS 64
+#define FSK_BENCH_PASSES        200
+#define FSK_BENCH_MAX_ERROR     2e-5
+
+struct fsk_bench_result {
+  SUFLOAT *arg;
+  double   msps;
+};
+
+SUPRIVATE SUFLOAT
+fsk_bench_noise(uint32_t *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+
+  return (SUFLOAT) (*state >> 8) / (SUFLOAT) (1u << 24) - .5f;
+}
+
+/* Random 4-FSK tones, 8 samples per symbol, with some noise and gain */
+SUPRIVATE void
+fsk_bench_make_signal(SUCOMPLEX *x, SUSCOUNT len)
+{
+  static const SUFLOAT tones[] = {-.3f, -.1f, .1f, .3f};
+  uint32_t state = 0x5eed;
+  SUFLOAT phase = 0;
+  SUFLOAT freq = 0;
+  SUSCOUNT i;
+
+  for (i = 0; i < len; ++i) {
+    if (i % 8 == 0)
+      freq = tones[(unsigned) (fsk_bench_noise(&state) * 4 + 2) & 3];
+
+    phase += (SUFLOAT) M_PI * freq;
+    x[i] = 3 * SU_C_EXP(I * phase)
+      + .1f * (fsk_bench_noise(&state) + I * fsk_bench_noise(&state));
+  }
+}
+
+SUPRIVATE double
+fsk_bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* The per-sample path, as the FSK inspector did it before block processing */
+SUPRIVATE void
+fsk_bench_scalar(
+    SUFLOAT *arg,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *last,
+    SUBOOL quad_demod)
+{
+  SUCOMPLEX prev = *last;
+  SUCOMPLEX det_x;
+  SUSCOUNT i;
+
+  for (i = 0; i < len; ++i) {
+    if (quad_demod)
+      det_x = x[i] * SU_C_CONJ(prev);
+    else
+      det_x = (x[i] * SU_C_CONJ(prev)) /
+      (.5 * (x[i] * SU_C_CONJ(x[i]) + prev * SU_C_CONJ(prev)) + 1e-8);
+
+    prev = x[i];
+    arg[i] = SU_C_ARG(det_x);
+  }
+
+  *last = prev;
+}
+
+SUPRIVATE void
+fsk_bench_block(
+    SUFLOAT *arg,
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUCOMPLEX *last,
+    SUBOOL quad_demod)
+{
+  static SUCOMPLEX disc[FSK_BENCH_BLOCK_SIZE];
+
+  suscan_fsk_discriminate(disc, x, len, last, quad_demod);
+  suscan_fsk_block_arg(arg, disc, len);
+}
+
+SUPRIVATE void
+fsk_bench_run(
+    struct fsk_bench_result *result,
+    void (*func) (SUFLOAT *, const SUCOMPLEX *, SUSCOUNT, SUCOMPLEX *, SUBOOL),
+    const SUCOMPLEX *x,
+    SUSCOUNT len,
+    SUBOOL quad_demod)
+{
+  SUCOMPLEX last;
+  SUSCOUNT i;
+  unsigned int pass;
+  double start;
+
+  start = fsk_bench_now();
+
+  for (pass = 0; pass < FSK_BENCH_PASSES; ++pass) {
+    last = 0;
+    for (i = 0; i < len; i += FSK_BENCH_BLOCK_SIZE)
+      (func) (result->arg + i, x + i, FSK_BENCH_BLOCK_SIZE, &last, quad_demod);
+  }
+
+  result->msps = 1e-6 * FSK_BENCH_PASSES * len / (fsk_bench_now() - start);
+}
+
+/* Phase difference, wrapped to [-pi, pi) */
+SUPRIVATE SUFLOAT
+fsk_bench_max_error(const SUFLOAT *a, const SUFLOAT *b, SUSCOUNT len)
+{
+  SUFLOAT err, max = 0;
+  SUSCOUNT i;
+
+  for (i = 0; i < len; ++i) {
+    err = SU_ABS(remainderf(a[i] - b[i], 2 * M_PI));
+    if (err > max)
+      max = err;
+  }
+
+  return max;
+}
+
+int
+main(int argc, char **argv)
+{
+  SUSCOUNT len = FSK_BENCH_BLOCK_SIZE * FSK_BENCH_SIGNAL_BLOCKS;
+  struct fsk_bench_result scalar, block;
+  SUCOMPLEX *x = NULL;
+  SUFLOAT err;
+  SUBOOL quad_demod;
+  SUBOOL ok = SU_TRUE;
+
+  if ((x = malloc(len * sizeof(SUCOMPLEX))) == NULL
+      || (scalar.arg = malloc(len * sizeof(SUFLOAT))) == NULL
+      || (block.arg = malloc(len * sizeof(SUFLOAT))) == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  fsk_bench_make_signal(x, len);
+
+  printf(
+      "%d-sample blocks, %lu samples x %d passes\n",
+      FSK_BENCH_BLOCK_SIZE,
+      (unsigned long) len,
+      FSK_BENCH_PASSES);
+
+  for (quad_demod = SU_FALSE; quad_demod <= SU_TRUE; ++quad_demod) {
+    fsk_bench_run(&scalar, fsk_bench_scalar, x, len, quad_demod);
+    fsk_bench_run(&block, fsk_bench_block, x, len, quad_demod);
+    err = fsk_bench_max_error(scalar.arg, block.arg, len);
+
+    printf(
+        "%-11s  scalar: %8.1f Msps  block: %8.1f Msps  (x%.2f)  "
+        "max error: %.2e rad\n",
+        quad_demod ? "quad-demod" : "normalized",
+        scalar.msps,
+        block.msps,
+        block.msps / scalar.msps,
+        err);
+
+    if (err > FSK_BENCH_MAX_ERROR)
+      ok = SU_FALSE;
+  }
+
+  free(x);
+  free(scalar.arg);
+  free(block.arg);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -33,11 +33,16 @@
 
 #include "inspector/inspector.h"
 
+#include "blockmf.h"
+#include "fskdisc.h"
+
 /* Some default FSK demodulator parameters */
 #define SUSCAN_FSK_INSPECTOR_DEFAULT_ROLL_OFF  .35
 #define SUSCAN_FSK_INSPECTOR_DEFAULT_EQ_MU     1e-3
 #define SUSCAN_FSK_INSPECTOR_DEFAULT_EQ_LENGTH 20
 #define SUSCAN_FSK_INSPECTOR_MAX_MF_SPAN       1024
+#define SUSCAN_FSK_INSPECTOR_BLOCK_SIZE        512
+#define SUSCAN_FSK_INSPECTOR_MAX_TONES         8
 
 /*
  * Spike durations measured in symbol times
@@ -59,19 +64,41 @@ struct suscan_fsk_inspector_params {
   struct suscan_inspector_fsk_params fsk;
 };
 
+/*
+ * Demodulation kernel, selected in commit_config. Stages that are not
+ * enabled are skipped for the whole block.
+ */
+struct suscan_fsk_inspector_kernel {
+  SUBOOL       agc;
+  SUFLOAT      gain;              /* Manual gain */
+  SUBOOL       quad_demod;
+  SUBOOL       mf;
+  SUBOOL       clock_detector;
+  SUBOOL       slice;
+  unsigned int tones;             /* Number of tones, for slicing */
+  SUCOMPLEX    scale;             /* Output phase and amplitude */
+  SUCOMPLEX    tone[SUSCAN_FSK_INSPECTOR_MAX_TONES]; /* Sliced symbols */
+};
+
 struct suscan_fsk_inspector {
   struct suscan_inspector_sampling_info samp_info;
   struct suscan_fsk_inspector_params req_params;
   struct suscan_fsk_inspector_params cur_params;
+  struct suscan_fsk_inspector_kernel kernel;
 
   /* Blocks */
   su_agc_t            agc;        /* AGC, for sampler */
-  su_iir_filt_t       mf;         /* Matched filter (Root Raised Cosine) */
+  struct suscan_inspector_block_mf mf; /* Matched filter (RRC) */
   su_clock_detector_t cd;         /* Clock detector */
   su_sampler_t        sampler;    /* Sampler */
-  su_ncqo_t           lo;         /* Oscillator for manual carrier offset */
   SUCOMPLEX           phase;      /* Local oscillator phase */
   SUCOMPLEX           last;       /* Last processed sample */
+
+  SUCOMPLEX           block[SUSCAN_FSK_INSPECTOR_BLOCK_SIZE];
+  SUCOMPLEX           disc[SUSCAN_FSK_INSPECTOR_BLOCK_SIZE];
+  SUCOMPLEX           symbols[SUSCAN_FSK_INSPECTOR_BLOCK_SIZE];
+  SUFLOAT             arg[SUSCAN_FSK_INSPECTOR_BLOCK_SIZE];
+  unsigned int        bin[SUSCAN_FSK_INSPECTOR_BLOCK_SIZE];
 };
 
 SUSCOUNT
@@ -87,6 +114,38 @@ suscan_fsk_inspector_mf_span(SUSCOUNT span)
   return span;
 }
 
+/*
+ * Multi-level slicing. The UI splits the circle in 2^bits_per_tone equal
+ * sectors starting at -pi, so every symbol is replaced by the center of
+ * the sector it falls in. The output phase is applied before slicing.
+ */
+SUPRIVATE void
+suscan_fsk_inspector_slice(
+    struct suscan_fsk_inspector *self,
+    SUCOMPLEX *x,
+    SUSCOUNT len)
+{
+  const struct suscan_fsk_inspector_kernel *kernel = &self->kernel;
+  const SUFLOAT *__restrict v = (const SUFLOAT *) x;
+  unsigned int *__restrict bin = self->bin;
+  SUFLOAT pc = SU_C_REAL(self->phase);
+  SUFLOAT ps = SU_C_IMAG(self->phase);
+  SUFLOAT k  = kernel->tones / (2 * M_PI);
+  int last   = kernel->tones - 1;
+  int n;
+  SUSCOUNT i;
+
+  for (i = 0; i < len; ++i) {
+    n = (int) (k * (suscan_fsk_fast_arg(
+          v[2 * i] * pc - v[2 * i + 1] * ps,
+          v[2 * i] * ps + v[2 * i + 1] * pc) + (SUFLOAT) M_PI));
+    bin[i] = n > last ? last : n;
+  }
+
+  for (i = 0; i < len; ++i)
+    x[i] = kernel->tone[bin[i]];
+}
+
 SUPRIVATE void
 suscan_fsk_inspector_params_initialize(
     struct suscan_fsk_inspector_params *params,
@@ -108,12 +167,47 @@ suscan_fsk_inspector_params_initialize(
   params->fsk.bits_per_tone = 1;
   params->fsk.quad_demod    = SU_FALSE;
   params->fsk.phase         = 0;
+  params->fsk.slice         = SU_FALSE;
+}
+
+SUPRIVATE void
+suscan_fsk_inspector_select_kernel(struct suscan_fsk_inspector *insp)
+{
+  struct suscan_fsk_inspector_kernel *kernel = &insp->kernel;
+  const struct suscan_fsk_inspector_params *params = &insp->cur_params;
+  unsigned int bits = params->fsk.bits_per_tone;
+  unsigned int i;
+
+  kernel->agc   = params->gc.gc_ctrl == SUSCAN_INSPECTOR_GAIN_CONTROL_AUTOMATIC;
+  kernel->gain  = 2 * params->gc.gc_gain;
+  kernel->quad_demod = params->fsk.quad_demod;
+  kernel->mf =
+    params->mf.mf_conf == SUSCAN_INSPECTOR_MATCHED_FILTER_MANUAL
+    && insp->mf.size > 0;
+  kernel->clock_detector =
+    params->br.br_ctrl != SUSCAN_INSPECTOR_BAUDRATE_CONTROL_MANUAL;
+
+  /* Reduce amplitude so it fits in the constellation window */
+  kernel->scale = .75 * insp->phase;
+
+  /* 2, 4 and 8-FSK */
+  if (bits < 1)
+    bits = 1;
+  else if (bits > 3)
+    bits = 3;
+
+  kernel->slice = params->fsk.slice;
+  kernel->tones = 1 << bits;
+
+  for (i = 0; i < kernel->tones; ++i)
+    kernel->tone[i] = .75 * SU_C_EXP(
+        I * (-M_PI + (2 * i + 1) * M_PI / kernel->tones));
 }
 
 SUPRIVATE void
 suscan_fsk_inspector_destroy(struct suscan_fsk_inspector *insp)
 {
-  su_iir_filt_finalize(&insp->mf);
+  suscan_inspector_block_mf_finalize(&insp->mf);
 
   su_agc_finalize(&insp->agc);
 
@@ -157,8 +251,6 @@ suscan_fsk_inspector_new(const struct suscan_inspector_sampling_info *sinfo)
           : 0),
       goto fail);
 
-  /* Initialize local oscillator */
-  su_ncqo_init(&new->lo, 0);
   new->phase = SU_C_EXP(I * new->cur_params.fsk.phase);
 
   /* Initialize AGC */
@@ -178,13 +270,16 @@ suscan_fsk_inspector_new(const struct suscan_inspector_sampling_info *sinfo)
 
   /* Initialize matched filter, with T = tau */
   SU_TRYCATCH(
-      su_iir_rrc_init(
+      suscan_inspector_block_mf_init(
           &new->mf,
           SU_CEIL(suscan_fsk_inspector_mf_span(6 * tau)),
+          SUSCAN_FSK_INSPECTOR_BLOCK_SIZE,
           SU_CEIL(tau),
           new->cur_params.mf.mf_rolloff),
       goto fail);
 
+  suscan_fsk_inspector_select_kernel(new);
+
   return new;
 
 fail:
@@ -263,7 +358,7 @@ suscan_fsk_inspector_commit_config(void *private)
   SUBOOL mf_changed;
   SUFLOAT actual_baud;
   SUFLOAT sym_period;
-  su_iir_filt_t mf = su_iir_filt_INITIALIZER;
+  struct suscan_inspector_block_mf mf;
   struct suscan_fsk_inspector *insp = (struct suscan_fsk_inspector *) private;
 
   actual_baud = insp->req_params.br.br_running
@@ -292,19 +387,31 @@ suscan_fsk_inspector_commit_config(void *private)
   
   /* Update matched filter */
   if (mf_changed && sym_period > 0) {
-    if (!su_iir_rrc_init(
+    if (!suscan_inspector_block_mf_init(
         &mf,
         SU_CEIL(suscan_fsk_inspector_mf_span(6 * sym_period)),
+        SUSCAN_FSK_INSPECTOR_BLOCK_SIZE,
         SU_CEIL(sym_period),
         insp->cur_params.mf.mf_rolloff)) {
       SU_ERROR("No memory left to update matched filter!\n");
     } else {
-      su_iir_filt_finalize(&insp->mf);
+      suscan_inspector_block_mf_finalize(&insp->mf);
       insp->mf = mf;
     }
   }
+
+  suscan_fsk_inspector_select_kernel(insp);
 }
 
+/*
+ * Samples are processed in blocks, one stage at a time. Only the AGC and
+ * the symbol synchronizer run sample by sample: the discriminator, the
+ * argument computation for the subcarrier inspector, the matched filter
+ * and the slicer are plain loops the compiler can vectorize.
+ *
+ * We are actually encoding frequency information in the phase. This
+ * is intentional, as the UI quantizes the argument of each sample.
+ */
 SUSDIFF
 suscan_fsk_inspector_feed(
     void *private,
@@ -312,69 +419,69 @@ suscan_fsk_inspector_feed(
     const SUCOMPLEX *x,
     SUSCOUNT count)
 {
-  SUSCOUNT i;
-  SUCOMPLEX const_gain = 0;
-  SUCOMPLEX det_x;
+  SUSCOUNT i, len, n = 0;
   SUCOMPLEX output;
-  SUBOOL new_sample = SU_FALSE;
-  SUCOMPLEX last = 0;
-
   struct suscan_fsk_inspector *fsk_insp =
       (struct suscan_fsk_inspector *) private;
+  const struct suscan_fsk_inspector_kernel *kernel = &fsk_insp->kernel;
+  SUCOMPLEX *y = fsk_insp->block;
+  SUCOMPLEX *d = fsk_insp->disc;
+  SUCOMPLEX *sym = fsk_insp->symbols;
+  SUFLOAT gain = kernel->gain;
+
+  /* At most one symbol per sample: the sampler buffer cannot overflow */
+  len = SU_MIN(count, suscan_inspector_sampler_buf_avail(insp));
+  if (len > SUSCAN_FSK_INSPECTOR_BLOCK_SIZE)
+    len = SUSCAN_FSK_INSPECTOR_BLOCK_SIZE;
+
+  if (len == 0)
+    return 0;
+
+  /* Perform gain control */
+  if (kernel->agc) {
+    for (i = 0; i < len; ++i)
+      y[i] = 2 * su_agc_feed(&fsk_insp->agc, x[i]);
+  } else {
+    for (i = 0; i < len; ++i)
+      y[i] = gain * x[i];
+  }
 
-  last = fsk_insp->last;
+  suscan_fsk_discriminate(d, y, len, &fsk_insp->last, kernel->quad_demod);
 
-  for (i = 0; i < count && suscan_inspector_sampler_buf_avail(insp) > 0; ++i) {
-    /* Re-center carrier */
-    det_x = x[i] * SU_C_CONJ(su_ncqo_read(&fsk_insp->lo));
+  /* Save for subcarrier inspection */
+  suscan_fsk_block_arg(fsk_insp->arg, d, len);
+  for (i = 0; i < len; ++i)
+    suscan_inspector_feed_sc_sample(insp, fsk_insp->arg[i]);
 
-    /* Perform gain control */
-    switch (fsk_insp->cur_params.gc.gc_ctrl) {
-      case SUSCAN_INSPECTOR_GAIN_CONTROL_MANUAL:
-        const_gain = 2 * fsk_insp->cur_params.gc.gc_gain * det_x;
-        break;
+  /* Add matched filter, if enabled */
+  if (kernel->mf)
+    suscan_inspector_block_mf_feed(&fsk_insp->mf, d, len);
 
-      case SUSCAN_INSPECTOR_GAIN_CONTROL_AUTOMATIC:
-        const_gain = 2 * su_agc_feed(&fsk_insp->agc, det_x);
-        break;
+  if (kernel->clock_detector) {
+    /* Automatic baudrate control enabled */
+    for (i = 0; i < len; ++i) {
+      su_clock_detector_feed(&fsk_insp->cd, d[i]);
+      if (su_clock_detector_read(&fsk_insp->cd, &output, 1) == 1)
+        sym[n++] = output;
     }
-
-    /*
-     * We are actually encoding frequency information in the phase. This
-     * is intentional, as the UI quantizes the argument of each sample.
-     */
-    if (fsk_insp->cur_params.fsk.quad_demod)
-      det_x = const_gain * SU_C_CONJ(last);
-    else
-      det_x = (const_gain * SU_C_CONJ(last)) /
-      (.5 * (const_gain * SU_C_CONJ(const_gain) + last * SU_C_CONJ(last)) + 1e-8);
-
-    last = const_gain;
-
-    /* Save for subcarrier inspection */
-    suscan_inspector_feed_sc_sample(insp, SU_C_ARG(det_x));
-
-    /* Add matched filter, if enabled */
-    if (fsk_insp->cur_params.mf.mf_conf == SUSCAN_INSPECTOR_MATCHED_FILTER_MANUAL)
-      det_x = su_iir_filt_feed(&fsk_insp->mf, det_x);
-
-    /* Check if channel sampler is enabled */
-    if (fsk_insp->cur_params.br.br_ctrl == SUSCAN_INSPECTOR_BAUDRATE_CONTROL_MANUAL) {
-      output = det_x;
-      new_sample = su_sampler_feed(&fsk_insp->sampler, &output);
-    } else {
-      /* Automatic baudrate control enabled */
-      su_clock_detector_feed(&fsk_insp->cd, det_x);
-      new_sample = su_clock_detector_read(&fsk_insp->cd, &output, 1) == 1;
+  } else {
+    for (i = 0; i < len; ++i) {
+      output = d[i];
+      if (su_sampler_feed(&fsk_insp->sampler, &output))
+        sym[n++] = output;
     }
+  }
 
-    if (new_sample)
-      suscan_inspector_push_sample(insp, output * .75 * fsk_insp->phase);
+  if (kernel->slice) {
+    suscan_fsk_inspector_slice(fsk_insp, sym, n);
+  } else {
+    for (i = 0; i < n; ++i)
+      sym[i] *= kernel->scale;
   }
 
-  fsk_insp->last = last;
+  suscan_inspector_push_sample_buffer(insp, sym, n);
 
-  return i;
+  return len;
 }
 
 void
@@ -20,19 +20,285 @@
 #define SU_LOG_DOMAIN "multicarrier-inspector"
 
 #include <sigutils/sigutils.h>
-#include <sigutils/agc.h>
-#include <sigutils/pll.h>
-#include <sigutils/sampling.h>
-#include <sigutils/iir.h>
-#include <sigutils/clock.h>
 
 #include <analyzer/version.h>
+#include <src/suscan.h>
 
 #include "inspector/interface.h"
 #include "inspector/params.h"
 #include "inspector/inspector.h"
+#include "inspector/factory.h"
 
 #include <string.h>
+#include <pthread.h>
+
+#define SUSCAN_MULTICARRIER_INSPECTOR_DEFAULT_SUBCARRIERS 64
+#define SUSCAN_MULTICARRIER_INSPECTOR_MAX_SUBCARRIERS     8192
+#define SUSCAN_MULTICARRIER_INSPECTOR_TAPS_PER_BRANCH     8
+#define SUSCAN_MULTICARRIER_INSPECTOR_BLOCK_STEPS         64
+
+/*
+ * Critically sampled polyphase FFT filter bank. The channel is split in
+ * N = size subcarriers, spaced fs / N apart and decimated by N. For every
+ * N input samples (a step), subcarrier k gets:
+ *
+ *   y_k[m] = sum_n h[n] x[mN - n] e^(j2pi kn / N)
+ *          = IDFT_k( sum_p h[r + pN] x[mN - r - pN] ),  r = 0 .. N - 1
+ *
+ * With h the low-pass prototype of length N * TAPS_PER_BRANCH. This is
+ * TAPS_PER_BRANCH multiplications plus an N-point FFT per N input
+ * samples for all the subcarriers at once. Subcarriers are numbered in
+ * FFT order: subcarrier k is centered at k * fs / N, and the ones above
+ * N / 2 are the negative frequencies.
+ */
+struct suscan_multicarrier_bank {
+  unsigned int size;                /* Subcarriers, also the decimation */
+  unsigned int length;              /* Prototype length */
+  SUFLOAT     *taps;                /* Prototype, in reverse order */
+  SUCOMPLEX   *line;                /* Delay line, stored twice */
+  SUCOMPLEX   *prod;                /* Taps times delay line */
+  unsigned int ptr;                 /* Next write position in the line */
+  unsigned int phase;               /* Samples since the last step */
+
+  SU_FFTW(_complex) *fft;
+  SU_FFTW(_plan)     plan;
+
+  /* Outputs of this block, subcarrier-major (one row per subcarrier) */
+  SUCOMPLEX   *out;
+  unsigned int steps;
+};
+
+/*
+ * Inspectors opened on a subcarrier. They are fed directly from the rows
+ * of the filter bank output, with no further channelization.
+ */
+struct suscan_multicarrier_child {
+  unsigned int        subcarrier;
+  suscan_inspector_t *insp;
+};
+
+struct suscan_multicarrier_inspector {
+  struct suscan_inspector_sampling_info samp_info;
+  struct suscan_inspector_multicarrier_params req_params;
+  struct suscan_inspector_multicarrier_params cur_params;
+
+  struct suscan_multicarrier_bank bank;
+
+  PTR_LIST(struct suscan_multicarrier_child, child);
+  pthread_mutex_t child_mutex;
+  SUBOOL          child_mutex_init;
+};
+
+/****************************** Filter bank **********************************/
+SUPRIVATE void
+suscan_multicarrier_bank_finalize(struct suscan_multicarrier_bank *self)
+{
+  if (self->plan != NULL)
+    suscan_fft_destroy_plan(self->plan);
+
+  if (self->fft != NULL)
+    SU_FFTW(_free) (self->fft);
+
+  if (self->taps != NULL)
+    free(self->taps);
+
+  if (self->line != NULL)
+    free(self->line);
+
+  if (self->prod != NULL)
+    free(self->prod);
+
+  if (self->out != NULL)
+    free(self->out);
+
+  memset(self, 0, sizeof(struct suscan_multicarrier_bank));
+}
+
+/* Blackman-windowed sinc, cut off at half the subcarrier spacing */
+SUPRIVATE void
+suscan_multicarrier_bank_init_taps(struct suscan_multicarrier_bank *self)
+{
+  unsigned int i, L = self->length;
+  SUFLOAT t, w, sinc, sum = 0;
+
+  for (i = 0; i < L; ++i) {
+    t = ((SUFLOAT) i - .5 * (L - 1)) / self->size;
+    sinc = SU_ABS(t) > 1e-6 ? SU_SIN(PI * t) / (PI * t) : 1;
+    w = .42 - .5 * SU_COS(2 * PI * i / (L - 1))
+      + .08 * SU_COS(4 * PI * i / (L - 1));
+
+    self->taps[L - 1 - i] = w * sinc;
+    sum += w * sinc;
+  }
+
+  /* Unit gain at the center of every subcarrier */
+  for (i = 0; i < L; ++i)
+    self->taps[i] /= sum;
+}
+
+SUPRIVATE SUBOOL
+suscan_multicarrier_bank_init(
+  struct suscan_multicarrier_bank *self,
+  unsigned int size)
+{
+  SUBOOL ok = SU_FALSE;
+
+  memset(self, 0, sizeof(struct suscan_multicarrier_bank));
+
+  self->size   = size;
+  self->length = size * SUSCAN_MULTICARRIER_INSPECTOR_TAPS_PER_BRANCH;
+
+  SU_ALLOCATE_MANY(self->taps, self->length, SUFLOAT);
+  SU_ALLOCATE_MANY(self->line, 2 * self->length, SUCOMPLEX);
+  SU_ALLOCATE_MANY(self->prod, self->length, SUCOMPLEX);
+  SU_ALLOCATE_MANY(
+    self->out,
+    size * SUSCAN_MULTICARRIER_INSPECTOR_BLOCK_STEPS,
+    SUCOMPLEX);
+
+  SU_TRY(self->fft = SU_FFTW(_malloc) (size * sizeof(SU_FFTW(_complex))));
+  SU_TRY(
+    self->plan = suscan_fft_plan_dft_1d(
+      size,
+      self->fft,
+      self->fft,
+      FFTW_BACKWARD));
+
+  suscan_multicarrier_bank_init_taps(self);
+
+  ok = SU_TRUE;
+
+done:
+  if (!ok)
+    suscan_multicarrier_bank_finalize(self);
+
+  return ok;
+}
+
+/* Compute the outputs of all subcarriers for the current step */
+SUPRIVATE void
+suscan_multicarrier_bank_step(struct suscan_multicarrier_bank *self)
+{
+  const SUFLOAT *__restrict h = self->taps;
+  const SUFLOAT *__restrict v = (const SUFLOAT *) (self->line + self->ptr);
+  SUFLOAT *__restrict w = (SUFLOAT *) self->prod;
+  SUCOMPLEX *fft = (SUCOMPLEX *) self->fft;
+  unsigned int N = self->size, L = self->length;
+  unsigned int i, k, r;
+
+  /* Oldest sample first: line[ptr + i] is x[mN - (L - 1 - i)] */
+  for (i = 0; i < L; ++i) {
+    w[2 * i]     = h[i] * v[2 * i];
+    w[2 * i + 1] = h[i] * v[2 * i + 1];
+  }
+
+  /* Polyphase fold: u[r] = sum_p h[r + pN] x[mN - r - pN] */
+  for (r = 0; r < N; ++r)
+    fft[r] = self->prod[L - 1 - r];
+
+  for (i = N; i < L; i += N)
+    for (r = 0; r < N; ++r)
+      fft[r] += self->prod[L - 1 - r - i];
+
+  SU_FFTW(_execute) (self->plan);
+
+  for (k = 0; k < N; ++k)
+    self->out[k * SUSCAN_MULTICARRIER_INSPECTOR_BLOCK_STEPS + self->steps]
+      = fft[k];
+
+  ++self->steps;
+}
+
+/*
+ * Feed samples until the next step is complete. Returns the number of
+ * samples consumed, and whether a step has been computed.
+ */
+SUPRIVATE SUSCOUNT
+suscan_multicarrier_bank_feed(
+  struct suscan_multicarrier_bank *self,
+  const SUCOMPLEX *x,
+  SUSCOUNT count,
+  SUBOOL *stepped)
+{
+  SUSCOUNT i, n = SU_MIN(count, self->size - self->phase);
+  unsigned int ptr = self->ptr, L = self->length;
+
+  for (i = 0; i < n; ++i) {
+    self->line[ptr] = self->line[ptr + L] = x[i];
+    if (++ptr == L)
+      ptr = 0;
+  }
+
+  self->ptr    = ptr;
+  self->phase += n;
+
+  if ((*stepped = self->phase == self->size)) {
+    self->phase = 0;
+    suscan_multicarrier_bank_step(self);
+  }
+
+  return n;
+}
+
+/***************************** Children handling *****************************/
+SUPRIVATE void
+suscan_multicarrier_inspector_feed_children(
+  struct suscan_multicarrier_inspector *self,
+  suscan_inspector_t *insp)
+{
+  suscan_inspector_factory_t *factory =
+    suscan_inspector_get_subcarrier_factory(insp);
+  struct suscan_multicarrier_child *child;
+  const SUCOMPLEX *row;
+  unsigned int i;
+  SUBOOL fed = SU_FALSE;
+
+  pthread_mutex_lock(&self->child_mutex);
+
+  for (i = 0; i < self->child_count; ++i) {
+    if ((child = self->child_list[i]) == NULL || child->insp == NULL)
+      continue;
+
+    row = self->bank.out
+      + child->subcarrier * SUSCAN_MULTICARRIER_INSPECTOR_BLOCK_STEPS;
+
+    /* This may close the child, do not touch it afterwards */
+    if (!suscan_inspector_factory_feed(
+      factory,
+      child->insp,
+      row,
+      self->bank.steps))
+      SU_WARNING("Failed to feed subcarrier inspector\n");
+
+    fed = SU_TRUE;
+  }
+
+  pthread_mutex_unlock(&self->child_mutex);
+
+  /* Rows are reused in the next block: wait for all children */
+  if (fed)
+    suscan_inspector_factory_force_sync(factory);
+}
+
+SUPRIVATE SUBOOL
+suscan_multicarrier_inspector_has_children(
+  struct suscan_multicarrier_inspector *self)
+{
+  unsigned int i;
+  SUBOOL have = SU_FALSE;
+
+  pthread_mutex_lock(&self->child_mutex);
+
+  for (i = 0; i < self->child_count; ++i)
+    if (self->child_list[i] != NULL) {
+      have = SU_TRUE;
+      break;
+    }
+
+  pthread_mutex_unlock(&self->child_mutex);
+
+  return have;
+}
 
 /************************** API implementation *******************************/
 SUPRIVATE void
@@ -40,33 +306,60 @@ suscan_inspector_multicarrier_params_initialize(
   struct suscan_inspector_multicarrier_params *self,
   const struct suscan_inspector_sampling_info *sinfo)
 {
-  self->enabled = SU_TRUE;  
+  self->enabled     = SU_TRUE;
+  self->subcarriers = SUSCAN_MULTICARRIER_INSPECTOR_DEFAULT_SUBCARRIERS;
+  self->output      = SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_NONE;
 }
 
 SUPRIVATE void
-suscan_inspector_multicarrier_params_finalize(
-  struct suscan_inspector_multicarrier_params *self)
+suscan_multicarrier_inspector_destroy(
+  struct suscan_multicarrier_inspector *self)
 {
+  unsigned int i;
+
+  for (i = 0; i < self->child_count; ++i)
+    if (self->child_list[i] != NULL)
+      free(self->child_list[i]);
+
+  if (self->child_list != NULL)
+    free(self->child_list);
+
+  if (self->child_mutex_init)
+    pthread_mutex_destroy(&self->child_mutex);
+
+  suscan_multicarrier_bank_finalize(&self->bank);
+
+  free(self);
 }
 
 void *
 suscan_multicarrier_inspector_open(const struct suscan_inspector_sampling_info *s)
 {
-  struct suscan_inspector_multicarrier_params *params = NULL;
+  struct suscan_multicarrier_inspector *new = NULL;
+  pthread_mutexattr_t attr;
+
+  SU_ALLOCATE_FAIL(new, struct suscan_multicarrier_inspector);
 
-  /* This inspector is special in that it only allocates space for its parameters */
+  new->samp_info = *s;
+  suscan_inspector_multicarrier_params_initialize(&new->cur_params, s);
+  new->req_params = new->cur_params;
 
-  SU_ALLOCATE_FAIL(params, struct suscan_inspector_multicarrier_params);
-  
-  suscan_inspector_multicarrier_params_initialize(params, s);
+  /* Children may be closed while being fed */
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  SU_TRYZ_FAIL(pthread_mutex_init(&new->child_mutex, &attr));
+  new->child_mutex_init = SU_TRUE;
 
-  return params;
+  SU_TRY_FAIL(
+    suscan_multicarrier_bank_init(
+      &new->bank,
+      new->cur_params.subcarriers));
+
+  return new;
 
 fail:
-  if (params != NULL) {
-    suscan_inspector_multicarrier_params_finalize(params);
-    free(params);
-  }
+  if (new != NULL)
+    suscan_multicarrier_inspector_destroy(new);
 
   return NULL;
 }
@@ -74,11 +367,11 @@ fail:
 SUBOOL
 suscan_multicarrier_inspector_get_config(void *private, suscan_config_t *config)
 {
-  struct suscan_inspector_multicarrier_params *params = 
-    (struct suscan_inspector_multicarrier_params *) private;
-  
+  struct suscan_multicarrier_inspector *self =
+    (struct suscan_multicarrier_inspector *) private;
+
   SU_TRYCATCH(
-    suscan_inspector_multicarrier_params_save(params, config),
+    suscan_inspector_multicarrier_params_save(&self->cur_params, config),
     return SU_FALSE);
 
   return SU_TRUE;
@@ -87,13 +380,27 @@ suscan_multicarrier_inspector_get_config(void *private, suscan_config_t *config)
 SUBOOL
 suscan_multicarrier_inspector_parse_config(void *private, const suscan_config_t *config)
 {
-  struct suscan_inspector_multicarrier_params *params = 
-    (struct suscan_inspector_multicarrier_params *) private;
+  struct suscan_multicarrier_inspector *self =
+    (struct suscan_multicarrier_inspector *) private;
+
+  suscan_inspector_multicarrier_params_initialize(
+    &self->req_params,
+    &self->samp_info);
 
   SU_TRYCATCH(
-    suscan_inspector_multicarrier_params_parse(params, config),
+    suscan_inspector_multicarrier_params_parse(&self->req_params, config),
     return SU_FALSE);
 
+  if (self->req_params.subcarriers < 2
+    || self->req_params.subcarriers
+      > SUSCAN_MULTICARRIER_INSPECTOR_MAX_SUBCARRIERS) {
+    SU_ERROR(
+      "Invalid number of subcarriers %d (must be between 2 and %d)\n",
+      self->req_params.subcarriers,
+      SUSCAN_MULTICARRIER_INSPECTOR_MAX_SUBCARRIERS);
+    return SU_FALSE;
+  }
+
   return SU_TRUE;
 }
 
@@ -101,8 +408,37 @@ suscan_multicarrier_inspector_parse_config(void *private, const suscan_config_t
 void
 suscan_multicarrier_inspector_commit_config(void *private)
 {
+  struct suscan_multicarrier_inspector *self =
+    (struct suscan_multicarrier_inspector *) private;
+  struct suscan_multicarrier_bank bank;
+  unsigned int subcarriers = self->cur_params.subcarriers;
+
+  if (self->req_params.subcarriers != subcarriers) {
+    if (suscan_multicarrier_inspector_has_children(self)) {
+      SU_WARNING(
+        "Cannot change the number of subcarriers with open subcarrier "
+        "inspectors\n");
+    } else if (!suscan_multicarrier_bank_init(
+      &bank,
+      self->req_params.subcarriers)) {
+      SU_ERROR("No memory left to update the filter bank\n");
+    } else {
+      suscan_multicarrier_bank_finalize(&self->bank);
+      self->bank  = bank;
+      subcarriers = self->req_params.subcarriers;
+    }
+  }
+
+  self->cur_params = self->req_params;
+  self->cur_params.subcarriers = subcarriers;
 }
 
+/*
+ * Samples are channelized in blocks of up to BLOCK_STEPS steps. Child
+ * inspectors get their subcarrier at the end of every block, and the
+ * subcarrier outputs (if enabled) are delivered as one vector of N
+ * values per step, in subcarrier order.
+ */
 SUSDIFF
 suscan_multicarrier_inspector_feed(
     void *private,
@@ -110,33 +446,338 @@ suscan_multicarrier_inspector_feed(
     const SUCOMPLEX *x,
     SUSCOUNT count)
 {
-  struct suscan_inspector_multicarrier_params *params = 
-    (struct suscan_inspector_multicarrier_params *) private;
-  
-  if (params->enabled) {
-    if (!suscan_inspector_feed_sc_stuner(insp, x, count)) {
-      SU_ERROR("Failed to feed samples to subcarrier\n");
-      return 0;
+  struct suscan_multicarrier_inspector *self =
+    (struct suscan_multicarrier_inspector *) private;
+  struct suscan_multicarrier_bank *bank = &self->bank;
+  enum suscan_inspector_multicarrier_output output = self->cur_params.output;
+  SUBOOL children = self->cur_params.enabled && self->child_count > 0;
+  SUCOMPLEX *vector;
+  SUSCOUNT i = 0, n, N = bank->size;
+  SUSCOUNT max_wm = SUSCAN_INSPECTOR_SAMPLER_BUF_SIZE - N;
+  SUBOOL stepped;
+  unsigned int k, s;
+
+  if (!children && output == SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_NONE)
+    return count;
+
+  /* Whole vectors only: make sure the sampler is flushed before overflow */
+  if (insp->sample_msg_watermark > max_wm)
+    suscan_inspector_set_msg_watermark(insp, max_wm);
+
+  bank->steps = 0;
+
+  while (i < count && bank->steps < SUSCAN_MULTICARRIER_INSPECTOR_BLOCK_STEPS) {
+    if (output != SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_NONE
+      && suscan_inspector_sampler_buf_avail(insp) < N)
+      break;
+
+    n = suscan_multicarrier_bank_feed(bank, x + i, count - i, &stepped);
+    i += n;
+
+    if (stepped && output != SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_NONE) {
+      s = bank->steps - 1;
+      vector = insp->sampler_buf + insp->sampler_ptr;
+
+      if (output == SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_POWER) {
+        for (k = 0; k < N; ++k) {
+          SUCOMPLEX y = bank->out[k * SUSCAN_MULTICARRIER_INSPECTOR_BLOCK_STEPS + s];
+          vector[k] = SU_C_REAL(y * SU_C_CONJ(y));
+        }
+      } else {
+        for (k = 0; k < N; ++k)
+          vector[k] = bank->out[k * SUSCAN_MULTICARRIER_INSPECTOR_BLOCK_STEPS + s];
+      }
+
+      insp->sampler_ptr += N;
     }
   }
 
-  return count;
+  if (children && bank->steps > 0)
+    suscan_multicarrier_inspector_feed_children(self, insp);
+
+  return i;
 }
 
 void
 suscan_multicarrier_inspector_close(void *private)
 {
-  struct suscan_inspector_multicarrier_params *params = 
-    (struct suscan_inspector_multicarrier_params *) private;
+  suscan_multicarrier_inspector_destroy(
+    (struct suscan_multicarrier_inspector *) private);
+}
+
+/******************* Subcarrier inspector factory *****************************/
+SUPRIVATE struct suscan_multicarrier_inspector *
+suscan_mc_inspector_factory_get_bank_owner(suscan_inspector_t *self)
+{
+  return (struct suscan_multicarrier_inspector *) self->privdata;
+}
+
+SUPRIVATE unsigned int
+suscan_mc_inspector_factory_subcarrier(
+  suscan_inspector_t *self,
+  SUFREQ frequency)
+{
+  struct suscan_multicarrier_inspector *owner =
+    suscan_mc_inspector_factory_get_bank_owner(self);
+  unsigned int N = owner->bank.size;
+  SUSDIFF k;
+
+  k = SU_FLOOR(frequency / self->samp_info.equiv_fs * N + .5);
+  k %= (SUSDIFF) N;
+  if (k < 0)
+    k += N;
+
+  return k;
+}
+
+SUPRIVATE void *
+suscan_mc_inspector_factory_ctor(suscan_inspector_factory_t *parent, va_list ap)
+{
+  suscan_inspector_t *self;
+
+  self = va_arg(ap, suscan_inspector_t *);
+
+  suscan_inspector_factory_set_mq_out(parent, self->mq_out);
+  suscan_inspector_factory_set_mq_ctl(parent, self->mq_ctl);
+
+  return self;
+}
+
+SUPRIVATE void
+suscan_mc_inspector_factory_get_time(void *userdata, struct timeval *tv)
+{
+  suscan_inspector_t *self = (suscan_inspector_t *) userdata;
+
+  suscan_inspector_factory_get_time(self->factory, tv);
+}
+
+SUPRIVATE void *
+suscan_mc_inspector_factory_open(
+  void *userdata,
+  const char **inspclass,
+  struct suscan_inspector_sampling_info *samp_info,
+  va_list ap)
+{
+  suscan_inspector_t *self = (suscan_inspector_t *) userdata;
+  struct suscan_multicarrier_inspector *owner =
+    suscan_mc_inspector_factory_get_bank_owner(self);
+  struct suscan_multicarrier_child *child = NULL;
+  const char *classname;
+  const struct sigutils_channel *channel;
+  unsigned int i, N = owner->bank.size;
+  SUFLOAT fs = self->samp_info.equiv_fs;
+  SUBOOL mutex_acquired = SU_FALSE;
+  SUBOOL ok = SU_FALSE;
+
+  classname = va_arg(ap, const char *);
+  channel   = va_arg(ap, const struct sigutils_channel *);
+  (void) va_arg(ap, SUBOOL); /* Precise: subcarriers are fixed */
+
+  SU_ALLOCATE(child, struct suscan_multicarrier_child);
+
+  child->subcarrier = suscan_mc_inspector_factory_subcarrier(
+    self,
+    channel->fc - channel->ft);
+
+  SU_TRYZ(pthread_mutex_lock(&owner->child_mutex));
+  mutex_acquired = SU_TRUE;
+
+  /* Reuse slots of closed subcarrier inspectors */
+  for (i = 0; i < owner->child_count; ++i)
+    if (owner->child_list[i] == NULL) {
+      owner->child_list[i] = child;
+      break;
+    }
+
+  if (i == owner->child_count)
+    SU_TRYC(PTR_LIST_APPEND_CHECK(owner->child, child));
+
+  /* Prepare output fields */
+  *inspclass = classname;
+
+  /* Initialize sampling info */
+  samp_info->equiv_fs = fs / N;
+  samp_info->bw_bd    = SU_ABS2NORM_FREQ(fs, fs / N);
+  samp_info->bw       = .5 * N * samp_info->bw_bd;
+  samp_info->f0       = SU_ABS2NORM_FREQ(fs, child->subcarrier * fs / N);
+
+  /* No frequency-domain delivery: keep power inspectors in time domain */
+  samp_info->fft_size        = SUSCAN_INSPECTOR_SAMPLER_BUF_SIZE;
+  samp_info->fft_bins        = SUSCAN_INSPECTOR_SAMPLER_BUF_SIZE;
+  samp_info->early_windowing = SU_FALSE;
+  samp_info->decimation      = N;
+
+  ok = SU_TRUE;
+
+done:
+  if (mutex_acquired)
+    pthread_mutex_unlock(&owner->child_mutex);
+
+  if (!ok && child != NULL) {
+    free(child);
+    child = NULL;
+  }
+
+  return child;
+}
+
+SUPRIVATE void
+suscan_mc_inspector_factory_bind(
+  void *userdata,
+  void *insp_self,
+  suscan_inspector_t *insp)
+{
+  suscan_inspector_t *self = (suscan_inspector_t *) userdata;
+  struct suscan_multicarrier_inspector *owner =
+    suscan_mc_inspector_factory_get_bank_owner(self);
+  struct suscan_multicarrier_child *child =
+    (struct suscan_multicarrier_child *) insp_self;
+
+  pthread_mutex_lock(&owner->child_mutex);
+  child->insp = insp;
+  SU_REF(insp, multicarrier);
+  pthread_mutex_unlock(&owner->child_mutex);
+}
+
+SUPRIVATE void
+suscan_mc_inspector_factory_close(
+  void *userdata,
+  void *insp_self)
+{
+  suscan_inspector_t *self = (suscan_inspector_t *) userdata;
+  struct suscan_multicarrier_inspector *owner =
+    suscan_mc_inspector_factory_get_bank_owner(self);
+  struct suscan_multicarrier_child *child =
+    (struct suscan_multicarrier_child *) insp_self;
+  unsigned int i;
+
+  pthread_mutex_lock(&owner->child_mutex);
+
+  for (i = 0; i < owner->child_count; ++i)
+    if (owner->child_list[i] == child) {
+      owner->child_list[i] = NULL;
+      break;
+    }
+
+  if (child->insp != NULL)
+    SU_DEREF(child->insp, multicarrier);
+
+  pthread_mutex_unlock(&owner->child_mutex);
+
+  free(child);
+}
+
+SUPRIVATE void
+suscan_mc_inspector_factory_free_buf(
+  void *self,
+  void *insp_self,
+  SUCOMPLEX *data,
+  SUSCOUNT len)
+{
+  /* No-op */
+}
+
+SUPRIVATE SUFLOAT
+suscan_mc_inspector_factory_get_bandwidth(
+  void *userdata,
+  void *insp_userdata)
+{
+  suscan_inspector_t *self = (suscan_inspector_t *) userdata;
+  struct suscan_multicarrier_inspector *owner =
+    suscan_mc_inspector_factory_get_bank_owner(self);
 
-  suscan_inspector_multicarrier_params_finalize(params);
-  free(params);
+  return self->samp_info.equiv_fs / owner->bank.size;
 }
 
+SUPRIVATE SUBOOL
+suscan_mc_inspector_factory_set_bandwidth(
+  void *userdata,
+  void *insp_userdata,
+  SUFLOAT bandwidth)
+{
+  /* Subcarrier bandwidth is fixed by the filter bank */
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+suscan_mc_inspector_factory_set_frequency(
+  void *userdata,
+  void *insp_userdata,
+  SUFREQ frequency)
+{
+  suscan_inspector_t *self = (suscan_inspector_t *) userdata;
+  struct suscan_multicarrier_inspector *owner =
+    suscan_mc_inspector_factory_get_bank_owner(self);
+  struct suscan_multicarrier_child *child =
+    (struct suscan_multicarrier_child *) insp_userdata;
+
+  pthread_mutex_lock(&owner->child_mutex);
+  child->subcarrier = suscan_mc_inspector_factory_subcarrier(self, frequency);
+  pthread_mutex_unlock(&owner->child_mutex);
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+suscan_mc_inspector_factory_set_domain(
+  void *userdata,
+  void *insp_userdata,
+  SUBOOL is_freq)
+{
+  return !is_freq;
+}
+
+SUPRIVATE SUFREQ
+suscan_mc_inspector_factory_get_abs_freq(
+  void *userdata,
+  void *insp_userdata)
+{
+  suscan_inspector_t *self = (suscan_inspector_t *) userdata;
+  struct suscan_multicarrier_inspector *owner =
+    suscan_mc_inspector_factory_get_bank_owner(self);
+  struct suscan_multicarrier_child *child =
+    (struct suscan_multicarrier_child *) insp_userdata;
+
+  return child->subcarrier * self->samp_info.equiv_fs / owner->bank.size;
+}
+
+SUPRIVATE SUBOOL
+suscan_mc_inspector_factory_set_freq_correction(
+  void *userdata,
+  void *insp_userdata,
+  SUFLOAT delta)
+{
+  /* Subcarriers are not retuned by frequency correctors */
+  return delta == 0;
+}
+
+SUPRIVATE void
+suscan_mc_inspector_factory_dtor(void *self)
+{
+  /* No-op */
+}
+
+static struct suscan_inspector_factory_class g_mc_factory = {
+  .name                = "mc-inspector",
+  .ctor                = suscan_mc_inspector_factory_ctor,
+  .get_time            = suscan_mc_inspector_factory_get_time,
+  .open                = suscan_mc_inspector_factory_open,
+  .bind                = suscan_mc_inspector_factory_bind,
+  .close               = suscan_mc_inspector_factory_close,
+  .free_buf            = suscan_mc_inspector_factory_free_buf,
+  .set_bandwidth       = suscan_mc_inspector_factory_set_bandwidth,
+  .get_bandwidth       = suscan_mc_inspector_factory_get_bandwidth,
+  .set_frequency       = suscan_mc_inspector_factory_set_frequency,
+  .set_domain          = suscan_mc_inspector_factory_set_domain,
+  .get_abs_freq        = suscan_mc_inspector_factory_get_abs_freq,
+  .set_freq_correction = suscan_mc_inspector_factory_set_freq_correction,
+  .dtor                = suscan_mc_inspector_factory_dtor
+};
+
 SUPRIVATE struct suscan_inspector_interface iface = {
     .name = "multicarrier",
     .desc = "Multicarrier channel inspector",
-    .sc_factory_class = "sc-inspector",
+    .sc_factory_class = "mc-inspector",
     .open = suscan_multicarrier_inspector_open,
     .get_config = suscan_multicarrier_inspector_get_config,
     .parse_config = suscan_multicarrier_inspector_parse_config,
@@ -159,6 +800,11 @@ suscan_multicarrier_inspector_register(void)
 
   SU_TRYCATCH(suscan_config_desc_register(iface.cfgdesc), return SU_FALSE);
 
+  /* Subcarrier inspectors are fed from the filter bank */
+  SU_TRYCATCH(
+    suscan_inspector_factory_class_register(&g_mc_factory),
+    return SU_FALSE);
+
   /* Register inspector interface */
   SU_TRYCATCH(suscan_inspector_interface_register(&iface), return SU_FALSE);
 
@@ -0,0 +1,653 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "powerbank-inspector"
+
+#include <sigutils/sigutils.h>
+
+#include <analyzer/version.h>
+
+#include "inspector/interface.h"
+#include "inspector/params.h"
+#include "inspector/inspector.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* Same window compensation as in the power inspector (see power.c) */
+#define SU_POWERBANK_INSPECTOR_FFT_WINDOW_INV_GAIN (8. / 3.)
+#define SU_POWERBANK_INSPECTOR_VARIANCE_SCALING    (35. / 18.)
+
+/* A whole measurement vector must fit in the sampler buffer */
+#define SUSCAN_POWERBANK_INSPECTOR_MAX_BANDS       4096
+
+/*
+ * The power bank inspector measures the power of a list of sub-bands of
+ * the channel, all of them from the same frequency-domain data delivered
+ * by the spectral tuner. It runs the frequency domain mode of the power
+ * inspector (see power.c) on every sub-band at once:
+ *
+ *   1. The power of every bin of the FFT frame is computed in a single
+ *      pass, and accumulated into a prefix sum. The energy of a sub-band
+ *      is then just the difference of two prefix sums, which makes the
+ *      cost per frame O(fft_bins + bands) regardless of the width of the
+ *      sub-bands.
+ *   2. Frame energies are integrated as in the power inspector, with
+ *      K = integrate_samples / fft_bins frames per measurement and the
+ *      fractional frame split between consecutive measurements.
+ *   3. Once per integration period, the measurements of all sub-bands
+ *      are pushed as a single vector. The message watermark is set to
+ *      the number of bands, so every SAMPLES message holds exactly one
+ *      vector, in the same order as the band list.
+ *
+ * Sub-bands are given as a list of "offset:bandwidth" pairs (in Hz,
+ * relative to the center of the channel) separated by commas.
+ */
+struct suscan_powerbank_band {
+  SUFLOAT  offset;
+  SUFLOAT  bw;
+
+  /* Bin range in the centered frame, [lo, hi) */
+  SUSCOUNT lo;
+  SUSCOUNT hi;
+};
+
+struct suscan_powerbank_inspector_params {
+  SUSCOUNT integrate_samples;
+  char    *band_spec;
+
+  struct suscan_powerbank_band *band_list;
+  unsigned int band_count;
+};
+
+struct suscan_powerbank_inspector {
+  struct suscan_inspector_sampling_info samp_info;
+  struct suscan_powerbank_inspector_params req_params;
+  struct suscan_powerbank_inspector_params cur_params;
+
+  suscan_inspector_t *insp;
+  SUBOOL   stable;
+
+  /* Frame buffers */
+  SUSCOUNT  mapped_bins;     /* Frame size of the current band mapping */
+  SUFLOAT  *bin_power;       /* Power per bin, centered */
+  SUDOUBLE *bin_cumsum;      /* Prefix sum of bin_power */
+
+  /* Integration, as in the power inspector */
+  SUFLOAT  K;
+  SUFLOAT  alpha, beta;
+  SUSCOUNT frame;
+  SUSCOUNT whole_frames;     /* floor(Kr) */
+  SUFLOAT  inv_gain;
+  SUBOOL   pending;          /* output not delivered yet */
+
+  SUFLOAT   *E;              /* Energy of the whole frames */
+  SUFLOAT   *E_p;            /* Energy of the previous partial frame */
+  SUCOMPLEX *output;
+};
+
+SUPRIVATE void
+suscan_powerbank_inspector_params_finalize(
+    struct suscan_powerbank_inspector_params *params)
+{
+  if (params->band_spec != NULL)
+    free(params->band_spec);
+
+  if (params->band_list != NULL)
+    free(params->band_list);
+
+  memset(params, 0, sizeof(struct suscan_powerbank_inspector_params));
+}
+
+SUPRIVATE SUBOOL
+suscan_powerbank_inspector_params_copy(
+    struct suscan_powerbank_inspector_params *dest,
+    const struct suscan_powerbank_inspector_params *src)
+{
+  SUBOOL ok = SU_FALSE;
+
+  dest->integrate_samples = src->integrate_samples;
+
+  if (src->band_spec != NULL)
+    SU_TRY(dest->band_spec = strdup(src->band_spec));
+
+  if (src->band_count > 0) {
+    SU_ALLOCATE_MANY(
+      dest->band_list,
+      src->band_count,
+      struct suscan_powerbank_band);
+    memcpy(
+      dest->band_list,
+      src->band_list,
+      src->band_count * sizeof(struct suscan_powerbank_band));
+  }
+
+  dest->band_count = src->band_count;
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+SUPRIVATE SUBOOL
+suscan_powerbank_inspector_params_parse_bands(
+    struct suscan_powerbank_inspector_params *params,
+    const char *spec)
+{
+  struct suscan_powerbank_band *band_list = NULL;
+  unsigned int band_count = 0, alloc = 0;
+  const char *p = spec;
+  char *end;
+  SUFLOAT offset, bw;
+  SUBOOL ok = SU_FALSE;
+
+  for (;;) {
+    while (isspace(*p) || *p == ',' || *p == ';')
+      ++p;
+
+    if (*p == '\0')
+      break;
+
+    offset = strtod(p, &end);
+    if (end == p || *end != ':') {
+      SU_ERROR("Invalid sub-band specification near `%s'\n", p);
+      goto done;
+    }
+
+    p = end + 1;
+    bw = strtod(p, &end);
+    if (end == p || bw <= 0) {
+      SU_ERROR("Invalid sub-band bandwidth near `%s'\n", p);
+      goto done;
+    }
+
+    p = end;
+
+    if (band_count == SUSCAN_POWERBANK_INSPECTOR_MAX_BANDS) {
+      SU_ERROR(
+        "Too many sub-bands (max is %d)\n",
+        SUSCAN_POWERBANK_INSPECTOR_MAX_BANDS);
+      goto done;
+    }
+
+    if (band_count == alloc) {
+      struct suscan_powerbank_band *tmp;
+
+      alloc = alloc == 0 ? 16 : 2 * alloc;
+      SU_TRY(
+        tmp = realloc(
+          band_list,
+          alloc * sizeof(struct suscan_powerbank_band)));
+      band_list = tmp;
+    }
+
+    band_list[band_count].offset = offset;
+    band_list[band_count].bw     = bw;
+    band_list[band_count].lo     = 0;
+    band_list[band_count].hi     = 0;
+    ++band_count;
+  }
+
+  if (params->band_list != NULL)
+    free(params->band_list);
+
+  params->band_list  = band_list;
+  params->band_count = band_count;
+  band_list = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (band_list != NULL)
+    free(band_list);
+
+  return ok;
+}
+
+SUPRIVATE void
+suscan_powerbank_inspector_clear_buffers(
+    struct suscan_powerbank_inspector *self)
+{
+  if (self->bin_power != NULL)
+    free(self->bin_power);
+
+  if (self->bin_cumsum != NULL)
+    free(self->bin_cumsum);
+
+  if (self->E != NULL)
+    free(self->E);
+
+  if (self->E_p != NULL)
+    free(self->E_p);
+
+  if (self->output != NULL)
+    free(self->output);
+
+  self->bin_power   = NULL;
+  self->bin_cumsum  = NULL;
+  self->E           = NULL;
+  self->E_p         = NULL;
+  self->output      = NULL;
+  self->mapped_bins = 0;
+}
+
+SUPRIVATE void
+suscan_powerbank_inspector_destroy(struct suscan_powerbank_inspector *self)
+{
+  suscan_powerbank_inspector_clear_buffers(self);
+
+  suscan_powerbank_inspector_params_finalize(&self->req_params);
+  suscan_powerbank_inspector_params_finalize(&self->cur_params);
+
+  free(self);
+}
+
+SUPRIVATE struct suscan_powerbank_inspector *
+suscan_powerbank_inspector_new(
+  const struct suscan_inspector_sampling_info *sinfo)
+{
+  struct suscan_powerbank_inspector *new = NULL;
+
+  SU_ALLOCATE_FAIL(new, struct suscan_powerbank_inspector);
+
+  new->samp_info = *sinfo;
+
+  return new;
+
+fail:
+  if (new != NULL)
+    suscan_powerbank_inspector_destroy(new);
+
+  return NULL;
+}
+
+/*
+ * Frames are delivered in FFT order (positive frequencies first). Bands
+ * are mapped onto the centered frame, in which bin c corresponds to the
+ * frequency (c - bins / 2) * fs / fft_size.
+ */
+SUPRIVATE SUBOOL
+suscan_powerbank_inspector_map_bands(
+    struct suscan_powerbank_inspector *self,
+    SUSCOUNT bins)
+{
+  struct suscan_powerbank_inspector_params *params = &self->cur_params;
+  struct suscan_powerbank_band *band;
+  SUFLOAT df = self->samp_info.equiv_fs / self->samp_info.fft_size;
+  SUSDIFF half = bins / 2;
+  SUSDIFF lo, hi;
+  unsigned int i, n = SU_MAX(params->band_count, 1);
+  SUBOOL ok = SU_FALSE;
+
+  suscan_powerbank_inspector_clear_buffers(self);
+
+  SU_ALLOCATE_MANY(self->bin_power,  bins,     SUFLOAT);
+  SU_ALLOCATE_MANY(self->bin_cumsum, bins + 1, SUDOUBLE);
+  SU_ALLOCATE_MANY(self->E,          n,        SUFLOAT);
+  SU_ALLOCATE_MANY(self->E_p,        n,        SUFLOAT);
+  SU_ALLOCATE_MANY(self->output,     n,        SUCOMPLEX);
+
+  for (i = 0; i < params->band_count; ++i) {
+    band = params->band_list + i;
+
+    lo = SU_FLOOR((band->offset - .5 * band->bw) / df + .5) + half;
+    hi = SU_FLOOR((band->offset + .5 * band->bw) / df + .5) + half;
+
+    if (hi <= lo)
+      hi = lo + 1;
+
+    band->lo = SU_MIN(SU_MAX(lo, 0), (SUSDIFF) bins);
+    band->hi = SU_MIN(SU_MAX(hi, 0), (SUSDIFF) bins);
+
+    if (band->lo == band->hi)
+      SU_WARNING(
+        "Sub-band #%d (%g Hz) falls outside the channel\n",
+        i,
+        band->offset);
+  }
+
+  self->mapped_bins = bins;
+  self->frame       = 0;
+  self->beta        = 0;
+  self->pending     = SU_FALSE;
+
+  ok = SU_TRUE;
+
+done:
+  if (!ok)
+    suscan_powerbank_inspector_clear_buffers(self);
+
+  return ok;
+}
+
+/************************** API implementation *******************************/
+void *
+suscan_powerbank_inspector_open(
+  const struct suscan_inspector_sampling_info *s)
+{
+  return suscan_powerbank_inspector_new(s);
+}
+
+SUBOOL
+suscan_powerbank_inspector_get_config(void *private, suscan_config_t *config)
+{
+  struct suscan_powerbank_inspector *self =
+    (struct suscan_powerbank_inspector *) private;
+
+  SU_TRYCATCH(
+    suscan_config_set_integer(
+      config,
+      "powerbank.integrate-samples",
+      self->cur_params.integrate_samples),
+    return SU_FALSE);
+
+  SU_TRYCATCH(
+    suscan_config_set_string(
+      config,
+      "powerbank.bands",
+      self->cur_params.band_spec != NULL ? self->cur_params.band_spec : ""),
+    return SU_FALSE);
+
+  return SU_TRUE;
+}
+
+SUBOOL
+suscan_powerbank_inspector_parse_config(
+  void *private,
+  const suscan_config_t *config)
+{
+  struct suscan_field_value *value;
+  struct suscan_powerbank_inspector *self =
+    (struct suscan_powerbank_inspector *) private;
+  struct suscan_powerbank_inspector_params params;
+  SUBOOL ok = SU_FALSE;
+
+  memset(&params, 0, sizeof(struct suscan_powerbank_inspector_params));
+
+  SU_TRY(
+      value = suscan_config_get_value(
+          config,
+          "powerbank.integrate-samples"));
+  SU_TRY(value->field->type == SUSCAN_FIELD_TYPE_INTEGER);
+
+  params.integrate_samples = value->as_int;
+
+  SU_TRY(
+      value = suscan_config_get_value(
+          config,
+          "powerbank.bands"));
+  SU_TRY(value->field->type == SUSCAN_FIELD_TYPE_STRING);
+
+  SU_TRY(params.band_spec = strdup(value->as_string));
+  SU_TRY(
+    suscan_powerbank_inspector_params_parse_bands(
+      &params,
+      params.band_spec));
+
+  suscan_powerbank_inspector_params_finalize(&self->req_params);
+  self->req_params = params;
+  memset(&params, 0, sizeof(struct suscan_powerbank_inspector_params));
+
+  ok = SU_TRUE;
+
+done:
+  suscan_powerbank_inspector_params_finalize(&params);
+
+  return ok;
+}
+
+SUPRIVATE void
+suscan_powerbank_inspector_send_scaling(
+  struct suscan_powerbank_inspector *self)
+{
+  SUDOUBLE scaling = self->cur_params.integrate_samples;
+
+  if (self->samp_info.early_windowing)
+    scaling /= SU_POWERBANK_INSPECTOR_VARIANCE_SCALING;
+
+  suscan_inspector_send_signal(self->insp, "scaling", scaling);
+}
+
+/* Called inside inspector mutex */
+void
+suscan_powerbank_inspector_commit_config(void *private)
+{
+  struct suscan_powerbank_inspector *self =
+    (struct suscan_powerbank_inspector *) private;
+  struct suscan_powerbank_inspector_params params;
+  SUSCOUNT integrate_samples;
+
+  memset(&params, 0, sizeof(struct suscan_powerbank_inspector_params));
+
+  if (!suscan_powerbank_inspector_params_copy(&params, &self->req_params)) {
+    SU_ERROR("No memory left to update the band list!\n");
+    suscan_powerbank_inspector_params_finalize(&params);
+    return;
+  }
+
+  suscan_powerbank_inspector_params_finalize(&self->cur_params);
+  self->cur_params = params;
+
+  /* Measurements are at least one FFT frame long */
+  integrate_samples = SU_MAX(
+    self->cur_params.integrate_samples,
+    self->samp_info.fft_bins);
+
+  self->K        = (SUFLOAT) integrate_samples / self->samp_info.fft_bins;
+  self->inv_gain = self->samp_info.early_windowing
+    ? SU_POWERBANK_INSPECTOR_FFT_WINDOW_INV_GAIN
+    : 1.;
+
+  /* Force remapping of the bands in the next frame */
+  self->mapped_bins = 0;
+
+  if (self->insp != NULL)
+    suscan_powerbank_inspector_send_scaling(self);
+}
+
+SUPRIVATE void
+suscan_powerbank_inspector_frame_power(
+  struct suscan_powerbank_inspector *self,
+  const SUCOMPLEX *x,
+  SUSCOUNT bins)
+{
+  const SUFLOAT *__restrict v = (const SUFLOAT *) x;
+  SUFLOAT *__restrict p = self->bin_power;
+  SUDOUBLE *__restrict cumsum = self->bin_cumsum;
+  SUSCOUNT half = bins / 2;
+  SUSCOUNT neg = bins - half;
+  SUSCOUNT i;
+  SUDOUBLE acc = 0;
+
+  /* Negative frequencies (end of the frame) go first */
+  for (i = 0; i < half; ++i)
+    p[i] = v[2 * (neg + i)] * v[2 * (neg + i)]
+      + v[2 * (neg + i) + 1] * v[2 * (neg + i) + 1];
+
+  for (i = 0; i < neg; ++i)
+    p[half + i] = v[2 * i] * v[2 * i] + v[2 * i + 1] * v[2 * i + 1];
+
+  cumsum[0] = 0;
+  for (i = 0; i < bins; ++i) {
+    acc += p[i];
+    cumsum[i + 1] = acc;
+  }
+}
+
+SUSDIFF
+suscan_powerbank_inspector_feed(
+    void *private,
+    suscan_inspector_t *insp,
+    const SUCOMPLEX *x,
+    SUSCOUNT count)
+{
+  struct suscan_powerbank_inspector *self =
+    (struct suscan_powerbank_inspector *) private;
+  const struct suscan_powerbank_band *band;
+  const SUDOUBLE *cumsum;
+  unsigned int i, n;
+  SUFLOAT Kr, e, scale;
+
+  if (insp != NULL)
+    self->insp = insp;
+
+  /* This inspector only works in the frequency domain */
+  if (!suscan_inspector_is_freq_domain(insp)) {
+    suscan_inspector_set_domain(insp, SU_TRUE);
+    return count;
+  }
+
+  if (!self->stable) {
+    self->stable = SU_TRUE;
+    suscan_powerbank_inspector_send_scaling(self);
+    return count;
+  }
+
+  n = self->cur_params.band_count;
+  if (n == 0 || count != self->samp_info.fft_bins)
+    return count;
+
+  /* Every measurement vector goes in its own message */
+  if (insp->sample_msg_watermark != n)
+    suscan_inspector_set_msg_watermark(insp, n);
+
+  if (self->mapped_bins != count)
+    SU_TRYCATCH(
+      suscan_powerbank_inspector_map_bands(self, count),
+      return -1);
+
+  /* Deliver a vector that did not fit in the sample buffer before */
+  if (self->pending && suscan_inspector_sampler_buf_avail(insp) >= n) {
+    suscan_inspector_push_sample_buffer(insp, self->output, n);
+    self->pending = SU_FALSE;
+  }
+
+  suscan_powerbank_inspector_frame_power(self, x, count);
+  cumsum = self->bin_cumsum;
+
+  /* First frame of the measurement: initialize Kr and alpha */
+  if (self->frame == 0) {
+    Kr = self->K - self->beta;
+    self->alpha = Kr - SU_FLOOR(Kr);
+    self->whole_frames = SU_FLOOR(Kr);
+    memset(self->E, 0, n * sizeof(SUFLOAT));
+  }
+
+  band = self->cur_params.band_list;
+
+  if (self->frame < self->whole_frames) {
+    /* Whole frame: accumulate E */
+    for (i = 0; i < n; ++i)
+      self->E[i] += cumsum[band[i].hi] - cumsum[band[i].lo];
+
+    ++self->frame;
+  } else {
+    /* Partial (next) frame: E_t = beta * E_p + E + alpha * E_n */
+    if (self->pending)
+      SU_WARNING("Sample buffer full, power measurement dropped\n");
+
+    scale = self->inv_gain / self->K;
+
+    for (i = 0; i < n; ++i) {
+      e = cumsum[band[i].hi] - cumsum[band[i].lo];
+      self->output[i] =
+        scale * (self->beta * self->E_p[i] + self->E[i] + self->alpha * e);
+      self->E_p[i] = e;
+    }
+
+    self->beta  = 1 - self->alpha;
+    self->frame = 0;
+
+    /* Integration goes on even if the vector has to wait */
+    if (suscan_inspector_sampler_buf_avail(insp) >= n) {
+      suscan_inspector_push_sample_buffer(insp, self->output, n);
+      self->pending = SU_FALSE;
+    } else {
+      self->pending = SU_TRUE;
+    }
+  }
+
+  return count;
+}
+
+void
+suscan_powerbank_inspector_close(void *private)
+{
+  struct suscan_powerbank_inspector *self =
+    (struct suscan_powerbank_inspector *) private;
+
+  suscan_powerbank_inspector_destroy(self);
+}
+
+SUPRIVATE struct suscan_inspector_interface iface = {
+    .name = "powerbank",
+    .desc = "Multi-channel power inspector",
+    .frequency_domain = SU_TRUE,
+    .open = suscan_powerbank_inspector_open,
+    .get_config = suscan_powerbank_inspector_get_config,
+    .parse_config = suscan_powerbank_inspector_parse_config,
+    .commit_config = suscan_powerbank_inspector_commit_config,
+    .feed = suscan_powerbank_inspector_feed,
+    .close = suscan_powerbank_inspector_close
+};
+
+SUBOOL
+suscan_powerbank_inspector_register(void)
+{
+  suscan_config_desc_t *desc = NULL;
+
+  SU_TRY_FAIL(
+      desc = suscan_config_desc_new_ex(
+          "powerbank-params-desc-" SUSCAN_VERSION_STRING));
+
+  SU_TRY_FAIL(
+    suscan_config_desc_add_field(
+      desc,
+      SUSCAN_FIELD_TYPE_INTEGER,
+      SU_FALSE,
+      "powerbank.integrate-samples",
+      "Number of samples to integrate"));
+
+  SU_TRY_FAIL(
+    suscan_config_desc_add_field(
+      desc,
+      SUSCAN_FIELD_TYPE_STRING,
+      SU_FALSE,
+      "powerbank.bands",
+      "Sub-bands to measure (offset:bandwidth, comma-separated)"));
+
+  iface.cfgdesc = desc;
+  desc = NULL;
+  SU_TRY_FAIL(suscan_config_desc_register(iface.cfgdesc));
+
+  (void) suscan_inspector_interface_add_spectsrc(&iface, "psd");
+
+  /* Register inspector interface */
+  SU_TRY_FAIL(suscan_inspector_interface_register(&iface));
+
+  return SU_TRUE;
+
+fail:
+  if (desc != NULL)
+    suscan_config_desc_destroy(desc);
+
+  return SU_FALSE;
+}
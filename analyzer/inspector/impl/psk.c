@@ -34,11 +34,14 @@
 
 #include "inspector/inspector.h"
 
+#include "blockmf.h"
+
 /* Some default PSK demodulator parameters */
 #define SUSCAN_PSK_INSPECTOR_DEFAULT_ROLL_OFF  .35
 #define SUSCAN_PSK_INSPECTOR_DEFAULT_EQ_MU     1e-3
 #define SUSCAN_PSK_INSPECTOR_DEFAULT_EQ_LENGTH 20
 #define SUSCAN_PSK_INSPECTOR_MAX_MF_SPAN       1024
+#define SUSCAN_PSK_INSPECTOR_BLOCK_SIZE        512
 
 /*
  * Spike durations measured in symbol times
@@ -61,21 +64,39 @@ struct suscan_psk_inspector_params {
   struct suscan_inspector_br_params br;
 };
 
+/*
+ * Demodulation kernel, selected in commit_config. Stages that are not
+ * enabled are skipped for the whole block, and the remaining ones run
+ * as tight loops over the block buffer.
+ */
+struct suscan_psk_inspector_kernel {
+  SUBOOL    lo;                   /* Carrier offset is not zero */
+  SUCOMPLEX scale;                /* Carrier phase and manual gain */
+  SUBOOL    agc;
+  SUBOOL    costas;
+  SUBOOL    mf;
+  SUBOOL    clock_detector;
+  SUBOOL    eq;
+};
+
 struct suscan_psk_inspector {
   struct suscan_inspector_sampling_info samp_info;
   struct suscan_psk_inspector_params req_params;
   struct suscan_psk_inspector_params cur_params;
+  struct suscan_psk_inspector_kernel kernel;
 
   /* Blocks */
   su_agc_t            agc;        /* AGC, for sampler */
   su_costas_t         costas;     /* Costas loop */
-  su_iir_filt_t       mf;         /* Matched filter (Root Raised Cosine) */
+  struct suscan_inspector_block_mf mf; /* Matched filter (RRC) */
   su_clock_detector_t cd;         /* Clock detector */
   su_sampler_t        sampler;    /* Sampler */
   su_equalizer_t      eq;         /* Equalizer */
   su_ncqo_t           lo;         /* Oscillator for manual carrier offset */
 
   SUCOMPLEX           phase;      /* Local oscillator phase */
+
+  SUCOMPLEX           block[SUSCAN_PSK_INSPECTOR_BLOCK_SIZE];
 };
 
 SUSCOUNT
@@ -116,10 +137,34 @@ suscan_psk_inspector_params_initialize(
   params->eq.eq_mu      = SUSCAN_PSK_INSPECTOR_DEFAULT_EQ_MU;
 }
 
+SUPRIVATE void
+suscan_psk_inspector_select_kernel(struct suscan_psk_inspector *insp)
+{
+  struct suscan_psk_inspector_kernel *kernel = &insp->kernel;
+  const struct suscan_psk_inspector_params *params = &insp->cur_params;
+
+  kernel->lo    = params->fc.fc_off != 0;
+  kernel->scale = insp->phase;
+  kernel->agc   = params->gc.gc_ctrl == SUSCAN_INSPECTOR_GAIN_CONTROL_AUTOMATIC;
+
+  if (params->gc.gc_ctrl == SUSCAN_INSPECTOR_GAIN_CONTROL_MANUAL)
+    kernel->scale *= 2 * params->gc.gc_gain;
+
+  kernel->costas =
+    params->fc.fc_ctrl != SUSCAN_INSPECTOR_CARRIER_CONTROL_MANUAL;
+  kernel->mf =
+    params->mf.mf_conf == SUSCAN_INSPECTOR_MATCHED_FILTER_MANUAL
+    && insp->mf.size > 0;
+  kernel->clock_detector =
+    params->br.br_ctrl != SUSCAN_INSPECTOR_BAUDRATE_CONTROL_MANUAL;
+  kernel->eq =
+    params->eq.eq_conf == SUSCAN_INSPECTOR_EQUALIZER_CMA;
+}
+
 SUPRIVATE void
 suscan_psk_inspector_destroy(struct suscan_psk_inspector *insp)
 {
-  su_iir_filt_finalize(&insp->mf);
+  suscan_inspector_block_mf_finalize(&insp->mf);
 
   su_agc_finalize(&insp->agc);
 
@@ -182,9 +227,10 @@ suscan_psk_inspector_new(const struct suscan_inspector_sampling_info *sinfo)
 
   /* Initialize matched filter, with T = tau */
   SU_TRYCATCH(
-      su_iir_rrc_init(
+      suscan_inspector_block_mf_init(
           &new->mf,
           SU_CEIL(suscan_psk_inspector_mf_span(6 * tau)),
+          SUSCAN_PSK_INSPECTOR_BLOCK_SIZE,
           SU_CEIL(tau),
           new->cur_params.mf.mf_rolloff),
       goto fail);
@@ -214,6 +260,8 @@ suscan_psk_inspector_new(const struct suscan_inspector_sampling_info *sinfo)
           : 0),
       goto fail);
 
+  suscan_psk_inspector_select_kernel(new);
+
   return new;
 
 fail:
@@ -303,7 +351,7 @@ suscan_psk_inspector_commit_config(void *private)
   SUFLOAT sym_period;
   su_costas_t costas;
 
-  su_iir_filt_t mf = su_iir_filt_INITIALIZER;
+  struct suscan_inspector_block_mf mf;
   struct suscan_psk_inspector *insp = (struct suscan_psk_inspector *) private;
 
   actual_baud = insp->req_params.br.br_running
@@ -344,14 +392,15 @@ suscan_psk_inspector_commit_config(void *private)
 
   /* Update matched filter */
   if (mf_changed && sym_period > 0) {
-    if (!su_iir_rrc_init(
+    if (!suscan_inspector_block_mf_init(
         &mf,
         SU_CEIL(suscan_psk_inspector_mf_span(6 * sym_period)),
+        SUSCAN_PSK_INSPECTOR_BLOCK_SIZE,
         SU_CEIL(sym_period),
         insp->cur_params.mf.mf_rolloff)) {
       SU_ERROR("No memory left to update matched filter!\n");
     } else {
-      su_iir_filt_finalize(&insp->mf);
+      suscan_inspector_block_mf_finalize(&insp->mf);
       insp->mf = mf;
     }
   }
@@ -391,8 +440,30 @@ suscan_psk_inspector_commit_config(void *private)
       su_costas_set_kind(&insp->costas, SU_COSTAS_KIND_8PSK);
       break;
   }
+
+  suscan_psk_inspector_select_kernel(insp);
 }
 
+SUINLINE void
+suscan_psk_inspector_push_symbol(
+    struct suscan_psk_inspector *psk_insp,
+    suscan_inspector_t *insp,
+    SUCOMPLEX output)
+{
+  /* Apply channel equalizer, if enabled */
+  if (psk_insp->kernel.eq)
+    output = su_equalizer_feed(&psk_insp->eq, output);
+
+  /* Reduce amplitude so it fits in the constellation window */
+  suscan_inspector_push_sample(insp, output * .75);
+}
+
+/*
+ * Samples are processed in blocks, one stage at a time. The AGC, the
+ * Costas loop and the symbol synchronizer are recursive and still run
+ * sample by sample, but carrier re-centering, manual gain and the matched
+ * filter are plain loops the compiler can vectorize.
+ */
 SUSDIFF
 suscan_psk_inspector_feed(
     void *private,
@@ -400,64 +471,65 @@ suscan_psk_inspector_feed(
     const SUCOMPLEX *x,
     SUSCOUNT count)
 {
-  SUSCOUNT i;
-  SUCOMPLEX det_x;
+  SUSCOUNT i, len;
   SUCOMPLEX output;
-  SUBOOL new_sample = SU_FALSE;
   struct suscan_psk_inspector *psk_insp =
       (struct suscan_psk_inspector *) private;
+  const struct suscan_psk_inspector_kernel *kernel = &psk_insp->kernel;
+  SUCOMPLEX *y = psk_insp->block;
+  SUCOMPLEX scale = kernel->scale;
+
+  /* At most one symbol per sample: the sampler buffer cannot overflow */
+  len = SU_MIN(count, suscan_inspector_sampler_buf_avail(insp));
+  if (len > SUSCAN_PSK_INSPECTOR_BLOCK_SIZE)
+    len = SUSCAN_PSK_INSPECTOR_BLOCK_SIZE;
+
+  /* Re-center carrier, perform manual gain control */
+  if (kernel->lo) {
+    for (i = 0; i < len; ++i)
+      y[i] = x[i] * SU_C_CONJ(su_ncqo_read(&psk_insp->lo)) * scale;
+  } else {
+    for (i = 0; i < len; ++i)
+      y[i] = x[i] * scale;
+  }
 
-  for (i = 0; i < count && suscan_inspector_sampler_buf_avail(insp) > 0; ++i) {
-    /* Re-center carrier */
-    det_x = x[i] * SU_C_CONJ(su_ncqo_read(&psk_insp->lo)) * psk_insp->phase;
-
-    /* Perform gain control */
-    switch (psk_insp->cur_params.gc.gc_ctrl) {
-      case SUSCAN_INSPECTOR_GAIN_CONTROL_MANUAL:
-        det_x *= 2 * psk_insp->cur_params.gc.gc_gain;
-        break;
-
-      case SUSCAN_INSPECTOR_GAIN_CONTROL_AUTOMATIC:
-        det_x  = 2 * su_agc_feed(&psk_insp->agc, det_x);
-        break;
-    }
+  /* Perform automatic gain control */
+  if (kernel->agc)
+    for (i = 0; i < len; ++i)
+      y[i] = 2 * su_agc_feed(&psk_insp->agc, y[i]);
 
-    /* Perform frequency correction */
-    if (psk_insp->cur_params.fc.fc_ctrl
-        != SUSCAN_INSPECTOR_CARRIER_CONTROL_MANUAL) {
-      su_costas_feed(&psk_insp->costas, det_x);
-      det_x = psk_insp->costas.y;
+  /* Perform frequency correction */
+  if (kernel->costas) {
+    for (i = 0; i < len; ++i) {
+      su_costas_feed(&psk_insp->costas, y[i]);
+      y[i] = psk_insp->costas.y;
     }
+  }
 
-    /* Save for subcarrier inspection */
-    suscan_inspector_feed_sc_sample(insp, det_x);
+  /* Save for subcarrier inspection */
+  for (i = 0; i < len; ++i)
+    suscan_inspector_feed_sc_sample(insp, y[i]);
 
-    /* Add matched filter, if enabled */
-    if (psk_insp->cur_params.mf.mf_conf == SUSCAN_INSPECTOR_MATCHED_FILTER_MANUAL)
-      det_x = su_iir_filt_feed(&psk_insp->mf, det_x);
+  /* Add matched filter, if enabled */
+  if (kernel->mf)
+    suscan_inspector_block_mf_feed(&psk_insp->mf, y, len);
 
-    /* Check if channel sampler is enabled */
-    if (psk_insp->cur_params.br.br_ctrl == SUSCAN_INSPECTOR_BAUDRATE_CONTROL_MANUAL) {
-      output = det_x;
-      new_sample = su_sampler_feed(&psk_insp->sampler, &output);
-    } else {
-      /* Automatic baudrate control enabled */
-      su_clock_detector_feed(&psk_insp->cd, det_x);
-      new_sample = su_clock_detector_read(&psk_insp->cd, &output, 1) == 1;
+  if (kernel->clock_detector) {
+    /* Automatic baudrate control enabled */
+    for (i = 0; i < len; ++i) {
+      su_clock_detector_feed(&psk_insp->cd, y[i]);
+      if (su_clock_detector_read(&psk_insp->cd, &output, 1) == 1)
+        suscan_psk_inspector_push_symbol(psk_insp, insp, output);
     }
-
-    /* Apply channel equalizer, if enabled */
-    if (new_sample) {
-      if (psk_insp->cur_params.eq.eq_conf == SUSCAN_INSPECTOR_EQUALIZER_CMA) {
-        output = su_equalizer_feed(&psk_insp->eq, output);
-      }
-
-      /* Reduce amplitude so it fits in the constellation window */
-      suscan_inspector_push_sample(insp, output * .75);
+  } else {
+    for (i = 0; i < len; ++i) {
+      output = y[i];
+      if (su_sampler_feed(&psk_insp->sampler, &output))
+        suscan_psk_inspector_push_symbol(psk_insp, insp, output);
     }
   }
 
-  return i;
+  return len;
 }
 
 void
@@ -25,38 +25,519 @@
 #include <sigutils/sampling.h>
 #include <sigutils/iir.h>
 #include <sigutils/clock.h>
+#include <sigutils/util/compat-time.h>
 
 #include <analyzer/version.h>
+#include <analyzer/realtime.h>
+#include <analyzer/samplewriter.h>
 
 #include "inspector/interface.h"
 #include "inspector/params.h"
 #include "inspector/inspector.h"
+#include "inspector/factory.h"
 
 #include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#define SUSCAN_RAW_INSPECTOR_PROGRESS_INTERVAL .5
+#define SUSCAN_RAW_INSPECTOR_MAX_CAPTURES      1024
+
+/*
+ * Record mode: instead of delivering the channel samples to the client,
+ * they are written to a SigMF recording in the server side, straight from
+ * the inspector worker. Clients only receive progress signals:
+ *
+ *   record.samples: samples written to disk so far
+ *   record.dropped: samples dropped because the disk could not keep up
+ *   record.error:   errno of the last failure (recording stops)
+ *
+ * Recordings are named after their start time and channel frequency, and
+ * existing files are never overwritten. Every time the channel frequency
+ * changes, a new capture segment is added to the metadata.
+ *
+ * raw.record-dir comes from the client. Device servers restrict it with
+ * suscan_raw_inspector_restrict_recordings() before serving anyone: it
+ * must then be the name of a subdirectory of the server's recording root
+ * (or empty, for the root itself), and nothing is recorded if the server
+ * has no recording root.
+ */
+struct suscan_raw_inspector_params {
+  SUBOOL record;
+  char  *record_dir;
+};
+
+SUPRIVATE SUBOOL g_record_restricted = SU_FALSE;
+SUPRIVATE char  *g_record_root       = NULL;
+
+struct suscan_raw_inspector_capture {
+  uint64_t       sample_start;
+  SUFREQ         frequency;
+  struct timeval time;
+};
+
+struct suscan_raw_inspector {
+  struct suscan_inspector_sampling_info samp_info;
+  struct suscan_raw_inspector_params req_params;
+  struct suscan_raw_inspector_params cur_params;
+  SUBOOL params_changed;
+
+  /* Recording state */
+  suscan_sample_writer_t *writer;
+  char    *meta_path;
+  uint64_t last_progress;
+  uint64_t samples;
+  PTR_LIST(struct suscan_raw_inspector_capture, capture);
+};
+
+typedef struct suscan_raw_inspector suscan_raw_inspector_t;
+
+SUPRIVATE void
+suscan_raw_inspector_params_finalize(struct suscan_raw_inspector_params *self)
+{
+  if (self->record_dir != NULL)
+    free(self->record_dir);
+
+  memset(self, 0, sizeof(struct suscan_raw_inspector_params));
+}
+
+SUPRIVATE SUBOOL
+suscan_raw_inspector_params_copy(
+    struct suscan_raw_inspector_params *dest,
+    const struct suscan_raw_inspector_params *src)
+{
+  char *record_dir = NULL;
+
+  if (src->record_dir != NULL)
+    SU_TRYCATCH(record_dir = strdup(src->record_dir), return SU_FALSE);
+
+  suscan_raw_inspector_params_finalize(dest);
+
+  dest->record     = src->record;
+  dest->record_dir = record_dir;
+
+  return SU_TRUE;
+}
+
+/* Whether going from a to b requires a new recording */
+SUPRIVATE SUBOOL
+suscan_raw_inspector_params_differ(
+    const struct suscan_raw_inspector_params *a,
+    const struct suscan_raw_inspector_params *b)
+{
+  const char *a_dir = a->record_dir != NULL ? a->record_dir : "";
+  const char *b_dir = b->record_dir != NULL ? b->record_dir : "";
+
+  return a->record != b->record || strcmp(a_dir, b_dir) != 0;
+}
+
+SUPRIVATE SUBOOL
+suscan_raw_inspector_format_time(
+    char *buf,
+    size_t size,
+    const struct timeval *tv,
+    const char *fmt)
+{
+  struct tm tm;
+  time_t secs = tv->tv_sec;
+
+  if (gmtime_r(&secs, &tm) == NULL)
+    return SU_FALSE;
+
+  return strftime(buf, size, fmt, &tm) > 0;
+}
+
+SUPRIVATE SUBOOL
+suscan_raw_inspector_write_meta(suscan_raw_inspector_t *self)
+{
+  const struct suscan_raw_inspector_capture *capture;
+  char datetime[32];
+  FILE *fp = NULL;
+  unsigned int i;
+  SUBOOL ok = SU_FALSE;
+
+  if ((fp = fopen(self->meta_path, "w")) == NULL) {
+    SU_ERROR(
+      "Cannot write SigMF metadata to `%s': %s\n",
+      self->meta_path,
+      strerror(errno));
+    goto done;
+  }
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"global\": {\n");
+  fprintf(
+    fp,
+    "    \"core:datatype\": \"%s\",\n",
+    SUSCAN_SAMPLE_WRITER_SIGMF_DATATYPE);
+  fprintf(
+    fp,
+    "    \"core:sample_rate\": %.17g,\n",
+    (double) self->samp_info.equiv_fs);
+  fprintf(fp, "    \"core:version\": \"1.0.0\",\n");
+  fprintf(fp, "    \"core:recorder\": \"suscan " SUSCAN_VERSION_STRING "\",\n");
+  fprintf(fp, "    \"core:description\": \"Raw channel recording\"\n");
+  fprintf(fp, "  },\n");
+  fprintf(fp, "  \"captures\": [\n");
+
+  for (i = 0; i < self->capture_count; ++i) {
+    capture = self->capture_list[i];
+
+    SU_TRY(
+      suscan_raw_inspector_format_time(
+        datetime,
+        sizeof(datetime),
+        &capture->time,
+        "%Y-%m-%dT%H:%M:%S"));
+
+    fprintf(fp, "    {\n");
+    fprintf(
+      fp,
+      "      \"core:sample_start\": %llu,\n",
+      (unsigned long long) capture->sample_start);
+    fprintf(fp, "      \"core:frequency\": %.17g,\n", capture->frequency);
+    fprintf(
+      fp,
+      "      \"core:datetime\": \"%s.%06ldZ\"\n",
+      datetime,
+      (long) capture->time.tv_usec);
+    fprintf(fp, "    }%s\n", i + 1 < self->capture_count ? "," : "");
+  }
+
+  fprintf(fp, "  ],\n");
+  fprintf(fp, "  \"annotations\": []\n");
+  fprintf(fp, "}\n");
+
+  ok = !ferror(fp);
+
+done:
+  if (fp != NULL)
+    fclose(fp);
+
+  return ok;
+}
+
+SUPRIVATE SUBOOL
+suscan_raw_inspector_add_capture(
+    suscan_raw_inspector_t *self,
+    suscan_inspector_t *insp,
+    SUFREQ frequency)
+{
+  struct suscan_raw_inspector_capture *capture = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  /* Hopping channels would make the metadata grow forever */
+  if (self->capture_count >= SUSCAN_RAW_INSPECTOR_MAX_CAPTURES)
+    return SU_TRUE;
+
+  SU_ALLOCATE(capture, struct suscan_raw_inspector_capture);
+
+  capture->sample_start = self->samples;
+  capture->frequency    = frequency;
+  suscan_inspector_factory_get_time(insp->factory, &capture->time);
+
+  SU_TRYC(PTR_LIST_APPEND_CHECK(self->capture, capture));
+  capture = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (capture != NULL)
+    free(capture);
+
+  return ok;
+}
+
+SUPRIVATE void
+suscan_raw_inspector_stop_recording(
+    suscan_raw_inspector_t *self,
+    suscan_inspector_t *insp)
+{
+  unsigned int i;
+
+  if (self->writer != NULL) {
+    /* Flushes pending samples */
+    suscan_sample_writer_destroy(self->writer);
+    self->writer = NULL;
+
+    if (!suscan_raw_inspector_write_meta(self))
+      SU_WARNING("SigMF metadata may be incomplete\n");
+
+    if (insp != NULL) {
+      suscan_inspector_send_signal(insp, "record.samples", self->samples);
+      suscan_inspector_set_local_output(insp, SU_FALSE);
+    }
+  }
+
+  if (self->meta_path != NULL) {
+    free(self->meta_path);
+    self->meta_path = NULL;
+  }
+
+  for (i = 0; i < self->capture_count; ++i)
+    free(self->capture_list[i]);
+
+  if (self->capture_list != NULL)
+    free(self->capture_list);
+
+  self->capture_list  = NULL;
+  self->capture_count = 0;
+  self->samples       = 0;
+}
+
+/* Not thread safe: call it before creating any analyzer */
+SUBOOL
+suscan_raw_inspector_restrict_recordings(const char *root)
+{
+  char *dup = NULL;
+
+  if (root != NULL)
+    SU_TRYCATCH(dup = strdup(root), return SU_FALSE);
+
+  if (g_record_root != NULL)
+    free(g_record_root);
+
+  g_record_root       = dup;
+  g_record_restricted = SU_TRUE;
+
+  return SU_TRUE;
+}
+
+/* Returns the directory to record to, or NULL with errno set */
+SUPRIVATE char *
+suscan_raw_inspector_resolve_dir(const char *dir)
+{
+  if (!g_record_restricted)
+    return strdup(dir != NULL && *dir != '\0' ? dir : ".");
+
+  if (g_record_root == NULL) {
+    SU_ERROR("Channel recordings are disabled in this server\n");
+    errno = EACCES;
+    return NULL;
+  }
+
+  if (dir == NULL || *dir == '\0')
+    return strdup(g_record_root);
+
+  if (strchr(dir, '/') != NULL
+      || strchr(dir, '\\') != NULL
+      || strcmp(dir, ".") == 0
+      || strcmp(dir, "..") == 0) {
+    SU_ERROR("Invalid recording subdirectory `%s'\n", dir);
+    errno = EACCES;
+    return NULL;
+  }
+
+  return strbuild("%s/%s", g_record_root, dir);
+}
+
+SUPRIVATE SUBOOL
+suscan_raw_inspector_start_recording(
+    suscan_raw_inspector_t *self,
+    suscan_inspector_t *insp)
+{
+  char *dir = NULL;
+  char *base = NULL;
+  char *data_path = NULL;
+  char stamp[32];
+  struct timeval tv;
+  SUFREQ freq;
+  SUBOOL ok = SU_FALSE;
+
+  freq = suscan_inspector_factory_get_inspector_freq(insp->factory, insp);
+  suscan_inspector_factory_get_time(insp->factory, &tv);
+
+  SU_TRY(
+    suscan_raw_inspector_format_time(
+      stamp,
+      sizeof(stamp),
+      &tv,
+      "%Y%m%d_%H%M%S"));
+
+  if ((dir = suscan_raw_inspector_resolve_dir(self->cur_params.record_dir))
+      == NULL) {
+    suscan_inspector_send_signal(insp, "record.error", errno);
+    goto done;
+  }
+
+  SU_TRY(
+    base = strbuild(
+      "%s/suscan-rec-%sZ-%.0lf-%.0lf",
+      dir,
+      stamp,
+      freq,
+      (double) self->samp_info.equiv_fs));
+
+  SU_TRY(data_path = strbuild("%s.sigmf-data", base));
+  SU_TRY(self->meta_path = strbuild("%s.sigmf-meta", base));
+
+  if ((self->writer = suscan_sample_writer_new(data_path)) == NULL) {
+    suscan_inspector_send_signal(insp, "record.error", errno);
+    goto done;
+  }
+
+  SU_TRY(suscan_raw_inspector_add_capture(self, insp, freq));
+
+  /* Leave a valid recording behind, even if we crash */
+  SU_TRY(suscan_raw_inspector_write_meta(self));
+
+  SU_INFO("Recording channel to %s\n", data_path);
+
+  self->last_progress = suscan_gettime();
+  suscan_inspector_set_local_output(insp, SU_TRUE);
+
+  ok = SU_TRUE;
+
+done:
+  if (!ok)
+    suscan_raw_inspector_stop_recording(self, NULL);
+
+  if (dir != NULL)
+    free(dir);
+
+  if (base != NULL)
+    free(base);
+
+  if (data_path != NULL)
+    free(data_path);
+
+  return ok;
+}
+
+SUPRIVATE SUBOOL
+suscan_raw_inspector_record(
+    suscan_raw_inspector_t *self,
+    suscan_inspector_t *insp,
+    const SUCOMPLEX *x,
+    SUSCOUNT count)
+{
+  const struct suscan_raw_inspector_capture *last;
+  uint64_t now;
+  SUFREQ freq;
+
+  /* Retuned channel: new capture segment */
+  freq = suscan_inspector_factory_get_inspector_freq(insp->factory, insp);
+  last = self->capture_list[self->capture_count - 1];
+  if (freq != last->frequency)
+    SU_TRYCATCH(
+      suscan_raw_inspector_add_capture(self, insp, freq),
+      return SU_FALSE);
+
+  if (!suscan_sample_writer_write(self->writer, x, count)) {
+    suscan_inspector_send_signal(
+      insp,
+      "record.error",
+      suscan_sample_writer_get_error(self->writer));
+    return SU_FALSE;
+  }
+
+  self->samples += count;
+
+  now = suscan_gettime();
+  if ((now - self->last_progress) * 1e-9
+    >= SUSCAN_RAW_INSPECTOR_PROGRESS_INTERVAL) {
+    self->last_progress = now;
+
+    suscan_inspector_send_signal(
+      insp,
+      "record.samples",
+      suscan_sample_writer_get_written(self->writer));
+
+    if (suscan_sample_writer_get_dropped(self->writer) > 0)
+      suscan_inspector_send_signal(
+        insp,
+        "record.dropped",
+        suscan_sample_writer_get_dropped(self->writer));
+  }
+
+  return SU_TRUE;
+}
 
 /************************** API implementation *******************************/
 void *
 suscan_raw_inspector_open(const struct suscan_inspector_sampling_info *s)
 {
-  return (void *) s;
+  suscan_raw_inspector_t *new = NULL;
+
+  SU_ALLOCATE_FAIL(new, suscan_raw_inspector_t);
+
+  new->samp_info = *s;
+
+  return new;
+
+fail:
+  return NULL;
 }
 
 SUBOOL
 suscan_raw_inspector_get_config(void *private, suscan_config_t *config)
 {
+  suscan_raw_inspector_t *self = (suscan_raw_inspector_t *) private;
+
+  SU_TRYCATCH(
+    suscan_config_set_bool(config, "raw.record", self->cur_params.record),
+    return SU_FALSE);
+
+  SU_TRYCATCH(
+    suscan_config_set_string(
+      config,
+      "raw.record-dir",
+      self->cur_params.record_dir != NULL ? self->cur_params.record_dir : ""),
+    return SU_FALSE);
+
   return SU_TRUE;
 }
 
 SUBOOL
 suscan_raw_inspector_parse_config(void *private, const suscan_config_t *config)
 {
-  return SU_TRUE;
+  suscan_raw_inspector_t *self = (suscan_raw_inspector_t *) private;
+  struct suscan_field_value *value;
+  struct suscan_raw_inspector_params params;
+  SUBOOL ok = SU_FALSE;
+
+  memset(&params, 0, sizeof(struct suscan_raw_inspector_params));
+
+  SU_TRY(value = suscan_config_get_value(config, "raw.record"));
+  SU_TRY(value->field->type == SUSCAN_FIELD_TYPE_BOOLEAN);
+  params.record = value->as_bool;
+
+  SU_TRY(value = suscan_config_get_value(config, "raw.record-dir"));
+  SU_TRY(value->field->type == SUSCAN_FIELD_TYPE_STRING);
+  SU_TRY(params.record_dir = strdup(value->as_string));
+
+  suscan_raw_inspector_params_finalize(&self->req_params);
+  self->req_params = params;
+  memset(&params, 0, sizeof(struct suscan_raw_inspector_params));
+
+  ok = SU_TRUE;
+
+done:
+  suscan_raw_inspector_params_finalize(&params);
+
+  return ok;
 }
 
 /* Called inside inspector mutex */
 void
 suscan_raw_inspector_commit_config(void *private)
 {
+  suscan_raw_inspector_t *self = (suscan_raw_inspector_t *) private;
+
+  /* Do not interrupt the current recording if nothing changed */
+  if (!suscan_raw_inspector_params_differ(
+      &self->cur_params,
+      &self->req_params))
+    return;
+
+  /* req_params stay as they are, they may be committed again */
+  if (!suscan_raw_inspector_params_copy(&self->cur_params, &self->req_params)) {
+    SU_ERROR("Cannot apply new recording parameters\n");
+    return;
+  }
+
+  /* Recordings are started and stopped from the feed method */
+  self->params_changed = SU_TRUE;
 }
 
 SUSDIFF
@@ -66,13 +547,43 @@ suscan_raw_inspector_feed(
     const SUCOMPLEX *x,
     SUSCOUNT count)
 {
-  /* Pass-thru */
-  return suscan_inspector_push_sample_buffer(insp, x, count);
+  suscan_raw_inspector_t *self = (suscan_raw_inspector_t *) private;
+
+  if (self->params_changed) {
+    self->params_changed = SU_FALSE;
+
+    /* A change in the recording parameters starts a new recording */
+    suscan_raw_inspector_stop_recording(self, insp);
+
+    if (self->cur_params.record)
+      if (!suscan_raw_inspector_start_recording(self, insp))
+        SU_ERROR("Failed to start recording\n");
+  }
+
+  if (self->writer == NULL) {
+    /* Pass-thru */
+    return suscan_inspector_push_sample_buffer(insp, x, count);
+  }
+
+  if (!suscan_raw_inspector_record(self, insp, x, count)) {
+    SU_ERROR("Recording stopped due to errors\n");
+    suscan_raw_inspector_stop_recording(self, insp);
+  }
+
+  return count;
 }
 
 void
 suscan_raw_inspector_close(void *private)
 {
+  suscan_raw_inspector_t *self = (suscan_raw_inspector_t *) private;
+
+  suscan_raw_inspector_stop_recording(self, NULL);
+
+  suscan_raw_inspector_params_finalize(&self->req_params);
+  suscan_raw_inspector_params_finalize(&self->cur_params);
+
+  free(self);
 }
 
 SUPRIVATE struct suscan_inspector_interface iface = {
@@ -89,17 +600,42 @@ SUPRIVATE struct suscan_inspector_interface iface = {
 SUBOOL
 suscan_raw_inspector_register(void)
 {
-  SU_TRYCATCH(
-      iface.cfgdesc = suscan_config_desc_new_ex(
-          "raw-params-desc-" SUSCAN_VERSION_STRING),
-      return SU_FALSE);
+  suscan_config_desc_t *desc = NULL;
+
+  SU_TRY_FAIL(
+      desc = suscan_config_desc_new_ex(
+          "raw-params-desc-" SUSCAN_VERSION_STRING));
+
+  SU_TRY_FAIL(
+    suscan_config_desc_add_field(
+      desc,
+      SUSCAN_FIELD_TYPE_BOOLEAN,
+      SU_TRUE,
+      "raw.record",
+      "Record channel to disk instead of sending samples"));
 
-  SU_TRYCATCH(suscan_config_desc_register(iface.cfgdesc), return SU_FALSE);
+  SU_TRY_FAIL(
+    suscan_config_desc_add_field(
+      desc,
+      SUSCAN_FIELD_TYPE_STRING,
+      SU_TRUE,
+      "raw.record-dir",
+      "Directory of the channel recordings"));
+
+  iface.cfgdesc = desc;
+  desc = NULL;
+  SU_TRY_FAIL(suscan_config_desc_register(iface.cfgdesc));
 
   (void) suscan_inspector_interface_add_spectsrc(&iface, "psd");
-  
+
   /* Register inspector interface */
-  SU_TRYCATCH(suscan_inspector_interface_register(&iface), return SU_FALSE);
+  SU_TRY_FAIL(suscan_inspector_interface_register(&iface));
 
   return SU_TRUE;
+
+fail:
+  if (desc != NULL)
+    suscan_config_desc_destroy(desc);
+
+  return SU_FALSE;
 }
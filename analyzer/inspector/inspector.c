@@ -533,13 +533,26 @@ suscan_inspector_spectrum_loop(
     const SUCOMPLEX *samp_buf,
     SUSCOUNT samp_count)
 {
-  suscan_spectsrc_t *src = NULL;
-  SUSDIFF fed;
-
-  if (insp->spectsrc_index > 0) {
-    src = insp->spectsrc_list[insp->spectsrc_index - 1];
-
-    if (suscan_inspector_is_freq_domain(insp)) {
+  unsigned int i, count;
+  uint32_t subs = insp->spectsrc_subscriptions;
+
+  /* Spectrum source changes are requested by the server thread */
+  SU_TRY_FAIL(
+    suscan_spectsrc_engine_select(insp->spect_engine, insp->spectsrc_index));
+
+  count = suscan_spectsrc_engine_get_count(insp->spect_engine);
+  if (count > SUSCAN_INSPECTOR_MAX_SPECTSRC_SUBSCRIPTIONS)
+    count = SUSCAN_INSPECTOR_MAX_SPECTSRC_SUBSCRIPTIONS;
+
+  for (i = 0; i < count; ++i)
+    SU_TRY_FAIL(
+      suscan_spectsrc_engine_subscribe(
+        insp->spect_engine,
+        i,
+        (subs >> i) & 1));
+
+  if (suscan_inspector_is_freq_domain(insp)) {
+    if (insp->spectsrc_index > 0) {
       uint64_t interval = insp->interval_spectrum * 1e9;
       uint64_t now = suscan_gettime();
       if (now - insp->last_spectrum > interval) {
@@ -551,16 +564,10 @@ suscan_inspector_spectrum_loop(
             samp_buf,
             samp_count));
       }
-    } else {
-      while (samp_count > 0) {
-        fed = suscan_spectsrc_feed(src, samp_buf, samp_count);
-
-        SU_TRY_FAIL(fed >= 0);
-
-        samp_buf   += fed;
-        samp_count -= fed;
-      }
     }
+  } else {
+    SU_TRY_FAIL(
+      suscan_spectsrc_engine_feed(insp->spect_engine, samp_buf, samp_count));
   }
 
   return SU_TRUE;
@@ -611,6 +618,7 @@ suscan_inspector_estimator_loop(
     SUSCOUNT samp_count)
 {
   struct suscan_analyzer_inspector_msg *msg = NULL;
+  suscan_estimator_engine_t *engine = insp->estimator_engine;
   unsigned int i;
   uint64_t now;
   SUFLOAT value;
@@ -622,17 +630,15 @@ suscan_inspector_estimator_loop(
     seconds = (now - insp->last_estimator) * 1e-9;
     if (seconds >= insp->interval_estimator) {
       insp->last_estimator = now;
-      for (i = 0; i < insp->estimator_count; ++i)
-        if (suscan_estimator_is_enabled(insp->estimator_list[i])) {
-          if (suscan_estimator_is_enabled(insp->estimator_list[i]))
-            SU_TRYCATCH(
-                suscan_estimator_feed(
-                    insp->estimator_list[i],
-                    samp_buf,
-                    samp_count),
-                goto fail);
 
-          if (suscan_estimator_read(insp->estimator_list[i], &value)) {
+      /* Shared products are computed once for all estimators */
+      SU_TRYCATCH(
+          suscan_estimator_engine_feed(engine, samp_buf, samp_count),
+          goto fail);
+
+      for (i = 0; i < engine->estimator_count; ++i)
+        if (suscan_estimator_is_enabled(engine->estimator_list[i])) {
+          if (suscan_estimator_engine_read(engine, i, &value)) {
             SU_TRYCATCH(
                 msg = suscan_analyzer_inspector_msg_new(
                     SUSCAN_ANALYZER_INSPECTOR_MSGKIND_ESTIMATOR,
@@ -826,6 +832,64 @@ suscan_inspector_assert_params(suscan_inspector_t *insp)
   }
 }
 
+/*
+ * Idle suspension. An inspector whose output is not being consumed keeps
+ * its channel open (and its frequency corrections going), but skips the
+ * demodulation chain altogether. This is driven by the consumer only:
+ *
+ *   - The consumer of mq_out reported it cannot keep up (e.g. the devserv
+ *     client TX queue is full), or
+ *   - The consumer disabled every output: sample batches (watermark 0),
+ *     spectrum sources, estimators and subcarrier inspectors.
+ *
+ * An inspector that simply has not produced anything in a while (e.g.
+ * a power inspector with a long integration time) is never suspended.
+ * Inspectors resume as soon as the consumer state changes.
+ */
+SUPRIVATE SUBOOL
+suscan_inspector_has_consumers(const suscan_inspector_t *insp)
+{
+  const suscan_estimator_engine_t *engine = insp->estimator_engine;
+  unsigned int i;
+
+  if (insp->sample_output)
+    return SU_TRUE;
+
+  if (insp->spectsrc_index > 0 || insp->spectsrc_subscriptions != 0)
+    return SU_TRUE;
+
+  if (insp->sc_factory != NULL && insp->sc_factory->inspector_count > 0)
+    return SU_TRUE;
+
+  for (i = 0; i < engine->estimator_count; ++i)
+    if (suscan_estimator_is_enabled(engine->estimator_list[i]))
+      return SU_TRUE;
+
+  return SU_FALSE;
+}
+
+SUBOOL
+suscan_inspector_check_suspension(suscan_inspector_t *insp)
+{
+  SUBOOL suspended;
+
+  if (insp->local_output)
+    suspended = SU_FALSE;
+  else
+    suspended = insp->consumer_stalled
+      || !suscan_inspector_has_consumers(insp);
+
+  if (suspended != insp->suspended)
+    SU_INFO(
+      "Inspector 0x%x: %s\n",
+      insp->handle,
+      suspended ? "nobody consumes its output, suspending" : "resuming");
+
+  insp->suspended = suspended;
+
+  return !suspended;
+}
+
 void
 suscan_inspector_destroy(suscan_inspector_t *self)
 {
@@ -854,17 +918,11 @@ suscan_inspector_destroy(suscan_inspector_t *self)
   if (self->privdata != NULL)
     (self->iface->close) (self->privdata);
 
-  for (i = 0; i < self->estimator_count; ++i)
-    suscan_estimator_destroy(self->estimator_list[i]);
+  if (self->estimator_engine != NULL)
+    suscan_estimator_engine_destroy(self->estimator_engine);
 
-  if (self->estimator_list != NULL)
-    free(self->estimator_list);
-
-  for (i = 0; i < self->spectsrc_count; ++i)
-    suscan_spectsrc_destroy(self->spectsrc_list[i]);
-
-  if (self->spectsrc_list != NULL)
-    free(self->spectsrc_list);
+  if (self->spect_engine != NULL)
+    suscan_spectsrc_engine_destroy(self->spect_engine);
 
   free(self);
 }
@@ -885,13 +943,10 @@ suscan_inspector_set_throttle_factor(
   suscan_inspector_t *self,
   SUFLOAT factor)
 {
-  unsigned int i;
-
   if (factor <= 0.)
     factor = 1.;
     
-  for (i = 0; i < self->spectsrc_count; ++i)
-    suscan_spectsrc_set_throttle_factor(self->spectsrc_list[i], factor);
+  suscan_spectsrc_engine_set_throttle_factor(self->spect_engine, factor);
 }
 
 void
@@ -928,28 +983,13 @@ suscan_inspector_add_estimator(
     suscan_inspector_t *insp,
     const struct suscan_estimator_class *class)
 {
-  suscan_estimator_t *estimator = NULL;
-
-  SU_TRYCATCH(
-      estimator = suscan_estimator_new(class, insp->samp_info.equiv_fs),
-      goto fail);
-
-  SU_TRYCATCH(
-      PTR_LIST_APPEND_CHECK(insp->estimator, estimator) != -1,
-      goto fail);
-
-  return SU_TRUE;
-
-fail:
-  if (estimator != NULL)
-    suscan_estimator_destroy(estimator);
-
-  return SU_FALSE;
+  return suscan_estimator_engine_add_class(insp->estimator_engine, class);
 }
 
 SUPRIVATE SUBOOL
 suscan_inspector_on_spectrum_data(
     void *userdata,
+    unsigned int index,
     const SUFLOAT *spectrum,
     SUSCOUNT size)
 {
@@ -965,7 +1005,7 @@ suscan_inspector_on_spectrum_data(
       goto done);
 
   msg->inspector_id  = insp->inspector_id;
-  msg->spectsrc_id   = insp->spectsrc_index;
+  msg->spectsrc_id   = index + 1;
   msg->samp_rate     = insp->samp_info.equiv_fs;
   msg->spectrum_size = size;
 
@@ -1000,29 +1040,14 @@ suscan_inspector_add_spectsrc(
     suscan_inspector_t *insp,
     const struct suscan_spectsrc_class *class)
 {
-  suscan_spectsrc_t *src = NULL;
   SUBOOL ok = SU_FALSE;
 
-  SU_MAKE(
-    src,
-    suscan_spectsrc,
-    class,
-    insp->samp_info.equiv_fs,
-    1. / insp->interval_spectrum,
-    SUSCAN_INSPECTOR_SPECTRUM_BUF_SIZE,
-    SU_CHANNEL_DETECTOR_WINDOW_BLACKMANN_HARRIS,
-    suscan_inspector_on_spectrum_data,
-    insp);
-
-  SU_TRYC(PTR_LIST_APPEND_CHECK(insp->spectsrc, src));
-  src = NULL;
+  /* Sources are instantiated by the engine, once selected */
+  SU_TRY(suscan_spectsrc_engine_add_class(insp->spect_engine, class));
 
   ok = SU_TRUE;
 
 done:
-  if (src != NULL)
-    suscan_spectsrc_destroy(src);
-
   return ok;
 }
 
@@ -1153,6 +1178,9 @@ suscan_inspector_new(
   new->last_estimator = suscan_gettime();
   new->last_spectrum  = suscan_gettime();
 
+  /* Sample batches are delivered until the consumer disables them */
+  new->sample_output  = SU_TRUE;
+
   /* All set to call specific inspector */
   new->iface = iface;
   SU_TRYCATCH(new->privdata = (iface->open) (&new->samp_info), goto fail);
@@ -1189,11 +1217,26 @@ suscan_inspector_new(
   }
   
   /* Creation successful! Add all estimators and spectrum sources */
+  SU_TRYCATCH(
+      new->spect_engine = suscan_spectsrc_engine_new(
+          new->samp_info.equiv_fs,
+          1. / new->interval_spectrum,
+          SUSCAN_INSPECTOR_SPECTRUM_BUF_SIZE,
+          SU_CHANNEL_DETECTOR_WINDOW_BLACKMANN_HARRIS,
+          suscan_inspector_on_spectrum_data,
+          new),
+      goto fail);
+
   for (i = 0; i < iface->spectsrc_count; ++i)
     SU_TRYCATCH(
         suscan_inspector_add_spectsrc(new, iface->spectsrc_list[i]),
         goto fail);
 
+  SU_TRYCATCH(
+      new->estimator_engine = suscan_estimator_engine_new(
+          new->samp_info.equiv_fs),
+      goto fail);
+
   for (i = 0; i < iface->estimator_count; ++i)
     SU_TRYCATCH(
         suscan_inspector_add_estimator(new, iface->estimator_list[i]),
@@ -1247,6 +1290,7 @@ suscan_init_inspectors(void)
   SU_TRYCATCH(suscan_audio_inspector_register(), return SU_FALSE);
   SU_TRYCATCH(suscan_raw_inspector_register(),   return SU_FALSE);
   SU_TRYCATCH(suscan_power_inspector_register(), return SU_FALSE);
+  SU_TRYCATCH(suscan_powerbank_inspector_register(), return SU_FALSE);
   SU_TRYCATCH(suscan_drift_inspector_register(), return SU_FALSE);
   SU_TRYCATCH(suscan_multicarrier_inspector_register(),   return SU_FALSE);
 
@@ -39,6 +39,9 @@ extern "C" {
 #define SUSCAN_INSPECTOR_SAMPLER_BUF_SIZE  65536
 #define SUSCAN_INSPECTOR_SPECTRUM_BUF_SIZE 8192
 
+/* Spectrum sources that can be subscribed to, one bit each */
+#define SUSCAN_INSPECTOR_MAX_SPECTSRC_SUBSCRIPTIONS 32
+
 struct suscan_inspector_factory;
 
 enum suscan_aync_state {
@@ -86,6 +89,7 @@ struct suscan_inspector {
   uint64_t last_orbit_report;
 
   uint32_t spectsrc_index;
+  uint32_t spectsrc_subscriptions; /* Bit n: spectsrc_id n + 1 */
 
   SUBOOL    params_requested;    /* New parameters requested */
   SUBOOL    bandwidth_notified;  /* New bandwidth set */
@@ -102,8 +106,14 @@ struct suscan_inspector {
   SUSCOUNT  sampler_ptr;
   SUSCOUNT  sample_msg_watermark; /* Watermark. When reached, message is sent */
   
-  PTR_LIST(suscan_estimator_t, estimator); /* Parameter estimators */
-  PTR_LIST(suscan_spectsrc_t, spectsrc); /* Spectrum source */
+  suscan_estimator_engine_t *estimator_engine; /* Parameter estimators */
+  suscan_spectsrc_engine_t *spect_engine; /* Spectrum sources */
+
+  /* Idle suspension */
+  SUBOOL   sample_output;     /* Consumer wants sample batches */
+  SUBOOL   consumer_stalled;  /* Consumer cannot keep up with mq_out */
+  SUBOOL   suspended;         /* Demodulation chain not running */
+  SUBOOL   local_output;      /* Output does not go through mq_out */
 };
 
 typedef struct suscan_inspector suscan_inspector_t;
@@ -175,6 +185,40 @@ suscan_inspector_set_msg_watermark(suscan_inspector_t *self, SUSCOUNT wm)
   return SU_TRUE;
 }
 
+SUINLINE SUBOOL
+suscan_inspector_is_suspended(const suscan_inspector_t *self)
+{
+  return self->suspended;
+}
+
+SUINLINE void
+suscan_inspector_set_sample_output(suscan_inspector_t *self, SUBOOL enabled)
+{
+  self->sample_output = enabled;
+}
+
+/* Whether the demodulation chain output goes somewhere */
+SUINLINE SUBOOL
+suscan_inspector_has_sample_output(const suscan_inspector_t *self)
+{
+  return self->sample_output || self->local_output;
+}
+
+/* Inspectors writing their output elsewhere (e.g. disk) are never idle */
+SUINLINE void
+suscan_inspector_set_local_output(suscan_inspector_t *self, SUBOOL local)
+{
+  self->local_output = local;
+}
+
+SUINLINE void
+suscan_inspector_set_consumer_stalled(
+  suscan_inspector_t *self,
+  SUBOOL stalled)
+{
+  self->consumer_stalled = stalled;
+}
+
 SUINLINE SUSCOUNT
 suscan_inspector_sampler_buf_avail(const suscan_inspector_t *self)
 {
@@ -292,6 +336,8 @@ SUBOOL suscan_inspector_deliver_report(
 
 void suscan_inspector_assert_params(suscan_inspector_t *insp);
 
+SUBOOL suscan_inspector_check_suspension(suscan_inspector_t *insp);
+
 void suscan_inspector_destroy(suscan_inspector_t *insp);
 
 SUBOOL suscan_inspector_set_config(
@@ -366,9 +412,13 @@ SUBOOL suscan_psk_inspector_register(void);
 SUBOOL suscan_audio_inspector_register(void);
 SUBOOL suscan_raw_inspector_register(void);
 SUBOOL suscan_power_inspector_register(void);
+SUBOOL suscan_powerbank_inspector_register(void);
 SUBOOL suscan_multicarrier_inspector_register(void);
 SUBOOL suscan_drift_inspector_register(void);
 
+/* Confine raw inspector recordings to root (NULL disables them) */
+SUBOOL suscan_raw_inspector_restrict_recordings(const char *root);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -614,6 +614,14 @@ suscan_config_desc_add_fsk_params(suscan_config_desc_t *desc)
           "Use traditional argument-based quadrature demodultor"),
       return SU_FALSE);
 
+  SU_TRYCATCH(
+      suscan_config_desc_add_field(
+          desc,
+          SUSCAN_FIELD_TYPE_BOOLEAN,
+          SU_TRUE,
+          "fsk.slice",
+          "Slice symbols to the nearest FSK tone"),
+      return SU_FALSE);
 
   return SU_TRUE;
 }
@@ -655,6 +663,15 @@ suscan_inspector_fsk_params_parse(
 
   params->quad_demod = value->as_bool;
 
+  SU_TRYCATCH(
+      value = suscan_config_get_value(
+          config,
+          "fsk.slice"),
+      return SU_FALSE);
+
+  SU_TRYCATCH(value->field->type == SUSCAN_FIELD_TYPE_BOOLEAN, return SU_FALSE);
+
+  params->slice = value->as_bool;
   
   return SU_TRUE;
 }
@@ -678,6 +695,13 @@ suscan_inspector_fsk_params_save(
       params->phase),
     return SU_FALSE);
 
+  SU_TRYCATCH(
+    suscan_config_set_bool(
+      config,
+      "fsk.slice",
+      params->slice),
+    return SU_FALSE);
+
   return SU_TRUE;
 
 }
@@ -1044,6 +1068,24 @@ suscan_config_desc_add_multicarrier_params(suscan_config_desc_t *desc)
           "Forward samples to subchannels"),
       return SU_FALSE);
 
+  SU_TRYCATCH(
+      suscan_config_desc_add_field(
+          desc,
+          SUSCAN_FIELD_TYPE_INTEGER,
+          SU_TRUE,
+          "mc.subcarriers",
+          "Number of subcarriers"),
+      return SU_FALSE);
+
+  SU_TRYCATCH(
+      suscan_config_desc_add_field(
+          desc,
+          SUSCAN_FIELD_TYPE_INTEGER,
+          SU_TRUE,
+          "mc.output",
+          "Subcarrier output (0: none, 1: symbols, 2: power)"),
+      return SU_FALSE);
+
   return SU_TRUE;
 }
 
@@ -1064,6 +1106,36 @@ suscan_inspector_multicarrier_params_parse(
 
   params->enabled = value->as_bool;
 
+  SU_TRYCATCH(
+      value = suscan_config_get_value(
+        config,
+        "mc.subcarriers"),
+      return SU_FALSE);
+
+  SU_TRYCATCH(value->field->type == SUSCAN_FIELD_TYPE_INTEGER, return SU_FALSE);
+
+  params->subcarriers = value->as_int;
+
+  SU_TRYCATCH(
+      value = suscan_config_get_value(
+        config,
+        "mc.output"),
+      return SU_FALSE);
+
+  SU_TRYCATCH(value->field->type == SUSCAN_FIELD_TYPE_INTEGER, return SU_FALSE);
+
+  switch (value->as_int) {
+    case SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_NONE:
+    case SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_SYMBOLS:
+    case SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_POWER:
+      params->output = value->as_int;
+      break;
+
+    default:
+      SU_ERROR("Invalid multicarrier output %d\n", (int) value->as_int);
+      return SU_FALSE;
+  }
+
   return SU_TRUE;
 }
 
@@ -1079,5 +1151,19 @@ suscan_inspector_multicarrier_params_save(
         params->enabled),
     return SU_FALSE);
 
+  SU_TRYCATCH(
+    suscan_config_set_integer(
+        config,
+        "mc.subcarriers",
+        params->subcarriers),
+    return SU_FALSE);
+
+  SU_TRYCATCH(
+    suscan_config_set_integer(
+        config,
+        "mc.output",
+        params->output),
+    return SU_FALSE);
+
   return SU_TRUE;
 }
@@ -134,6 +134,7 @@ struct suscan_inspector_fsk_params {
   unsigned int bits_per_tone; /* Bits per symbol (dummy) */
   SUBOOL quad_demod;
   SUFLOAT phase; /* Demodulator phase */
+  SUBOOL slice;  /* Snap symbols to the center of their tone */
 };
 
 SUBOOL suscan_config_desc_add_fsk_params(suscan_config_desc_t *desc);
@@ -195,8 +196,16 @@ SUBOOL suscan_inspector_audio_params_save(
     suscan_config_t *config);
 
 /*************************** Multicarrier config ******************************/
+enum suscan_inspector_multicarrier_output {
+  SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_NONE,
+  SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_SYMBOLS,
+  SUSCAN_INSPECTOR_MULTICARRIER_OUTPUT_POWER
+};
+
 struct suscan_inspector_multicarrier_params {
   SUBOOL enabled;
+  unsigned int subcarriers; /* Number of subcarriers of the filter bank */
+  enum suscan_inspector_multicarrier_output output;
 };
 
 SUBOOL suscan_config_desc_add_multicarrier_params(suscan_config_desc_t *desc);
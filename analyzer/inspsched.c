@@ -141,6 +141,10 @@ suscan_inpsched_task_cb(
 
   switch (task_info->type) {
     case SUSCAN_INSPECTOR_TASK_INFO_TYPE_SAMPLES:
+      /* Nobody is consuming the output of this inspector: skip block */
+      if (!suscan_inspector_check_suspension(task_info->inspector))
+        break;
+
       /* Feed all enabled estimators */
       SU_TRYCATCH(
           suscan_inspector_estimator_loop(
@@ -159,14 +163,16 @@ suscan_inpsched_task_cb(
 
       /*
       * We just process the incoming data. If we broke something,
-      * mark the inspector as halted.
+      * mark the inspector as halted. Nobody wants sample batches
+      * from this inspector: skip the demodulation chain.
       */
-      SU_TRYCATCH(
-          suscan_inspector_sampler_loop(
-              task_info->inspector,
-              task_info->samples.data,
-              task_info->samples.size),
-          goto fail);
+      if (suscan_inspector_has_sample_output(task_info->inspector))
+        SU_TRYCATCH(
+            suscan_inspector_sampler_loop(
+                task_info->inspector,
+                task_info->samples.data,
+                task_info->samples.size),
+            goto fail);
       break;
 
     case SUSCAN_INSPECTOR_TASK_INFO_TYPE_NEW_FREQ:
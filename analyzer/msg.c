@@ -184,6 +184,7 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_psd_msg)
 
   SUSCAN_PACK(int,   self->fc);
   SUSCAN_PACK(uint,  self->inspector_id);
+  SUSCAN_PACK(uint,  self->source_index);
   SUSCAN_PACK(uint,  self->timestamp.tv_sec);
   SUSCAN_PACK(uint,  self->timestamp.tv_usec);
   SUSCAN_PACK(uint,  self->rt_time.tv_sec);
@@ -193,13 +194,37 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_psd_msg)
   SUSCAN_PACK(float, self->samp_rate);
   SUSCAN_PACK(float, self->measured_samp_rate);
   SUSCAN_PACK(float, self->N0);
+  SUSCAN_PACK(uint,  self->codec.encoding);
 
-  SU_TRYCATCH(
-      suscan_pack_compact_single_array(
-          buffer,
-          self->psd_data,
-          self->psd_size),
-      goto fail);
+  if (self->stream != NULL
+    && suscan_psd_codec_params_has_deltas(&self->codec)) {
+    SU_TRYCATCH(
+        suscan_psd_stream_pack(
+            self->stream,
+            buffer,
+            &self->codec,
+            self->fc,
+            self->psd_data,
+            self->psd_size),
+        goto fail);
+  } else if (suscan_psd_encoding_is_quantized(self->codec.encoding)) {
+    SU_TRYCATCH(
+        suscan_psd_codec_pack(
+            buffer,
+            &self->codec,
+            self->psd_data,
+            self->psd_size),
+        goto fail);
+  } else {
+    SU_TRYCATCH(
+        suscan_pack_compact_single_array_segmented(
+            buffer,
+            self->segments,
+            self->psd_data,
+            self->psd_size,
+            self->little_endian),
+        goto fail);
+  }
 
   SUSCAN_PACK_BOILERPLATE_END;
 }
@@ -212,6 +237,7 @@ SUSCAN_PARTIAL_DESERIALIZER_PROTO(suscan_analyzer_psd_msg)
 
   SUSCAN_UNPACK(int64,  self->fc);
   SUSCAN_UNPACK(uint32, self->inspector_id);
+  SUSCAN_UNPACK(uint32, self->source_index);
 
   SUSCAN_UNPACK(uint64, tv_sec);
   SUSCAN_UNPACK(uint32, tv_usec);
@@ -234,16 +260,33 @@ SUSCAN_PARTIAL_DESERIALIZER_PROTO(suscan_analyzer_psd_msg)
 
 SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_psd_msg)
 {
+  uint8_t encoding;
   SUSCAN_UNPACK_BOILERPLATE_START;
 
   SU_TRY_FAIL(
     suscan_analyzer_psd_msg_deserialize_partial(self, buffer));
 
-  SU_TRY_FAIL(
-      suscan_unpack_compact_single_array(
-          buffer,
-          &self->psd_data,
-          &self->psd_size));
+  SUSCAN_UNPACK(uint8, encoding);
+  self->codec.encoding = encoding;
+
+  if (suscan_psd_encoding_is_quantized(self->codec.encoding)) {
+    SU_TRY_FAIL(
+        suscan_psd_codec_unpack(
+            buffer,
+            self->codec.encoding,
+            &self->psd_data,
+            &self->psd_size,
+            &self->frame));
+  } else if (self->codec.encoding == SUSCAN_PSD_ENCODING_FLOAT32) {
+    SU_TRY_FAIL(
+        suscan_unpack_compact_single_array(
+            buffer,
+            &self->psd_data,
+            &self->psd_size));
+  } else {
+    SU_ERROR("Unsupported PSD encoding %d\n", encoding);
+    goto fail;
+  }
 
   SUSCAN_UNPACK_BOILERPLATE_END;
 }
@@ -254,6 +297,9 @@ suscan_analyzer_psd_msg_destroy(struct suscan_analyzer_psd_msg *msg)
   if (msg->psd_data != NULL)
     free(msg->psd_data);
 
+  if (msg->frame != NULL)
+    suscan_psd_frame_destroy(msg->frame);
+
   free(msg);
 }
 
@@ -339,6 +385,164 @@ fail:
   return NULL;
 }
 
+/*************************** Panorama messages ********************************/
+SUSCAN_SERIALIZER_PROTO(suscan_analyzer_panorama_params)
+{
+  SUSCAN_PACK_BOILERPLATE_START;
+
+  SUSCAN_PACK(bool,  self->enabled);
+  SUSCAN_PACK(bool,  self->hop_psd);
+  SUSCAN_PACK(freq,  self->min_freq);
+  SUSCAN_PACK(freq,  self->max_freq);
+  SUSCAN_PACK(float, self->bin_width);
+  SUSCAN_PACK(float, self->aging);
+  SUSCAN_PACK(float, self->update_int);
+  SUSCAN_PACK(uint,  self->mode);
+  SUSCAN_PACK(uint,  self->keyframe_int);
+
+  SUSCAN_PACK_BOILERPLATE_END;
+}
+
+SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_panorama_params)
+{
+  SUSCAN_UNPACK_BOILERPLATE_START;
+
+  SUSCAN_UNPACK(bool,   self->enabled);
+  SUSCAN_UNPACK(bool,   self->hop_psd);
+  SUSCAN_UNPACK(freq,   self->min_freq);
+  SUSCAN_UNPACK(freq,   self->max_freq);
+  SUSCAN_UNPACK(float,  self->bin_width);
+  SUSCAN_UNPACK(float,  self->aging);
+  SUSCAN_UNPACK(float,  self->update_int);
+  SUSCAN_UNPACK(uint32, self->mode);
+  SUSCAN_UNPACK(uint32, self->keyframe_int);
+
+  SU_TRYCATCH(self->mode <= SUSCAN_ANALYZER_PANORAMA_MODE_DELTA, goto fail);
+
+  SUSCAN_UNPACK_BOILERPLATE_END;
+}
+
+SUSCAN_SERIALIZER_PROTO(suscan_analyzer_panorama_keyframe_msg)
+{
+  SUSCAN_PACK_BOILERPLATE_START;
+
+  SUSCAN_PACK(uint, self->epoch);
+
+  SUSCAN_PACK_BOILERPLATE_END;
+}
+
+SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_panorama_keyframe_msg)
+{
+  SUSCAN_UNPACK_BOILERPLATE_START;
+
+  SUSCAN_UNPACK(uint32, self->epoch);
+
+  SUSCAN_UNPACK_BOILERPLATE_END;
+}
+
+SUSCAN_SERIALIZER_PROTO(suscan_analyzer_panorama_msg)
+{
+  SUSCAN_PACK_BOILERPLATE_START;
+
+  SUSCAN_PACK(uint,  self->epoch);
+  SUSCAN_PACK(uint,  self->seq);
+  SUSCAN_PACK(bool,  self->keyframe);
+  SUSCAN_PACK(freq,  self->min_freq);
+  SUSCAN_PACK(float, self->bin_width);
+  SUSCAN_PACK(uint,  self->total_bins);
+  SUSCAN_PACK(uint,  self->start_bin);
+  SUSCAN_PACK(uint,  self->timestamp.tv_sec);
+  SUSCAN_PACK(uint,  self->timestamp.tv_usec);
+  SUSCAN_PACK(uint,  self->rt_time.tv_sec);
+  SUSCAN_PACK(uint,  self->rt_time.tv_usec);
+
+  SU_TRYCATCH(
+      suscan_pack_compact_single_array(
+          buffer,
+          self->psd_data,
+          self->psd_size),
+      goto fail);
+
+  SUSCAN_PACK_BOILERPLATE_END;
+}
+
+SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_panorama_msg)
+{
+  uint64_t tv_sec = 0;
+  uint32_t tv_usec = 0;
+  SUSCAN_UNPACK_BOILERPLATE_START;
+
+  SUSCAN_UNPACK(uint32, self->epoch);
+  SUSCAN_UNPACK(uint32, self->seq);
+  SUSCAN_UNPACK(bool,   self->keyframe);
+  SUSCAN_UNPACK(freq,   self->min_freq);
+  SUSCAN_UNPACK(float,  self->bin_width);
+  SUSCAN_UNPACK(uint64, self->total_bins);
+  SUSCAN_UNPACK(uint64, self->start_bin);
+
+  SUSCAN_UNPACK(uint64, tv_sec);
+  SUSCAN_UNPACK(uint32, tv_usec);
+  self->timestamp.tv_sec  = tv_sec;
+  self->timestamp.tv_usec = tv_usec;
+
+  SUSCAN_UNPACK(uint64, tv_sec);
+  SUSCAN_UNPACK(uint32, tv_usec);
+  self->rt_time.tv_sec  = tv_sec;
+  self->rt_time.tv_usec = tv_usec;
+
+  SU_TRY_FAIL(
+      suscan_unpack_compact_single_array(
+          buffer,
+          &self->psd_data,
+          &self->psd_size));
+
+  SU_TRYCATCH(
+      self->start_bin + self->psd_size <= self->total_bins,
+      goto fail);
+
+  SUSCAN_UNPACK_BOILERPLATE_END;
+}
+
+void
+suscan_analyzer_panorama_msg_destroy(struct suscan_analyzer_panorama_msg *msg)
+{
+  if (msg->psd_data != NULL)
+    free(msg->psd_data);
+
+  free(msg);
+}
+
+struct suscan_analyzer_panorama_msg *
+suscan_analyzer_panorama_msg_new(const SUFLOAT *psd_data, SUSCOUNT psd_size)
+{
+  struct suscan_analyzer_panorama_msg *new = NULL;
+
+  SU_TRYCATCH(
+      new = calloc(1, sizeof(struct suscan_analyzer_panorama_msg)),
+      goto fail);
+
+  if (psd_size > 0) {
+    SU_TRYCATCH(
+        new->psd_data = malloc(sizeof(SUFLOAT) * psd_size),
+        goto fail);
+
+    if (psd_data != NULL)
+      memcpy(new->psd_data, psd_data, psd_size * sizeof(SUFLOAT));
+
+    new->psd_size = psd_size;
+  }
+
+  gettimeofday(&new->rt_time, NULL);
+
+  return new;
+
+fail:
+  if (new != NULL)
+    suscan_analyzer_panorama_msg_destroy(new);
+
+  return NULL;
+}
+
 /***************************** Inspector message ******************************/
 SUSCAN_SERIALIZABLE(sigutils_channel);
 
@@ -401,6 +605,7 @@ suscan_analyzer_inspector_msg_serialize_open(
 
   SUSCAN_PACK(uint,  self->handle);
   SUSCAN_PACK(bool,  self->precise);
+  SUSCAN_PACK(uint,  self->source_index);
   SUSCAN_PACK(uint,  self->fs);
   SUSCAN_PACK(float, self->equiv_fs);
   SUSCAN_PACK(float, self->bandwidth);
@@ -441,6 +646,7 @@ suscan_analyzer_inspector_msg_deserialize_open(
 
   SUSCAN_UNPACK(uint32, self->handle);
   SUSCAN_UNPACK(bool,   self->precise);
+  SUSCAN_UNPACK(uint32, self->source_index);
   SUSCAN_UNPACK(uint32, self->fs);
   SUSCAN_UNPACK(float,  self->equiv_fs);
   SUSCAN_UNPACK(float,  self->bandwidth);
@@ -651,6 +857,56 @@ suscan_analyzer_inspector_msg_deserialize_set_watermark(
   SUSCAN_UNPACK_BOILERPLATE_END;
 }
 
+SUPRIVATE SUBOOL
+suscan_analyzer_inspector_msg_serialize_set_stalled(
+    grow_buf_t *buffer,
+    const struct suscan_analyzer_inspector_msg *self)
+{
+  SUSCAN_PACK_BOILERPLATE_START;
+
+  SUSCAN_PACK(bool, self->stalled);
+
+  SUSCAN_PACK_BOILERPLATE_END;
+}
+
+SUPRIVATE SUBOOL
+suscan_analyzer_inspector_msg_deserialize_set_stalled(
+    grow_buf_t *buffer,
+    struct suscan_analyzer_inspector_msg *self)
+{
+  SUSCAN_UNPACK_BOILERPLATE_START;
+
+  SUSCAN_UNPACK(bool, self->stalled);
+
+  SUSCAN_UNPACK_BOILERPLATE_END;
+}
+
+SUPRIVATE SUBOOL
+suscan_analyzer_inspector_msg_serialize_subscribe_spectrum(
+    grow_buf_t *buffer,
+    const struct suscan_analyzer_inspector_msg *self)
+{
+  SUSCAN_PACK_BOILERPLATE_START;
+
+  SUSCAN_PACK(uint, self->spectsrc_id);
+  SUSCAN_PACK(bool, self->spectsrc_subscribed);
+
+  SUSCAN_PACK_BOILERPLATE_END;
+}
+
+SUPRIVATE SUBOOL
+suscan_analyzer_inspector_msg_deserialize_subscribe_spectrum(
+    grow_buf_t *buffer,
+    struct suscan_analyzer_inspector_msg *self)
+{
+  SUSCAN_UNPACK_BOILERPLATE_START;
+
+  SUSCAN_UNPACK(uint32, self->spectsrc_id);
+  SUSCAN_UNPACK(bool,   self->spectsrc_subscribed);
+
+  SUSCAN_UNPACK_BOILERPLATE_END;
+}
+
 SUPRIVATE SUBOOL
 suscan_analyzer_inspector_msg_serialize_set_tle(
     grow_buf_t *buffer,
@@ -838,6 +1094,20 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_inspector_msg)
           goto fail);
       break;
 
+    case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SET_STALLED:
+      SU_TRYCATCH(
+          suscan_analyzer_inspector_msg_serialize_set_stalled(buffer, self),
+          goto fail);
+      break;
+
+    case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SUBSCRIBE_SPECTRUM:
+      SU_TRYCATCH(
+          suscan_analyzer_inspector_msg_serialize_subscribe_spectrum(
+            buffer,
+            self),
+          goto fail);
+      break;
+
     case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SET_TLE:
       SU_TRYCATCH(
           suscan_analyzer_inspector_msg_serialize_set_tle(buffer, self),
@@ -937,6 +1207,20 @@ SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_inspector_msg)
           goto fail);
       break;
 
+    case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SET_STALLED:
+      SU_TRYCATCH(
+          suscan_analyzer_inspector_msg_deserialize_set_stalled(buffer, self),
+          goto fail);
+      break;
+
+    case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SUBSCRIBE_SPECTRUM:
+      SU_TRYCATCH(
+          suscan_analyzer_inspector_msg_deserialize_subscribe_spectrum(
+            buffer,
+            self),
+          goto fail);
+      break;
+
     case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SET_TLE:
       SU_TRYCATCH(
           suscan_analyzer_inspector_msg_deserialize_set_tle(buffer, self),
@@ -1063,10 +1347,13 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_sample_batch_msg)
 {
   SUSCAN_PACK_BOILERPLATE_START;
 
-  SUSCAN_PACK(int, self->inspector_id);
+  SUSCAN_PACK(int,  self->inspector_id);
+  SUSCAN_PACK(uint, self->encoding);
   SU_TRYCATCH(
-      suscan_pack_compact_complex_array(
+      suscan_sample_codec_pack(
           buffer,
+          self->encoding,
+          self->little_endian,
           self->samples,
           self->sample_count),
       goto fail);
@@ -1077,11 +1364,17 @@ SUSCAN_SERIALIZER_PROTO(suscan_analyzer_sample_batch_msg)
 SUSCAN_DESERIALIZER_PROTO(suscan_analyzer_sample_batch_msg)
 {
   SUSCAN_UNPACK_BOILERPLATE_START;
+  uint8_t encoding;
 
   SUSCAN_UNPACK(uint32, self->inspector_id);
+  SUSCAN_UNPACK(uint8,  encoding);
+
+  self->encoding = encoding;
+
   SU_TRYCATCH(
-      suscan_unpack_compact_complex_array(
+      suscan_sample_codec_unpack(
           buffer,
+          self->encoding,
           &self->samples,
           &self->sample_count),
       goto fail);
@@ -1275,7 +1568,19 @@ suscan_analyzer_msg_serialize(
     case SUSCAN_ANALYZER_MESSAGE_TYPE_REPLAY:
       SU_TRY_FAIL(suscan_analyzer_replay_msg_serialize(ptr, buffer));
       break;
-    
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_PARAMS:
+      SU_TRY_FAIL(suscan_analyzer_panorama_params_serialize(ptr, buffer));
+      break;
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA:
+      SU_TRY_FAIL(suscan_analyzer_panorama_msg_serialize(ptr, buffer));
+      break;
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_KEYFRAME:
+      SU_TRY_FAIL(
+        suscan_analyzer_panorama_keyframe_msg_serialize(ptr, buffer));
+      break;
   }
 
   SUSCAN_PACK_BOILERPLATE_END;
@@ -1360,6 +1665,21 @@ suscan_analyzer_msg_deserialize(uint32_t *type, void **ptr, grow_buf_t *buffer)
       SU_TRY_FAIL(suscan_analyzer_replay_msg_deserialize(msgptr, buffer));
       break;
 
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_PARAMS:
+      SU_TRY_FAIL(msgptr = calloc(1, sizeof (struct suscan_analyzer_panorama_params)));
+      SU_TRY_FAIL(suscan_analyzer_panorama_params_deserialize(msgptr, buffer));
+      break;
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA:
+      SU_TRY_FAIL(msgptr = suscan_analyzer_panorama_msg_new(NULL, 0));
+      SU_TRY_FAIL(suscan_analyzer_panorama_msg_deserialize(msgptr, buffer));
+      break;
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_KEYFRAME:
+      SU_TRY_FAIL(msgptr = calloc(1, sizeof (struct suscan_analyzer_panorama_keyframe_msg)));
+      SU_TRY_FAIL(suscan_analyzer_panorama_keyframe_msg_deserialize(msgptr, buffer));
+      break;
+
     default:
       SU_WARNING("Unknown message type `%d'\n", *type);
       goto fail;
@@ -1408,8 +1728,14 @@ suscan_analyzer_dispose_message(uint32_t type, void *ptr)
       suscan_analyzer_sample_batch_msg_destroy(ptr);
       break;
 
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA:
+      suscan_analyzer_panorama_msg_destroy(ptr);
+      break;
+
     case SUSCAN_ANALYZER_MESSAGE_TYPE_PARAMS:
     case SUSCAN_ANALYZER_MESSAGE_TYPE_THROTTLE:
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_PARAMS:
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_KEYFRAME:
       free(ptr);
       break;
   }
@@ -1517,8 +1843,9 @@ suscan_analyzer_send_source_info(
   // XXX: Protect!
   SU_TRYCATCH(suscan_source_info_init_copy(copy, info), goto done);
 
-  /* Send source info */
-  suscan_analyzer_get_source_time(self, &copy->source_time);
+  /* Send source info. Additional sources keep their own time. */
+  if (info->source_index == 0)
+    suscan_analyzer_get_source_time(self, &copy->source_time);
   
   SU_TRYCATCH(
       suscan_mq_write(
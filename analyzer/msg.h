@@ -25,6 +25,8 @@
 
 #include "analyzer.h"
 #include "serialize.h"
+#include "psdcodec.h"
+#include "samplecodec.h"
 #include <sgdp4/sgdp4-types.h>
 #include "correctors/tle.h"
 
@@ -48,6 +50,9 @@ extern "C" {
 #define SUSCAN_ANALYZER_MESSAGE_TYPE_SEEK          0xd
 #define SUSCAN_ANALYZER_MESSAGE_TYPE_HISTORY_SIZE  0xe
 #define SUSCAN_ANALYZER_MESSAGE_TYPE_REPLAY        0xf
+#define SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_PARAMS 0x10 /* Set panorama */
+#define SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA      0x11 /* Stitched spectrum */
+#define SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_KEYFRAME 0x12 /* Resync panorama */
 
 /* Invalid message. No one should even send this. */
 #define SUSCAN_ANALYZER_MESSAGE_TYPE_INVALID       0x8000000
@@ -106,6 +111,7 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_replay_msg) {
 SUSCAN_SERIALIZABLE(suscan_analyzer_psd_msg) {
   int64_t fc;
   uint32_t inspector_id;
+  uint32_t source_index; /* 0 is the primary source */
   struct   timeval timestamp; /* Timestamp after PSD */
   struct   timeval rt_time;   /* Real time timestamp */
   SUBOOL   looped;
@@ -115,16 +121,90 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_psd_msg) {
   SUFLOAT  N0;
   SUSCOUNT psd_size;
   SUFLOAT *psd_data;
+
+  /* Wire encoding of psd_data. Set by the server before serializing */
+  struct suscan_psd_codec_params codec;
+
+  /* Delta stream state of the receiving client, if any (server side) */
+  struct suscan_psd_stream *stream;
+
+  /* Send float32 psd_data as a little endian array (server side) */
+  SUBOOL little_endian;
+
+  /* Segments of the PDU being serialized, if any (server side) */
+  struct suscan_pdu_segments *segments;
+
+  /* Received stream frame, psd_data is NULL until decoded (client side) */
+  struct suscan_psd_frame *frame;
 };
 
 /* These messages allow partial deserialization */
 SUSCAN_PARTIAL_DESERIALIZER_PROTO(suscan_analyzer_psd_msg);
 
+/* Wide spectrum panorama configuration */
+enum suscan_analyzer_panorama_mode {
+  SUSCAN_ANALYZER_PANORAMA_MODE_FULL,  /* Whole panorama on every update */
+  SUSCAN_ANALYZER_PANORAMA_MODE_DELTA  /* Only changed bin ranges */
+};
+
+SUSCAN_SERIALIZABLE(suscan_analyzer_panorama_params) {
+  SUBOOL   enabled;
+  SUBOOL   hop_psd;      /* Keep sending per-hop PSD messages */
+  SUFREQ   min_freq;
+  SUFREQ   max_freq;
+  SUFLOAT  bin_width;    /* In Hz */
+  SUFLOAT  aging;        /* Weight of new hop data, 1 = overwrite */
+  SUFLOAT  update_int;   /* In seconds */
+  enum suscan_analyzer_panorama_mode mode;
+  uint32_t keyframe_int; /* Delta updates between full updates */
+};
+
+#define suscan_analyzer_panorama_params_INITIALIZER         \
+{                                                           \
+  SU_FALSE, /* enabled */                                   \
+  SU_TRUE,  /* hop_psd */                                   \
+  0,        /* min_freq */                                  \
+  0,        /* max_freq */                                  \
+  10e3,     /* bin_width */                                 \
+  .5,       /* aging */                                     \
+  .1,       /* update_int */                                \
+  SUSCAN_ANALYZER_PANORAMA_MODE_DELTA,                      \
+  50,       /* keyframe_int */                              \
+}
+
+/* Request of a panorama keyframe. Ignored if the epoch is not current */
+SUSCAN_SERIALIZABLE(suscan_analyzer_panorama_keyframe_msg) {
+  uint32_t epoch;
+};
+
+/*
+ * Stitched panorama message. Keyframes carry the whole panorama and
+ * reset the client state. Delta frames carry the bin range
+ * [start_bin, start_bin + psd_size) only.
+ */
+SUSCAN_SERIALIZABLE(suscan_analyzer_panorama_msg) {
+  uint32_t epoch;        /* Changes on every reconfiguration */
+  uint32_t seq;          /* Message sequence number within epoch */
+  SUBOOL   keyframe;
+  SUFREQ   min_freq;     /* Frequency of the lower edge of bin 0 */
+  SUFLOAT  bin_width;
+  SUSCOUNT total_bins;
+  SUSCOUNT start_bin;
+  struct   timeval timestamp;
+  struct   timeval rt_time;
+  SUSCOUNT psd_size;
+  SUFLOAT *psd_data;
+};
+
 /* Channel sample batch */
 SUSCAN_SERIALIZABLE(suscan_analyzer_sample_batch_msg) {
   uint32_t   inspector_id;
   SUCOMPLEX *samples;
   SUSCOUNT   sample_count;
+
+  /* Wire encoding of samples. Set by the server before serializing */
+  enum suscan_sample_encoding encoding;
+  SUBOOL little_endian;
 };
 
 /*
@@ -153,6 +233,8 @@ enum suscan_analyzer_inspector_msgkind {
   SUSCAN_ANALYZER_INSPECTOR_MSGKIND_ORBIT_REPORT,
   SUSCAN_ANALYZER_INSPECTOR_MSGKIND_INVALID_CORRECTION,
   SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SIGNAL,
+  SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SET_STALLED,
+  SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SUBSCRIBE_SPECTRUM,
   SUSCAN_ANALYZER_INSPECTOR_MSGKIND_COUNT
 };
 
@@ -185,6 +267,8 @@ suscan_analyzer_inspector_msgkind_to_string(
     SUSCAN_COMP_MSGKIND(ORBIT_REPORT);
     SUSCAN_COMP_MSGKIND(INVALID_CORRECTION);
     SUSCAN_COMP_MSGKIND(SIGNAL);
+    SUSCAN_COMP_MSGKIND(SET_STALLED);
+    SUSCAN_COMP_MSGKIND(SUBSCRIBE_SPECTRUM);
 
     default:
       return "UNKNOWN";
@@ -210,6 +294,7 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_inspector_msg) {
       struct sigutils_channel channel;
       suscan_config_t *config;
       SUBOOL precise;
+      uint32_t source_index; /* Source to open the channel on */
       uint32_t fs;  /* Baseband rate */
       SUFLOAT equiv_fs; /* Channel rate */
       SUFLOAT bandwidth;
@@ -231,6 +316,7 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_inspector_msg) {
       SUSCOUNT  samp_rate;
       SUFREQ    fc;
       SUFLOAT   N0;
+      SUBOOL    spectsrc_subscribed; /* SUBSCRIBE_SPECTRUM only */
     };
 
     struct {
@@ -246,6 +332,7 @@ SUSCAN_SERIALIZABLE(suscan_analyzer_inspector_msg) {
     struct suscan_orbit_report orbit_report;
 
     SUSCOUNT watermark;
+    SUBOOL   stalled;
   };
 };
 
@@ -325,6 +412,14 @@ SUFLOAT *suscan_analyzer_psd_msg_take_psd(struct suscan_analyzer_psd_msg *msg);
 
 void suscan_analyzer_psd_msg_destroy(struct suscan_analyzer_psd_msg *msg);
 
+/* Panorama update message */
+struct suscan_analyzer_panorama_msg *suscan_analyzer_panorama_msg_new(
+    const SUFLOAT *psd_data,
+    SUSCOUNT psd_size);
+
+void suscan_analyzer_panorama_msg_destroy(
+    struct suscan_analyzer_panorama_msg *msg);
+
 /* Sample batch message */
 struct suscan_analyzer_sample_batch_msg *suscan_analyzer_sample_batch_msg_new(
     uint32_t inspector_id,
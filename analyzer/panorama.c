@@ -0,0 +1,334 @@
+/*
+
+  Copyright (C) 2023 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "panorama"
+
+#include <sigutils/log.h>
+#include <string.h>
+#include <errno.h>
+
+#include "panorama.h"
+#include "realtime.h"
+
+SU_INSTANCER(
+  suscan_panorama,
+  const struct suscan_analyzer_panorama_params *params,
+  uint32_t epoch)
+{
+  suscan_panorama_t *self = NULL;
+  SUFLOAT bin_count;
+
+  if (params->bin_width <= 0) {
+    SU_ERROR("Invalid panorama bin width\n");
+    goto fail;
+  }
+
+  if (params->max_freq <= params->min_freq) {
+    SU_ERROR("Invalid panorama frequency range\n");
+    goto fail;
+  }
+
+  if (params->aging <= 0 || params->aging > 1) {
+    SU_ERROR("Panorama aging factor must be in the (0, 1] range\n");
+    goto fail;
+  }
+
+  if (params->update_int < 0) {
+    SU_ERROR("Invalid panorama update interval\n");
+    goto fail;
+  }
+
+  bin_count = SU_CEIL((params->max_freq - params->min_freq) / params->bin_width);
+  if (bin_count > SUSCAN_PANORAMA_MAX_BINS) {
+    SU_ERROR(
+      "Panorama too big (%g bins, max is %d)\n",
+      bin_count,
+      SUSCAN_PANORAMA_MAX_BINS);
+    goto fail;
+  }
+
+  SU_ALLOCATE_FAIL(self, suscan_panorama_t);
+
+  self->params        = *params;
+  self->epoch         = epoch;
+  self->bin_count     = bin_count;
+  self->need_keyframe = SU_TRUE;
+
+  SU_ALLOCATE_MANY_FAIL(self->bins,  self->bin_count, SUFLOAT);
+  SU_ALLOCATE_MANY_FAIL(self->state, self->bin_count, uint8_t);
+
+  return self;
+
+fail:
+  if (self != NULL)
+    suscan_panorama_destroy(self);
+
+  return NULL;
+}
+
+SU_COLLECTOR(suscan_panorama)
+{
+  if (self->bins != NULL)
+    free(self->bins);
+
+  if (self->state != NULL)
+    free(self->state);
+
+  if (self->hop_psd != NULL)
+    free(self->hop_psd);
+
+  free(self);
+}
+
+SUINLINE SUFLOAT
+suscan_panorama_psd_at(const SUFLOAT *psd, SUSCOUNT size, SUSDIFF k)
+{
+  SUSDIFF half = size >> 1;
+
+  if (k < -half)
+    k = -half;
+  else if (k >= (SUSDIFF) size - half)
+    k = size - half - 1;
+
+  return psd[k < 0 ? k + (SUSDIFF) size : k];
+}
+
+SU_METHOD(
+  suscan_panorama,
+  SUBOOL,
+  feed,
+  SUFREQ fc,
+  SUFLOAT samp_rate,
+  SUFLOAT rel_bw,
+  const SUFLOAT *psd,
+  SUSCOUNT size)
+{
+  SUFREQ bw   = self->params.bin_width;
+  SUFREQ df, half, bin_lo, bin_hi;
+  SUSDIFF j, j0, j1, k, k0, k1;
+  SUFLOAT value;
+
+  if (size == 0 || samp_rate <= 0)
+    return SU_TRUE;
+
+  if (rel_bw <= 0 || rel_bw > 1)
+    rel_bw = 1;
+
+  df   = samp_rate / size;
+  half = .5 * samp_rate * rel_bw;
+
+  /* Only panorama bins that fall entirely inside the useful band */
+  j0 = SU_CEIL((fc - half - self->params.min_freq) / bw);
+  j1 = SU_FLOOR((fc + half - self->params.min_freq) / bw);
+
+  if (j0 < 0)
+    j0 = 0;
+  if (j1 > (SUSDIFF) self->bin_count)
+    j1 = self->bin_count;
+
+  for (j = j0; j < j1; ++j) {
+    bin_lo = self->params.min_freq + j * bw - fc;
+    bin_hi = bin_lo + bw;
+
+    k0 = SU_CEIL(bin_lo / df);
+    k1 = SU_CEIL(bin_hi / df) - 1;
+
+    if (k1 < k0) {
+      /* Panorama bin narrower than the FFT bin: take the closest one */
+      k0 = k1 = SU_FLOOR((bin_lo + .5 * bw) / df + .5);
+      value = suscan_panorama_psd_at(psd, size, k0);
+    } else {
+      value = 0;
+      for (k = k0; k <= k1; ++k)
+        value += suscan_panorama_psd_at(psd, size, k);
+      value /= k1 - k0 + 1;
+    }
+
+    if (self->state[j] & SUSCAN_PANORAMA_BIN_VALID) {
+      self->bins[j] += self->params.aging * (value - self->bins[j]);
+    } else {
+      self->bins[j]   = value;
+      self->state[j] |= SUSCAN_PANORAMA_BIN_VALID;
+    }
+
+    self->state[j] |= SUSCAN_PANORAMA_BIN_DIRTY;
+    self->changed   = SU_TRUE;
+  }
+
+  return SU_TRUE;
+}
+
+SU_METHOD(
+  suscan_panorama,
+  SUBOOL,
+  feed_detector,
+  SUFREQ fc,
+  SUFLOAT rel_bw,
+  const su_channel_detector_t *cd)
+{
+  SUSCOUNT i, size = cd->params.window_size;
+  SUFLOAT samp_rate = cd->params.samp_rate;
+  SUFLOAT *tmp;
+  SUBOOL ok = SU_FALSE;
+
+  if (cd->params.decimation > 1)
+    samp_rate /= cd->params.decimation;
+
+  if (size > self->hop_psd_alloc) {
+    SU_TRY(tmp = realloc(self->hop_psd, size * sizeof(SUFLOAT)));
+    self->hop_psd = tmp;
+    self->hop_psd_alloc = size;
+  }
+
+  for (i = 0; i < size; ++i)
+    self->hop_psd[i] = SU_C_REAL(cd->fft[i] * SU_C_CONJ(cd->fft[i])) / size;
+
+  SU_TRY(
+    suscan_panorama_feed(
+      self,
+      fc,
+      samp_rate,
+      rel_bw,
+      self->hop_psd,
+      size));
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+SUPRIVATE SUBOOL
+suscan_panorama_send(
+  suscan_panorama_t *self,
+  suscan_analyzer_t *analyzer,
+  SUSCOUNT start,
+  SUSCOUNT size,
+  SUBOOL keyframe)
+{
+  struct suscan_analyzer_panorama_msg *msg = NULL;
+  SUSCOUNT i;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(msg = suscan_analyzer_panorama_msg_new(NULL, size));
+
+  for (i = 0; i < size; ++i)
+    msg->psd_data[i] =
+      (self->state[start + i] & SUSCAN_PANORAMA_BIN_VALID)
+      ? self->bins[start + i]
+      : 0;
+
+  msg->epoch      = self->epoch;
+  msg->seq        = self->seq++;
+  msg->keyframe   = keyframe;
+  msg->min_freq   = self->params.min_freq;
+  msg->bin_width  = self->params.bin_width;
+  msg->total_bins = self->bin_count;
+  msg->start_bin  = start;
+  suscan_analyzer_get_source_time(analyzer, &msg->timestamp);
+
+  if (!suscan_mq_write(
+      analyzer->mq_out,
+      SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA,
+      msg)) {
+    suscan_analyzer_send_status(
+        analyzer,
+        SUSCAN_ANALYZER_MESSAGE_TYPE_INTERNAL,
+        -1,
+        "Cannot write message: %s",
+        strerror(errno));
+    goto done;
+  }
+
+  /* Message queued, forget about it */
+  msg = NULL;
+
+  for (i = 0; i < size; ++i)
+    self->state[start + i] &= ~SUSCAN_PANORAMA_BIN_DIRTY;
+
+  ok = SU_TRUE;
+
+done:
+  if (msg != NULL)
+    suscan_analyzer_panorama_msg_destroy(msg);
+
+  return ok;
+}
+
+SU_METHOD(suscan_panorama, SUBOOL, update, suscan_analyzer_t *analyzer)
+{
+  uint64_t now = suscan_gettime_coarse();
+  SUSCOUNT i, start, end, gap;
+  SUBOOL keyframe;
+  SUBOOL ok = SU_FALSE;
+
+  if (!self->changed)
+    return SU_TRUE;
+
+  if (now - self->last_update < self->params.update_int * 1e9)
+    return SU_TRUE;
+
+  self->last_update = now;
+  self->changed     = SU_FALSE;
+
+  keyframe = self->need_keyframe
+    || self->params.mode == SUSCAN_ANALYZER_PANORAMA_MODE_FULL
+    || (self->params.keyframe_int > 0
+        && self->deltas >= self->params.keyframe_int);
+
+  if (keyframe) {
+    SU_TRY(suscan_panorama_send(self, analyzer, 0, self->bin_count, SU_TRUE));
+    self->need_keyframe = SU_FALSE;
+    self->deltas = 0;
+  } else {
+    i = 0;
+
+    while (i < self->bin_count) {
+      if (!(self->state[i] & SUSCAN_PANORAMA_BIN_DIRTY)) {
+        ++i;
+        continue;
+      }
+
+      /* Extend this range until we find a big enough clean gap */
+      start = i;
+      end   = i + 1;
+      gap   = 0;
+
+      for (i = end; i < self->bin_count && gap < SUSCAN_PANORAMA_MERGE_GAP; ++i) {
+        if (self->state[i] & SUSCAN_PANORAMA_BIN_DIRTY) {
+          end = i + 1;
+          gap = 0;
+        } else {
+          ++gap;
+        }
+      }
+
+      SU_TRY(
+        suscan_panorama_send(self, analyzer, start, end - start, SU_FALSE));
+      i = end;
+    }
+
+    ++self->deltas;
+  }
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
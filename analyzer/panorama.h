@@ -0,0 +1,127 @@
+/*
+
+  Copyright (C) 2023 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SUSCAN_PANORAMA_H
+#define _SUSCAN_PANORAMA_H
+
+#include <sigutils/types.h>
+#include <sigutils/defs.h>
+#include <sigutils/detect.h>
+#include <stdint.h>
+
+#include "msg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define SUSCAN_PANORAMA_MAX_BINS   (1 << 20)
+
+/*
+ * Delta updates of changed ranges separated by less than this amount of
+ * unchanged bins are merged into a single message.
+ */
+#define SUSCAN_PANORAMA_MERGE_GAP  32
+
+#define SUSCAN_PANORAMA_BIN_VALID  1
+#define SUSCAN_PANORAMA_BIN_DIRTY  2
+
+/*
+ * The panorama object keeps a spectrum buffer covering the whole sweep
+ * range at a fixed bin width. Every hop of the wide spectrum worker is
+ * resampled into it, and clients receive either the full panorama or the
+ * bin ranges that changed since the last update. Bins that have not been
+ * measured yet are sent as zero.
+ */
+struct suscan_panorama {
+  struct suscan_analyzer_panorama_params params;
+
+  uint32_t  epoch;
+  uint32_t  seq;
+  SUSCOUNT  deltas;      /* Delta updates since last keyframe */
+  uint64_t  last_update; /* In nanoseconds */
+  SUBOOL    changed;
+  SUBOOL    need_keyframe;
+
+  SUSCOUNT  bin_count;
+  SUFLOAT  *bins;
+  uint8_t  *state;
+
+  SUFLOAT  *hop_psd;     /* Scratch buffer for detector PSDs */
+  SUSCOUNT  hop_psd_alloc;
+};
+
+typedef struct suscan_panorama suscan_panorama_t;
+
+SU_INSTANCER(
+  suscan_panorama,
+  const struct suscan_analyzer_panorama_params *,
+  uint32_t);
+SU_COLLECTOR(suscan_panorama);
+
+SUINLINE SU_GETTER(suscan_panorama, SUSCOUNT, bin_count)
+{
+  return self->bin_count;
+}
+
+SUINLINE SU_GETTER(suscan_panorama, uint32_t, epoch)
+{
+  return self->epoch;
+}
+
+SUINLINE SU_GETTER(suscan_panorama, SUBOOL, hop_psd_enabled)
+{
+  return self->params.hop_psd;
+}
+
+/* The next update will carry the whole panorama */
+SUINLINE SU_METHOD(suscan_panorama, void, request_keyframe)
+{
+  self->need_keyframe = SU_TRUE;
+  self->changed       = SU_TRUE;
+}
+
+/* Merge a linear PSD (in FFT order) centered at fc */
+SU_METHOD(
+  suscan_panorama,
+  SUBOOL,
+  feed,
+  SUFREQ fc,
+  SUFLOAT samp_rate,
+  SUFLOAT rel_bw,
+  const SUFLOAT *psd,
+  SUSCOUNT size);
+
+/* Merge the current PSD of a channel detector working in spectrum mode */
+SU_METHOD(
+  suscan_panorama,
+  SUBOOL,
+  feed_detector,
+  SUFREQ fc,
+  SUFLOAT rel_bw,
+  const su_channel_detector_t *detector);
+
+/* Send panorama messages to the analyzer, if the update interval expired */
+SU_METHOD(suscan_panorama, SUBOOL, update, suscan_analyzer_t *analyzer);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SUSCAN_PANORAMA_H */
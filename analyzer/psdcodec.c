@@ -0,0 +1,710 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "psdcodec"
+
+#include <sigutils/log.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "psdcodec.h"
+#include "serialize.h"
+
+/* Frames are never bigger than this */
+#define SUSCAN_PSD_CODEC_MAX_BINS (1 << 24)
+
+SUPRIVATE const char *g_psd_encoding_names[SUSCAN_PSD_ENCODING_COUNT] = {
+  "f32",
+  "db8",
+  "db16"
+};
+
+const char *
+suscan_psd_encoding_to_string(enum suscan_psd_encoding encoding)
+{
+  if (encoding < 0 || encoding >= SUSCAN_PSD_ENCODING_COUNT)
+    return NULL;
+
+  return g_psd_encoding_names[encoding];
+}
+
+SUBOOL
+suscan_psd_encoding_from_string(
+  const char *string,
+  enum suscan_psd_encoding *encoding)
+{
+  unsigned int i;
+
+  for (i = 0; i < SUSCAN_PSD_ENCODING_COUNT; ++i)
+    if (strcasecmp(string, g_psd_encoding_names[i]) == 0) {
+      *encoding = i;
+      return SU_TRUE;
+    }
+
+  return SU_FALSE;
+}
+
+SUBOOL
+suscan_psd_codec_params_is_valid(const struct suscan_psd_codec_params *params)
+{
+  if (params->encoding < 0 || params->encoding >= SUSCAN_PSD_ENCODING_COUNT)
+    return SU_FALSE;
+
+  if (!suscan_psd_encoding_is_quantized(params->encoding))
+    return params->keyframe_int == 0;
+
+  return isfinite(params->min_db)
+      && isfinite(params->max_db)
+      && params->min_db < params->max_db
+      && params->keyframe_int <= SUSCAN_PSD_CODEC_MAX_KEYFRAME_INT;
+}
+
+SUINLINE unsigned int
+suscan_psd_encoding_get_levels(enum suscan_psd_encoding encoding)
+{
+  return encoding == SUSCAN_PSD_ENCODING_DB_U8 ? 0xff : 0xffff;
+}
+
+/* Range of the frame in dB, clipped to the requested dynamic range */
+SUPRIVATE void
+suscan_psd_codec_get_range(
+  const struct suscan_psd_codec_params *params,
+  const SUFLOAT *psd,
+  SUSCOUNT size,
+  SUFLOAT *lo,
+  SUFLOAT *hi)
+{
+  SUFLOAT lin_min = INFINITY, lin_max = 0;
+  SUSCOUNT i;
+
+  /* dB is monotonic: find the frame range in linear units */
+  for (i = 0; i < size; ++i)
+    if (psd[i] > 0) {
+      if (psd[i] < lin_min)
+        lin_min = psd[i];
+      if (psd[i] > lin_max)
+        lin_max = psd[i];
+    }
+
+  if (lin_max > 0) {
+    *lo = SU_POWER_DB_RAW(lin_min);
+    *hi = SU_POWER_DB_RAW(lin_max);
+  } else {
+    *lo = *hi = params->min_db;
+  }
+
+  *lo = SU_MIN(SU_MAX(*lo, params->min_db), params->max_db);
+  *hi = SU_MIN(SU_MAX(*hi, params->min_db), params->max_db);
+}
+
+SUPRIVATE void
+suscan_psd_codec_quantize_bins(
+  enum suscan_psd_encoding encoding,
+  SUSINGLE offset,
+  SUSINGLE scale,
+  const SUFLOAT *psd,
+  SUSCOUNT size,
+  uint16_t *q)
+{
+  unsigned int levels = suscan_psd_encoding_get_levels(encoding);
+  SUFLOAT db, inv, x;
+  SUSCOUNT i;
+
+  inv = scale > 0 ? 1. / scale : 0;
+
+  for (i = 0; i < size; ++i) {
+    db = psd[i] > 0 ? SU_POWER_DB_RAW(psd[i]) : offset;
+    x  = SU_FLOOR((db - offset) * inv + .5);
+
+    if (!(x > 0))
+      q[i] = 0;
+    else if (x >= levels)
+      q[i] = levels;
+    else
+      q[i] = (uint16_t) x;
+  }
+}
+
+SUPRIVATE void
+suscan_psd_codec_dequantize_bins(
+  enum suscan_psd_encoding encoding,
+  SUSINGLE offset,
+  SUSINGLE scale,
+  const uint16_t *q,
+  SUSCOUNT size,
+  SUFLOAT *psd)
+{
+  SUFLOAT lut[256];
+  SUSCOUNT i;
+
+  if (encoding == SUSCAN_PSD_ENCODING_DB_U8) {
+    /* Only 256 possible values: compute them once */
+    for (i = 0; i < 256; ++i)
+      lut[i] = SU_POW(10., .1 * (offset + scale * i));
+
+    for (i = 0; i < size; ++i)
+      psd[i] = lut[q[i] & 0xff];
+  } else {
+    for (i = 0; i < size; ++i)
+      psd[i] = SU_POW(10., .1 * (offset + scale * q[i]));
+  }
+}
+
+/* Wire representation of quantized bins: 16-bit bins are big endian */
+SUPRIVATE void
+suscan_psd_codec_q_to_bytes(
+  enum suscan_psd_encoding encoding,
+  const uint16_t *q,
+  SUSCOUNT size,
+  uint8_t *bytes)
+{
+  SUSCOUNT i;
+
+  if (encoding == SUSCAN_PSD_ENCODING_DB_U8) {
+    for (i = 0; i < size; ++i)
+      bytes[i] = q[i];
+  } else {
+    for (i = 0; i < size; ++i) {
+      bytes[2 * i]     = q[i] >> 8;
+      bytes[2 * i + 1] = q[i] & 0xff;
+    }
+  }
+}
+
+SUPRIVATE void
+suscan_psd_codec_bytes_to_q(
+  enum suscan_psd_encoding encoding,
+  const uint8_t *bytes,
+  SUSCOUNT size,
+  uint16_t *q)
+{
+  SUSCOUNT i;
+
+  if (encoding == SUSCAN_PSD_ENCODING_DB_U8) {
+    for (i = 0; i < size; ++i)
+      q[i] = bytes[i];
+  } else {
+    for (i = 0; i < size; ++i)
+      q[i] = (bytes[2 * i] << 8) | bytes[2 * i + 1];
+  }
+}
+
+/*
+ * Residuals are computed modulo 2^bits and zigzag-mapped, so that small
+ * differences of either sign become small unsigned numbers. 16-bit
+ * residuals are stored as two byte planes (high bytes first), which turns
+ * small residuals into long runs of zeroes.
+ */
+SUPRIVATE void
+suscan_psd_codec_residual_to_bytes(
+  enum suscan_psd_encoding encoding,
+  const uint16_t *ref,
+  const uint16_t *q,
+  SUSCOUNT size,
+  uint8_t *bytes)
+{
+  unsigned int bits = 8 * suscan_psd_encoding_get_bin_size(encoding);
+  uint32_t mask = (1u << bits) - 1;
+  uint32_t u, zz;
+  SUSCOUNT i;
+
+  for (i = 0; i < size; ++i) {
+    u  = (uint32_t) (q[i] - ref[i]) & mask;
+    zz = ((u << 1) ^ (0u - (u >> (bits - 1)))) & mask;
+
+    if (bits == 8) {
+      bytes[i] = zz;
+    } else {
+      bytes[i]        = zz >> 8;
+      bytes[size + i] = zz & 0xff;
+    }
+  }
+}
+
+SUPRIVATE void
+suscan_psd_codec_apply_residual(
+  enum suscan_psd_encoding encoding,
+  uint16_t *ref,
+  const uint8_t *bytes,
+  SUSCOUNT size)
+{
+  unsigned int bits = 8 * suscan_psd_encoding_get_bin_size(encoding);
+  uint32_t mask = (1u << bits) - 1;
+  uint32_t u, zz;
+  SUSCOUNT i;
+
+  for (i = 0; i < size; ++i) {
+    if (bits == 8)
+      zz = bytes[i];
+    else
+      zz = (bytes[i] << 8) | bytes[size + i];
+
+    u      = ((zz >> 1) ^ (0u - (zz & 1))) & mask;
+    ref[i] = (ref[i] + u) & mask;
+  }
+}
+
+void
+suscan_psd_quantize(
+  const struct suscan_psd_codec_params *params,
+  const SUFLOAT *psd,
+  SUSCOUNT size,
+  SUFLOAT *offset,
+  SUFLOAT *scale,
+  void *data)
+{
+  unsigned int levels = suscan_psd_encoding_get_levels(params->encoding);
+  uint8_t *as_bytes = (uint8_t *) data;
+  uint16_t q[256];
+  SUFLOAT lo, hi;
+  SUSINGLE s_offset, s_scale;
+  SUSCOUNT i, chunk;
+
+  suscan_psd_codec_get_range(params, psd, size, &lo, &hi);
+
+  /* Encoder and decoder must agree on the exact same pair */
+  s_offset = lo;
+  s_scale  = (hi - lo) / levels;
+
+  for (i = 0; i < size; i += chunk) {
+    chunk = SU_MIN(size - i, 256);
+
+    suscan_psd_codec_quantize_bins(
+      params->encoding,
+      s_offset,
+      s_scale,
+      psd + i,
+      chunk,
+      q);
+
+    suscan_psd_codec_q_to_bytes(
+      params->encoding,
+      q,
+      chunk,
+      as_bytes + i * suscan_psd_encoding_get_bin_size(params->encoding));
+  }
+
+  *offset = s_offset;
+  *scale  = s_scale;
+}
+
+SUBOOL
+suscan_psd_dequantize(
+  enum suscan_psd_encoding encoding,
+  SUFLOAT offset,
+  SUFLOAT scale,
+  const void *data,
+  SUSCOUNT size,
+  SUFLOAT *psd)
+{
+  const uint8_t *as_bytes = (const uint8_t *) data;
+  SUFLOAT lut[256];
+  unsigned int q;
+  SUSCOUNT i;
+
+  if (!isfinite(offset) || !isfinite(scale) || scale < 0)
+    return SU_FALSE;
+
+  switch (encoding) {
+    case SUSCAN_PSD_ENCODING_DB_U8:
+      /* Only 256 possible values: compute them once */
+      for (i = 0; i < 256; ++i)
+        lut[i] = SU_POW(10., .1 * (offset + scale * i));
+
+      for (i = 0; i < size; ++i)
+        psd[i] = lut[as_bytes[i]];
+      break;
+
+    case SUSCAN_PSD_ENCODING_DB_U16:
+      for (i = 0; i < size; ++i) {
+        q = (as_bytes[2 * i] << 8) | as_bytes[2 * i + 1];
+        psd[i] = SU_POW(10., .1 * (offset + scale * q));
+      }
+      break;
+
+    default:
+      return SU_FALSE;
+  }
+
+  return SU_TRUE;
+}
+
+SUBOOL
+suscan_psd_codec_pack(
+  grow_buf_t *buffer,
+  const struct suscan_psd_codec_params *params,
+  const SUFLOAT *psd,
+  SUSCOUNT size)
+{
+  uint8_t *data = NULL;
+  SUSCOUNT data_size;
+  SUFLOAT offset, scale;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(suscan_psd_encoding_is_quantized(params->encoding));
+
+  data_size = size * suscan_psd_encoding_get_bin_size(params->encoding);
+  if (data_size > 0)
+    SU_ALLOCATE_MANY(data, data_size, uint8_t);
+
+  suscan_psd_quantize(params, psd, size, &offset, &scale, data);
+
+  SU_TRYZ(cbor_pack_uint(buffer, SUSCAN_PSD_FRAME_TYPE_STANDALONE));
+  SU_TRYZ(cbor_pack_single(buffer, offset));
+  SU_TRYZ(cbor_pack_single(buffer, scale));
+  SU_TRYZ(cbor_pack_blob(buffer, data, data_size));
+
+  ok = SU_TRUE;
+
+done:
+  if (data != NULL)
+    free(data);
+
+  return ok;
+}
+
+SUBOOL
+suscan_psd_codec_unpack(
+  grow_buf_t *buffer,
+  enum suscan_psd_encoding encoding,
+  SUFLOAT **psd,
+  SUSCOUNT *size,
+  struct suscan_psd_frame **frame)
+{
+  struct suscan_psd_frame *new_frame = NULL;
+  uint8_t type;
+  uint32_t seq = 0;
+  SUSINGLE offset, scale;
+  void *data = NULL;
+  size_t data_size = 0;
+  unsigned int bin_size;
+  SUFLOAT *result = NULL;
+  SUSCOUNT count;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(suscan_psd_encoding_is_quantized(encoding));
+
+  bin_size = suscan_psd_encoding_get_bin_size(encoding);
+
+  SU_TRYZ(cbor_unpack_uint8(buffer, &type));
+  if (type != SUSCAN_PSD_FRAME_TYPE_STANDALONE)
+    SU_TRYZ(cbor_unpack_uint32(buffer, &seq));
+
+  SU_TRYZ(cbor_unpack_single(buffer, &offset));
+  SU_TRYZ(cbor_unpack_single(buffer, &scale));
+  SU_TRYZ(cbor_unpack_blob(buffer, &data, &data_size));
+
+  if (data_size % bin_size != 0) {
+    SU_ERROR("Quantized PSD size is not a multiple of the bin size\n");
+    goto done;
+  }
+
+  count = data_size / bin_size;
+  if (count > SUSCAN_PSD_CODEC_MAX_BINS) {
+    SU_ERROR("Quantized PSD is too big (%lu bins)\n", count);
+    goto done;
+  }
+
+  switch (type) {
+    case SUSCAN_PSD_FRAME_TYPE_STANDALONE:
+      if (count > 0) {
+        SU_ALLOCATE_MANY(result, count, SUFLOAT);
+        SU_TRY(
+          suscan_psd_dequantize(encoding, offset, scale, data, count, result));
+      }
+
+      if (*psd != NULL)
+        free(*psd);
+
+      *psd   = result;
+      result = NULL;
+      break;
+
+    case SUSCAN_PSD_FRAME_TYPE_KEYFRAME:
+    case SUSCAN_PSD_FRAME_TYPE_DELTA:
+      SU_ALLOCATE(new_frame, struct suscan_psd_frame);
+
+      new_frame->type      = type;
+      new_frame->seq       = seq;
+      new_frame->offset    = offset;
+      new_frame->scale     = scale;
+      new_frame->data      = data;
+      new_frame->data_size = data_size;
+      data = NULL;
+
+      if (*frame != NULL)
+        suscan_psd_frame_destroy(*frame);
+
+      *frame    = new_frame;
+      new_frame = NULL;
+      break;
+
+    default:
+      SU_ERROR("Unknown PSD frame type %d\n", type);
+      goto done;
+  }
+
+  *size = count;
+
+  ok = SU_TRUE;
+
+done:
+  if (data != NULL)
+    free(data);
+
+  if (result != NULL)
+    free(result);
+
+  if (new_frame != NULL)
+    suscan_psd_frame_destroy(new_frame);
+
+  return ok;
+}
+
+/***************************** Delta streams **********************************/
+void
+suscan_psd_frame_destroy(struct suscan_psd_frame *self)
+{
+  if (self->data != NULL)
+    free(self->data);
+
+  free(self);
+}
+
+void
+suscan_psd_stream_init(struct suscan_psd_stream *self)
+{
+  memset(self, 0, sizeof(struct suscan_psd_stream));
+}
+
+void
+suscan_psd_stream_finalize(struct suscan_psd_stream *self)
+{
+  if (self->ref != NULL)
+    free(self->ref);
+
+  if (self->cur != NULL)
+    free(self->cur);
+
+  if (self->bytes != NULL)
+    free(self->bytes);
+
+  suscan_psd_stream_init(self);
+}
+
+SUPRIVATE SUBOOL
+suscan_psd_stream_ensure_alloc(struct suscan_psd_stream *self, SUSCOUNT size)
+{
+  uint16_t *ref = NULL, *cur = NULL;
+  uint8_t *bytes = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  if (size <= self->alloc)
+    return SU_TRUE;
+
+  SU_ALLOCATE_MANY(ref,   size,     uint16_t);
+  SU_ALLOCATE_MANY(cur,   size,     uint16_t);
+  SU_ALLOCATE_MANY(bytes, 2 * size, uint8_t);
+
+  suscan_psd_stream_finalize(self);
+
+  self->ref   = ref;
+  self->cur   = cur;
+  self->bytes = bytes;
+  self->alloc = size;
+
+  ref = cur = NULL;
+  bytes = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (ref != NULL)
+    free(ref);
+
+  if (cur != NULL)
+    free(cur);
+
+  if (bytes != NULL)
+    free(bytes);
+
+  return ok;
+}
+
+SUBOOL
+suscan_psd_stream_pack(
+  struct suscan_psd_stream *self,
+  grow_buf_t *buffer,
+  const struct suscan_psd_codec_params *params,
+  int64_t fc,
+  const SUFLOAT *psd,
+  SUSCOUNT size)
+{
+  unsigned int levels = suscan_psd_encoding_get_levels(params->encoding);
+  unsigned int bin_size = suscan_psd_encoding_get_bin_size(params->encoding);
+  enum suscan_psd_frame_type type;
+  uint16_t *tmp;
+  SUFLOAT lo, hi;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(suscan_psd_codec_params_has_deltas(params));
+  SU_TRY(suscan_psd_stream_ensure_alloc(self, size));
+
+  suscan_psd_codec_get_range(params, psd, size, &lo, &hi);
+
+  if (!self->synced
+    || self->fc != fc
+    || self->size != size
+    || self->encoding != params->encoding
+    || self->deltas >= params->keyframe_int
+    || lo < self->offset
+    || hi > self->offset + self->scale * levels) {
+    type = SUSCAN_PSD_FRAME_TYPE_KEYFRAME;
+
+    lo = SU_MAX(lo - SUSCAN_PSD_STREAM_RANGE_MARGIN_DB, params->min_db);
+    hi = SU_MIN(hi + SUSCAN_PSD_STREAM_RANGE_MARGIN_DB, params->max_db);
+
+    self->fc       = fc;
+    self->size     = size;
+    self->encoding = params->encoding;
+    self->offset   = lo;
+    self->scale    = (hi - lo) / levels;
+    self->deltas   = 0;
+  } else {
+    type = SUSCAN_PSD_FRAME_TYPE_DELTA;
+    ++self->deltas;
+  }
+
+  suscan_psd_codec_quantize_bins(
+    self->encoding,
+    self->offset,
+    self->scale,
+    psd,
+    size,
+    self->cur);
+
+  if (type == SUSCAN_PSD_FRAME_TYPE_KEYFRAME)
+    suscan_psd_codec_q_to_bytes(self->encoding, self->cur, size, self->bytes);
+  else
+    suscan_psd_codec_residual_to_bytes(
+      self->encoding,
+      self->ref,
+      self->cur,
+      size,
+      self->bytes);
+
+  /* Until this frame is out, the decoder cannot follow us */
+  self->synced = SU_FALSE;
+
+  SU_TRYZ(cbor_pack_uint(buffer, type));
+  SU_TRYZ(cbor_pack_uint(buffer, self->seq + 1));
+  SU_TRYZ(cbor_pack_single(buffer, self->offset));
+  SU_TRYZ(cbor_pack_single(buffer, self->scale));
+  SU_TRYZ(cbor_pack_blob(buffer, self->bytes, size * bin_size));
+
+  ++self->seq;
+
+  tmp       = self->ref;
+  self->ref = self->cur;
+  self->cur = tmp;
+
+  self->synced = SU_TRUE;
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+SUBOOL
+suscan_psd_stream_decode(
+  struct suscan_psd_stream *self,
+  enum suscan_psd_encoding encoding,
+  int64_t fc,
+  const struct suscan_psd_frame *frame,
+  SUFLOAT **psd,
+  SUSCOUNT *size)
+{
+  unsigned int bin_size;
+  SUSCOUNT count;
+  SUFLOAT *result = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(suscan_psd_encoding_is_quantized(encoding));
+
+  if (!isfinite(frame->offset) || !isfinite(frame->scale) || frame->scale < 0)
+    goto done;
+
+  bin_size = suscan_psd_encoding_get_bin_size(encoding);
+  count    = frame->data_size / bin_size;
+
+  if (frame->type == SUSCAN_PSD_FRAME_TYPE_KEYFRAME) {
+    SU_TRY(suscan_psd_stream_ensure_alloc(self, count));
+
+    suscan_psd_codec_bytes_to_q(encoding, frame->data, count, self->ref);
+
+    self->fc       = fc;
+    self->size     = count;
+    self->encoding = encoding;
+  } else {
+    /* Frames can only be applied on top of the one they were built on */
+    if (!self->synced
+      || frame->seq != self->seq + 1
+      || self->fc != fc
+      || self->size != count
+      || self->encoding != encoding)
+      goto done;
+
+    suscan_psd_codec_apply_residual(encoding, self->ref, frame->data, count);
+  }
+
+  self->seq    = frame->seq;
+  self->offset = frame->offset;
+  self->scale  = frame->scale;
+
+  if (count > 0) {
+    SU_ALLOCATE_MANY(result, count, SUFLOAT);
+    suscan_psd_codec_dequantize_bins(
+      encoding,
+      self->offset,
+      self->scale,
+      self->ref,
+      count,
+      result);
+  }
+
+  if (*psd != NULL)
+    free(*psd);
+
+  *psd   = result;
+  *size  = count;
+  result = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  self->synced = ok;
+
+  if (result != NULL)
+    free(result);
+
+  return ok;
+}
@@ -0,0 +1,253 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SUSCAN_PSDCODEC_H
+#define _SUSCAN_PSDCODEC_H
+
+#include <sigutils/types.h>
+#include <sigutils/defs.h>
+#include <util/cbor.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define SUSCAN_PSD_CODEC_DEFAULT_MIN_DB -200.
+#define SUSCAN_PSD_CODEC_DEFAULT_MAX_DB  100.
+#define SUSCAN_PSD_CODEC_MAX_KEYFRAME_INT 1000
+
+/* Headroom added to the range of keyframes, so that deltas fit in it */
+#define SUSCAN_PSD_STREAM_RANGE_MARGIN_DB 6.
+
+/* Delta streams are kept per source. Further sources are never deltas. */
+#define SUSCAN_PSD_STREAM_MAX 8
+
+/* Size of the offset / scale header of quantized frames */
+#define SUSCAN_PSD_CODEC_FRAME_HEADER_SIZE (2 * sizeof(uint32_t))
+
+/*
+ * Wire encodings of PSD data. Quantized encodings convert every bin to dB
+ * and store it as an unsigned integer q, so that:
+ *
+ *   dB = offset + scale * q
+ *
+ * Offset and scale are computed for each frame from the bins that fall
+ * within the dynamic range requested by the client. Decoding is a pure
+ * function of (offset, scale, q), so every decoder (unicast or multicast)
+ * reconstructs exactly the same floats.
+ */
+enum suscan_psd_encoding {
+  SUSCAN_PSD_ENCODING_FLOAT32,
+  SUSCAN_PSD_ENCODING_DB_U8,
+  SUSCAN_PSD_ENCODING_DB_U16,
+  SUSCAN_PSD_ENCODING_COUNT
+};
+
+struct suscan_psd_codec_params {
+  enum suscan_psd_encoding encoding;
+  SUFLOAT  min_db;       /* Bins below this are clipped */
+  SUFLOAT  max_db;       /* Bins above this are clipped */
+  uint32_t keyframe_int; /* Delta frames between keyframes, 0: no deltas */
+};
+
+#define suscan_psd_codec_params_INITIALIZER     \
+{                                               \
+  SUSCAN_PSD_ENCODING_FLOAT32, /* encoding */   \
+  SUSCAN_PSD_CODEC_DEFAULT_MIN_DB, /* min_db */ \
+  SUSCAN_PSD_CODEC_DEFAULT_MAX_DB, /* max_db */ \
+  0, /* keyframe_int */                         \
+}
+
+/*
+ * Quantized frames are either standalone, or part of a delta stream.
+ * Streams start with a keyframe (a standalone frame plus a sequence
+ * number), followed by frames with the difference of their quantized bins
+ * against the previous one. Delta frames reuse the offset and scale of
+ * the keyframe, and are only decodable if every previous frame in the
+ * stream was received: decoders that miss a frame wait for the next
+ * keyframe.
+ */
+enum suscan_psd_frame_type {
+  SUSCAN_PSD_FRAME_TYPE_STANDALONE,
+  SUSCAN_PSD_FRAME_TYPE_KEYFRAME,
+  SUSCAN_PSD_FRAME_TYPE_DELTA
+};
+
+/* Stream frame, as received. Decoded by suscan_psd_stream_decode. */
+struct suscan_psd_frame {
+  enum suscan_psd_frame_type type;
+  uint32_t seq;
+  SUSINGLE offset;
+  SUSINGLE scale;
+  void    *data;
+  size_t   data_size;
+};
+
+void suscan_psd_frame_destroy(struct suscan_psd_frame *self);
+
+/* Encoder or decoder state of a delta stream */
+struct suscan_psd_stream {
+  SUBOOL    synced;   /* Reference frame is valid */
+  uint32_t  seq;      /* Sequence number of the reference frame */
+  int64_t   fc;
+  SUSCOUNT  size;
+  enum suscan_psd_encoding encoding;
+  SUSINGLE  offset;
+  SUSINGLE  scale;
+  SUSCOUNT  deltas;   /* Delta frames since the last keyframe */
+
+  uint16_t *ref;      /* Quantized bins of the reference frame */
+  uint16_t *cur;
+  uint8_t  *bytes;
+  SUSCOUNT  alloc;
+};
+
+void suscan_psd_stream_init(struct suscan_psd_stream *self);
+void suscan_psd_stream_finalize(struct suscan_psd_stream *self);
+
+/* Next frame will be a keyframe (encoder) or must be a keyframe (decoder) */
+SUINLINE void
+suscan_psd_stream_reset(struct suscan_psd_stream *self)
+{
+  self->synced = SU_FALSE;
+}
+
+/* Encodes the next frame of the stream, as a keyframe or a delta frame */
+SUBOOL suscan_psd_stream_pack(
+  struct suscan_psd_stream *self,
+  grow_buf_t *buffer,
+  const struct suscan_psd_codec_params *params,
+  int64_t fc,
+  const SUFLOAT *psd,
+  SUSCOUNT size);
+
+/*
+ * Reconstructs a stream frame. Fails if the stream is out of sync, in
+ * which case the frame must be discarded.
+ */
+SUBOOL suscan_psd_stream_decode(
+  struct suscan_psd_stream *self,
+  enum suscan_psd_encoding encoding,
+  int64_t fc,
+  const struct suscan_psd_frame *frame,
+  SUFLOAT **psd,
+  SUSCOUNT *size);
+
+SUINLINE unsigned int
+suscan_psd_encoding_get_bin_size(enum suscan_psd_encoding encoding)
+{
+  switch (encoding) {
+    case SUSCAN_PSD_ENCODING_DB_U8:
+      return sizeof(uint8_t);
+
+    case SUSCAN_PSD_ENCODING_DB_U16:
+      return sizeof(uint16_t);
+
+    default:
+      return sizeof(float);
+  }
+}
+
+SUINLINE SUBOOL
+suscan_psd_encoding_is_quantized(enum suscan_psd_encoding encoding)
+{
+  return encoding == SUSCAN_PSD_ENCODING_DB_U8
+      || encoding == SUSCAN_PSD_ENCODING_DB_U16;
+}
+
+/* Whether two parameter sets produce the same serialized PSD */
+SUINLINE SUBOOL
+suscan_psd_codec_params_equal(
+  const struct suscan_psd_codec_params *a,
+  const struct suscan_psd_codec_params *b)
+{
+  if (a->encoding != b->encoding)
+    return SU_FALSE;
+
+  if (!suscan_psd_encoding_is_quantized(a->encoding))
+    return SU_TRUE;
+
+  return a->min_db == b->min_db
+      && a->max_db == b->max_db
+      && a->keyframe_int == b->keyframe_int;
+}
+
+SUINLINE SUBOOL
+suscan_psd_codec_params_has_deltas(const struct suscan_psd_codec_params *p)
+{
+  return suscan_psd_encoding_is_quantized(p->encoding) && p->keyframe_int > 0;
+}
+
+const char *suscan_psd_encoding_to_string(enum suscan_psd_encoding encoding);
+SUBOOL suscan_psd_encoding_from_string(
+  const char *string,
+  enum suscan_psd_encoding *encoding);
+
+SUBOOL suscan_psd_codec_params_is_valid(
+  const struct suscan_psd_codec_params *params);
+
+/*
+ * Quantizes size bins into data (size * bin size bytes, 16-bit bins in
+ * network byte order). Returns the frame offset and scale.
+ */
+void suscan_psd_quantize(
+  const struct suscan_psd_codec_params *params,
+  const SUFLOAT *psd,
+  SUSCOUNT size,
+  SUFLOAT *offset,
+  SUFLOAT *scale,
+  void *data);
+
+/* Inverse of the above. Fails on malformed offset / scale pairs. */
+SUBOOL suscan_psd_dequantize(
+  enum suscan_psd_encoding encoding,
+  SUFLOAT offset,
+  SUFLOAT scale,
+  const void *data,
+  SUSCOUNT size,
+  SUFLOAT *psd);
+
+/*
+ * CBOR representation of standalone quantized frames: frame type, offset,
+ * scale, blob. Stream frames add a sequence number after the frame type.
+ */
+SUBOOL suscan_psd_codec_pack(
+  grow_buf_t *buffer,
+  const struct suscan_psd_codec_params *params,
+  const SUFLOAT *psd,
+  SUSCOUNT size);
+
+/*
+ * Standalone frames are decoded into psd / size. Stream frames are
+ * returned in frame (and size set to their number of bins), as only the
+ * owner of the stream can decode them.
+ */
+SUBOOL suscan_psd_codec_unpack(
+  grow_buf_t *buffer,
+  enum suscan_psd_encoding encoding,
+  SUFLOAT **psd,
+  SUSCOUNT *size,
+  struct suscan_psd_frame **frame);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SUSCAN_PSDCODEC_H */
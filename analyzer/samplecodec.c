@@ -0,0 +1,331 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "samplecodec"
+
+#include <sigutils/log.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "samplecodec.h"
+#include "serialize.h"
+
+/* Batches are never bigger than this */
+#define SUSCAN_SAMPLE_CODEC_MAX_SAMPLES (1 << 24)
+
+SUPRIVATE const char *g_sample_encoding_names[SUSCAN_SAMPLE_ENCODING_COUNT] = {
+  "f32",
+  "iq16",
+  "iq8",
+  "real32",
+  "real16"
+};
+
+const char *
+suscan_sample_encoding_to_string(enum suscan_sample_encoding encoding)
+{
+  if (encoding < 0 || encoding >= SUSCAN_SAMPLE_ENCODING_COUNT)
+    return NULL;
+
+  return g_sample_encoding_names[encoding];
+}
+
+SUBOOL
+suscan_sample_encoding_from_string(
+  const char *string,
+  enum suscan_sample_encoding *encoding)
+{
+  unsigned int i;
+
+  for (i = 0; i < SUSCAN_SAMPLE_ENCODING_COUNT; ++i)
+    if (strcasecmp(string, g_sample_encoding_names[i]) == 0) {
+      *encoding = i;
+      return SU_TRUE;
+    }
+
+  return SU_FALSE;
+}
+
+SUBOOL
+suscan_sample_codec_params_is_valid(
+  const struct suscan_sample_codec_params *params)
+{
+  if (params->iq < 0 || params->iq >= SUSCAN_SAMPLE_ENCODING_COUNT)
+    return SU_FALSE;
+
+  if (params->audio < 0 || params->audio >= SUSCAN_SAMPLE_ENCODING_COUNT)
+    return SU_FALSE;
+
+  return !suscan_sample_encoding_is_real(params->iq);
+}
+
+SUINLINE unsigned int
+suscan_sample_encoding_get_levels(enum suscan_sample_encoding encoding)
+{
+  return encoding == SUSCAN_SAMPLE_ENCODING_IQ_INT8 ? 0x7f : 0x7fff;
+}
+
+/* Largest component of the batch. Invalid samples are ignored. */
+SUPRIVATE SUFLOAT
+suscan_sample_codec_get_peak(
+  const SUCOMPLEX *samples,
+  SUSCOUNT count,
+  SUBOOL real)
+{
+  SUFLOAT peak = 0, re, im;
+  SUSCOUNT i;
+
+  for (i = 0; i < count; ++i) {
+    re = SU_ABS(SU_C_REAL(samples[i]));
+    im = real ? 0 : SU_ABS(SU_C_IMAG(samples[i]));
+
+    if (isfinite(re) && re > peak)
+      peak = re;
+    if (isfinite(im) && im > peak)
+      peak = im;
+  }
+
+  return peak;
+}
+
+SUINLINE int32_t
+suscan_sample_codec_quantize(SUFLOAT x, SUFLOAT inv_step, int32_t levels)
+{
+  SUFLOAT q = SU_FLOOR(x * inv_step + .5);
+
+  if (!isfinite(q))
+    return 0;
+  if (q > levels)
+    return levels;
+  if (q < -levels)
+    return -levels;
+
+  return (int32_t) q;
+}
+
+SUBOOL
+suscan_sample_codec_pack(
+  grow_buf_t *buffer,
+  enum suscan_sample_encoding encoding,
+  SUBOOL little_endian,
+  const SUCOMPLEX *samples,
+  SUSCOUNT count)
+{
+  SUBOOL real = suscan_sample_encoding_is_real(encoding);
+  uint8_t *data = NULL;
+  int32_t levels = 0;
+  SUFLOAT step = 0, inv_step = 0;
+  SUSINGLE value;
+  uint32_t as_int;
+  SUSCOUNT i;
+  SUBOOL ok = SU_FALSE;
+
+  if (encoding == SUSCAN_SAMPLE_ENCODING_FLOAT32)
+    return suscan_pack_compact_complex_array_ex(
+      buffer,
+      samples,
+      count,
+      little_endian);
+
+  if (encoding < 0 || encoding >= SUSCAN_SAMPLE_ENCODING_COUNT) {
+    SU_ERROR("Invalid sample encoding %d\n", encoding);
+    goto done;
+  }
+
+  SU_TRYZ(cbor_pack_uint(buffer, count));
+
+  if (suscan_sample_encoding_is_quantized(encoding)) {
+    levels = suscan_sample_encoding_get_levels(encoding);
+    step   = suscan_sample_codec_get_peak(samples, count, real) / levels;
+    if (step > 0)
+      inv_step = 1. / step;
+
+    SU_TRYZ(cbor_pack_single(buffer, step));
+  }
+
+  if (count == 0) {
+    SU_TRYZ(cbor_pack_blob(buffer, NULL, 0));
+  } else {
+    SU_TRY(
+      data = cbor_alloc_blob(
+        buffer,
+        count * suscan_sample_encoding_get_size(encoding)));
+
+    switch (encoding) {
+      case SUSCAN_SAMPLE_ENCODING_IQ_INT16:
+        for (i = 0; i < count; ++i) {
+          cpu16_to_be_unaligned(
+            suscan_sample_codec_quantize(
+              SU_C_REAL(samples[i]),
+              inv_step,
+              levels),
+            data + 4 * i);
+          cpu16_to_be_unaligned(
+            suscan_sample_codec_quantize(
+              SU_C_IMAG(samples[i]),
+              inv_step,
+              levels),
+            data + 4 * i + 2);
+        }
+        break;
+
+      case SUSCAN_SAMPLE_ENCODING_IQ_INT8:
+        for (i = 0; i < count; ++i) {
+          data[2 * i] = suscan_sample_codec_quantize(
+            SU_C_REAL(samples[i]),
+            inv_step,
+            levels);
+          data[2 * i + 1] = suscan_sample_codec_quantize(
+            SU_C_IMAG(samples[i]),
+            inv_step,
+            levels);
+        }
+        break;
+
+      case SUSCAN_SAMPLE_ENCODING_REAL_FLOAT32:
+        for (i = 0; i < count; ++i) {
+          value = SU_C_REAL(samples[i]);
+          memcpy(&as_int, &value, sizeof(uint32_t));
+          cpu32_to_be_unaligned(as_int, data + 4 * i);
+        }
+        break;
+
+      case SUSCAN_SAMPLE_ENCODING_REAL_INT16:
+        for (i = 0; i < count; ++i)
+          cpu16_to_be_unaligned(
+            suscan_sample_codec_quantize(
+              SU_C_REAL(samples[i]),
+              inv_step,
+              levels),
+            data + 2 * i);
+        break;
+
+      default:
+        goto done;
+    }
+  }
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+SUBOOL
+suscan_sample_codec_unpack(
+  grow_buf_t *buffer,
+  enum suscan_sample_encoding encoding,
+  SUCOMPLEX **samples,
+  SUSCOUNT *count)
+{
+  uint64_t length;
+  SUSINGLE step = 0, value;
+  const uint8_t *data = NULL;
+  size_t data_size = 0;
+  SUCOMPLEX *result = *samples;
+  uint32_t as_int;
+  SUSCOUNT i;
+  SUBOOL ok = SU_FALSE;
+
+  if (encoding == SUSCAN_SAMPLE_ENCODING_FLOAT32)
+    return suscan_unpack_compact_complex_array(buffer, samples, count);
+
+  if (encoding < 0 || encoding >= SUSCAN_SAMPLE_ENCODING_COUNT) {
+    SU_ERROR("Invalid sample encoding %d\n", encoding);
+    goto done;
+  }
+
+  SU_TRYZ(cbor_unpack_uint64(buffer, &length));
+
+  if (length > SUSCAN_SAMPLE_CODEC_MAX_SAMPLES) {
+    SU_ERROR("Sample batch is too big (%lu samples)\n", (unsigned long) length);
+    goto done;
+  }
+
+  if (suscan_sample_encoding_is_quantized(encoding)) {
+    SU_TRYZ(cbor_unpack_single(buffer, &step));
+    if (!isfinite(step)) {
+      SU_ERROR("Invalid sample batch step\n");
+      goto done;
+    }
+  }
+
+  SU_TRYZ(cbor_unpack_blob_ref(buffer, (const void **) &data, &data_size));
+
+  if (data_size != length * suscan_sample_encoding_get_size(encoding)) {
+    SU_ERROR("Sample batch size does not match its sample count\n");
+    goto done;
+  }
+
+  if (length == 0) {
+    if (result != NULL)
+      free(result);
+
+    *samples = NULL;
+    *count   = 0;
+
+    ok = SU_TRUE;
+    goto done;
+  }
+
+  if (result == NULL || *count != length) {
+    SU_TRY(result = realloc(result, length * sizeof(SUCOMPLEX)));
+    *samples = result;
+    *count   = length;
+  }
+
+  switch (encoding) {
+    case SUSCAN_SAMPLE_ENCODING_IQ_INT16:
+      for (i = 0; i < length; ++i)
+        result[i] =
+            step * (int16_t) be16_to_cpu_unaligned(data + 4 * i)
+          + I * step * (int16_t) be16_to_cpu_unaligned(data + 4 * i + 2);
+      break;
+
+    case SUSCAN_SAMPLE_ENCODING_IQ_INT8:
+      for (i = 0; i < length; ++i)
+        result[i] =
+            step * (int8_t) data[2 * i]
+          + I * step * (int8_t) data[2 * i + 1];
+      break;
+
+    case SUSCAN_SAMPLE_ENCODING_REAL_FLOAT32:
+      for (i = 0; i < length; ++i) {
+        as_int = be32_to_cpu_unaligned(data + 4 * i);
+        memcpy(&value, &as_int, sizeof(SUSINGLE));
+        result[i] = value;
+      }
+      break;
+
+    case SUSCAN_SAMPLE_ENCODING_REAL_INT16:
+      for (i = 0; i < length; ++i)
+        result[i] = step * (int16_t) be16_to_cpu_unaligned(data + 2 * i);
+      break;
+
+    default:
+      goto done;
+  }
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
@@ -0,0 +1,136 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SUSCAN_SAMPLECODEC_H
+#define _SUSCAN_SAMPLECODEC_H
+
+#include <sigutils/types.h>
+#include <sigutils/defs.h>
+#include <util/cbor.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Wire encodings of sample batches. Integer encodings store every
+ * component as a signed integer q, so that:
+ *
+ *   x = step * q
+ *
+ * The step is computed for each batch from its peak amplitude. Real
+ * encodings drop the imaginary part, and are meant for inspectors whose
+ * output is consumed as a real signal (e.g. demodulated audio).
+ */
+enum suscan_sample_encoding {
+  SUSCAN_SAMPLE_ENCODING_FLOAT32,
+  SUSCAN_SAMPLE_ENCODING_IQ_INT16,
+  SUSCAN_SAMPLE_ENCODING_IQ_INT8,
+  SUSCAN_SAMPLE_ENCODING_REAL_FLOAT32,
+  SUSCAN_SAMPLE_ENCODING_REAL_INT16,
+  SUSCAN_SAMPLE_ENCODING_COUNT
+};
+
+struct suscan_sample_codec_params {
+  enum suscan_sample_encoding iq;    /* Samples of any inspector */
+  enum suscan_sample_encoding audio; /* Samples of audio inspectors */
+};
+
+#define suscan_sample_codec_params_INITIALIZER     \
+{                                                  \
+  SUSCAN_SAMPLE_ENCODING_FLOAT32, /* iq */         \
+  SUSCAN_SAMPLE_ENCODING_FLOAT32, /* audio */      \
+}
+
+SUINLINE SUBOOL
+suscan_sample_encoding_is_real(enum suscan_sample_encoding encoding)
+{
+  return encoding == SUSCAN_SAMPLE_ENCODING_REAL_FLOAT32
+      || encoding == SUSCAN_SAMPLE_ENCODING_REAL_INT16;
+}
+
+SUINLINE SUBOOL
+suscan_sample_encoding_is_quantized(enum suscan_sample_encoding encoding)
+{
+  return encoding == SUSCAN_SAMPLE_ENCODING_IQ_INT16
+      || encoding == SUSCAN_SAMPLE_ENCODING_IQ_INT8
+      || encoding == SUSCAN_SAMPLE_ENCODING_REAL_INT16;
+}
+
+/* Bytes per sample on the wire */
+SUINLINE unsigned int
+suscan_sample_encoding_get_size(enum suscan_sample_encoding encoding)
+{
+  switch (encoding) {
+    case SUSCAN_SAMPLE_ENCODING_IQ_INT16:
+      return 2 * sizeof(int16_t);
+
+    case SUSCAN_SAMPLE_ENCODING_IQ_INT8:
+      return 2 * sizeof(int8_t);
+
+    case SUSCAN_SAMPLE_ENCODING_REAL_FLOAT32:
+      return sizeof(float);
+
+    case SUSCAN_SAMPLE_ENCODING_REAL_INT16:
+      return sizeof(int16_t);
+
+    default:
+      return 2 * sizeof(float);
+  }
+}
+
+const char *suscan_sample_encoding_to_string(
+  enum suscan_sample_encoding encoding);
+SUBOOL suscan_sample_encoding_from_string(
+  const char *string,
+  enum suscan_sample_encoding *encoding);
+
+/* Real encodings are only accepted for audio inspectors */
+SUBOOL suscan_sample_codec_params_is_valid(
+  const struct suscan_sample_codec_params *params);
+
+/*
+ * CBOR representation of a batch: sample count, the step of quantized
+ * encodings, and a blob with the encoded samples (big endian). Float32
+ * batches are compact complex arrays, as before encodings existed, and
+ * may be sent in little endian order (see serialize.h).
+ */
+SUBOOL suscan_sample_codec_pack(
+  grow_buf_t *buffer,
+  enum suscan_sample_encoding encoding,
+  SUBOOL little_endian,
+  const SUCOMPLEX *samples,
+  SUSCOUNT count);
+
+/*
+ * Decodes a batch straight from the buffer into *samples, which is
+ * reallocated if its size does not match.
+ */
+SUBOOL suscan_sample_codec_unpack(
+  grow_buf_t *buffer,
+  enum suscan_sample_encoding encoding,
+  SUCOMPLEX **samples,
+  SUSCOUNT *count);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SUSCAN_SAMPLECODEC_H */
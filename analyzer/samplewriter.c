@@ -0,0 +1,268 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "samplewriter"
+
+#include <sigutils/log.h>
+#include <sigutils/util/compat-unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include "samplewriter.h"
+#include "analyzer.h"
+
+#ifndef O_BINARY
+#  define O_BINARY 0
+#endif /* O_BINARY */
+
+SUPRIVATE SUBOOL
+suscan_sample_writer_write_block(
+    suscan_sample_writer_t *self,
+    const struct suscan_sample_writer_block *block)
+{
+  const uint8_t *data = (const uint8_t *) block->data;
+  size_t size = 2 * block->size * sizeof(float);
+  ssize_t got;
+
+  while (size > 0) {
+    got = write(self->fd, data, size);
+    if (got < 0) {
+      if (errno == EINTR)
+        continue;
+
+      return SU_FALSE;
+    }
+
+    data += got;
+    size -= got;
+  }
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+suscan_sample_writer_worker_cb(
+    struct suscan_mq *mq_out,
+    void *wk_private,
+    void *cb_private)
+{
+  suscan_sample_writer_t *self = (suscan_sample_writer_t *) wk_private;
+  struct suscan_sample_writer_block *block;
+  SUBOOL failed;
+
+  pthread_mutex_lock(&self->mutex);
+  block  = self->block_list + self->block_head;
+  failed = self->failed;
+  pthread_mutex_unlock(&self->mutex);
+
+  /* After a failure, blocks are just released */
+  if (!failed && !suscan_sample_writer_write_block(self, block)) {
+    self->error = errno;
+    SU_ERROR("Failed to write samples: %s\n", strerror(self->error));
+    failed = SU_TRUE;
+  }
+
+  pthread_mutex_lock(&self->mutex);
+  if (failed)
+    self->failed = SU_TRUE;
+  else
+    self->written += block->size;
+
+  block->size = 0;
+  self->block_head = (self->block_head + 1) % SUSCAN_SAMPLE_WRITER_MAX_BLOCKS;
+  --self->block_count;
+  pthread_mutex_unlock(&self->mutex);
+
+  return SU_FALSE;
+}
+
+/*
+ * Hands the block being filled to the worker. One block is always kept
+ * for the producer, so this fails if the worker already has all the
+ * others.
+ */
+SUPRIVATE SUBOOL
+suscan_sample_writer_commit(suscan_sample_writer_t *self)
+{
+  SUBOOL ok = SU_FALSE;
+
+  pthread_mutex_lock(&self->mutex);
+  if (self->block_count < SUSCAN_SAMPLE_WRITER_MAX_BLOCKS - 1) {
+    ++self->block_count;
+    self->block_fill = (self->block_fill + 1) % SUSCAN_SAMPLE_WRITER_MAX_BLOCKS;
+    ok = SU_TRUE;
+  }
+  pthread_mutex_unlock(&self->mutex);
+
+  if (ok && !suscan_worker_push(
+      self->worker,
+      suscan_sample_writer_worker_cb,
+      NULL)) {
+    self->failed = SU_TRUE;
+    ok = SU_FALSE;
+  }
+
+  return ok;
+}
+
+SU_METHOD(
+  suscan_sample_writer,
+  SUBOOL,
+  write,
+  const SUCOMPLEX *data,
+  SUSCOUNT len)
+{
+  struct suscan_sample_writer_block *block;
+  SUSCOUNT chunk;
+  float *dest;
+  SUBOOL ok = SU_FALSE;
+
+  if (self->failed)
+    goto done;
+
+  while (len > 0) {
+    block = self->block_list + self->block_fill;
+
+    if (block->size == SUSCAN_SAMPLE_WRITER_BLOCK_SIZE) {
+      if (!suscan_sample_writer_commit(self)) {
+        if (self->failed)
+          goto done;
+
+        /* Disk is not keeping up */
+        self->dropped += len;
+        break;
+      }
+
+      block = self->block_list + self->block_fill;
+    }
+
+    /* Blocks are allocated as they are needed */
+    if (block->data == NULL)
+      SU_ALLOCATE_MANY(block->data, 2 * SUSCAN_SAMPLE_WRITER_BLOCK_SIZE, float);
+
+    chunk = SUSCAN_SAMPLE_WRITER_BLOCK_SIZE - block->size;
+    if (chunk > len)
+      chunk = len;
+
+    dest = block->data + 2 * block->size;
+
+#ifdef _SU_SINGLE_PRECISION
+    memcpy(dest, data, chunk * sizeof(SUCOMPLEX));
+#else
+    {
+      SUSCOUNT i;
+
+      for (i = 0; i < chunk; ++i) {
+        dest[2 * i]     = SU_C_REAL(data[i]);
+        dest[2 * i + 1] = SU_C_IMAG(data[i]);
+      }
+    }
+#endif /* _SU_SINGLE_PRECISION */
+
+    block->size += chunk;
+    data        += chunk;
+    len         -= chunk;
+  }
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+SU_INSTANCER(suscan_sample_writer, const char *path)
+{
+  suscan_sample_writer_t *new = NULL;
+
+  SU_ALLOCATE_FAIL(new, suscan_sample_writer_t);
+
+  new->fd = open(
+    path,
+    O_WRONLY | O_CREAT | O_EXCL | O_BINARY,
+    0644);
+
+  if (new->fd == -1) {
+    new->error = errno;
+    SU_ERROR("Cannot create `%s': %s\n", path, strerror(errno));
+    goto fail;
+  }
+
+  SU_TRYZ_FAIL(pthread_mutex_init(&new->mutex, NULL));
+  new->mutex_init = SU_TRUE;
+
+  SU_TRY_FAIL(suscan_mq_init(&new->worker_mq));
+  new->worker_mq_init = SU_TRUE;
+
+  SU_TRY_FAIL(
+    new->worker = suscan_worker_new_ex(
+      "sample-writer",
+      &new->worker_mq,
+      new));
+
+  return new;
+
+fail:
+  if (new != NULL)
+    suscan_sample_writer_destroy(new);
+
+  return NULL;
+}
+
+/*
+ * Blocks the worker did not get to (and the last, partial block) are
+ * written synchronously, so that closing the writer never loses samples.
+ */
+SU_COLLECTOR(suscan_sample_writer)
+{
+  struct suscan_sample_writer_block *block;
+  unsigned int i, ndx;
+
+  if (self->worker != NULL)
+    if (!suscan_analyzer_halt_worker(self->worker))
+      SU_ERROR("Sample writer worker destruction failed, memory leak ahead\n");
+
+  if (self->fd != -1) {
+    for (i = 0; i <= self->block_count; ++i) {
+      ndx   = (self->block_head + i) % SUSCAN_SAMPLE_WRITER_MAX_BLOCKS;
+      block = self->block_list + ndx;
+
+      if (!self->failed && block->size > 0) {
+        if (suscan_sample_writer_write_block(self, block))
+          self->written += block->size;
+        else
+          SU_ERROR("Failed to flush samples: %s\n", strerror(errno));
+      }
+    }
+
+    close(self->fd);
+  }
+
+  for (i = 0; i < SUSCAN_SAMPLE_WRITER_MAX_BLOCKS; ++i)
+    if (self->block_list[i].data != NULL)
+      free(self->block_list[i].data);
+
+  if (self->worker_mq_init)
+    suscan_mq_finalize(&self->worker_mq);
+
+  if (self->mutex_init)
+    pthread_mutex_destroy(&self->mutex);
+
+  free(self);
+}
@@ -0,0 +1,116 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _SUSCAN_SAMPLEWRITER_H
+#define _SUSCAN_SAMPLEWRITER_H
+
+#include <sigutils/types.h>
+#include <sigutils/defs.h>
+#include <pthread.h>
+
+#include "worker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define SUSCAN_SAMPLE_WRITER_BLOCK_SIZE 16384 /* In samples */
+#define SUSCAN_SAMPLE_WRITER_MAX_BLOCKS 32
+
+/* Samples are always stored as interleaved, native-endian floats */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#  define SUSCAN_SAMPLE_WRITER_SIGMF_DATATYPE "cf32_be"
+#else
+#  define SUSCAN_SAMPLE_WRITER_SIGMF_DATATYPE "cf32_le"
+#endif
+
+struct suscan_sample_writer_block {
+  float   *data;
+  SUSCOUNT size;  /* In samples */
+};
+
+/*
+ * Buffered asynchronous sample writer. Samples are accumulated in fixed
+ * size blocks, which are written to disk by a dedicated worker. Whoever
+ * writes samples is never blocked by the disk: if the worker falls
+ * behind and no free blocks are left, samples are dropped (and counted).
+ *
+ * Blocks are a ring: [block_head, block_head + block_count) are waiting
+ * for the worker, and block_fill is being filled by the producer.
+ */
+struct suscan_sample_writer {
+  int fd;
+
+  struct suscan_sample_writer_block block_list[SUSCAN_SAMPLE_WRITER_MAX_BLOCKS];
+  unsigned int     block_head;
+  unsigned int     block_count;
+  unsigned int     block_fill;
+  pthread_mutex_t  mutex;
+  SUBOOL           mutex_init;
+
+  suscan_worker_t *worker;
+  struct suscan_mq worker_mq;
+  SUBOOL           worker_mq_init;
+
+  /* Statistics */
+  uint64_t written; /* In samples */
+  uint64_t dropped; /* In samples */
+  SUBOOL   failed;
+  int      error;
+};
+
+typedef struct suscan_sample_writer suscan_sample_writer_t;
+
+/* Creates a new file. Existing files are never overwritten. */
+SU_INSTANCER(suscan_sample_writer, const char *path);
+SU_COLLECTOR(suscan_sample_writer);
+
+SUINLINE SU_GETTER(suscan_sample_writer, uint64_t, get_written)
+{
+  return self->written;
+}
+
+SUINLINE SU_GETTER(suscan_sample_writer, uint64_t, get_dropped)
+{
+  return self->dropped;
+}
+
+SUINLINE SU_GETTER(suscan_sample_writer, SUBOOL, is_failed)
+{
+  return self->failed;
+}
+
+SUINLINE SU_GETTER(suscan_sample_writer, int, get_error)
+{
+  return self->error;
+}
+
+/* Returns SU_FALSE if the writer failed */
+SU_METHOD(
+  suscan_sample_writer,
+  SUBOOL,
+  write,
+  const SUCOMPLEX *data,
+  SUSCOUNT len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SUSCAN_SAMPLEWRITER_H */
@@ -27,18 +27,103 @@
 #include "serialize.h"
 
 /* Helper functions */
+#if defined(__GNUC__) || defined(__clang__)
+#  define SUSCAN_BSWAP32(x) __builtin_bswap32(x)
+#  define SUSCAN_BSWAP64(x) __builtin_bswap64(x)
+#else
+#  define SUSCAN_BSWAP32(x)                                  \
+  ((((x) & 0xff) << 24) | (((x) & 0xff00) << 8)              \
+  | (((x) >> 8) & 0xff00) | (((x) >> 24) & 0xff))
+#  define SUSCAN_BSWAP64(x)                                  \
+  (((uint64_t) SUSCAN_BSWAP32((uint32_t) (x)) << 32)          \
+  | SUSCAN_BSWAP32((uint32_t) ((x) >> 32)))
+#endif
+
+/*
+ * Byte swapping kernels. They work in place and on unaligned arrays, and
+ * swap blocks of 16 bytes so that compilers turn them into vector
+ * shuffles (pshufb, vrev, etc).
+ */
+SUPRIVATE void
+suscan_array_bswap32(void *dest, const void *orig, SUSCOUNT size)
+{
+  uint8_t *d = dest;
+  const uint8_t *o = orig;
+  uint32_t x[4];
+  SUSCOUNT i;
+
+  for (i = 0; i + 4 <= size; i += 4) {
+    memcpy(x, o + 4 * i, sizeof(x));
+    x[0] = SUSCAN_BSWAP32(x[0]);
+    x[1] = SUSCAN_BSWAP32(x[1]);
+    x[2] = SUSCAN_BSWAP32(x[2]);
+    x[3] = SUSCAN_BSWAP32(x[3]);
+    memcpy(d + 4 * i, x, sizeof(x));
+  }
+
+  for (; i < size; ++i) {
+    memcpy(x, o + 4 * i, sizeof(uint32_t));
+    x[0] = SUSCAN_BSWAP32(x[0]);
+    memcpy(d + 4 * i, x, sizeof(uint32_t));
+  }
+}
+
+SUPRIVATE void
+suscan_array_bswap64(void *dest, const void *orig, SUSCOUNT size)
+{
+  uint8_t *d = dest;
+  const uint8_t *o = orig;
+  uint64_t x[2];
+  SUSCOUNT i;
+
+  for (i = 0; i + 2 <= size; i += 2) {
+    memcpy(x, o + 8 * i, sizeof(x));
+    x[0] = SUSCAN_BSWAP64(x[0]);
+    x[1] = SUSCAN_BSWAP64(x[1]);
+    memcpy(d + 8 * i, x, sizeof(x));
+  }
+
+  if (i < size) {
+    memcpy(x, o + 8 * i, sizeof(uint64_t));
+    x[0] = SUSCAN_BSWAP64(x[0]);
+    memcpy(d + 8 * i, x, sizeof(uint64_t));
+  }
+}
+
+/* Converts between host order and the given order. Symmetric. */
+SUPRIVATE void
+suscan_array_convert32(
+    void *dest,
+    const void *orig,
+    SUSCOUNT size,
+    SUBOOL little_endian)
+{
+  if (!suscan_array_order_is_native(little_endian))
+    suscan_array_bswap32(dest, orig, size);
+  else if (dest != orig)
+    memcpy(dest, orig, size * sizeof(uint32_t));
+}
+
+SUPRIVATE void
+suscan_array_convert64(
+    void *dest,
+    const void *orig,
+    SUSCOUNT size,
+    SUBOOL little_endian)
+{
+  if (!suscan_array_order_is_native(little_endian))
+    suscan_array_bswap64(dest, orig, size);
+  else if (dest != orig)
+    memcpy(dest, orig, size * sizeof(uint64_t));
+}
+
 void
 suscan_single_array_cpu_to_be(
     SUSINGLE *array,
     const SUSINGLE *orig,
     SUSCOUNT size)
 {
-  SUSCOUNT i;
-  uint32_t *idest = (uint32_t *) array;
-  const uint32_t *iorig = (const uint32_t *) orig;
-
-  for (i = 0; i < size; ++i)
-    idest[i] = cpu32_to_be(iorig[i]);
+  suscan_array_convert32(array, orig, size, SU_FALSE);
 }
 
 void
@@ -47,12 +132,25 @@ suscan_single_array_be_to_cpu(
     const SUSINGLE *orig,
     SUSCOUNT size)
 {
-  SUSCOUNT i;
-  uint32_t *idest = (uint32_t *) array;
-  const uint32_t *iorig = (const uint32_t *) orig;
+  suscan_array_convert32(array, orig, size, SU_FALSE);
+}
+
+void
+suscan_single_array_cpu_to_le(
+    SUSINGLE *array,
+    const SUSINGLE *orig,
+    SUSCOUNT size)
+{
+  suscan_array_convert32(array, orig, size, SU_TRUE);
+}
 
-  for (i = 0; i < size; ++i)
-    idest[i] = be32_to_cpu_unaligned(iorig + i);
+void
+suscan_single_array_le_to_cpu(
+    SUSINGLE *array,
+    const SUSINGLE *orig,
+    SUSCOUNT size)
+{
+  suscan_array_convert32(array, orig, size, SU_TRUE);
 }
 
 void
@@ -61,12 +159,7 @@ suscan_double_array_cpu_to_be(
     const SUDOUBLE *orig,
     SUSCOUNT size)
 {
-  SUSCOUNT i;
-  uint64_t *idest = (uint64_t *) array;
-  const uint64_t *iorig = (const uint64_t *) orig;
-
-  for (i = 0; i < size; ++i)
-    idest[i] = cpu64_to_be(iorig[i]);
+  suscan_array_convert64(array, orig, size, SU_FALSE);
 }
 
 void
@@ -75,12 +168,25 @@ suscan_double_array_be_to_cpu(
     const SUDOUBLE *orig,
     SUSCOUNT size)
 {
-  SUSCOUNT i;
-  uint64_t *idest = (uint64_t *) array;
-  const uint64_t *iorig = (const uint64_t *) orig;
+  suscan_array_convert64(array, orig, size, SU_FALSE);
+}
+
+void
+suscan_double_array_cpu_to_le(
+    SUDOUBLE *array,
+    const SUDOUBLE *orig,
+    SUSCOUNT size)
+{
+  suscan_array_convert64(array, orig, size, SU_TRUE);
+}
 
-  for (i = 0; i < size; ++i)
-    idest[i] = be64_to_cpu_unaligned(iorig + i);
+void
+suscan_double_array_le_to_cpu(
+    SUDOUBLE *array,
+    const SUDOUBLE *orig,
+    SUSCOUNT size)
+{
+  suscan_array_convert64(array, orig, size, SU_TRUE);
 }
 
 SUBOOL
@@ -106,10 +212,11 @@ suscan_unpack_blob(
 }
 
 SUBOOL
-suscan_pack_compact_single_array(
+suscan_pack_compact_single_array_ex(
     grow_buf_t *buffer,
     const SUSINGLE *array,
-    SUSCOUNT size)
+    SUSCOUNT size,
+    SUBOOL little_endian)
 {
   SUSCOUNT array_size = size * sizeof(SUSINGLE);
   SUSINGLE *dest;
@@ -118,8 +225,11 @@ suscan_pack_compact_single_array(
   SUSCAN_PACK(uint, size);
 
   if (size > 0) {
+    if (little_endian)
+      SUSCAN_PACK(tag, CBOR_TAG_FLOAT32_LE);
+
     SU_TRYCATCH(dest = cbor_alloc_blob(buffer, array_size), goto fail);
-    suscan_single_array_cpu_to_be(dest, array, size);
+    suscan_array_convert32(dest, array, size, little_endian);
   }
 
   ok = SU_TRUE;
@@ -128,12 +238,21 @@ fail:
   return ok;
 }
 
+SUBOOL
+suscan_pack_compact_single_array(
+    grow_buf_t *buffer,
+    const SUSINGLE *array,
+    SUSCOUNT size)
+{
+  return suscan_pack_compact_single_array_ex(buffer, array, size, SU_FALSE);
+}
 
 SUBOOL
-suscan_pack_compact_double_array(
+suscan_pack_compact_double_array_ex(
     grow_buf_t *buffer,
     const SUDOUBLE *array,
-    SUSCOUNT size)
+    SUSCOUNT size,
+    SUBOOL little_endian)
 {
   SUSCOUNT array_size = size * sizeof(SUDOUBLE);
   SUDOUBLE *dest;
@@ -142,8 +261,11 @@ suscan_pack_compact_double_array(
   SUSCAN_PACK(uint, size);
 
   if (size > 0) {
+    if (little_endian)
+      SUSCAN_PACK(tag, CBOR_TAG_FLOAT64_LE);
+
     SU_TRYCATCH(dest = cbor_alloc_blob(buffer, array_size), goto fail);
-    suscan_double_array_cpu_to_be(dest, array, size);
+    suscan_array_convert64(dest, array, size, little_endian);
   }
 
   ok = SU_TRUE;
@@ -152,16 +274,153 @@ fail:
   return ok;
 }
 
+SUBOOL
+suscan_pack_compact_double_array(
+    grow_buf_t *buffer,
+    const SUDOUBLE *array,
+    SUSCOUNT size)
+{
+  return suscan_pack_compact_double_array_ex(buffer, array, size, SU_FALSE);
+}
+
+SUBOOL
+suscan_pack_compact_complex_array_ex(
+    grow_buf_t *buffer,
+    const SUCOMPLEX *array,
+    SUSCOUNT size,
+    SUBOOL little_endian)
+{
+  return suscan_pack_compact_float_array_ex(
+      buffer,
+      (const SUFLOAT *) array,
+      size << 1,
+      little_endian);
+}
+
 SUBOOL
 suscan_pack_compact_complex_array(
     grow_buf_t *buffer,
     const SUCOMPLEX *array,
     SUSCOUNT size)
 {
-  return suscan_pack_compact_float_array(
+  return suscan_pack_compact_complex_array_ex(buffer, array, size, SU_FALSE);
+}
+
+SUBOOL
+suscan_pdu_segments_flatten(
+    const struct suscan_pdu_segments *self,
+    const grow_buf_t *buffer,
+    grow_buf_t *dest)
+{
+  const uint8_t *bytes = grow_buf_get_buffer(buffer);
+  size_t size = grow_buf_get_size(buffer);
+  size_t p = 0;
+  unsigned int i;
+
+  for (i = 0; i < self->count; ++i) {
+    if (self->segment[i].offset > p)
+      SU_TRYCATCH(
+          grow_buf_append(dest, bytes + p, self->segment[i].offset - p) != -1,
+          return SU_FALSE);
+
+    SU_TRYCATCH(
+        grow_buf_append(
+          dest,
+          self->segment[i].data,
+          self->segment[i].size) != -1,
+        return SU_FALSE);
+
+    p = self->segment[i].offset;
+  }
+
+  if (size > p)
+    SU_TRYCATCH(
+        grow_buf_append(dest, bytes + p, size - p) != -1,
+        return SU_FALSE);
+
+  return SU_TRUE;
+}
+
+SUPRIVATE SUBOOL
+suscan_pdu_segments_add(
+    struct suscan_pdu_segments *self,
+    const grow_buf_t *buffer,
+    const void *data,
+    size_t size)
+{
+  if (self->count == SUSCAN_PDU_MAX_SEGMENTS)
+    return SU_FALSE;
+
+  self->segment[self->count].offset = grow_buf_get_size(buffer);
+  self->segment[self->count].data   = data;
+  self->segment[self->count].size   = size;
+
+  ++self->count;
+  self->size += size;
+
+  return SU_TRUE;
+}
+
+SUBOOL
+suscan_pack_compact_single_array_segmented(
+    grow_buf_t *buffer,
+    struct suscan_pdu_segments *segments,
+    const SUSINGLE *array,
+    SUSCOUNT size,
+    SUBOOL little_endian)
+{
+  SUSCOUNT array_size = size * sizeof(SUSINGLE);
+  SUBOOL ok = SU_FALSE;
+
+  /* Arrays that need byte swapping must be copied anyway */
+  if (segments == NULL
+    || !suscan_array_order_is_native(little_endian)
+    || array_size < SUSCAN_PDU_SEGMENT_MIN_SIZE
+    || segments->count == SUSCAN_PDU_MAX_SEGMENTS)
+    return suscan_pack_compact_single_array_ex(
       buffer,
-      (const SUFLOAT *) array,
-      size << 1);
+      array,
+      size,
+      little_endian);
+
+  SUSCAN_PACK(uint, size);
+  if (little_endian)
+    SUSCAN_PACK(tag, CBOR_TAG_FLOAT32_LE);
+  SU_TRYCATCH(cbor_pack_blob_start(buffer, array_size) == 0, goto fail);
+  SU_TRY_FAIL(suscan_pdu_segments_add(segments, buffer, array, array_size));
+
+  ok = SU_TRUE;
+
+fail:
+  return ok;
+}
+
+/* Untagged arrays are big endian. Only the given tag is accepted. */
+SUPRIVATE SUBOOL
+suscan_unpack_array_order(
+    grow_buf_t *buffer,
+    uint64_t le_tag,
+    SUBOOL *little_endian)
+{
+  enum cbor_major_type type;
+  uint8_t extra;
+  uint64_t tag;
+
+  *little_endian = SU_FALSE;
+
+  SU_TRYCATCH(cbor_peek_type(buffer, &type, &extra) == 0, return SU_FALSE);
+
+  if (type == CMT_TAG) {
+    SU_TRYCATCH(cbor_unpack_tag(buffer, &tag) == 0, return SU_FALSE);
+    if (tag != le_tag) {
+      SU_ERROR("Unexpected array tag %lu\n", (unsigned long) tag);
+      return SU_FALSE;
+    }
+
+    *little_endian = SU_TRUE;
+  }
+
+  return SU_TRUE;
 }
 
 SUBOOL
@@ -173,17 +432,20 @@ suscan_unpack_compact_single_array(
   SUSINGLE *array = *oarray;
   SUSCOUNT array_length = 0;
   size_t array_size = *osize * sizeof(SUSINGLE);
+  SUBOOL little_endian;
   SUBOOL ok = SU_FALSE;
 
   SUSCAN_UNPACK(uint64, array_length);
 
   if (array_length > 0) {
+    SU_TRY_FAIL(
+      suscan_unpack_array_order(buffer, CBOR_TAG_FLOAT32_LE, &little_endian));
     SU_TRYCATCH(
           cbor_unpack_blob(buffer, (void **) &array, &array_size) == 0,
           goto fail);
     SU_TRYCATCH(array_size == array_length * sizeof(SUSINGLE), goto fail);
 
-    suscan_single_array_be_to_cpu(array, array, array_length);
+    suscan_array_convert32(array, array, array_length, little_endian);
   } else {
     array = NULL;
   }
@@ -211,18 +473,21 @@ suscan_unpack_compact_double_array(
   SUDOUBLE *array = *oarray;
   size_t array_size = *osize * sizeof(SUDOUBLE);
   SUSCOUNT array_length = 0;
+  SUBOOL little_endian;
   SUBOOL ok = SU_FALSE;
 
   SUSCAN_UNPACK(uint64, array_length);
 
   if (array_length > 0) {
+    SU_TRY_FAIL(
+      suscan_unpack_array_order(buffer, CBOR_TAG_FLOAT64_LE, &little_endian));
     SU_TRYCATCH(
         cbor_unpack_blob(buffer, (void **) &array, &array_size) == 0,
         goto fail);
 
     SU_TRYCATCH(array_size == array_length * sizeof(SUDOUBLE), goto fail);
 
-    suscan_double_array_be_to_cpu(array, array, array_length);
+    suscan_array_convert64(array, array, array_length, little_endian);
   } else {
     array = NULL;
   }
@@ -23,13 +23,33 @@
 #include <util/cbor.h>
 
 #ifdef _SU_SINGLE_PRECISION
-#  define suscan_pack_compact_float_array   suscan_pack_compact_single_array
-#  define suscan_unpack_compact_float_array suscan_unpack_compact_single_array
+#  define suscan_pack_compact_float_array    suscan_pack_compact_single_array
+#  define suscan_pack_compact_float_array_ex suscan_pack_compact_single_array_ex
+#  define suscan_unpack_compact_float_array  suscan_unpack_compact_single_array
 #else
-#  define suscan_pack_compact_float_array   suscan_pack_compact_double_array
-#  define suscan_unpack_compact_float_array suscan_unpack_compact_double_array
+#  define suscan_pack_compact_float_array    suscan_pack_compact_double_array
+#  define suscan_pack_compact_float_array_ex suscan_pack_compact_double_array_ex
+#  define suscan_unpack_compact_float_array  suscan_unpack_compact_double_array
 #endif /* _SU_SINGLE_PRECISION */
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#  define SUSCAN_HOST_IS_BIG_ENDIAN 1
+#else
+#  define SUSCAN_HOST_IS_BIG_ENDIAN 0
+#endif
+
+/*
+ * Compact arrays are big endian by default. Peers accepting little
+ * endian arrays (SUSCAN_REMOTE_FLAGS_LE_ARRAYS) may receive them tagged
+ * as RFC 8746 little endian typed arrays instead, which spares the byte
+ * swapping on most hosts. Unpackers accept both.
+ */
+SUINLINE SUBOOL
+suscan_array_order_is_native(SUBOOL little_endian)
+{
+  return little_endian ? !SUSCAN_HOST_IS_BIG_ENDIAN : SUSCAN_HOST_IS_BIG_ENDIAN;
+}
+
 #define SUSCAN_TYPE_SERIALIZER_PROTO(typename)         \
 SUBOOL                                                 \
 JOIN(typename, _serialize)(                            \
@@ -134,6 +154,16 @@ void suscan_single_array_be_to_cpu(
     const SUSINGLE *orig,
     SUSCOUNT size);
 
+void suscan_single_array_cpu_to_le(
+    SUSINGLE *array,
+    const SUSINGLE *orig,
+    SUSCOUNT size);
+
+void suscan_single_array_le_to_cpu(
+    SUSINGLE *array,
+    const SUSINGLE *orig,
+    SUSCOUNT size);
+
 void suscan_double_array_cpu_to_be(
     SUDOUBLE *array,
     const SUDOUBLE *orig,
@@ -144,21 +174,49 @@ void suscan_double_array_be_to_cpu(
     const SUDOUBLE *orig,
     SUSCOUNT size);
 
+void suscan_double_array_cpu_to_le(
+    SUDOUBLE *array,
+    const SUDOUBLE *orig,
+    SUSCOUNT size);
+
+void suscan_double_array_le_to_cpu(
+    SUDOUBLE *array,
+    const SUDOUBLE *orig,
+    SUSCOUNT size);
+
 SUBOOL suscan_pack_compact_single_array(
     grow_buf_t *buffer,
     const SUSINGLE *array,
     SUSCOUNT size);
 
+SUBOOL suscan_pack_compact_single_array_ex(
+    grow_buf_t *buffer,
+    const SUSINGLE *array,
+    SUSCOUNT size,
+    SUBOOL little_endian);
+
 SUBOOL suscan_pack_compact_double_array(
     grow_buf_t *buffer,
     const SUDOUBLE *array,
     SUSCOUNT size);
 
+SUBOOL suscan_pack_compact_double_array_ex(
+    grow_buf_t *buffer,
+    const SUDOUBLE *array,
+    SUSCOUNT size,
+    SUBOOL little_endian);
+
 SUBOOL suscan_pack_compact_complex_array(
     grow_buf_t *buffer,
     const SUCOMPLEX *array,
     SUSCOUNT size);
 
+SUBOOL suscan_pack_compact_complex_array_ex(
+    grow_buf_t *buffer,
+    const SUCOMPLEX *array,
+    SUSCOUNT size,
+    SUBOOL little_endian);
+
 SUBOOL
 suscan_unpack_compact_single_array(
     grow_buf_t *buffer,
@@ -176,4 +234,46 @@ SUBOOL suscan_unpack_compact_complex_array(
     SUCOMPLEX **array,
     SUSCOUNT *size);
 
+/*
+ * Segmented PDUs. Packers given a segment list do not copy big arrays
+ * that are already in wire byte order: they only pack the header of the
+ * blob, and reference the array as a segment that goes right after it.
+ * Referenced arrays must outlive the PDU.
+ */
+#define SUSCAN_PDU_SEGMENT_MIN_SIZE 4096
+#define SUSCAN_PDU_MAX_SEGMENTS     4
+
+struct suscan_pdu_segment {
+  size_t      offset; /* Position in the buffer the segment goes at */
+  const void *data;
+  size_t      size;
+};
+
+struct suscan_pdu_segments {
+  struct suscan_pdu_segment segment[SUSCAN_PDU_MAX_SEGMENTS];
+  unsigned int count;
+  size_t       size;  /* Bytes referenced by all segments */
+};
+
+SUINLINE void
+suscan_pdu_segments_clear(struct suscan_pdu_segments *self)
+{
+  self->count = 0;
+  self->size  = 0;
+}
+
+/* Appends buffer to dest, with every segment copied into its place */
+SUBOOL suscan_pdu_segments_flatten(
+    const struct suscan_pdu_segments *self,
+    const grow_buf_t *buffer,
+    grow_buf_t *dest);
+
+/* Same as suscan_pack_compact_single_array_ex if segments is NULL */
+SUBOOL suscan_pack_compact_single_array_segmented(
+    grow_buf_t *buffer,
+    struct suscan_pdu_segments *segments,
+    const SUSINGLE *array,
+    SUSCOUNT size,
+    SUBOOL little_endian);
+
 #endif /* _SUSCAN_SERIALIZE_H */
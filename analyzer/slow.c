@@ -266,10 +266,20 @@ suscan_local_analyzer_set_bw_cb(
     void *cb_private)
 {
   suscan_local_analyzer_t *analyzer = (suscan_local_analyzer_t *) wk_private;
+  SUBOOL req;
   SUFLOAT bw;
 
-  if (analyzer->bw_req) {
-    bw = analyzer->bw_req_value;
+  /* vvvvvvvvvvvvvvvvvv Acquire hotconf request mutex vvvvvvvvvvvvvvvvvvvvvvvvv */
+  SU_TRYCATCH(
+      pthread_mutex_lock(&analyzer->hotconf_mutex) != -1,
+      return SU_FALSE);
+  req = analyzer->bw_req;
+  bw  = analyzer->bw_req_value;
+  analyzer->bw_req = SU_FALSE;
+  pthread_mutex_unlock(&analyzer->hotconf_mutex);
+  /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^^^ */
+
+  if (req) {
     if (suscan_source_set_bandwidth(analyzer->source, bw)) {
       if (analyzer->parent->params.mode == SUSCAN_ANALYZER_MODE_WIDE_SPECTRUM) {
         /* XXX: Use a proper frequency adjust method */
@@ -283,7 +293,6 @@ suscan_local_analyzer_set_bw_cb(
           analyzer->parent,
           &analyzer->source_info);
     }
-    analyzer->bw_req = analyzer->bw_req_value != bw;
   }
 
   return SU_FALSE;
@@ -296,10 +305,20 @@ suscan_local_analyzer_set_ppm_cb(
     void *cb_private)
 {
   suscan_local_analyzer_t *analyzer = (suscan_local_analyzer_t *) wk_private;
+  SUBOOL req;
   SUFLOAT ppm;
 
-  if (analyzer->ppm_req) {
-    ppm = analyzer->ppm_req_value;
+  /* vvvvvvvvvvvvvvvvvv Acquire hotconf request mutex vvvvvvvvvvvvvvvvvvvvvvvvv */
+  SU_TRYCATCH(
+      pthread_mutex_lock(&analyzer->hotconf_mutex) != -1,
+      return SU_FALSE);
+  req = analyzer->ppm_req;
+  ppm = analyzer->ppm_req_value;
+  analyzer->ppm_req = SU_FALSE;
+  pthread_mutex_unlock(&analyzer->hotconf_mutex);
+  /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^^^ */
+
+  if (req) {
     if (suscan_source_set_ppm(analyzer->source, ppm)) {
       /* Source info changed. Notify update */
       analyzer->source_info.ppm = ppm;
@@ -308,7 +327,6 @@ suscan_local_analyzer_set_ppm_cb(
           analyzer->parent,
           &analyzer->source_info);
     }
-    analyzer->ppm_req = analyzer->ppm_req_value != ppm;
   }
 
   return SU_FALSE;
@@ -321,13 +339,22 @@ suscan_local_analyzer_set_freq_cb(
     void *cb_private)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) wk_private;
+  SUBOOL req;
   SUFREQ freq;
   SUFREQ lnb_freq;
 
-  if (self->freq_req) {
-    freq = self->freq_req_value;
-    lnb_freq = self->lnb_req_value;
-    
+  /* vvvvvvvvvvvvvvvvvv Acquire hotconf request mutex vvvvvvvvvvvvvvvvvvvvvvvvv */
+  SU_TRYCATCH(
+      pthread_mutex_lock(&self->hotconf_mutex) != -1,
+      return SU_FALSE);
+  req      = self->freq_req;
+  freq     = self->freq_req_value;
+  lnb_freq = self->lnb_req_value;
+  self->freq_req = SU_FALSE;
+  pthread_mutex_unlock(&self->hotconf_mutex);
+  /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^^^ */
+
+  if (req) {
     if (suscan_source_set_freq2(self->source, freq, lnb_freq)) {
       if (self->parent->params.mode == SUSCAN_ANALYZER_MODE_WIDE_SPECTRUM) {
         /* XXX: Use a proper frequency adjust method */
@@ -342,9 +369,6 @@ suscan_local_analyzer_set_freq_cb(
           self->parent,
           &self->source_info);
     }
-
-    self->freq_req = (self->freq_req_value != freq ||
-        self->lnb_req_value != lnb_freq);
   }
 
   return SU_FALSE;
@@ -557,6 +581,41 @@ suscan_local_analyzer_set_inspector_throttle_cb(
   return SU_FALSE;
 }
 
+SUPRIVATE SUBOOL
+suscan_local_analyzer_set_source_freq_cb(
+    struct suscan_mq *mq_out,
+    void *wk_private,
+    void *cb_private)
+{
+  suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) wk_private;
+  suscan_local_subsource_t *subsource = (suscan_local_subsource_t *) cb_private;
+  SUFREQ freq;
+  SUFREQ lnb_freq;
+
+  if (subsource->freq_req) {
+    freq = subsource->freq_req_value;
+    lnb_freq = subsource->lnb_req_value;
+
+    if (suscan_source_set_freq2(subsource->source, freq, lnb_freq)) {
+      /* Source info changed. Notify update */
+      subsource->source_info.frequency = freq;
+      subsource->source_info.lnb       = lnb_freq;
+      suscan_source_get_time(
+          subsource->source,
+          &subsource->source_info.source_time);
+
+      suscan_analyzer_send_source_info(
+          self->parent,
+          &subsource->source_info);
+    }
+
+    subsource->freq_req = (subsource->freq_req_value != freq ||
+        subsource->lnb_req_value != lnb_freq);
+  }
+
+  return SU_FALSE;
+}
+
 /****************************** Slow methods **********************************/
 SUBOOL
 suscan_local_analyzer_set_inspector_freq_overridable(
@@ -661,19 +720,34 @@ suscan_local_analyzer_slow_set_freq(
     SUFREQ freq,
     SUFREQ lnb)
 {
+  SUBOOL ok;
+
   SU_TRYCATCH(
       self->parent->params.mode == SUSCAN_ANALYZER_MODE_CHANNEL,
       return SU_FALSE);
 
+  /* vvvvvvvvvvvvvvvvvv Acquire hotconf request mutex vvvvvvvvvvvvvvvvvvvvvvvvv */
+  SU_TRYCATCH(
+      pthread_mutex_lock(&self->hotconf_mutex) != -1,
+      return SU_FALSE);
   self->freq_req_value = freq;
   self->lnb_req_value  = lnb;
-  self->freq_req = SU_TRUE;
 
-  /* This operation is rather slow. Do it somewhere else. */
-  return suscan_worker_push(
-      self->slow_wk,
-      suscan_local_analyzer_set_freq_cb,
-      NULL);
+  /*
+   * A queued request will pick the new value. Otherwise, this operation
+   * is rather slow: do it somewhere else. The request is only marked as
+   * pending if the callback was actually queued.
+   */
+  if (!self->freq_req)
+    self->freq_req = suscan_worker_push(
+        self->slow_wk,
+        suscan_local_analyzer_set_freq_cb,
+        NULL);
+  ok = self->freq_req;
+  pthread_mutex_unlock(&self->hotconf_mutex);
+  /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^^^ */
+
+  return ok;
 }
 
 SUBOOL
@@ -766,8 +840,17 @@ suscan_local_analyzer_slow_set_antenna(
       goto fail);
   mutex_acquired = SU_TRUE;
 
+  /* A queued request will pick the new antenna. Otherwise, queue one. */
   if (analyzer->antenna_req != NULL)
     free(analyzer->antenna_req);
+  else
+    SU_TRYCATCH(
+        suscan_worker_push(
+          analyzer->slow_wk,
+          suscan_local_analyzer_set_antenna_cb,
+          NULL),
+        goto fail);
+
   analyzer->antenna_req = req;
   req = NULL;
 
@@ -775,10 +858,7 @@ suscan_local_analyzer_slow_set_antenna(
   mutex_acquired = SU_FALSE;
   /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^ */
 
-  return suscan_worker_push(
-      analyzer->slow_wk,
-      suscan_local_analyzer_set_antenna_cb,
-      NULL);
+  return SU_TRUE;
 
 fail:
   if (mutex_acquired)
@@ -793,14 +873,25 @@ fail:
 SUBOOL
 suscan_local_analyzer_slow_set_bw(suscan_local_analyzer_t *analyzer, SUFLOAT bw)
 {
+  SUBOOL ok;
+
+  /* vvvvvvvvvvvvvvvvvv Acquire hotconf request mutex vvvvvvvvvvvvvvvvvvvvvvvvv */
+  SU_TRYCATCH(
+      pthread_mutex_lock(&analyzer->hotconf_mutex) != -1,
+      return SU_FALSE);
   analyzer->bw_req_value = bw;
-  analyzer->bw_req = SU_TRUE;
 
-  /* This operation is rather slow. Do it somewhere else. */
-  return suscan_worker_push(
-      analyzer->slow_wk,
-      suscan_local_analyzer_set_bw_cb,
-      NULL);
+  /* A queued request will pick the new value. Otherwise, queue one. */
+  if (!analyzer->bw_req)
+    analyzer->bw_req = suscan_worker_push(
+        analyzer->slow_wk,
+        suscan_local_analyzer_set_bw_cb,
+        NULL);
+  ok = analyzer->bw_req;
+  pthread_mutex_unlock(&analyzer->hotconf_mutex);
+  /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^^^ */
+
+  return ok;
 }
 
 SUBOOL
@@ -808,13 +899,25 @@ suscan_local_analyzer_slow_set_ppm(
     suscan_local_analyzer_t *analyzer,
     SUFLOAT ppm)
 {
+  SUBOOL ok;
+
+  /* vvvvvvvvvvvvvvvvvv Acquire hotconf request mutex vvvvvvvvvvvvvvvvvvvvvvvvv */
+  SU_TRYCATCH(
+      pthread_mutex_lock(&analyzer->hotconf_mutex) != -1,
+      return SU_FALSE);
   analyzer->ppm_req_value = ppm;
-  analyzer->ppm_req = SU_TRUE;
 
-  return suscan_worker_push(
-      analyzer->slow_wk,
-      suscan_local_analyzer_set_ppm_cb,
-      NULL);
+  /* A queued request will pick the new value. Otherwise, queue one. */
+  if (!analyzer->ppm_req)
+    analyzer->ppm_req = suscan_worker_push(
+        analyzer->slow_wk,
+        suscan_local_analyzer_set_ppm_cb,
+        NULL);
+  ok = analyzer->ppm_req;
+  pthread_mutex_unlock(&analyzer->hotconf_mutex);
+  /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^^^ */
+
+  return ok;
 }
 
 SUBOOL
@@ -825,6 +928,7 @@ suscan_local_analyzer_slow_set_gain(
 {
   struct suscan_source_gain_info *req = NULL;
   SUBOOL mutex_acquired = SU_FALSE;
+  unsigned int i;
 
   SU_TRYCATCH(
       req = suscan_source_gain_info_new_value_only(name, value),
@@ -836,19 +940,35 @@ suscan_local_analyzer_slow_set_gain(
       goto fail);
   mutex_acquired = SU_TRUE;
 
-  SU_TRYCATCH(
-      PTR_LIST_APPEND_CHECK(analyzer->gain_request, req) != -1,
-      goto fail);
+  /* A queued request will process the whole list. Otherwise, queue one. */
+  if (analyzer->gain_request_count == 0)
+    SU_TRYCATCH(
+        suscan_worker_push(
+          analyzer->slow_wk,
+          suscan_local_analyzer_set_gain_cb,
+          NULL),
+        goto fail);
+
+  /* Newer values of a gain replace the older ones */
+  for (i = 0; i < analyzer->gain_request_count; ++i)
+    if (strcmp(analyzer->gain_request_list[i]->name, name) == 0)
+      break;
+
+  if (i < analyzer->gain_request_count) {
+    suscan_source_gain_info_destroy(analyzer->gain_request_list[i]);
+    analyzer->gain_request_list[i] = req;
+  } else {
+    SU_TRYCATCH(
+        PTR_LIST_APPEND_CHECK(analyzer->gain_request, req) != -1,
+        goto fail);
+  }
   req = NULL;
 
   pthread_mutex_unlock(&analyzer->hotconf_mutex);
   mutex_acquired = SU_FALSE;
   /* ^^^^^^^^^^^^^^^^^^ Release hotconf request mutex ^^^^^^^^^^^^^^^^^^^^^^^ */
 
-  return suscan_worker_push(
-      analyzer->slow_wk,
-      suscan_local_analyzer_set_gain_cb,
-      NULL);
+  return SU_TRUE;
 
 fail:
   if (mutex_acquired)
@@ -860,3 +980,20 @@ fail:
   return SU_FALSE;
 }
 
+
+SUBOOL
+suscan_local_analyzer_slow_set_source_freq(
+    suscan_local_analyzer_t *self,
+    suscan_local_subsource_t *subsource,
+    SUFREQ freq,
+    SUFREQ lnb)
+{
+  subsource->freq_req_value = freq;
+  subsource->lnb_req_value  = lnb;
+  subsource->freq_req = SU_TRUE;
+
+  return suscan_worker_push(
+      self->slow_wk,
+      suscan_local_analyzer_set_source_freq_cb,
+      subsource);
+}
@@ -278,16 +278,22 @@ suscan_source_read_samples(suscan_source_t *self, SUCOMPLEX *buffer, SUSCOUNT ma
           SUSCAN_SOURCE_DEFAULT_BUFSIZ)) < 1)
           return got;
 
-        if (self->dc_correction_enabled)
-          su_dc_corrector_correct(&self->dc_corrector, self->read_buf, got);
+        /* Decimator input: IQ reversal is applied later, on its output */
+        suscan_iq_corrector_feed(
+          &self->iq_corrector,
+          self->read_buf,
+          NULL,
+          got,
+          SUSCAN_IQ_CORRECTOR_STAGE_FRONTEND);
+        suscan_iq_corrector_update(&self->iq_corrector);
+
         suscan_source_feed_decimator(self, self->read_buf, got);
       } while(self->curr_ptr == 0);
       result += self->curr_ptr;
     }
   } else {
+    /* Corrected by suscan_source_correct_samples */
     result = (self->iface->read) (self->src_priv, buffer, max);
-    if (result > 0 && self->dc_correction_enabled)
-      su_dc_corrector_correct(&self->dc_corrector, buffer, result);
   }
 
   return result;
@@ -309,17 +315,31 @@ suscan_source_history_get_rel_history_rp(const suscan_source_t *self)
   return ptr;
 }
 
+/*
+ * Correct samples and save them in the history, in a single pass. The
+ * history keeps the samples without IQ reversal, which is applied again
+ * during replay.
+ */
 SUINLINE void
 suscan_source_history_write(
   suscan_source_t *self,
-  const SUCOMPLEX *buffer,
-  SUSCOUNT len)
+  SUCOMPLEX *buffer,
+  SUSCOUNT len,
+  unsigned int stages)
 {
+  suscan_iq_corrector_t *corr = &self->iq_corrector;
+
   (void) pthread_mutex_lock(&self->history_mutex);
 
   SUSCOUNT ptr = self->history_ptr;
 
   if (len > self->history_alloc) {
+    suscan_iq_corrector_feed(
+      corr,
+      buffer,
+      NULL,
+      len - self->history_alloc,
+      stages);
     buffer += len - self->history_alloc;
     len = self->history_alloc;
   }
@@ -328,7 +348,7 @@ suscan_source_history_write(
   SUSCOUNT avail = self->history_alloc - ptr;
   SUSCOUNT chunklen = MIN(len, avail);
 
-  memcpy(self->history + ptr, buffer, chunklen * sizeof(SUCOMPLEX));
+  suscan_iq_corrector_feed(corr, buffer, self->history + ptr, chunklen, stages);
 
   rem    -= chunklen;
   buffer += chunklen;
@@ -338,7 +358,7 @@ suscan_source_history_write(
     ptr = 0;
   
     if (rem > 0) {
-      memcpy(self->history, buffer, rem * sizeof(SUCOMPLEX));
+      suscan_iq_corrector_feed(corr, buffer, self->history, rem, stages);
       ptr += rem;
     }
   }
@@ -379,7 +399,11 @@ suscan_source_history_read(
   if (len > avail)
     len = avail;
 
-  memcpy(buffer, self->history + self->rp, len * sizeof(SUCOMPLEX));
+  suscan_iq_corrector_copy_reversed(
+    &self->iq_corrector,
+    buffer,
+    self->history + self->rp,
+    len);
 
   self->rp += len;
   
@@ -398,6 +422,30 @@ done:
   return len;
 }
 
+/*
+ * Apply the pending corrections to the samples we just read, saving them
+ * to the history if necessary. Decimated samples were already corrected
+ * before entering the decimator, and only need to be reversed.
+ */
+SUINLINE void
+suscan_source_correct_samples(
+  suscan_source_t *self,
+  SUCOMPLEX *buffer,
+  SUSCOUNT len)
+{
+  unsigned int stages = self->decim > 1
+    ? SUSCAN_IQ_CORRECTOR_STAGE_REVERSE
+    : SUSCAN_IQ_CORRECTOR_STAGE_ALL;
+
+  if (self->history_enabled)
+    suscan_source_history_write(self, buffer, len, stages);
+  else
+    suscan_iq_corrector_feed(&self->iq_corrector, buffer, NULL, len, stages);
+
+  if (stages & SUSCAN_IQ_CORRECTOR_STAGE_FRONTEND)
+    suscan_iq_corrector_update(&self->iq_corrector);
+}
+
 SUSDIFF
 suscan_source_read(suscan_source_t *self, SUCOMPLEX *buffer, SUSCOUNT max)
 {
@@ -414,18 +462,13 @@ suscan_source_read(suscan_source_t *self, SUCOMPLEX *buffer, SUSCOUNT max)
     SU_TRYZ(pthread_mutex_unlock(&self->throttle_mutex));
   }
   
-  if (self->history_enabled) {
-    if (self->history_replay) {
-      result = suscan_source_history_read(self, buffer, max);
-    } else {
-      result = suscan_source_read_samples(self, buffer, max);
-
-      if (result > 0)
-        suscan_source_history_write(self, buffer, result);
-    }
+  if (self->history_enabled && self->history_replay) {
+    result = suscan_source_history_read(self, buffer, max);
   } else {
-    /* No history, just regular read */
     result = suscan_source_read_samples(self, buffer, max);
+
+    if (result > 0)
+      suscan_source_correct_samples(self, buffer, result);
   }
 
   if (result > 0)
@@ -678,9 +721,7 @@ suscan_source_set_dc_remove(suscan_source_t *self, SUBOOL remove)
     return SU_FALSE;
 
   if (self->soft_dc) {
-    if (remove)
-      su_dc_corrector_reset(&self->dc_corrector);
-    self->dc_correction_enabled = remove;
+    suscan_iq_corrector_set_dc_enabled(&self->iq_corrector, remove);
     return SU_TRUE;
   } else {
     if (self->iface->set_dc_remove == NULL)
@@ -695,6 +736,13 @@ suscan_source_set_dc_remove(suscan_source_t *self, SUBOOL remove)
   return SU_TRUE;
 }
 
+void
+suscan_source_set_iq_reverse(suscan_source_t *self, SUBOOL reverse)
+{
+  suscan_iq_corrector_set_reverse(&self->iq_corrector, reverse);
+  self->info.iq_reverse = reverse;
+}
+
 SUBOOL
 suscan_source_set_gain(suscan_source_t *self, const char *name, SUFLOAT val)
 {
@@ -945,16 +993,19 @@ suscan_source_adjust_permissions(suscan_source_t *self)
 
   /* If source does not support DC remove, enable it by software */
   if (~self->info.permissions & SUSCAN_ANALYZER_PERM_SET_DC_REMOVE) {
-    self->soft_dc               = SU_TRUE;
-    self->dc_correction_enabled = self->config->dc_remove;
+    self->soft_dc = SU_TRUE;
 
     dc_samples = suscan_source_get_dc_samples(self);
     if (dc_samples > 0)
-      su_dc_corrector_init_with_training_period(&self->dc_corrector, dc_samples);
+      suscan_iq_corrector_set_dc_training(&self->iq_corrector, dc_samples);
     else
-      su_dc_corrector_init_with_alpha(
-        &self->dc_corrector,
+      suscan_iq_corrector_set_dc_alpha(
+        &self->iq_corrector,
         SU_SPLPF_ALPHA(SUSCAN_SOURCE_DC_AVERAGING_PERIOD));
+
+    suscan_iq_corrector_set_dc_enabled(
+      &self->iq_corrector,
+      self->config->dc_remove);
     
     if (self->soft_dc) {
       SU_INFO("Source does not support native DC correction, falling back to software correction\n");
@@ -1266,6 +1317,11 @@ suscan_source_new(suscan_source_config_t *config)
 
   new->decim = 1;
 
+  suscan_iq_corrector_init(&new->iq_corrector);
+  suscan_iq_corrector_set_balance_enabled(
+    &new->iq_corrector,
+    suscan_source_config_get_iq_balance(config));
+
   if (config->average > 1)
     SU_TRY_FAIL(suscan_source_configure_decimation(new, config->average));
 
@@ -27,9 +27,9 @@
 #include <analyzer/throttle.h>
 #include <analyzer/source/config.h>
 #include <analyzer/source/info.h>
+#include <analyzer/source/iqcorr.h>
 #include <sigutils/util/compat-time.h>
 #include <sigutils/util/util.h>
-#include <sigutils/dc_corrector.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -117,10 +117,10 @@ struct suscan_source {
   SUSCOUNT total_samples;
   SUBOOL   looped;
 
-  SUBOOL   dc_correction_enabled;
   SUBOOL   soft_dc;
 
-  su_dc_corrector_t dc_corrector;
+  /* DC removal, IQ balance and IQ reversal */
+  suscan_iq_corrector_t iq_corrector;
 
   /* To prevent source from looping forever */
   SUBOOL force_eos;
@@ -197,6 +197,7 @@ SUBOOL suscan_source_set_antenna(suscan_source_t *source, const char *name);
 SUBOOL suscan_source_set_bandwidth(suscan_source_t *source, SUFLOAT bw);
 SUBOOL suscan_source_set_ppm(suscan_source_t *source, SUFLOAT ppm);
 SUBOOL suscan_source_set_dc_remove(suscan_source_t *source, SUBOOL remove);
+void   suscan_source_set_iq_reverse(suscan_source_t *source, SUBOOL reverse);
 SUBOOL suscan_source_set_agc(suscan_source_t *source, SUBOOL set);
 
 /* History control */
@@ -123,6 +123,7 @@ SUSCAN_SERIALIZER_PROTO(suscan_source_info)
 
   SUSCAN_PACK(uint,  self->permissions);
   SUSCAN_PACK(uint,  self->mtu);
+  SUSCAN_PACK(uint,  self->source_index);
   SUSCAN_PACK(bool,  self->realtime);
   SUSCAN_PACK(bool,  self->replay);
   SUSCAN_PACK(uint,  self->source_samp_rate);
@@ -182,6 +183,7 @@ SUSCAN_DESERIALIZER_PROTO(suscan_source_info)
 
   SUSCAN_UNPACK(uint64, self->permissions);
   SUSCAN_UNPACK(uint32, self->mtu);
+  SUSCAN_UNPACK(uint32, self->source_index);
   SUSCAN_UNPACK(bool,   self->realtime);
   SUSCAN_UNPACK(bool,   self->replay);
   SUSCAN_UNPACK(uint64, self->source_samp_rate);
@@ -296,6 +298,7 @@ suscan_source_info_init_copy(
   suscan_source_info_init(self);
 
   self->permissions         = origin->permissions;
+  self->source_index        = origin->source_index;
   self->source_samp_rate    = origin->source_samp_rate;
   self->effective_samp_rate = origin->effective_samp_rate;
   self->measured_samp_rate  = origin->measured_samp_rate;
@@ -50,6 +50,7 @@ extern "C" {
 #define SUSCAN_ANALYZER_PERM_SET_BB_FILTER      (1ull << 17)
 #define SUSCAN_ANALYZER_PERM_SET_HISTORY_SIZE   (1ull << 18)
 #define SUSCAN_ANALYZER_PERM_REPLAY             (1ull << 19)
+#define SUSCAN_ANALYZER_PERM_SET_PANORAMA       (1ull << 20)
 
 #define SUSCAN_ANALYZER_PERM_ALL              0xffffffffffffffffull
 
@@ -120,6 +121,7 @@ void suscan_source_gain_info_destroy(struct suscan_source_gain_info *self);
 SUSCAN_SERIALIZABLE(suscan_source_info) {
   uint64_t permissions;
   uint32_t mtu;
+  uint32_t source_index; /* 0 is the primary source */
 
   SUBOOL   realtime;
   SUBOOL   replay;
@@ -0,0 +1,297 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#define SU_LOG_DOMAIN "iqcorr"
+
+#include <sigutils/sigutils.h>
+#include <string.h>
+
+#include "iqcorr.h"
+
+void
+suscan_iq_corrector_init(suscan_iq_corrector_t *self)
+{
+  memset(self, 0, sizeof(suscan_iq_corrector_t));
+
+  self->dc_alpha      = 1;
+  self->balance_alpha = SU_SPLPF_ALPHA(SUSCAN_IQ_CORRECTOR_BALANCE_PERIOD);
+  self->q_gain        = 1;
+}
+
+SUPRIVATE void
+suscan_iq_corrector_reset_dc(suscan_iq_corrector_t *self)
+{
+  self->dc_i     = self->dc_q = 0;
+  self->dc_count = 0;
+}
+
+SUPRIVATE void
+suscan_iq_corrector_reset_balance(suscan_iq_corrector_t *self)
+{
+  self->balance_valid = SU_FALSE;
+  self->pow_i         = self->pow_q = self->cross = 0;
+  self->q_from_i      = 0;
+  self->q_gain        = 1;
+}
+
+SUPRIVATE void
+suscan_iq_corrector_clear_acc(suscan_iq_corrector_t *self)
+{
+  self->acc_count = 0;
+  self->acc_i     = self->acc_q  = 0;
+  self->acc_ii    = self->acc_qq = self->acc_iq = 0;
+}
+
+SU_METHOD(suscan_iq_corrector, void, set_dc_alpha, SUFLOAT alpha)
+{
+  self->dc_training = SU_FALSE;
+  self->dc_alpha    = alpha;
+  suscan_iq_corrector_reset_dc(self);
+}
+
+SU_METHOD(suscan_iq_corrector, void, set_dc_training, SUSCOUNT samples)
+{
+  self->dc_training = SU_TRUE;
+  self->dc_period   = samples;
+  suscan_iq_corrector_reset_dc(self);
+}
+
+SU_METHOD(suscan_iq_corrector, void, set_dc_enabled, SUBOOL enabled)
+{
+  /* Enabling DC removal always starts a new estimation */
+  if (enabled)
+    suscan_iq_corrector_reset_dc(self);
+
+  self->dc_enabled = enabled;
+}
+
+SU_METHOD(suscan_iq_corrector, void, set_balance_enabled, SUBOOL enabled)
+{
+  if (enabled && !self->balance_enabled)
+    suscan_iq_corrector_reset_balance(self);
+
+  self->balance_enabled = enabled;
+}
+
+SU_METHOD(suscan_iq_corrector, void, set_reverse, SUBOOL reverse)
+{
+  self->reverse = reverse;
+}
+
+SU_METHOD(suscan_iq_corrector, void, reset)
+{
+  suscan_iq_corrector_reset_dc(self);
+  suscan_iq_corrector_reset_balance(self);
+  suscan_iq_corrector_clear_acc(self);
+}
+
+SUINLINE SU_GETTER(suscan_iq_corrector, SUBOOL, needs_stats)
+{
+  if (self->balance_enabled)
+    return SU_TRUE;
+
+  if (self->dc_enabled)
+    return !self->dc_training || self->dc_count < self->dc_period;
+
+  return SU_FALSE;
+}
+
+/*
+ * Loop body of the corrector. Samples are accessed as interleaved floats
+ * and all the conditionals are resolved at compile time, so that the
+ * compiler is able to vectorize all the variants of the loop.
+ */
+#define SUSCAN_IQ_CORRECTOR_LOOP(stats, store)  \
+  for (i = 0; i < len; ++i) {                   \
+    re = v[2 * i]     - dc_i;                   \
+    im = v[2 * i + 1] - dc_q;                   \
+    if (stats) {                                \
+      si  += re;                                \
+      sq  += im;                                \
+      sii += re * re;                           \
+      sqq += im * im;                           \
+      siq += re * im;                           \
+    }                                           \
+    im = g * (im + a * re);                     \
+    if (store) {                                \
+      t[2 * i]     = re;                        \
+      t[2 * i + 1] = im;                        \
+    }                                           \
+    v[2 * i]     = re;                          \
+    v[2 * i + 1] = s * im;                      \
+  }
+
+SU_METHOD(
+  suscan_iq_corrector,
+  void,
+  feed,
+  SUCOMPLEX *x,
+  SUCOMPLEX *tee,
+  SUSCOUNT len,
+  unsigned int stages)
+{
+  SUFLOAT *__restrict v = (SUFLOAT *) x;
+  SUFLOAT *__restrict t = (SUFLOAT *) tee;
+  SUBOOL frontend =
+    (stages & SUSCAN_IQ_CORRECTOR_STAGE_FRONTEND)
+    && (self->dc_enabled || self->balance_enabled);
+  SUBOOL reverse =
+    (stages & SUSCAN_IQ_CORRECTOR_STAGE_REVERSE) && self->reverse;
+  SUBOOL stats = frontend && suscan_iq_corrector_needs_stats(self);
+  SUFLOAT dc_i = 0, dc_q = 0, a = 0, g = 1, s = reverse ? -1 : 1;
+  SUFLOAT si = 0, sq = 0, sii = 0, sqq = 0, siq = 0;
+  SUFLOAT re, im;
+  SUSCOUNT i;
+
+  if (!frontend && !reverse) {
+    if (tee != NULL)
+      memcpy(tee, x, len * sizeof(SUCOMPLEX));
+    return;
+  }
+
+  if (frontend) {
+    if (self->dc_enabled) {
+      dc_i = self->dc_i;
+      dc_q = self->dc_q;
+    }
+
+    if (self->balance_enabled) {
+      a = self->q_from_i;
+      g = self->q_gain;
+    }
+  }
+
+  if (stats) {
+    if (tee != NULL)
+      SUSCAN_IQ_CORRECTOR_LOOP(1, 1)
+    else
+      SUSCAN_IQ_CORRECTOR_LOOP(1, 0)
+
+    self->acc_count += len;
+    self->acc_i     += si;
+    self->acc_q     += sq;
+    self->acc_ii    += sii;
+    self->acc_qq    += sqq;
+    self->acc_iq    += siq;
+  } else {
+    if (tee != NULL)
+      SUSCAN_IQ_CORRECTOR_LOOP(0, 1)
+    else
+      SUSCAN_IQ_CORRECTOR_LOOP(0, 0)
+  }
+}
+
+#undef SUSCAN_IQ_CORRECTOR_LOOP
+
+SU_GETTER(
+  suscan_iq_corrector,
+  void,
+  copy_reversed,
+  SUCOMPLEX *dest,
+  const SUCOMPLEX *src,
+  SUSCOUNT len)
+{
+  SUFLOAT *__restrict d = (SUFLOAT *) dest;
+  const SUFLOAT *__restrict v = (const SUFLOAT *) src;
+  SUSCOUNT i;
+
+  if (!self->reverse) {
+    memcpy(dest, src, len * sizeof(SUCOMPLEX));
+    return;
+  }
+
+  for (i = 0; i < len; ++i) {
+    d[2 * i]     =  v[2 * i];
+    d[2 * i + 1] = -v[2 * i + 1];
+  }
+}
+
+/*
+ * The IQ imbalance is corrected by orthogonalizing Q against I
+ * (Gram-Schmidt) and scaling it to the power of I:
+ *
+ *   Q' = sqrt(P_I / (P_Q - C^2 / P_I)) * (Q - C / P_I * I)
+ *
+ * With P_I, P_Q and C the (smoothed) powers of I and Q and their cross
+ * correlation.
+ */
+SUPRIVATE void
+suscan_iq_corrector_update_balance(
+  suscan_iq_corrector_t *self,
+  SUFLOAT pow_i,
+  SUFLOAT pow_q,
+  SUFLOAT cross)
+{
+  SUFLOAT alpha = self->balance_alpha;
+  SUFLOAT q_orth;
+
+  if (self->balance_valid) {
+    self->pow_i += alpha * (pow_i - self->pow_i);
+    self->pow_q += alpha * (pow_q - self->pow_q);
+    self->cross += alpha * (cross - self->cross);
+  } else {
+    self->pow_i = pow_i;
+    self->pow_q = pow_q;
+    self->cross = cross;
+    self->balance_valid = SU_TRUE;
+  }
+
+  if (self->pow_i <= 0)
+    return;
+
+  q_orth = self->pow_q - self->cross * self->cross / self->pow_i;
+  if (q_orth <= 0)
+    return;
+
+  self->q_from_i = -self->cross / self->pow_i;
+  self->q_gain   = SU_SQRT(self->pow_i / q_orth);
+}
+
+SU_METHOD(suscan_iq_corrector, void, update)
+{
+  SUFLOAT n = self->acc_count;
+  SUSCOUNT total;
+
+  if (self->acc_count == 0)
+    return;
+
+  /* Accumulators hold the residual DC with respect to the current estimate */
+  if (self->dc_enabled) {
+    if (self->dc_training) {
+      if (self->dc_count < self->dc_period) {
+        total = self->dc_count + self->acc_count;
+        self->dc_i += self->acc_i / total;
+        self->dc_q += self->acc_q / total;
+        self->dc_count = total;
+      }
+    } else {
+      self->dc_i += self->dc_alpha * self->acc_i / n;
+      self->dc_q += self->dc_alpha * self->acc_q / n;
+    }
+  }
+
+  if (self->balance_enabled)
+    suscan_iq_corrector_update_balance(
+      self,
+      self->acc_ii / n,
+      self->acc_qq / n,
+      self->acc_iq / n);
+
+  suscan_iq_corrector_clear_acc(self);
+}
@@ -0,0 +1,126 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+#ifndef _ANALYZER_SOURCE_IQCORR_H
+#define _ANALYZER_SOURCE_IQCORR_H
+
+#include <sigutils/types.h>
+#include <sigutils/defs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Stages of the corrector */
+#define SUSCAN_IQ_CORRECTOR_STAGE_FRONTEND 1 /* DC removal and IQ balance */
+#define SUSCAN_IQ_CORRECTOR_STAGE_REVERSE  2 /* IQ swap (conjugation) */
+#define SUSCAN_IQ_CORRECTOR_STAGE_ALL      3
+
+/* Averaging period of the IQ imbalance estimator, in blocks */
+#define SUSCAN_IQ_CORRECTOR_BALANCE_PERIOD 50
+
+/*
+ * Fused front-end correction of the source samples. DC removal, IQ
+ * balance and IQ reversal are applied in a single pass over the buffer,
+ * optionally storing a copy of the (non-reversed) result somewhere else,
+ * like the history buffer.
+ *
+ * Estimators are updated with the statistics of the whole block, once
+ * per block (see suscan_iq_corrector_update). The corrections of a block
+ * are therefore those estimated up to the previous one, which is what
+ * makes a single pass possible.
+ */
+struct suscan_iq_corrector {
+  /* DC removal */
+  SUBOOL    dc_enabled;
+  SUBOOL    dc_training;     /* One-shot estimation */
+  SUSCOUNT  dc_period;       /* Training length, in samples */
+  SUSCOUNT  dc_count;        /* Samples trained so far */
+  SUFLOAT   dc_alpha;        /* Per-block update of continuous mode */
+  SUFLOAT   dc_i, dc_q;
+
+  /* IQ balance */
+  SUBOOL    balance_enabled;
+  SUFLOAT   balance_alpha;
+  SUBOOL    balance_valid;
+  SUFLOAT   pow_i, pow_q, cross;
+  SUFLOAT   q_from_i;        /* Q' = q_gain * (Q + q_from_i * I) */
+  SUFLOAT   q_gain;
+
+  /* IQ reversal */
+  SUBOOL    reverse;
+
+  /* Statistics of the current block */
+  SUSCOUNT  acc_count;
+  SUFLOAT   acc_i, acc_q;
+  SUFLOAT   acc_ii, acc_qq, acc_iq;
+};
+
+typedef struct suscan_iq_corrector suscan_iq_corrector_t;
+
+void suscan_iq_corrector_init(suscan_iq_corrector_t *self);
+
+/* Continuous DC removal, with a per-block smoothing factor */
+SU_METHOD(suscan_iq_corrector, void, set_dc_alpha, SUFLOAT alpha);
+
+/* One-shot DC estimation during the first `samples` samples */
+SU_METHOD(suscan_iq_corrector, void, set_dc_training, SUSCOUNT samples);
+
+SU_METHOD(suscan_iq_corrector, void, set_dc_enabled, SUBOOL enabled);
+SU_METHOD(suscan_iq_corrector, void, set_balance_enabled, SUBOOL enabled);
+SU_METHOD(suscan_iq_corrector, void, set_reverse, SUBOOL reverse);
+SU_METHOD(suscan_iq_corrector, void, reset);
+
+SUINLINE SU_GETTER(suscan_iq_corrector, SUBOOL, is_active)
+{
+  return self->dc_enabled || self->balance_enabled || self->reverse;
+}
+
+/*
+ * Correct `len` samples of `x` in place, applying the given stages. If
+ * `tee` is not NULL, the result is also written there, without the IQ
+ * reversal. The corrected samples are accounted for the next call to
+ * suscan_iq_corrector_update.
+ */
+SU_METHOD(
+  suscan_iq_corrector,
+  void,
+  feed,
+  SUCOMPLEX *x,
+  SUCOMPLEX *tee,
+  SUSCOUNT len,
+  unsigned int stages);
+
+/* Copy samples, applying just the IQ reversal */
+SU_GETTER(
+  suscan_iq_corrector,
+  void,
+  copy_reversed,
+  SUCOMPLEX *dest,
+  const SUCOMPLEX *src,
+  SUSCOUNT len);
+
+/* Update estimators with the samples fed since the last update */
+SU_METHOD(suscan_iq_corrector, void, update);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _ANALYZER_SOURCE_IQCORR_H */
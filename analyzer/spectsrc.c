@@ -45,8 +45,9 @@ suscan_spectsrc_class_register(const struct suscan_spectsrc_class *class)
 {
   SU_TRYCATCH(class->name    != NULL, return SU_FALSE);
   SU_TRYCATCH(class->desc    != NULL, return SU_FALSE);
-  SU_TRYCATCH(class->ctor    != NULL, return SU_FALSE);
-  SU_TRYCATCH(class->dtor    != NULL, return SU_FALSE);
+  SU_TRYCATCH(
+      (class->ctor == NULL) == (class->dtor == NULL),
+      return SU_FALSE);
 
   SU_TRYCATCH(
       suscan_spectsrc_class_lookup(class->name) == NULL,
@@ -111,7 +112,7 @@ suscan_spectsrc_new(
   new->on_spectrum = on_spectrum;
   new->userdata = userdata;
 
-  if (classdef->preproc != NULL) {
+  if (classdef->preproc != NULL || classdef->from_products != NULL) {
     SU_TRYCATCH(new->buffer = malloc(size * sizeof(SUCOMPLEX)), goto fail);
     new->buffer_size = size;
   }
@@ -133,9 +134,11 @@ suscan_spectsrc_new(
           new),
       goto fail);
 
-  SU_TRYCATCH(
-      new->privdata = (classdef->ctor) (new),
-      goto fail);
+  /* Stateless sources have no ctor and receive NULL privdata */
+  if (classdef->ctor != NULL)
+    SU_TRYCATCH(
+        new->privdata = (classdef->ctor) (new),
+        goto fail);
 
   return new;
 
@@ -150,29 +153,45 @@ fail:
 SUSCOUNT
 suscan_spectsrc_feed(
     suscan_spectsrc_t *self,
-    const SUCOMPLEX *data,
+    const struct suscan_spectsrc_products *products,
     SUSCOUNT size)
 {
-  if (self->classptr->preproc != NULL) {
+  if (self->classptr->from_products != NULL) {
+    if (size > self->buffer_size)
+      size = self->buffer_size;
+
+    SU_TRYCATCH(
+        (self->classptr->from_products) (
+            self,
+            self->privdata,
+            products,
+            self->buffer,
+            size),
+        return -1);
+
+    SU_TRYCATCH(
+        su_smoothpsd_feed(self->smooth_psd, self->buffer, size),
+        return -1);
+  } else if (self->classptr->preproc != NULL) {
     /* Spectrum source has a preprocessing routine. Apply data to it */
     if (size > self->buffer_size)
       size = self->buffer_size;
 
-    memcpy(self->buffer, data, size * sizeof(SUCOMPLEX));
+    memcpy(self->buffer, products->x, size * sizeof(SUCOMPLEX));
     SU_TRYCATCH(
         (self->classptr->preproc) (
             self,
             self->privdata,
             self->buffer,
             size),
-        return SU_FALSE);
+        return -1);
 
     SU_TRYCATCH(
         su_smoothpsd_feed(self->smooth_psd, self->buffer, size),
         return -1);
   } else {
     SU_TRYCATCH(
-        su_smoothpsd_feed(self->smooth_psd, data, size),
+        su_smoothpsd_feed(self->smooth_psd, products->x, size),
         return -1);
   }
 
@@ -194,6 +213,359 @@ suscan_spectsrc_destroy(suscan_spectsrc_t *self)
   free(self);
 }
 
+/****************************** Spectrum engine ******************************/
+SUPRIVATE SUBOOL
+suscan_spectsrc_engine_on_spectrum(
+    void *userdata,
+    const SUFLOAT *data,
+    SUSCOUNT size)
+{
+  suscan_spectsrc_engine_t *self = (suscan_spectsrc_engine_t *) userdata;
+
+  return (self->on_spectrum) (self->userdata, self->current, data, size);
+}
+
+SU_INSTANCER(
+  suscan_spectsrc_engine,
+  SUFLOAT samp_rate,
+  SUFLOAT spectrum_rate,
+  SUSCOUNT size,
+  enum sigutils_channel_detector_window window_type,
+  SUBOOL (*on_spectrum) (
+    void *userdata,
+    unsigned int index,
+    const SUFLOAT *data,
+    SUSCOUNT size),
+  void *userdata)
+{
+  suscan_spectsrc_engine_t *new = NULL;
+
+  SU_ALLOCATE_FAIL(new, suscan_spectsrc_engine_t);
+
+  new->samp_rate       = samp_rate;
+  new->spectrum_rate   = spectrum_rate;
+  new->throttle_factor = 1.;
+  new->size            = size;
+  new->window_type     = window_type;
+  new->on_spectrum     = on_spectrum;
+  new->userdata        = userdata;
+
+  return new;
+
+fail:
+  if (new != NULL)
+    suscan_spectsrc_engine_destroy(new);
+
+  return NULL;
+}
+
+SU_COLLECTOR(suscan_spectsrc_engine)
+{
+  unsigned int i;
+
+  for (i = 0; i < self->class_count; ++i)
+    if (self->source_list[i] != NULL)
+      suscan_spectsrc_destroy(self->source_list[i]);
+
+  if (self->source_list != NULL)
+    free(self->source_list);
+
+  if (self->subscribed != NULL)
+    free(self->subscribed);
+
+  if (self->class_list != NULL)
+    free(self->class_list);
+
+  if (self->unit != NULL)
+    free(self->unit);
+
+  if (self->unit_2 != NULL)
+    free(self->unit_2);
+
+  if (self->unit_4 != NULL)
+    free(self->unit_4);
+
+  if (self->unit_8 != NULL)
+    free(self->unit_8);
+
+  if (self->conj_diff != NULL)
+    free(self->conj_diff);
+
+  if (self->phase_diff != NULL)
+    free(self->phase_diff);
+
+  if (self->delta != NULL)
+    free(self->delta);
+
+  free(self);
+}
+
+SU_METHOD(
+  suscan_spectsrc_engine,
+  SUBOOL,
+  add_class,
+  const struct suscan_spectsrc_class *classdef)
+{
+  suscan_spectsrc_t **source_list = NULL;
+  SUBOOL *subscribed = NULL;
+  unsigned int count = self->class_count + 1;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(
+    source_list = realloc(
+      self->source_list,
+      count * sizeof(suscan_spectsrc_t *)));
+  self->source_list = source_list;
+  self->source_list[count - 1] = NULL;
+
+  SU_TRY(subscribed = realloc(self->subscribed, count * sizeof(SUBOOL)));
+  self->subscribed = subscribed;
+  self->subscribed[count - 1] = SU_FALSE;
+
+  SU_TRYC(PTR_LIST_APPEND_CHECK(self->class, (void *) classdef));
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+SU_METHOD(suscan_spectsrc_engine, void, set_throttle_factor, SUFLOAT factor)
+{
+  unsigned int i;
+
+  self->throttle_factor = factor;
+
+  for (i = 0; i < self->class_count; ++i)
+    if (self->source_list[i] != NULL)
+      suscan_spectsrc_set_throttle_factor(self->source_list[i], factor);
+}
+
+SUPRIVATE SUBOOL
+suscan_spectsrc_engine_alloc_product(
+  suscan_spectsrc_engine_t *self,
+  void **buffer,
+  size_t elem_size)
+{
+  if (*buffer == NULL)
+    *buffer = malloc(self->size * elem_size);
+
+  return *buffer != NULL;
+}
+
+/*
+ * Instantiate the subscribed sources that were not created yet and
+ * recompute the products they need (along with the products these
+ * products are derived from).
+ */
+SUPRIVATE SUBOOL
+suscan_spectsrc_engine_update(suscan_spectsrc_engine_t *self)
+{
+  const struct suscan_spectsrc_class *classdef;
+  uint32_t products = 0;
+  unsigned int i, active = 0;
+  SUBOOL ok = SU_FALSE;
+
+  for (i = 0; i < self->class_count; ++i) {
+    if (!self->subscribed[i] && self->selected != i + 1)
+      continue;
+
+    classdef = self->class_list[i];
+
+    if (self->source_list[i] == NULL) {
+      SU_TRY(
+        self->source_list[i] = suscan_spectsrc_new(
+          classdef,
+          self->samp_rate,
+          self->spectrum_rate,
+          self->size,
+          self->window_type,
+          suscan_spectsrc_engine_on_spectrum,
+          self));
+
+      if (!sufeq(self->throttle_factor, 1., 1e-6))
+        suscan_spectsrc_set_throttle_factor(
+          self->source_list[i],
+          self->throttle_factor);
+    }
+
+    if (classdef->from_products != NULL)
+      products |= classdef->products;
+
+    ++active;
+  }
+
+  if (products & SUSCAN_SPECTSRC_PRODUCT_UNIT_8)
+    products |= SUSCAN_SPECTSRC_PRODUCT_UNIT_4;
+  if (products & SUSCAN_SPECTSRC_PRODUCT_UNIT_4)
+    products |= SUSCAN_SPECTSRC_PRODUCT_UNIT_2;
+  if (products & SUSCAN_SPECTSRC_PRODUCT_UNIT_2)
+    products |= SUSCAN_SPECTSRC_PRODUCT_UNIT;
+  if (products & SUSCAN_SPECTSRC_PRODUCT_PHASE_DIFF)
+    products |= SUSCAN_SPECTSRC_PRODUCT_CONJ_DIFF;
+
+#define SUSCAN_SPECTSRC_ENGINE_ALLOC(flag, field)                   \
+  if (products & flag)                                              \
+    SU_TRY(                                                         \
+      suscan_spectsrc_engine_alloc_product(                         \
+        self,                                                       \
+        (void **) &self->field,                                     \
+        sizeof(*self->field)))
+
+  SUSCAN_SPECTSRC_ENGINE_ALLOC(SUSCAN_SPECTSRC_PRODUCT_UNIT,       unit);
+  SUSCAN_SPECTSRC_ENGINE_ALLOC(SUSCAN_SPECTSRC_PRODUCT_UNIT_2,     unit_2);
+  SUSCAN_SPECTSRC_ENGINE_ALLOC(SUSCAN_SPECTSRC_PRODUCT_UNIT_4,     unit_4);
+  SUSCAN_SPECTSRC_ENGINE_ALLOC(SUSCAN_SPECTSRC_PRODUCT_UNIT_8,     unit_8);
+  SUSCAN_SPECTSRC_ENGINE_ALLOC(SUSCAN_SPECTSRC_PRODUCT_CONJ_DIFF,  conj_diff);
+  SUSCAN_SPECTSRC_ENGINE_ALLOC(SUSCAN_SPECTSRC_PRODUCT_PHASE_DIFF, phase_diff);
+  SUSCAN_SPECTSRC_ENGINE_ALLOC(SUSCAN_SPECTSRC_PRODUCT_DELTA,      delta);
+
+#undef SUSCAN_SPECTSRC_ENGINE_ALLOC
+
+  ok = SU_TRUE;
+
+done:
+  /* Never compute products whose buffers could not be allocated */
+  self->products     = ok ? products : 0;
+  self->active_count = ok ? active : 0;
+
+  return ok;
+}
+
+SU_METHOD(suscan_spectsrc_engine, SUBOOL, select, unsigned int id)
+{
+  if (id > self->class_count)
+    return SU_FALSE;
+
+  if (id == self->selected)
+    return SU_TRUE;
+
+  self->selected = id;
+
+  return suscan_spectsrc_engine_update(self);
+}
+
+SU_METHOD(
+  suscan_spectsrc_engine,
+  SUBOOL,
+  subscribe,
+  unsigned int index,
+  SUBOOL subscribed)
+{
+  if (index >= self->class_count)
+    return SU_FALSE;
+
+  if (self->subscribed[index] == subscribed)
+    return SU_TRUE;
+
+  self->subscribed[index] = subscribed;
+
+  return suscan_spectsrc_engine_update(self);
+}
+
+/*
+ * Single pass over the input computing all the products required by
+ * the subscribed sources. The product mask is loop-invariant, so these
+ * branches are always predicted correctly.
+ */
+SUPRIVATE void
+suscan_spectsrc_engine_compute_products(
+  suscan_spectsrc_engine_t *self,
+  const SUCOMPLEX *x,
+  SUSCOUNT size)
+{
+  uint32_t p = self->products;
+  SUCOMPLEX prev = self->last;
+  SUCOMPLEX u, d;
+  SUSCOUNT i;
+
+  if (p != 0) {
+    for (i = 0; i < size; ++i) {
+      if (p & SUSCAN_SPECTSRC_PRODUCT_UNIT) {
+        u = x[i] / (SU_C_ABS(x[i]) + 1e-8);
+        self->unit[i] = u;
+
+        if (p & SUSCAN_SPECTSRC_PRODUCT_UNIT_2) {
+          u *= u;
+          self->unit_2[i] = u;
+
+          if (p & SUSCAN_SPECTSRC_PRODUCT_UNIT_4) {
+            u *= u;
+            self->unit_4[i] = u;
+
+            if (p & SUSCAN_SPECTSRC_PRODUCT_UNIT_8)
+              self->unit_8[i] = u * u;
+          }
+        }
+      }
+
+      if (p & SUSCAN_SPECTSRC_PRODUCT_CONJ_DIFF) {
+        d = x[i] * SU_C_CONJ(prev);
+        self->conj_diff[i] = d;
+
+        if (p & SUSCAN_SPECTSRC_PRODUCT_PHASE_DIFF)
+          self->phase_diff[i] = SU_C_ARG(d);
+      }
+
+      if (p & SUSCAN_SPECTSRC_PRODUCT_DELTA)
+        self->delta[i] = x[i] - prev;
+
+      prev = x[i];
+    }
+  }
+
+  if (size > 0)
+    self->last = x[size - 1];
+}
+
+SU_METHOD(
+  suscan_spectsrc_engine,
+  SUBOOL,
+  feed,
+  const SUCOMPLEX *data,
+  SUSCOUNT size)
+{
+  struct suscan_spectsrc_products products;
+  SUSCOUNT chunk;
+  unsigned int i;
+
+  if (self->active_count == 0) {
+    if (size > 0)
+      self->last = data[size - 1];
+    return SU_TRUE;
+  }
+
+  while (size > 0) {
+    chunk = SU_MIN(size, self->size);
+
+    suscan_spectsrc_engine_compute_products(self, data, chunk);
+
+    products.x          = data;
+    products.unit       = self->unit;
+    products.unit_2     = self->unit_2;
+    products.unit_4     = self->unit_4;
+    products.unit_8     = self->unit_8;
+    products.conj_diff  = self->conj_diff;
+    products.phase_diff = self->phase_diff;
+    products.delta      = self->delta;
+
+    for (i = 0; i < self->class_count; ++i) {
+      if (!self->subscribed[i] && self->selected != i + 1)
+        continue;
+
+      self->current = i;
+      SU_TRYCATCH(
+        suscan_spectsrc_feed(self->source_list[i], &products, chunk) >= 0,
+        return SU_FALSE);
+    }
+
+    data += chunk;
+    size -= chunk;
+  }
+
+  return SU_TRUE;
+}
+
 SUBOOL
 suscan_spectsrcs_initialized(void)
 {
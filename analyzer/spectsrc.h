@@ -30,6 +30,30 @@ extern "C" {
 
 struct suscan_spectsrc;
 
+/*
+ * Intermediate products of the input signal. They are computed by the
+ * spectrum engine once per block, only if some subscribed spectrum
+ * source needs them, and shared among all of them.
+ */
+#define SUSCAN_SPECTSRC_PRODUCT_UNIT       (1 << 0) /* x[n] / |x[n]| */
+#define SUSCAN_SPECTSRC_PRODUCT_UNIT_2     (1 << 1) /* (x[n] / |x[n]|)^2 */
+#define SUSCAN_SPECTSRC_PRODUCT_UNIT_4     (1 << 2) /* (x[n] / |x[n]|)^4 */
+#define SUSCAN_SPECTSRC_PRODUCT_UNIT_8     (1 << 3) /* (x[n] / |x[n]|)^8 */
+#define SUSCAN_SPECTSRC_PRODUCT_CONJ_DIFF  (1 << 4) /* x[n] x*[n - 1] */
+#define SUSCAN_SPECTSRC_PRODUCT_PHASE_DIFF (1 << 5) /* arg(x[n] x*[n - 1]) */
+#define SUSCAN_SPECTSRC_PRODUCT_DELTA      (1 << 6) /* x[n] - x[n - 1] */
+
+struct suscan_spectsrc_products {
+  const SUCOMPLEX *x;
+  const SUCOMPLEX *unit;
+  const SUCOMPLEX *unit_2;
+  const SUCOMPLEX *unit_4;
+  const SUCOMPLEX *unit_8;
+  const SUCOMPLEX *conj_diff;
+  const SUFLOAT   *phase_diff;
+  const SUCOMPLEX *delta;
+};
+
 struct suscan_spectsrc_class {
   const char *name;
   const char *desc;
@@ -42,6 +66,18 @@ struct suscan_spectsrc_class {
       SUCOMPLEX *buffer,
       SUSCOUNT size);
 
+  /* 
+   * Alternative to preproc: build the input of the PSD from the shared
+   * products declared in the products mask.
+   */
+  uint32_t products;
+  SUBOOL (*from_products) (
+      struct suscan_spectsrc *src,
+      void *privdata,
+      const struct suscan_spectsrc_products *products,
+      SUCOMPLEX *buffer,
+      SUSCOUNT size);
+
   void (*dtor) (void *privdata);
 };
 
@@ -84,11 +120,105 @@ void suscan_spectsrc_set_throttle_factor(
 
 SUSCOUNT suscan_spectsrc_feed(
     suscan_spectsrc_t *src,
-    const SUCOMPLEX *data,
+    const struct suscan_spectsrc_products *products,
     SUSCOUNT size);
 
 void suscan_spectsrc_destroy(suscan_spectsrc_t *src);
 
+/*
+ * Spectrum engine: all the spectrum sources of an inspector. Sources are
+ * only instantiated (and their PSD state allocated) once they are
+ * selected or subscribed, and the intermediate products they need are
+ * computed in a single pass over every block of samples. The selected
+ * source is always subscribed.
+ */
+struct suscan_spectsrc_engine {
+  SUFLOAT  samp_rate;
+  SUFLOAT  spectrum_rate;
+  SUFLOAT  throttle_factor;
+  SUSCOUNT size;
+  enum sigutils_channel_detector_window window_type;
+
+  PTR_LIST_CONST(struct suscan_spectsrc_class, class);
+  suscan_spectsrc_t **source_list;  /* One per class, NULL until needed */
+  SUBOOL            *subscribed;    /* One per class */
+  unsigned int       selected;      /* 1-based, 0 is none */
+  unsigned int       active_count;  /* Number of subscribed sources */
+  unsigned int       current;       /* Source being fed */
+
+  /* Shared products */
+  uint32_t   products;
+  SUCOMPLEX *unit;
+  SUCOMPLEX *unit_2;
+  SUCOMPLEX *unit_4;
+  SUCOMPLEX *unit_8;
+  SUCOMPLEX *conj_diff;
+  SUFLOAT   *phase_diff;
+  SUCOMPLEX *delta;
+  SUCOMPLEX  last;
+
+  SUBOOL (*on_spectrum) (
+    void *userdata,
+    unsigned int index,
+    const SUFLOAT *data,
+    SUSCOUNT size);
+  void *userdata;
+};
+
+typedef struct suscan_spectsrc_engine suscan_spectsrc_engine_t;
+
+SU_INSTANCER(
+  suscan_spectsrc_engine,
+  SUFLOAT samp_rate,
+  SUFLOAT spectrum_rate,
+  SUSCOUNT size,
+  enum sigutils_channel_detector_window window_type,
+  SUBOOL (*on_spectrum) (
+    void *userdata,
+    unsigned int index,
+    const SUFLOAT *data,
+    SUSCOUNT size),
+  void *userdata);
+SU_COLLECTOR(suscan_spectsrc_engine);
+
+SUINLINE SU_GETTER(suscan_spectsrc_engine, unsigned int, get_count)
+{
+  return self->class_count;
+}
+
+SUINLINE SU_GETTER(
+  suscan_spectsrc_engine,
+  const struct suscan_spectsrc_class *,
+  get_class,
+  unsigned int index)
+{
+  return index < self->class_count ? self->class_list[index] : NULL;
+}
+
+SU_METHOD(
+  suscan_spectsrc_engine,
+  SUBOOL,
+  add_class,
+  const struct suscan_spectsrc_class *classdef);
+
+SU_METHOD(suscan_spectsrc_engine, void, set_throttle_factor, SUFLOAT factor);
+
+/* Both must be called from the thread feeding the engine */
+SU_METHOD(suscan_spectsrc_engine, SUBOOL, select, unsigned int id);
+SU_METHOD(
+  suscan_spectsrc_engine,
+  SUBOOL,
+  subscribe,
+  unsigned int index,
+  SUBOOL subscribed);
+
+SU_METHOD(
+  suscan_spectsrc_engine,
+  SUBOOL,
+  feed,
+  const SUCOMPLEX *data,
+  SUSCOUNT size);
+
 SUBOOL suscan_spectsrc_psd_register(void);
 SUBOOL suscan_spectsrc_cyclo_register(void);
 SUBOOL suscan_spectsrc_fmcyclo_register(void);
@@ -25,50 +25,31 @@
 
 #define SU_CYCLO_GAIN 1e6
 
-void *
-suscan_spectsrc_cyclo_ctor(suscan_spectsrc_t *src)
-{
-  return calloc(1, sizeof(SUCOMPLEX));
-}
-
 SUBOOL
-suscan_spectsrc_cyclo_preproc(
+suscan_spectsrc_cyclo_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
-  SUCOMPLEX *last = (SUCOMPLEX *) private;
-  SUCOMPLEX prev = *last;
-  SUCOMPLEX diff;
+  const SUCOMPLEX *diff = products->conj_diff;
   SUSCOUNT i;
 
-  for (i = 0; i < size; ++i) {
-    diff = buffer[i] * SU_C_CONJ(prev);
-    prev = buffer[i];
-    buffer[i] = SU_CYCLO_GAIN * diff;
-  }
-
-  *last = prev;
+  for (i = 0; i < size; ++i)
+    buffer[i] = SU_CYCLO_GAIN * diff[i];
 
   return SU_TRUE;
 }
 
-void
-suscan_spectsrc_cyclo_dtor(void *private)
-{
-  free(private);
-}
-
 SUBOOL
 suscan_spectsrc_cyclo_register(void)
 {
   static const struct suscan_spectsrc_class class = {
     .name = "cyclo",
     .desc = "Cyclostationary analysis",
-    .ctor = suscan_spectsrc_cyclo_ctor,
-    .preproc  = suscan_spectsrc_cyclo_preproc,
-    .dtor = suscan_spectsrc_cyclo_dtor
+    .products = SUSCAN_SPECTSRC_PRODUCT_CONJ_DIFF,
+    .from_products = suscan_spectsrc_cyclo_from_products
   };
 
   SU_TRYCATCH(suscan_spectsrc_class_register(&class), return SU_FALSE);
@@ -30,16 +30,19 @@ suscan_spectsrc_exp_2_ctor(suscan_spectsrc_t *src)
 }
 
 SUBOOL
-suscan_spectsrc_exp_2_preproc(
+suscan_spectsrc_exp_2_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
+  const SUCOMPLEX *unit_2 = products->unit_2;
+  SUFLOAT k = 1. / size;
   SUSCOUNT i;
 
   for (i = 0; i < size; ++i)
-    buffer[i] = cpow(buffer[i] / (SU_C_ABS(buffer[i]) + 1e-8), 2) / size;
+    buffer[i] = k * unit_2[i];
 
   return SU_TRUE;
 }
@@ -57,7 +60,8 @@ suscan_spectsrc_exp_2_register(void)
     .name = "exp_2",
     .desc = "Signal exponentiation (^2)",
     .ctor = suscan_spectsrc_exp_2_ctor,
-    .preproc  = suscan_spectsrc_exp_2_preproc,
+    .products = SUSCAN_SPECTSRC_PRODUCT_UNIT_2,
+    .from_products = suscan_spectsrc_exp_2_from_products,
     .dtor = suscan_spectsrc_exp_2_dtor
   };
 
@@ -30,16 +30,19 @@ suscan_spectsrc_exp_4_ctor(suscan_spectsrc_t *src)
 }
 
 SUBOOL
-suscan_spectsrc_exp_4_preproc(
+suscan_spectsrc_exp_4_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
+  const SUCOMPLEX *unit_4 = products->unit_4;
+  SUFLOAT k = 1. / size;
   SUSCOUNT i;
 
   for (i = 0; i < size; ++i)
-    buffer[i] = cpow(buffer[i] / (SU_C_ABS(buffer[i]) + 1e-8), 4) / size;
+    buffer[i] = k * unit_4[i];
 
   return SU_TRUE;
 }
@@ -57,7 +60,8 @@ suscan_spectsrc_exp_4_register(void)
     .name = "exp_4",
     .desc = "Signal exponentiation (^4)",
     .ctor = suscan_spectsrc_exp_4_ctor,
-    .preproc  = suscan_spectsrc_exp_4_preproc,
+    .products = SUSCAN_SPECTSRC_PRODUCT_UNIT_4,
+    .from_products = suscan_spectsrc_exp_4_from_products,
     .dtor = suscan_spectsrc_exp_4_dtor
   };
 
@@ -30,16 +30,19 @@ suscan_spectsrc_exp_8_ctor(suscan_spectsrc_t *src)
 }
 
 SUBOOL
-suscan_spectsrc_exp_8_preproc(
+suscan_spectsrc_exp_8_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
+  const SUCOMPLEX *unit_8 = products->unit_8;
+  SUFLOAT k = 1. / size;
   SUSCOUNT i;
 
   for (i = 0; i < size; ++i)
-    buffer[i] = cpow(buffer[i] / (SU_C_ABS(buffer[i]) + 1e-8), 8) / size;
+    buffer[i] = k * unit_8[i];
 
   return SU_TRUE;
 }
@@ -57,7 +60,8 @@ suscan_spectsrc_exp_8_register(void)
     .name = "exp_8",
     .desc = "Signal exponentiation (^8)",
     .ctor = suscan_spectsrc_exp_8_ctor,
-    .preproc  = suscan_spectsrc_exp_8_preproc,
+    .products = SUSCAN_SPECTSRC_PRODUCT_UNIT_8,
+    .from_products = suscan_spectsrc_exp_8_from_products,
     .dtor = suscan_spectsrc_exp_8_dtor
   };
 
@@ -26,7 +26,6 @@
 #define FMCYCLO_GAIN 1e-5
 
 struct fmcyclo_ctx {
-  SUCOMPLEX fm_prev;
   SUFLOAT   pd_prev;
 };
 
@@ -37,26 +36,23 @@ suscan_spectsrc_fmcyclo_ctor(suscan_spectsrc_t *src)
 }
 
 SUBOOL
-suscan_spectsrc_fmcyclo_preproc(
+suscan_spectsrc_fmcyclo_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
   struct fmcyclo_ctx *ctx = (struct fmcyclo_ctx *) private;
-  SUCOMPLEX fm_prev = ctx->fm_prev;
+  const SUFLOAT *phase_diff = products->phase_diff;
   SUFLOAT   pd_prev = ctx->pd_prev;
-  SUFLOAT   phase_diff;
   SUSCOUNT i;
 
   for (i = 0; i < size; ++i) {
-    phase_diff = SU_C_ARG(buffer[i] * SU_C_CONJ(fm_prev));
-    fm_prev = buffer[i];
-    buffer[i] = FMCYCLO_GAIN * SU_ABS(phase_diff - pd_prev);
-    pd_prev = phase_diff;
+    buffer[i] = FMCYCLO_GAIN * SU_ABS(phase_diff[i] - pd_prev);
+    pd_prev = phase_diff[i];
   }
 
-  ctx->fm_prev = fm_prev;
   ctx->pd_prev = pd_prev;
 
   return SU_TRUE;
@@ -75,7 +71,8 @@ suscan_spectsrc_fmcyclo_register(void)
     .name = "fmcyclo",
     .desc = "FM cyclostationary analysis",
     .ctor = suscan_spectsrc_fmcyclo_ctor,
-    .preproc  = suscan_spectsrc_fmcyclo_preproc,
+    .products = SUSCAN_SPECTSRC_PRODUCT_PHASE_DIFF,
+    .from_products = suscan_spectsrc_fmcyclo_from_products,
     .dtor = suscan_spectsrc_fmcyclo_dtor
   };
 
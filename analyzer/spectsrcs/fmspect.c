@@ -25,50 +25,31 @@
 
 #define FMSPECT_GAIN 1e-5
 
-void *
-suscan_spectsrc_fmspect_ctor(suscan_spectsrc_t *src)
-{
-  return calloc(1, sizeof(SUCOMPLEX));
-}
-
 SUBOOL
-suscan_spectsrc_fmspect_preproc(
+suscan_spectsrc_fmspect_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
-  SUCOMPLEX *last = (SUCOMPLEX *) private;
-  SUCOMPLEX prev = *last;
-  SUCOMPLEX diff;
+  const SUFLOAT *phase_diff = products->phase_diff;
   SUSCOUNT i;
 
-  for (i = 0; i < size; ++i) {
-    diff = SU_C_ARG(buffer[i] * SU_C_CONJ(prev));
-    prev = buffer[i];
-    buffer[i] = FMSPECT_GAIN * diff;
-  }
-
-  *last = prev;
+  for (i = 0; i < size; ++i)
+    buffer[i] = FMSPECT_GAIN * phase_diff[i];
 
   return SU_TRUE;
 }
 
-void
-suscan_spectsrc_fmspect_dtor(void *private)
-{
-  free(private);
-}
-
 SUBOOL
 suscan_spectsrc_fmspect_register(void)
 {
   static const struct suscan_spectsrc_class class = {
     .name = "fmspect",
     .desc = "FM baseband spectrum",
-    .ctor = suscan_spectsrc_fmspect_ctor,
-    .preproc  = suscan_spectsrc_fmspect_preproc,
-    .dtor = suscan_spectsrc_fmspect_dtor
+    .products = SUSCAN_SPECTSRC_PRODUCT_PHASE_DIFF,
+    .from_products = suscan_spectsrc_fmspect_from_products
   };
 
   SU_TRYCATCH(suscan_spectsrc_class_register(&class), return SU_FALSE);
@@ -23,81 +23,51 @@
 
 #include "spectsrc.h"
 
-void *
-suscan_spectsrc_timediff_ctor(suscan_spectsrc_t *src)
-{
-  return calloc(1, sizeof(SUCOMPLEX));
-}
-
 SUBOOL
-suscan_spectsrc_timediff_preproc(
+suscan_spectsrc_timediff_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
-  SUCOMPLEX *last = (SUCOMPLEX *) private;
-  SUCOMPLEX prev = *last;
-  SUCOMPLEX diff;
-  SUSCOUNT i;
-
-  for (i = 0; i < size; ++i) {
-    diff = buffer[i] - prev;
-    prev = buffer[i];
-    buffer[i] = diff;
-  }
-
-  *last = prev;
+  memcpy(buffer, products->delta, size * sizeof(SUCOMPLEX));
 
   return SU_TRUE;
 }
 
 SUBOOL
-suscan_spectsrc_abstimediff_preproc(
+suscan_spectsrc_abstimediff_from_products(
     suscan_spectsrc_t *src,
     void *private,
+    const struct suscan_spectsrc_products *products,
     SUCOMPLEX *buffer,
     SUSCOUNT size)
 {
-  SUCOMPLEX *last = (SUCOMPLEX *) private;
-  SUCOMPLEX prev = *last;
-  SUCOMPLEX diff;
+  const SUCOMPLEX *delta = products->delta;
   SUSCOUNT i;
 
-  for (i = 0; i < size; ++i) {
-    diff = buffer[i] - prev;
-    prev = buffer[i];
-    buffer[i] = diff * SU_C_CONJ(diff);
-  }
-
-  *last = prev;
+  for (i = 0; i < size; ++i)
+    buffer[i] = delta[i] * SU_C_CONJ(delta[i]);
 
   return SU_TRUE;
 }
 
-void
-suscan_spectsrc_timediff_dtor(void *private)
-{
-  free(private);
-}
-
 SUBOOL
 suscan_spectsrc_timediff_register(void)
 {
   static const struct suscan_spectsrc_class classsgn = {
     .name = "timediff",
     .desc = "Time derivative",
-    .ctor = suscan_spectsrc_timediff_ctor,
-    .preproc  = suscan_spectsrc_timediff_preproc,
-    .dtor = suscan_spectsrc_timediff_dtor
+    .products = SUSCAN_SPECTSRC_PRODUCT_DELTA,
+    .from_products = suscan_spectsrc_timediff_from_products
   };
 
   static const struct suscan_spectsrc_class classabs = {
     .name = "abstimediff",
     .desc = "Absolute value of time derivative",
-    .ctor = suscan_spectsrc_timediff_ctor,
-    .preproc  = suscan_spectsrc_abstimediff_preproc,
-    .dtor = suscan_spectsrc_timediff_dtor
+    .products = SUSCAN_SPECTSRC_PRODUCT_DELTA,
+    .from_products = suscan_spectsrc_abstimediff_from_products
   };
 
 
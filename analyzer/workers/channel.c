@@ -80,23 +80,24 @@ suscan_local_analyzer_process_end(suscan_local_analyzer_t *analyzer)
 SUPRIVATE SUBOOL
 suscan_local_analyzer_feed_baseband_filters(
     suscan_local_analyzer_t *self,
+    suscan_sample_buffer_t *buffer,
     SUCOMPLEX *samples,
     SUSCOUNT length)
 {
   struct rbtree_node *this;
-  struct suscan_analyzer_baseband_filter *bbfilt;
+  suscan_bbfilt_t *bbfilt;
+  SUSCOUNT consumed;
 
   this = rbtree_get_first(self->bbfilt_tree);
+  if (this == NULL)
+    return SU_TRUE;
+
+  consumed = suscan_source_get_consumed_samples(self->source) - length;
 
   while (this != NULL) {
     bbfilt = rbtree_node_data(this);
     if (bbfilt != NULL) {
-      if (!bbfilt->func(
-          bbfilt->privdata,
-          self->parent,
-          samples,
-          length,
-          suscan_source_get_consumed_samples(self->source) - length))
+      if (!suscan_bbfilt_feed(bbfilt, buffer, samples, length, consumed))
         return SU_FALSE;
     }
 
@@ -106,8 +107,22 @@ suscan_local_analyzer_feed_baseband_filters(
   return SU_TRUE;
 }
 
+/* Called before acquiring the loop mutex */
+SUPRIVATE void
+suscan_local_analyzer_wait_baseband_filters(suscan_local_analyzer_t *self)
+{
+  struct rbtree_node *this;
+  suscan_bbfilt_t *bbfilt;
+
+  for (this = rbtree_get_first(self->bbfilt_tree);
+       this != NULL;
+       this = rbtree_node_next(this))
+    if ((bbfilt = rbtree_node_data(this)) != NULL)
+      suscan_bbfilt_wait_room(bbfilt);
+}
+
 SUPRIVATE SUBOOL
-suscan_local_analyzer_feed_inspectors(
+suscan_local_analyzer_feed_inspectors_unsafe(
     suscan_local_analyzer_t *self,
     suscan_sample_buffer_t *buffer)
 {
@@ -180,6 +195,27 @@ suscan_local_analyzer_feed_inspectors(
   return ok;
 }
 
+/*
+ * The inspector scheduler is shared by all sources of the analyzer, and
+ * its synchronization barrier cannot be used by several threads at once.
+ */
+SUPRIVATE SUBOOL
+suscan_local_analyzer_feed_inspectors(
+    suscan_local_analyzer_t *self,
+    suscan_sample_buffer_t *buffer)
+{
+  SUBOOL ok;
+
+  if (pthread_mutex_lock(&self->sched_mutex) != 0)
+    return SU_FALSE;
+
+  ok = suscan_local_analyzer_feed_inspectors_unsafe(self, buffer);
+
+  (void) pthread_mutex_unlock(&self->sched_mutex);
+
+  return ok;
+}
+
 SUPRIVATE SUBOOL
 suscan_local_analyzer_on_channel_data(
     const struct sigutils_specttuner_channel *channel,
@@ -219,9 +255,54 @@ suscan_local_analyzer_on_new_freq(
 }
 
 /*********************** Channel opening and closing *************************/
+/*
+ * Channels can be opened on the primary source or any of the additional
+ * sources of the analyzer. This struct gathers the spectral tuner and the
+ * tuning information of a given source.
+ */
+struct suscan_local_tuner {
+  su_specttuner_t *stuner;
+  pthread_mutex_t *mutex;
+  unsigned int     samp_rate;
+  SUFREQ           freq;
+};
+
+/* Per-inspector data of the local factory */
+struct suscan_local_channel {
+  su_specttuner_channel_t *schan;
+  unsigned int             source;
+};
+
+SUPRIVATE SUBOOL
+suscan_local_analyzer_get_tuner(
+    suscan_local_analyzer_t *self,
+    unsigned int source,
+    struct suscan_local_tuner *tuner)
+{
+  suscan_local_subsource_t *subsource;
+
+  if (source == 0) {
+    tuner->stuner    = self->stuner;
+    tuner->mutex     = &self->stuner_mutex;
+    tuner->samp_rate = suscan_analyzer_get_samp_rate(self->parent);
+    tuner->freq      = self->source_info.frequency;
+  } else {
+    if ((subsource = suscan_local_analyzer_get_subsource(self, source)) == NULL)
+      return SU_FALSE;
+
+    tuner->stuner    = subsource->stuner;
+    tuner->mutex     = &subsource->stuner_mutex;
+    tuner->samp_rate = suscan_source_get_samp_rate(subsource->source);
+    tuner->freq      = subsource->source_info.frequency;
+  }
+
+  return SU_TRUE;
+}
+
 SUPRIVATE su_specttuner_channel_t *
 suscan_local_analyzer_open_channel_ex(
     suscan_local_analyzer_t *self,
+    const struct suscan_local_tuner *tuner,
     const struct sigutils_channel *chan_info,
     SUBOOL precise,
     su_specttuner_channel_data_func_t on_data,
@@ -236,7 +317,7 @@ suscan_local_analyzer_open_channel_ex(
   params.f0 =
       SU_NORM2ANG_FREQ(
           SU_ABS2NORM_FREQ(
-              suscan_analyzer_get_samp_rate(self->parent),
+              tuner->samp_rate,
               chan_info->fc - chan_info->ft));
 
   if (params.f0 < 0)
@@ -245,7 +326,7 @@ suscan_local_analyzer_open_channel_ex(
   params.bw =
       SU_NORM2ANG_FREQ(
           SU_ABS2NORM_FREQ(
-              suscan_analyzer_get_samp_rate(self->parent),
+              tuner->samp_rate,
               chan_info->f_hi - chan_info->f_lo));
 
   params.guard    = SUSCAN_ANALYZER_GUARD_BAND_PROPORTION;
@@ -255,16 +336,16 @@ suscan_local_analyzer_open_channel_ex(
   params.on_data  = on_data;
   params.on_freq_changed = on_new_freq;
 
-  SU_TRYCATCH(pthread_mutex_lock(&self->stuner_mutex) == 0, goto done);
+  SU_TRYCATCH(pthread_mutex_lock(tuner->mutex) == 0, goto done);
   mutex_acquired = SU_TRUE;
 
   SU_TRYCATCH(
-      channel = su_specttuner_open_channel(self->stuner, &params),
+      channel = su_specttuner_open_channel(tuner->stuner, &params),
       goto done);
 
 done:
   if (mutex_acquired)
-    (void) pthread_mutex_unlock(&self->stuner_mutex);
+    (void) pthread_mutex_unlock(tuner->mutex);
 
   return channel;
 }
@@ -273,19 +354,20 @@ done:
 SUPRIVATE SUBOOL
 suscan_local_analyzer_close_channel(
     suscan_local_analyzer_t *self,
+    const struct suscan_local_tuner *tuner,
     su_specttuner_channel_t *channel)
 {
   SUBOOL mutex_acquired = SU_FALSE;
   SUBOOL ok = SU_FALSE;
 
-  SU_TRYCATCH(pthread_mutex_lock(&self->stuner_mutex) == 0, goto done);
+  SU_TRYCATCH(pthread_mutex_lock(tuner->mutex) == 0, goto done);
   mutex_acquired = SU_TRUE;
 
-  ok = su_specttuner_close_channel(self->stuner, channel);
+  ok = su_specttuner_close_channel(tuner->stuner, channel);
 
 done:
   if (mutex_acquired)
-    (void) pthread_mutex_unlock(&self->stuner_mutex);
+    (void) pthread_mutex_unlock(tuner->mutex);
 
   return ok;
 }
@@ -320,18 +402,29 @@ suscan_local_inspector_factory_open(
   va_list ap)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) userdata;
-  unsigned int samp_rate = suscan_analyzer_get_samp_rate(self->parent);
+  struct suscan_local_channel *chan = NULL;
+  struct suscan_local_tuner tuner;
   const char *classname;
   const struct sigutils_channel *channel;
   su_specttuner_channel_t *schan;
+  unsigned int source;
   SUBOOL precise;
 
   classname = va_arg(ap, const char *);
   channel   = va_arg(ap, const struct sigutils_channel *);
   precise   = va_arg(ap, SUBOOL);
+  source    = va_arg(ap, unsigned int);
+
+  if (!suscan_local_analyzer_get_tuner(self, source, &tuner)) {
+    SU_ERROR("Local inspector factory: no such source (%u)\n", source);
+    return NULL;
+  }
+
+  SU_ALLOCATE_FAIL(chan, struct suscan_local_channel);
 
   schan = suscan_local_analyzer_open_channel_ex(
     self,
+    &tuner,
     channel,
     precise,
     suscan_local_analyzer_on_channel_data,
@@ -340,23 +433,32 @@ suscan_local_inspector_factory_open(
 
   if (schan == NULL) {
     SU_ERROR("Local inspector factory: failed to open channel (invalid channel?)\n");
-    return NULL;
+    goto fail;
   }
 
+  chan->schan  = schan;
+  chan->source = source;
+
   /* Prepare output fields */
   *inspclass = classname;
 
   /* Initialize sampling info */
-  samp_info->equiv_fs   = SU_ASFLOAT(samp_rate) / schan->decimation;
+  samp_info->equiv_fs   = SU_ASFLOAT(tuner.samp_rate) / schan->decimation;
   samp_info->bw_bd      = SU_ANG2NORM_FREQ(su_specttuner_channel_get_bw(schan));
   samp_info->bw         = .5 * schan->decimation * samp_info->bw_bd;
   samp_info->f0         = SU_ANG2NORM_FREQ(su_specttuner_channel_get_f0(schan));
   samp_info->fft_size   = schan->size;
   samp_info->fft_bins   = schan->width;
-  samp_info->early_windowing = su_specttuner_uses_early_windowing(self->stuner);
+  samp_info->early_windowing = su_specttuner_uses_early_windowing(tuner.stuner);
 
   samp_info->decimation = schan->decimation;
-  return schan;
+  return chan;
+
+fail:
+  if (chan != NULL)
+    free(chan);
+
+  return NULL;
 }
 
 SUPRIVATE void
@@ -365,7 +467,7 @@ suscan_local_inspector_factory_bind(
   void *insp_self, 
   suscan_inspector_t *insp)
 {
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_self;
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_self;
 
   /* We need to do this here. */
   suscan_inspector_set_domain(
@@ -373,7 +475,7 @@ suscan_local_inspector_factory_bind(
     suscan_inspector_is_freq_domain(insp));
 
   /* TODO: Assign inspector to channel and open a handle (use SU_REF) */
-  chan->params.privdata = insp;
+  chan->schan->params.privdata = insp;
 
   SU_REF(insp, specttuner);
 }
@@ -384,15 +486,19 @@ suscan_local_inspector_factory_close(
   void *insp_self)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) userdata;
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_self;
-  suscan_inspector_t *insp      = (suscan_inspector_t *) chan->params.privdata;
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_self;
+  suscan_inspector_t *insp = (suscan_inspector_t *) chan->schan->params.privdata;
+  struct suscan_local_tuner tuner;
 
   /* For channels created before binding */
   if (insp != NULL)
     SU_DEREF(insp, specttuner);
 
-  if (!suscan_local_analyzer_close_channel(self, chan))
+  if (!suscan_local_analyzer_get_tuner(self, chan->source, &tuner)
+    || !suscan_local_analyzer_close_channel(self, &tuner, chan->schan))
     SU_WARNING("Failed to close channel!\n");
+
+  free(chan);
 }
 
 SUPRIVATE void
@@ -405,6 +511,11 @@ suscan_local_inspector_factory_free_buf(
   /* TODO: No-op */
 }
 
+/*
+ * Inspector requests are committed by the primary source worker, while
+ * channels of additional sources are fed by their own workers. Tuner
+ * changes must be performed with the tuner lock held.
+ */
 SUPRIVATE SUBOOL
 suscan_local_inspector_factory_set_bandwidth(
   void *userdata, 
@@ -412,15 +523,19 @@ suscan_local_inspector_factory_set_bandwidth(
   SUFLOAT bandwidth)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) userdata;
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_userdata;
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_userdata;
+  struct suscan_local_tuner tuner;
   SUFLOAT relbw;
 
-  relbw = SU_NORM2ANG_FREQ(
-    SU_ABS2NORM_FREQ(
-      suscan_analyzer_get_samp_rate(self->parent),
-      bandwidth));
+  SU_TRYCATCH(
+    suscan_local_analyzer_get_tuner(self, chan->source, &tuner),
+    return SU_FALSE);
+
+  relbw = SU_NORM2ANG_FREQ(SU_ABS2NORM_FREQ(tuner.samp_rate, bandwidth));
 
-  (void) su_specttuner_set_channel_bandwidth(self->stuner, chan, relbw);
+  SU_TRYCATCH(pthread_mutex_lock(tuner.mutex) == 0, return SU_FALSE);
+  (void) su_specttuner_set_channel_bandwidth(tuner.stuner, chan->schan, relbw);
+  (void) pthread_mutex_unlock(tuner.mutex);
 
   return SU_TRUE;
 }
@@ -431,12 +546,14 @@ suscan_local_inspector_factory_get_bandwidth(
   void *insp_userdata)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) userdata;
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_userdata;
-  SUFLOAT relbw = su_specttuner_channel_get_bw(chan);
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_userdata;
+  struct suscan_local_tuner tuner;
+  SUFLOAT relbw = su_specttuner_channel_get_bw(chan->schan);
 
-  return SU_NORM2ABS_FREQ(
-    suscan_analyzer_get_samp_rate(self->parent),
-    SU_ANG2NORM_FREQ(relbw));
+  if (!suscan_local_analyzer_get_tuner(self, chan->source, &tuner))
+    return 0;
+
+  return SU_NORM2ABS_FREQ(tuner.samp_rate, SU_ANG2NORM_FREQ(relbw));
 }
 
 SUPRIVATE SUBOOL
@@ -446,18 +563,22 @@ suscan_local_inspector_factory_set_frequency(
   SUFREQ frequency)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) userdata;
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_userdata;
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_userdata;
+  struct suscan_local_tuner tuner;
   SUFLOAT f0;
 
-  f0 = SU_NORM2ANG_FREQ(
-        SU_ABS2NORM_FREQ(
-            suscan_analyzer_get_samp_rate(self->parent),
-            frequency));
+  SU_TRYCATCH(
+    suscan_local_analyzer_get_tuner(self, chan->source, &tuner),
+    return SU_FALSE);
+
+  f0 = SU_NORM2ANG_FREQ(SU_ABS2NORM_FREQ(tuner.samp_rate, frequency));
 
   if (f0 < 0)
     f0 += 2 * PI;
 
-  (void) su_specttuner_set_channel_freq(self->stuner, chan, f0);
+  SU_TRYCATCH(pthread_mutex_lock(tuner.mutex) == 0, return SU_FALSE);
+  (void) su_specttuner_set_channel_freq(tuner.stuner, chan->schan, f0);
+  (void) pthread_mutex_unlock(tuner.mutex);
 
   return SU_TRUE;
 }
@@ -468,10 +589,10 @@ suscan_local_inspector_factory_set_domain(
   void *insp_userdata, 
   SUBOOL is_freq)
 {
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_userdata;
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_userdata;
   
   su_specttuner_channel_set_domain(
-    chan,
+    chan->schan,
     is_freq 
     ? SU_SPECTTUNER_CHANNEL_FREQUENCY_DOMAIN
     : SU_SPECTTUNER_CHANNEL_TIME_DOMAIN);    
@@ -485,15 +606,15 @@ suscan_local_inspector_factory_get_abs_freq(
   void *insp_userdata)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) userdata;
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_userdata;
-  unsigned int samp_rate = suscan_analyzer_get_samp_rate(self->parent);
-  SUFREQ tuner_freq = self->source_info.frequency;
-  SUFREQ channel_freq = 
-    tuner_freq + SU_NORM2ABS_FREQ(
-      samp_rate,
-      SU_ANG2NORM_FREQ(su_specttuner_channel_get_f0(chan)));
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_userdata;
+  struct suscan_local_tuner tuner;
+
+  if (!suscan_local_analyzer_get_tuner(self, chan->source, &tuner))
+    return 0;
 
-  return channel_freq;
+  return tuner.freq + SU_NORM2ABS_FREQ(
+      tuner.samp_rate,
+      SU_ANG2NORM_FREQ(su_specttuner_channel_get_f0(chan->schan)));
 }
 
 SUPRIVATE SUBOOL
@@ -503,12 +624,19 @@ suscan_local_inspector_factory_set_freq_correction(
   SUFLOAT delta)
 {
   suscan_local_analyzer_t *self = (suscan_local_analyzer_t *) userdata;
-  su_specttuner_channel_t *chan = (su_specttuner_channel_t *) insp_userdata;
-  unsigned int samp_rate = suscan_analyzer_get_samp_rate(self->parent);
+  struct suscan_local_channel *chan = (struct suscan_local_channel *) insp_userdata;
+  struct suscan_local_tuner tuner;
+  SUFLOAT domega;
 
-  SUFLOAT domega = SU_NORM2ANG_FREQ(SU_ABS2NORM_FREQ(samp_rate, delta));
-  
-  su_specttuner_set_channel_delta_f(self->stuner, chan, domega);
+  SU_TRYCATCH(
+    suscan_local_analyzer_get_tuner(self, chan->source, &tuner),
+    return SU_FALSE);
+
+  domega = SU_NORM2ANG_FREQ(SU_ABS2NORM_FREQ(tuner.samp_rate, delta));
+
+  SU_TRYCATCH(pthread_mutex_lock(tuner.mutex) == 0, return SU_FALSE);
+  su_specttuner_set_channel_delta_f(tuner.stuner, chan->schan, domega);
+  (void) pthread_mutex_unlock(tuner.mutex);
 
   return SU_TRUE;
 }
@@ -777,6 +905,9 @@ suscan_local_analyzer_buffer_channelizer_wk_cb(
   SUBOOL restart = SU_FALSE;
   SUFLOAT seconds;
 
+  /* Blocking baseband filters must not stall other loop mutex users */
+  suscan_local_analyzer_wait_baseband_filters(self);
+
   SU_TRY(suscan_local_analyzer_lock_loop(self));
   mutex_acquired = SU_TRUE;
 
@@ -794,10 +925,12 @@ suscan_local_analyzer_buffer_channelizer_wk_cb(
   suscan_local_analyzer_process_start(self);
   samples = suscan_sample_buffer_data(buffer);
 
-  if (self->iq_rev)
-    suscan_analyzer_do_iq_rev(samples, got);
-
-  SU_TRY(suscan_local_analyzer_feed_baseband_filters(self, samples, got));
+  SU_TRY(
+      suscan_local_analyzer_feed_baseband_filters(
+          self,
+          buffer,
+          samples,
+          got));
 
   /*
     * NO CIRCULARITY: Increment reference and deliver to worker.
@@ -861,6 +994,9 @@ suscan_local_analyzer_circbuf_channelizer_wk_cb(
   SUBOOL restart = SU_FALSE;
   SUFLOAT seconds;
 
+  /* Blocking baseband filters must not stall other loop mutex users */
+  suscan_local_analyzer_wait_baseband_filters(self);
+
   SU_TRY(suscan_local_analyzer_lock_loop(self));
   mutex_acquired = SU_TRUE;
 
@@ -878,12 +1014,10 @@ suscan_local_analyzer_circbuf_channelizer_wk_cb(
   suscan_local_analyzer_process_start(self);
   samples = suscan_sample_buffer_data(buffer);
 
-  if (self->iq_rev)
-    suscan_analyzer_do_iq_rev(samples, got);
-
   SU_TRY(
       suscan_local_analyzer_feed_baseband_filters(
           self,
+          buffer,
           samples,
           got));
 
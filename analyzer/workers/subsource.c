@@ -0,0 +1,395 @@
+/*
+
+  Copyright (C) 2024 Gonzalo José Carracedo Carballal
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as
+  published by the Free Software Foundation, version 3.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this program.  If not, see
+  <http://www.gnu.org/licenses/>
+
+*/
+
+/*
+ * Additional sources of the channel analyzer: every subsource reads from
+ * its own device, computes its own PSD and channelizes with its own
+ * spectral tuner. Inspectors opened on a subsource share the inspector
+ * factory of the analyzer, so all sources are served by the same
+ * inspector worker pool.
+ */
+
+#define SU_LOG_DOMAIN "subsource"
+
+#include <string.h>
+#include <errno.h>
+
+#include <sigutils/sigutils.h>
+#include <analyzer/impl/local.h>
+
+#include "realtime.h"
+#include "mq.h"
+#include "msg.h"
+
+SUPRIVATE SUBOOL
+suscan_local_subsource_on_psd(
+    void *userdata,
+    const SUFLOAT *psd,
+    unsigned int size)
+{
+  suscan_local_subsource_t *self = (suscan_local_subsource_t *) userdata;
+  suscan_analyzer_t *analyzer = self->owner->parent;
+  struct suscan_analyzer_psd_msg *msg = NULL;
+  SUBOOL ok = SU_FALSE;
+
+  if ((msg = suscan_analyzer_psd_msg_new_from_data(
+      self->source_info.source_samp_rate,
+      psd,
+      size)) == NULL) {
+    suscan_analyzer_send_status(
+        analyzer,
+        SUSCAN_ANALYZER_MESSAGE_TYPE_INTERNAL,
+        -1,
+        "Cannot create message: %s",
+        strerror(errno));
+    goto done;
+  }
+
+  msg->source_index = self->index;
+  msg->fc           = self->source_info.frequency;
+  msg->looped       = suscan_source_has_looped(self->source);
+  msg->history_size = suscan_source_get_current_history_size(self->source);
+  suscan_source_get_time(self->source, &msg->timestamp);
+
+  if (!suscan_mq_write(
+      analyzer->mq_out,
+      SUSCAN_ANALYZER_MESSAGE_TYPE_PSD,
+      msg)) {
+    suscan_analyzer_send_status(
+        analyzer,
+        SUSCAN_ANALYZER_MESSAGE_TYPE_INTERNAL,
+        -1,
+        "Cannot write message: %s",
+        strerror(errno));
+    goto done;
+  }
+
+  /* Message queued, forget about it */
+  msg = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (msg != NULL)
+    suscan_analyzer_dispose_message(SUSCAN_ANALYZER_MESSAGE_TYPE_PSD, msg);
+
+  return ok;
+}
+
+SUPRIVATE SUBOOL
+suscan_local_subsource_psd_wk_cb(
+    struct suscan_mq *mq_out,
+    void *wk_private,
+    void *cb_private)
+{
+  suscan_local_subsource_t *self = (suscan_local_subsource_t *) wk_private;
+  suscan_sample_buffer_t *buffer = (suscan_sample_buffer_t *) cb_private;
+
+  SU_TRY(
+    su_smoothpsd_feed(
+      self->smooth_psd,
+      suscan_sample_buffer_data(buffer),
+      suscan_sample_buffer_size(buffer)));
+
+done:
+  if (!suscan_sample_buffer_pool_give(self->bufpool, buffer))
+    SU_ERROR("Failed to give buffer!\n");
+
+  return SU_FALSE;
+}
+
+SUPRIVATE SUBOOL
+suscan_local_subsource_feed_inspectors(
+    suscan_local_subsource_t *self,
+    const SUCOMPLEX *data,
+    SUSCOUNT size)
+{
+  suscan_local_analyzer_t *owner = self->owner;
+  SUSDIFF got;
+  SUBOOL ok = SU_TRUE;
+
+  if (su_specttuner_get_channel_count(self->stuner) == 0)
+    return SU_TRUE;
+
+  if (pthread_mutex_lock(&owner->sched_mutex) != 0)
+    return SU_FALSE;
+
+  while (size > 0) {
+    if (pthread_mutex_lock(&self->stuner_mutex) != 0) {
+      ok = SU_FALSE;
+      break;
+    }
+
+    got = su_specttuner_feed_bulk_single(self->stuner, data, size);
+
+    if (su_specttuner_new_data(self->stuner)) {
+      suscan_inspector_factory_force_sync(owner->insp_factory);
+      su_specttuner_ack_data(self->stuner);
+    }
+
+    (void) pthread_mutex_unlock(&self->stuner_mutex);
+
+    if (got == -1) {
+      ok = SU_FALSE;
+      break;
+    }
+
+    data += got;
+    size -= got;
+  }
+
+  (void) pthread_mutex_unlock(&owner->sched_mutex);
+
+  return ok;
+}
+
+SUPRIVATE SUBOOL
+suscan_local_subsource_wk_cb(
+    struct suscan_mq *mq_out,
+    void *wk_private,
+    void *cb_private)
+{
+  suscan_local_subsource_t *self = (suscan_local_subsource_t *) wk_private;
+  suscan_analyzer_t *analyzer = self->owner->parent;
+  suscan_sample_buffer_t *buffer = NULL;
+  SUCOMPLEX *samples;
+  SUSDIFF got;
+  SUBOOL restart = SU_FALSE;
+
+  buffer = suscan_source_read_buffer(self->source, self->bufpool, &got);
+  if (buffer == NULL) {
+    /* This is not the end of the analyzer, just of this source */
+    if (!analyzer->halt_requested)
+      suscan_analyzer_send_status(
+          analyzer,
+          SUSCAN_ANALYZER_MESSAGE_TYPE_INTERNAL,
+          got,
+          "Source #%u stopped (read result %d)",
+          self->index,
+          got);
+    goto done;
+  }
+
+  samples = suscan_sample_buffer_data(buffer);
+
+  /* Same as in the primary source: do not let the PSD stall the reader */
+  if (suscan_sample_buffer_pool_free_num(self->bufpool) > 0) {
+    suscan_sample_buffer_inc_ref(buffer);
+    SU_TRY(
+      suscan_worker_push(
+        self->psd_worker,
+        suscan_local_subsource_psd_wk_cb,
+        buffer));
+  }
+
+  SU_TRY(suscan_local_subsource_feed_inspectors(self, samples, got));
+
+  restart = !analyzer->halt_requested;
+
+done:
+  if (buffer != NULL)
+    if (!suscan_sample_buffer_pool_give(self->bufpool, buffer))
+      SU_ERROR("Failed to give buffer!\n");
+
+  return restart;
+}
+
+SU_INSTANCER(
+  suscan_local_subsource,
+  suscan_local_analyzer_t *owner,
+  suscan_source_config_t *config,
+  unsigned int index)
+{
+  suscan_local_subsource_t *new = NULL;
+  struct sigutils_specttuner_params st_params =
+      sigutils_specttuner_params_INITIALIZER;
+  struct sigutils_smoothpsd_params sp_params =
+      sigutils_smoothpsd_params_INITIALIZER;
+  struct suscan_sample_buffer_pool_params bp_params =
+      suscan_sample_buffer_pool_params_INITIALIZER;
+  pthread_mutexattr_t attr;
+
+  SU_ALLOCATE_FAIL(new, suscan_local_subsource_t);
+
+  new->owner = owner;
+  new->index = index;
+
+  SU_MAKE_FAIL(new->source, suscan_source, config);
+  SU_TRY_FAIL(
+    suscan_source_info_init_copy(
+      &new->source_info,
+      suscan_source_get_info(new->source)));
+  new->source_info.source_index = index;
+
+  /* Same tuner sizes as the primary source */
+  if (new->source_info.effective_samp_rate >= 10000000)
+    st_params.window_size = 131072;
+  else if (new->source_info.effective_samp_rate >= 5000000)
+    st_params.window_size = 65536;
+  else if (new->source_info.effective_samp_rate >= 1600000)
+    st_params.window_size = 16384;
+  else if (new->source_info.effective_samp_rate >= 250000)
+    st_params.window_size = 4096;
+  else
+    st_params.window_size = 2048;
+
+  bp_params.alloc_size = st_params.window_size;
+  bp_params.name       = "subsource";
+
+  SU_MAKE_FAIL(new->bufpool, suscan_sample_buffer_pool, &bp_params);
+  SU_TRY_FAIL(new->stuner = su_specttuner_new(&st_params));
+
+  /* Channels may be closed from inside the data callback */
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  SU_TRYZ_FAIL(pthread_mutex_init(&new->stuner_mutex, &attr));
+  new->stuner_init = SU_TRUE;
+
+  sp_params.fft_size     = owner->parent->params.detector_params.window_size;
+  sp_params.samp_rate    = new->source_info.effective_samp_rate;
+  sp_params.refresh_rate = 1. / owner->interval_psd;
+
+  SU_MAKE_FAIL(
+    new->smooth_psd,
+    su_smoothpsd,
+    &sp_params,
+    suscan_local_subsource_on_psd,
+    new);
+
+  SU_TRY_FAIL(
+    new->psd_worker = suscan_worker_new_ex(
+      "subsource-psd-worker",
+      &owner->mq_in,
+      new));
+
+  SU_TRY_FAIL(
+    new->source_wk = suscan_worker_new_ex(
+      "subsource-worker",
+      &owner->mq_in,
+      new));
+
+  return new;
+
+fail:
+  if (new != NULL)
+    suscan_local_subsource_destroy(new);
+
+  return NULL;
+}
+
+SU_METHOD(suscan_local_subsource, SUBOOL, start)
+{
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(suscan_source_start_capture(self->source));
+  self->capturing = SU_TRUE;
+
+  SU_TRY(
+    suscan_worker_push(
+      self->source_wk,
+      suscan_local_subsource_wk_cb,
+      NULL));
+
+  /* Let clients know about the new source */
+  suscan_source_get_time(self->source, &self->source_info.source_time);
+  SU_TRY(
+    suscan_analyzer_send_source_info(
+      self->owner->parent,
+      &self->source_info));
+
+  ok = SU_TRUE;
+
+done:
+  return ok;
+}
+
+/*
+ * Stops all the workers of the subsource. It must be called before
+ * destroying the inspector factory of the analyzer, as the reader worker
+ * delivers samples to it. The spectral tuner is kept alive, as the factory
+ * still holds pointers to its channels.
+ */
+SU_METHOD(suscan_local_subsource, void, stop)
+{
+  if (self->source != NULL)
+    suscan_source_force_eos(self->source);
+
+  if (self->source_wk != NULL) {
+    if (!suscan_analyzer_halt_worker(self->source_wk))
+      SU_ERROR("Subsource worker destruction failed, memory leak ahead\n");
+    self->source_wk = NULL;
+  }
+
+  if (self->psd_worker != NULL) {
+    if (!suscan_analyzer_halt_worker(self->psd_worker)) {
+      SU_ERROR("Subsource PSD worker destruction failed\n");
+
+      /* Mark smoothPSD object as released */
+      self->smooth_psd = NULL;
+    }
+    self->psd_worker = NULL;
+  }
+
+  if (self->capturing) {
+    suscan_source_stop_capture(self->source);
+    self->capturing = SU_FALSE;
+  }
+}
+
+SU_COLLECTOR(suscan_local_subsource)
+{
+  suscan_local_subsource_stop(self);
+
+  if (self->smooth_psd != NULL)
+    su_smoothpsd_destroy(self->smooth_psd);
+
+  if (self->stuner_init)
+    pthread_mutex_destroy(&self->stuner_mutex);
+
+  if (self->stuner != NULL)
+    su_specttuner_destroy(self->stuner);
+
+  if (self->source != NULL)
+    suscan_source_destroy(self->source);
+
+  suscan_source_info_finalize(&self->source_info);
+
+  if (self->bufpool != NULL)
+    suscan_sample_buffer_pool_destroy(self->bufpool);
+
+  free(self);
+}
+
+suscan_local_subsource_t *
+suscan_local_analyzer_get_subsource(
+    suscan_local_analyzer_t *self,
+    unsigned int index)
+{
+  suscan_local_subsource_t *subsource = NULL;
+
+  if (index == 0)
+    return NULL;
+
+  pthread_mutex_lock(&self->subsource_mutex);
+  if (index <= self->subsource_count)
+    subsource = self->subsource_list[index - 1];
+  pthread_mutex_unlock(&self->subsource_mutex);
+
+  return subsource;
+}
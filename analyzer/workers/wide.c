@@ -167,8 +167,6 @@ suscan_source_wide_wk_cb(
       self->read_buf,
       self->read_size)) > 0) {
 
-    if (self->iq_rev)
-      suscan_analyzer_do_iq_rev(self->read_buf, got);
     self->fft_samples += got;
 
     if (self->fft_samples > self->current_sweep_params.fft_min_samples +
@@ -188,9 +186,25 @@ suscan_source_wide_wk_cb(
        */
 
       if (su_channel_detector_get_iters(self->detector) > 0) {
-        SU_TRYCATCH(
-            suscan_analyzer_send_psd(self->parent, self->detector),
-            goto done);
+        if (self->panorama == NULL
+          || suscan_panorama_hop_psd_enabled(self->panorama))
+          SU_TRYCATCH(
+              suscan_analyzer_send_psd(self->parent, self->detector),
+              goto done);
+
+        if (self->panorama != NULL) {
+          SU_TRYCATCH(
+              suscan_panorama_feed_detector(
+                  self->panorama,
+                  self->curr_freq,
+                  self->current_sweep_params.rel_bw,
+                  self->detector),
+              goto done);
+
+          SU_TRYCATCH(
+              suscan_panorama_update(self->panorama, self->parent),
+              goto done);
+        }
 
         self->fft_samples = 0;
         su_channel_detector_rewind(self->detector);
@@ -255,6 +269,69 @@ done:
   return restart;
 }
 
+SUBOOL
+suscan_local_analyzer_set_panorama_params(
+    suscan_local_analyzer_t *self,
+    const struct suscan_analyzer_panorama_params *params)
+{
+  struct suscan_analyzer_panorama_params actual = *params;
+  suscan_panorama_t *panorama = NULL;
+  SUBOOL mutex_acquired = SU_FALSE;
+  SUBOOL ok = SU_FALSE;
+
+  SU_TRY(suscan_local_analyzer_lock_loop(self));
+  mutex_acquired = SU_TRUE;
+
+  if (actual.enabled) {
+    /* No explicit range: cover the current sweep range */
+    if (actual.max_freq <= actual.min_freq) {
+      actual.min_freq = self->current_sweep_params.min_freq;
+      actual.max_freq = self->current_sweep_params.max_freq;
+    }
+
+    SU_MAKE(
+      panorama,
+      suscan_panorama,
+      &actual,
+      ++self->panorama_epoch);
+  }
+
+  /* Replace the current panorama. Clients will get a new keyframe */
+  if (self->panorama != NULL)
+    suscan_panorama_destroy(self->panorama);
+
+  self->panorama = panorama;
+  panorama = NULL;
+
+  ok = SU_TRUE;
+
+done:
+  if (mutex_acquired)
+    (void) suscan_local_analyzer_unlock_loop(self);
+
+  if (panorama != NULL)
+    suscan_panorama_destroy(panorama);
+
+  return ok;
+}
+
+SUBOOL
+suscan_local_analyzer_req_panorama_keyframe(
+    suscan_local_analyzer_t *self,
+    uint32_t epoch)
+{
+  SU_TRYCATCH(suscan_local_analyzer_lock_loop(self), return SU_FALSE);
+
+  /* Panoramas of older epochs were replaced (and sent whole) already */
+  if (self->panorama != NULL
+    && suscan_panorama_epoch(self->panorama) == epoch)
+    suscan_panorama_request_keyframe(self->panorama);
+
+  suscan_local_analyzer_unlock_loop(self);
+
+  return SU_TRUE;
+}
+
 SUPRIVATE void
 suscan_local_analyzer_init_detector_params(
     suscan_local_analyzer_t *self,
@@ -24,6 +24,10 @@
 #include <util/confdb.h>
 #include <util/compat.h>
 #include <string.h>
+#include <signal.h>
+#ifdef __unix__
+#  include <unistd.h>
+#endif /* __unix__ */
 
 #include <cli/cli.h>
 #include <cli/cmds.h>
@@ -33,6 +37,40 @@ suscan_source_config_t *ui_config;
 PTR_LIST_PRIVATE(suscan_source_config_t, cli_config);
 
 SUPRIVATE uint32_t init_mask = 0;
+SUPRIVATE volatile sig_atomic_t g_halt_requested = 0;
+
+void
+suscli_request_halt(void)
+{
+  g_halt_requested = 1;
+}
+
+SUBOOL
+suscli_halt_requested(void)
+{
+  return g_halt_requested != 0;
+}
+
+#ifdef __unix__
+/* Only async-signal-safe things here. A second signal exits right away */
+SUPRIVATE void
+suscli_halt_signal_handler(int sig)
+{
+  if (g_halt_requested)
+    _exit(1);
+
+  g_halt_requested = 1;
+}
+#endif /* __unix__ */
+
+void
+suscli_handle_halt_signals(void)
+{
+#ifdef __unix__
+  signal(SIGINT, suscli_halt_signal_handler);
+  signal(SIGTERM, suscli_halt_signal_handler);
+#endif /* __unix__ */
+}
 
 suscan_source_config_t *
 suscli_get_source(unsigned int id)
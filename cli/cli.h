@@ -104,4 +104,14 @@ suscan_source_config_t *suscli_resolve_profile(const char *spec);
 SUBOOL suscli_init(void);
 void suscli_log_init(void);
 
+/*
+ * Termination requests (SIGINT, SIGTERM). Requesting a halt is
+ * async-signal-safe. Long-running commands that poll the flag to shut
+ * down gracefully call suscli_handle_halt_signals() first, the rest
+ * keep the default signal disposition.
+ */
+void   suscli_request_halt(void);
+SUBOOL suscli_halt_requested(void);
+void   suscli_handle_halt_signals(void);
+
 #endif /* _SUSCLI_CLI_H */
@@ -27,6 +27,8 @@
 #include <util/confdb.h>
 #include <sigutils/log.h>
 #include <analyzer/analyzer.h>
+#include <analyzer/inspector/inspector.h>
+#include <suscan.h>
 #include <analyzer/version.h>
 #include <analyzer/device/impl/multicast.h>
 #include <string.h>
@@ -37,6 +39,7 @@
 #include <cli/cmds.h>
 
 #define SUSCLI_DEVSERV_DEFAULT_PORT_BASE 28000
+#define SUSCLI_DEVSERV_STATS_INTERVAL    60 /* Seconds */
 SUPRIVATE SUBOOL su_log_cr = SU_TRUE;
 
 SUPRIVATE void
@@ -179,7 +182,8 @@ SUPRIVATE struct suscli_devserv_ctx *
 suscli_devserv_ctx_new(
     const char *iface,
     const char *mcaddr,
-    size_t compress_threshold)
+    size_t compress_threshold,
+    const struct suscan_remote_compression_params *compression)
 {
   struct suscli_devserv_ctx *new = NULL;
   suscan_source_config_t *cfg;
@@ -252,6 +256,7 @@ suscli_devserv_ctx_new(
   new->mc_addr.sin_port = htons(SURPC_DISCOVERY_PROTOCOL_PORT);
 
   params.compress_threshold = compress_threshold;
+  params.compression        = *compression;
   params.ifname             = iface;
 
   /* Populate servers */
@@ -369,8 +374,11 @@ SUBOOL
 suscli_devserv_cb(const hashlist_t *params)
 {
   struct suscli_devserv_ctx *ctx = NULL;
-  const char *iface, *mc;
+  struct suscan_remote_compression_params compression =
+    suscan_remote_compression_params_INITIALIZER;
+  const char *iface, *mc, *codec, *record_dir;
   int threshold = 0;
+  unsigned int i, ticks = 0;
 
   pthread_t thread;
   SUBOOL thread_running = SU_FALSE;
@@ -390,6 +398,36 @@ suscli_devserv_cb(const hashlist_t *params)
         0),
       goto done);
 
+  SU_TRYCATCH(
+      suscli_param_read_string(params, "compression", &codec, "zlib"),
+      goto done);
+
+  SU_TRYCATCH(
+      suscli_param_read_int(
+        params,
+        "compress_level",
+        &compression.level,
+        SUSCAN_REMOTE_COMPRESSION_DEFAULT_LEVEL),
+      goto done);
+
+  SU_TRYCATCH(
+      suscli_param_read_string(params, "record_dir", &record_dir, NULL),
+      goto done);
+
+  if (!suscan_remote_compression_from_string(codec, &compression.codec)) {
+    fprintf(stderr, "devserv: unknown compression codec `%s'\n", codec);
+    goto done;
+  }
+
+  if (!suscan_remote_compression_params_is_valid(&compression)) {
+    fprintf(
+      stderr,
+      "devserv: compression `%s' (level %d) not supported by this build\n",
+      codec,
+      compression.level);
+    goto done;
+  }
+
   if (iface == NULL) {
     fprintf(
         stderr,
@@ -433,17 +471,28 @@ suscli_devserv_cb(const hashlist_t *params)
           SURPC_DISCOVERY_MULTICAST_ADDR),
       goto done);
 
+  /* Clients cannot choose where channel recordings are written */
+  SU_TRYCATCH(
+      suscan_raw_inspector_restrict_recordings(record_dir),
+      goto done);
+
   SU_INFO("Suscan device server %s\n", SUSCAN_VERSION_STRING);
   SU_INFO(
     "SuRPC protocol version: %d.%d\n",
     SUSCAN_REMOTE_PROTOCOL_MAJOR_VERSION,
     SUSCAN_REMOTE_PROTOCOL_MINOR_VERSION);
 
+  if (record_dir != NULL)
+    SU_INFO("Channel recordings are saved under %s\n", record_dir);
+  else
+    SU_INFO("Channel recordings disabled (enable them with record_dir=)\n");
+
   SU_TRYCATCH(
       ctx = suscli_devserv_ctx_new(
         iface, 
         mc, 
-        threshold),
+        threshold,
+        &compression),
       goto done);
 
   SU_TRYCATCH(
@@ -451,9 +500,22 @@ suscli_devserv_cb(const hashlist_t *params)
       goto done);
   thread_running = SU_TRUE;
 
-  for (;;)
+  suscli_handle_halt_signals();
+
+  while (!suscli_halt_requested()) {
     sleep(1);
 
+    /* Plans keep being created while clients come and go */
+    if (!suscan_sync_fft_wisdom(SU_FALSE))
+      SU_WARNING("Failed to save FFT wisdom\n");
+
+    if (++ticks % SUSCLI_DEVSERV_STATS_INTERVAL == 0)
+      for (i = 0; i < ctx->server_count; ++i)
+        suscli_analyzer_server_report_stats(ctx->server_list[i]);
+  }
+
+  SU_INFO("Termination requested, shutting down\n");
+
   ok = SU_TRUE;
 
 done:
@@ -32,12 +32,19 @@
 
 /************************** Analyzer Client API *******************************/
 suscli_analyzer_client_t *
-suscli_analyzer_client_new(int sfd, unsigned int compress_threshold)
+suscli_analyzer_client_new(
+    int sfd,
+    unsigned int compress_threshold,
+    const struct suscan_remote_compression_params *compression)
 {
   struct sockaddr_in sin;
   struct suscan_analyzer_params params = suscan_analyzer_params_INITIALIZER;
+  struct suscan_psd_codec_params codec = suscan_psd_codec_params_INITIALIZER;
+  struct suscan_sample_codec_params sample_codec =
+    suscan_sample_codec_params_INITIALIZER;
   socklen_t len = sizeof(struct sockaddr_in);
   suscli_analyzer_client_t *new = NULL;
+  unsigned int i;
 #ifdef SO_NOSIGPIPE
   int set = 1;
 #endif /* SO_NOSIGPIPE */
@@ -46,7 +53,13 @@ suscli_analyzer_client_new(int sfd, unsigned int compress_threshold)
   SU_TRYCATCH(new->inspectors.inspector_tree = rbtree_new(), goto fail);
 
   new->analyzer_params = params;
+  new->psd_codec       = codec;
+  new->sample_codec    = sample_codec;
   new->sfd   = -1;
+
+  for (i = 0; i < SUSCAN_PSD_STREAM_MAX; ++i)
+    suscan_psd_stream_init(new->psd_streams + i);
+
   rbtree_set_dtor(new->inspectors.inspector_tree, rbtree_node_free_dtor, NULL);
   
   SU_TRYCATCH(
@@ -79,7 +92,8 @@ suscli_analyzer_client_new(int sfd, unsigned int compress_threshold)
       suscli_analyzer_client_tx_thread_initialize(
         &new->tx, 
         sfd,
-        compress_threshold),
+        compress_threshold,
+        compression),
       goto fail);
 
   SU_MAKE_FAIL(new->req_table, rbtree);
@@ -649,6 +663,17 @@ suscli_analyzer_client_intercept_message(
           goto done;
         }
         break;
+
+      case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA_PARAMS:
+        if (!suscli_analyzer_client_test_permission(
+          self,
+          SUSCAN_ANALYZER_PERM_SET_PANORAMA)) {
+          SU_WARNING(
+            "%s: client not allowed to configure the panorama\n",
+            suscli_analyzer_client_get_name(self));
+          goto done;
+        }
+        break;
     }
   }
 
@@ -758,6 +783,89 @@ done:
   return ok;
 }
 
+SUPRIVATE struct suscan_analyzer_psd_msg *
+suscli_analyzer_call_get_psd_msg(const struct suscan_analyzer_remote_call *call)
+{
+  if (call->type != SUSCAN_ANALYZER_REMOTE_MESSAGE
+    || call->msg.type != SUSCAN_ANALYZER_MESSAGE_TYPE_PSD)
+    return NULL;
+
+  return (struct suscan_analyzer_psd_msg *) call->msg.ptr;
+}
+
+SUPRIVATE SUBOOL
+suscli_analyzer_client_uses_psd_deltas(
+    const suscli_analyzer_client_t *self,
+    const struct suscan_analyzer_remote_call *call)
+{
+  const struct suscan_analyzer_psd_msg *psd;
+
+  if ((psd = suscli_analyzer_call_get_psd_msg(call)) == NULL)
+    return SU_FALSE;
+
+  return suscan_psd_codec_params_has_deltas(&self->psd_codec)
+      && psd->source_index < SUSCAN_PSD_STREAM_MAX;
+}
+
+/*
+ * Serializes a call the way this client expects it. For now, this only
+ * means PSD messages in the encoding negotiated during authentication.
+ * Delta-coded PSDs advance the stream of the client, so the result must
+ * be delivered to it. If segments is not NULL, large PSD arrays may be
+ * referenced instead of copied into pdu (see serialize.h).
+ */
+SUPRIVATE SUBOOL
+suscli_analyzer_client_serialize_call_segmented(
+    suscli_analyzer_client_t *self,
+    const struct suscan_analyzer_remote_call *call,
+    grow_buf_t *pdu,
+    struct suscan_pdu_segments *segments)
+{
+  struct suscan_analyzer_psd_msg *psd;
+  struct suscan_psd_codec_params codec = suscan_psd_codec_params_INITIALIZER;
+  unsigned int i;
+  SUBOOL ok;
+
+  /* Frames were lost in the TX queue: start over with keyframes */
+  if (suscli_analyzer_client_tx_thread_take_psd_resync(&self->tx)) {
+    for (i = 0; i < SUSCAN_PSD_STREAM_MAX; ++i)
+      suscan_psd_stream_reset(self->psd_streams + i);
+  }
+
+  if ((psd = suscli_analyzer_call_get_psd_msg(call)) != NULL) {
+    psd->codec         = self->psd_codec;
+    psd->little_endian = self->le_arrays;
+    if (suscli_analyzer_client_uses_psd_deltas(self, call))
+      psd->stream = self->psd_streams + psd->source_index;
+    else
+      psd->segments = segments;
+  }
+
+  ok = suscan_analyzer_remote_call_serialize(call, pdu);
+
+  if (psd != NULL) {
+    psd->codec         = codec;
+    psd->little_endian = SU_FALSE;
+    psd->stream        = NULL;
+    psd->segments      = NULL;
+  }
+
+  return ok;
+}
+
+SUBOOL
+suscli_analyzer_client_serialize_call(
+    suscli_analyzer_client_t *self,
+    const struct suscan_analyzer_remote_call *call,
+    grow_buf_t *pdu)
+{
+  return suscli_analyzer_client_serialize_call_segmented(
+    self,
+    call,
+    pdu,
+    NULL);
+}
+
 SUBOOL
 suscli_analyzer_client_deliver_call(
     suscli_analyzer_client_t *self,
@@ -767,7 +875,7 @@ suscli_analyzer_client_deliver_call(
   SUBOOL ok = SU_FALSE;
 
   SU_TRYCATCH(
-      suscan_analyzer_remote_call_serialize(call, &pdu),
+      suscli_analyzer_client_serialize_call(self, call, &pdu),
       goto done);
 
   SU_TRYCATCH(suscli_analyzer_client_write_buffer(self, &pdu), goto done);
@@ -871,6 +979,8 @@ done:
 void
 suscli_analyzer_client_destroy(suscli_analyzer_client_t *self)
 {
+  unsigned int i;
+
   suscli_analyzer_client_tx_thread_finalize(&self->tx);
 
   if (self->sfd != -1 && !self->closed)
@@ -887,6 +997,9 @@ suscli_analyzer_client_destroy(suscli_analyzer_client_t *self)
   suscan_analyzer_server_hello_finalize(&self->server_hello);
   suscan_analyzer_remote_call_finalize(&self->incoming_call);
 
+  for (i = 0; i < SUSCAN_PSD_STREAM_MAX; ++i)
+    suscan_psd_stream_finalize(self->psd_streams + i);
+
   if (self->inspectors.inspector_tree != NULL)
     rbtree_destroy(self->inspectors.inspector_tree);
 
@@ -958,11 +1071,27 @@ done:
   return ok;
 }
 
+SUPRIVATE void
+suscli_analyzer_client_list_get_compression_stats_unsafe(
+    const struct suscli_analyzer_client_list *self,
+    struct suscan_remote_compressor_stats *stats)
+{
+  unsigned int i;
+
+  *stats = self->compression_stats;
+
+  for (i = 0; i < SUSCAN_REMOTE_COMPRESSION_COUNT; ++i)
+    suscan_remote_compressor_stats_add(
+      stats,
+      &self->broadcast_compressors[i].stats);
+}
+
 SUPRIVATE SUBOOL
 suscli_analyzer_client_list_cleanup_unsafe(
     struct suscli_analyzer_client_list *self)
 {
   suscli_analyzer_client_t *client;
+  struct suscan_remote_compressor_stats stats;
   struct rbtree_node *this;
   SUBOOL changed = SU_FALSE;
 
@@ -984,6 +1113,21 @@ suscli_analyzer_client_list_cleanup_unsafe(
             "%s: client removed from list (%d outstanding clients)\n",
             suscli_analyzer_client_get_name(client),
             self->client_count);
+
+        /* Server totals are reported periodically by devserv */
+        suscli_analyzer_client_tx_thread_get_compression_stats(
+            &client->tx,
+            &stats);
+        if (stats.pdus > 0) {
+          suscan_remote_compressor_stats_add(&self->compression_stats, &stats);
+          SU_INFO(
+              "%s: %lu PDUs compressed, ratio %.2f, %.1f us/PDU\n",
+              suscli_analyzer_client_get_name(client),
+              (unsigned long) stats.pdus,
+              suscan_remote_compressor_stats_get_ratio(&stats),
+              1e-3 * stats.time_ns / stats.pdus);
+        }
+
         suscli_analyzer_client_destroy(client);
         changed = SU_TRUE;
       }
@@ -1182,6 +1326,32 @@ suscli_analyzer_client_list_alloc_global_id_unsafe(
   return randn;
 }
 
+/*
+ * Compression stats of the whole server: removed clients, live clients
+ * and PDUs compressed once for several clients.
+ */
+void
+suscli_analyzer_client_list_get_compression_stats(
+  struct suscli_analyzer_client_list *self,
+  struct suscan_remote_compressor_stats *stats)
+{
+  struct suscan_remote_compressor_stats client_stats;
+  suscli_analyzer_client_t *this;
+
+  (void) pthread_mutex_lock(&self->client_mutex);
+
+  suscli_analyzer_client_list_get_compression_stats_unsafe(self, stats);
+
+  for (this = self->client_head; this != NULL; this = this->next) {
+    suscli_analyzer_client_tx_thread_get_compression_stats(
+      &this->tx,
+      &client_stats);
+    suscan_remote_compressor_stats_add(stats, &client_stats);
+  }
+
+  (void) pthread_mutex_unlock(&self->client_mutex);
+}
+
 uint32_t
 suscli_analyzer_client_list_alloc_global_id(
   struct suscli_analyzer_client_list *self)
@@ -1323,10 +1493,141 @@ done:
   return ok;
 }
 
+/*
+ * Clients negotiating different PSD encodings (or array byte orders)
+ * need different PDUs. Every distinct encoding in use is serialized once
+ * per broadcast, and then compressed once per compression setting in
+ * use. PSDs sent as deltas depend on the state of each client and are
+ * never shared, and calls other than PSDs are the same for everyone.
+ */
+struct suscli_analyzer_pdu_variant {
+  struct suscan_psd_codec_params codec;
+  SUBOOL                         le_arrays;
+  suscli_analyzer_shared_pdu_t  *pdu;
+};
+
+SUPRIVATE SUBOOL
+suscli_analyzer_client_list_is_unicast_target(
+    const struct suscli_analyzer_client_list *self,
+    const suscli_analyzer_client_t *client)
+{
+  SUBOOL unicast = !(self->mc_manager != NULL
+    && suscli_analyzer_client_accepts_multicast(client));
+
+  return suscli_analyzer_client_can_write(client)
+    && suscli_analyzer_client_has_source_info(client)
+    && unicast;
+}
+
+SUPRIVATE suscli_analyzer_shared_pdu_t *
+suscli_analyzer_client_list_find_pdu(
+    const struct suscli_analyzer_pdu_variant *variants,
+    unsigned int count,
+    const suscli_analyzer_client_t *client,
+    const struct suscan_analyzer_remote_call *call)
+{
+  const struct suscan_psd_codec_params *codec;
+  SUBOOL le_arrays;
+  unsigned int i;
+
+  if (suscli_analyzer_call_get_psd_msg(call) == NULL)
+    return count > 0 ? variants[0].pdu : NULL;
+
+  codec     = suscli_analyzer_client_get_psd_codec(client);
+  le_arrays = suscli_analyzer_client_accepts_le_arrays(client);
+
+  for (i = 0; i < count; ++i)
+    if (suscan_psd_codec_params_equal(&variants[i].codec, codec)
+      && variants[i].le_arrays == le_arrays)
+      return variants[i].pdu;
+
+  return NULL;
+}
+
+/*
+ * Builds the shared PDU this client will receive, compressed the way it
+ * expects. This happens before any of them is queued, as queued PDUs
+ * are read concurrently by the tx threads.
+ */
+SUPRIVATE SUBOOL
+suscli_analyzer_client_list_prepare_pdu_unsafe(
+    struct suscli_analyzer_client_list *self,
+    struct suscli_analyzer_pdu_variant *variants,
+    unsigned int *count,
+    suscli_analyzer_client_t *client,
+    const struct suscan_analyzer_remote_call *call)
+{
+  struct suscan_remote_compression_params params;
+  struct suscan_remote_compressor *compressor;
+  suscli_analyzer_shared_pdu_t *shared;
+  struct suscan_pdu_segments segments;
+  struct suscan_pdu_segments *segments_ptr = &segments;
+  grow_buf_t pdu = grow_buf_INITIALIZER;
+  unsigned int i;
+  SUBOOL ok = SU_FALSE;
+
+  suscan_pdu_segments_clear(&segments);
+
+  /* Delta frames are serialized right before queuing them */
+  if (suscli_analyzer_client_uses_psd_deltas(client, call))
+    return SU_TRUE;
+
+  shared = suscli_analyzer_client_list_find_pdu(
+    variants,
+    *count,
+    client,
+    call);
+
+  if (shared == NULL) {
+    /* Too many encodings in use: serialized just for this client */
+    if (*count == SUSCLI_ANALYZER_CLIENT_LIST_MAX_PDU_VARIANTS)
+      return SU_TRUE;
+
+    /* Only one variant may keep the message, and hence reference it */
+    for (i = 0; i < *count; ++i)
+      if (suscli_analyzer_shared_pdu_is_segmented(variants[i].pdu))
+        segments_ptr = NULL;
+
+    SU_TRY(
+      suscli_analyzer_client_serialize_call_segmented(
+        client,
+        call,
+        &pdu,
+        segments_ptr));
+    SU_TRY(shared = suscli_analyzer_shared_pdu_new(&pdu, segments_ptr));
+    SU_REF(shared, broadcast);
+
+    variants[*count].codec = *suscli_analyzer_client_get_psd_codec(client);
+    variants[*count].le_arrays =
+      suscli_analyzer_client_accepts_le_arrays(client);
+    variants[(*count)++].pdu = shared;
+  }
+
+  if (suscli_analyzer_client_tx_thread_wants_compression(
+    &client->tx,
+    suscli_analyzer_shared_pdu_get_size(shared))) {
+    suscli_analyzer_client_tx_thread_get_compression(&client->tx, &params);
+    compressor = self->broadcast_compressors + params.codec;
+
+    if (compressor->params.codec != params.codec
+      || compressor->params.level != params.level)
+      SU_TRY(suscan_remote_compressor_set_params(compressor, &params));
+
+    SU_TRY(suscli_analyzer_shared_pdu_compress(shared, compressor));
+  }
+
+  ok = SU_TRUE;
+
+done:
+  grow_buf_finalize(&pdu);
+
+  return ok;
+}
+
 SUBOOL
 suscli_analyzer_client_list_broadcast_unsafe(
     struct suscli_analyzer_client_list *self,
-    const struct suscan_analyzer_remote_call *call,
+    struct suscan_analyzer_remote_call *call,
     SUBOOL (*on_client_error) (
         suscli_analyzer_client_t *client,
         void *userdata,
@@ -1334,45 +1635,80 @@ suscli_analyzer_client_list_broadcast_unsafe(
     void *userdata)
 {
   suscli_analyzer_client_t *this;
+  struct suscli_analyzer_pdu_variant
+    variants[SUSCLI_ANALYZER_CLIENT_LIST_MAX_PDU_VARIANTS];
+  unsigned int variant_count = 0;
   grow_buf_t pdu = grow_buf_INITIALIZER;
-  SUBOOL mc_enabled = self->mc_manager != NULL;
-  SUBOOL unicast;
+  suscli_analyzer_shared_pdu_t *shared;
+  SUBOOL queued;
+  unsigned int i;
   int error;
   SUBOOL ok = SU_FALSE;
 
+  memset(variants, 0, sizeof(variants));
+
   /* Step 1: If multicast is enabled, chop and send via multicast */
-  if (mc_enabled)
+  if (self->mc_manager != NULL)
     SU_TRY(suscli_multicast_manager_deliver_call(self->mc_manager, call));
 
-  /* Step 2: For non-multicast clients, make a normal PDU and send */
-  SU_TRYCATCH(
-    suscan_analyzer_remote_call_serialize(call, &pdu),
-    goto done);
-
-  this = self->client_head;  
-  while (this != NULL) {
-    unicast = 
-      !(mc_enabled && suscli_analyzer_client_accepts_multicast(this));
-
-    if (suscli_analyzer_client_can_write(this)
-        && suscli_analyzer_client_has_source_info(this)
-        && unicast) {
-      if (!suscli_analyzer_client_write_buffer(this, &pdu)) {
-        error = errno;
-        SU_WARNING(
-            "%s: write failed (%s)\n",
-            suscli_analyzer_client_get_name(this),
-            strerror(error));
-        SU_TRYCATCH((on_client_error) (this, userdata, error), goto done);
-      }
+  /* Step 2: Serialize and compress the PDUs shared by unicast clients */
+  for (this = self->client_head; this != NULL; this = this->next)
+    if (suscli_analyzer_client_list_is_unicast_target(self, this))
+      SU_TRY(
+        suscli_analyzer_client_list_prepare_pdu_unsafe(
+          self,
+          variants,
+          &variant_count,
+          this,
+          call));
+
+  /* Step 3: Queue them, along with the PDUs that could not be shared */
+  for (this = self->client_head; this != NULL; this = this->next) {
+    if (!suscli_analyzer_client_list_is_unicast_target(self, this))
+      continue;
+
+    shared = NULL;
+    if (!suscli_analyzer_client_uses_psd_deltas(this, call))
+      shared = suscli_analyzer_client_list_find_pdu(
+        variants,
+        variant_count,
+        this,
+        call);
+
+    if (shared != NULL) {
+      queued = suscli_analyzer_client_tx_thread_push_shared(&this->tx, shared);
+    } else {
+      SU_TRY(suscli_analyzer_client_serialize_call(this, call, &pdu));
+      queued = suscli_analyzer_client_write_buffer_zerocopy(this, &pdu);
+      grow_buf_clear(&pdu);
     }
 
-    this = this->next;
+    if (!queued) {
+      error = errno;
+      SU_WARNING(
+          "%s: write failed (%s)\n",
+          suscli_analyzer_client_get_name(this),
+          strerror(error));
+      SU_TRYCATCH((on_client_error) (this, userdata, error), goto done);
+    }
   }
 
   ok = SU_TRUE;
 
 done:
+  /* Segmented PDUs reference the message, which must outlive them */
+  for (i = 0; i < variant_count; ++i)
+    if (suscli_analyzer_shared_pdu_is_segmented(variants[i].pdu)) {
+      suscli_analyzer_shared_pdu_keep_message(
+        variants[i].pdu,
+        call->msg.type,
+        call->msg.ptr);
+      call->msg.ptr = NULL;
+    }
+
+  for (i = 0; i < variant_count; ++i)
+    SU_DEREF(variants[i].pdu, broadcast);
+
   grow_buf_finalize(&pdu);
 
   return ok;
@@ -1503,6 +1839,7 @@ void
 suscli_analyzer_client_list_finalize(struct suscli_analyzer_client_list *self)
 {
   suscli_analyzer_client_t *this, *next;
+  unsigned int i;
 
   if (self->client_mutex_initialized)
     pthread_mutex_destroy(&self->client_mutex);
@@ -1529,6 +1866,9 @@ suscli_analyzer_client_list_finalize(struct suscli_analyzer_client_list *self)
 
   if (self->req_tree != NULL)
     rbtree_destroy(self->req_tree);
+
+  for (i = 0; i < SUSCAN_REMOTE_COMPRESSION_COUNT; ++i)
+    suscan_remote_compressor_finalize(self->broadcast_compressors + i);
   
   memset(self, 0, sizeof(struct suscli_analyzer_client_list));
 }
@@ -23,6 +23,7 @@
 #include <sigutils/util/compat-unistd.h>
 #include <analyzer/impl/remote.h>
 #include <util/rbtree.h>
+#include <util/com.h>
 #include <util/hashlist.h>
 #include <sigutils/util/compat-inet.h>
 
@@ -63,11 +64,122 @@ struct suscli_analyzer_client_inspector_list {
 
 #define SUSCLI_ANALYZER_CLIENT_TX_MESSAGE 0
 #define SUSCLI_ANALYZER_CLIENT_TX_CANCEL  1
+#define SUSCLI_ANALYZER_CLIENT_TX_SHARED  2
 
 #define SUSCLI_ANALYZER_CLIENT_TX_CLEANUP_WATERMARK 50
 
+/* Hysteresis of the stalled client detection, in queued PDUs */
+#define SUSCLI_ANALYZER_CLIENT_TX_STALL_HIGH_WATERMARK 40
+#define SUSCLI_ANALYZER_CLIENT_TX_STALL_LOW_WATERMARK  10
+
+/* How queued PDUs are treated when the tx queue must be cleaned up */
+enum suscli_analyzer_pdu_class {
+  SUSCLI_ANALYZER_PDU_CLASS_CRITICAL,
+  SUSCLI_ANALYZER_PDU_CLASS_SOURCE_INFO,
+  SUSCLI_ANALYZER_PDU_CLASS_PSD,
+  SUSCLI_ANALYZER_PDU_CLASS_PANORAMA,
+  SUSCLI_ANALYZER_PDU_CLASS_DISCARDABLE
+};
+
+enum suscli_analyzer_pdu_class suscli_analyzer_pdu_classify(
+  grow_buf_t *pdu);
+
+/*
+ * Broadcast PDUs are serialized (and compressed, once per codec in use)
+ * a single time and queued by reference in the tx queue of every client.
+ * They are immutable once queued: tx threads only read them, and release
+ * them with SU_DEREF.
+ */
+#define SUSCLI_ANALYZER_SHARED_PDU_MAX_VARIANTS 4
+
+struct suscli_analyzer_shared_pdu_variant {
+  struct suscan_remote_compression_params params;
+  uint32_t   magic;
+  grow_buf_t data;
+};
+
+struct suscli_analyzer_shared_pdu {
+  SUSCAN_REFCOUNT; /* Must be the first field */
+
+  enum suscli_analyzer_pdu_class pdu_class;
+  grow_buf_t pdu;
+
+  /* Arrays sent from the message itself, which is kept until destruction */
+  struct suscan_pdu_segments segments;
+  uint32_t msg_type;
+  void    *msg;
+
+  struct suscli_analyzer_shared_pdu_variant
+    variants[SUSCLI_ANALYZER_SHARED_PDU_MAX_VARIANTS];
+  unsigned int variant_count;
+};
+
+typedef struct suscli_analyzer_shared_pdu suscli_analyzer_shared_pdu_t;
+
+/*
+ * Takes the contents of pdu, along with its segments (if not NULL). The
+ * result has no references.
+ */
+suscli_analyzer_shared_pdu_t *suscli_analyzer_shared_pdu_new(
+  grow_buf_t *pdu,
+  const struct suscan_pdu_segments *segments);
+
+SUINLINE SUBOOL
+suscli_analyzer_shared_pdu_is_segmented(const suscli_analyzer_shared_pdu_t *self)
+{
+  return self->segments.count > 0;
+}
+
+SUINLINE size_t
+suscli_analyzer_shared_pdu_get_size(const suscli_analyzer_shared_pdu_t *self)
+{
+  return grow_buf_get_size(&self->pdu) + self->segments.size;
+}
+
+/* Takes ownership of the message referenced by the segments */
+void suscli_analyzer_shared_pdu_keep_message(
+  suscli_analyzer_shared_pdu_t *self,
+  uint32_t type,
+  void *msg);
+
+/*
+ * Adds a variant compressed with compressor, unless already present.
+ * Clients whose variant did not fit are compressed by their tx thread.
+ */
+SUBOOL suscli_analyzer_shared_pdu_compress(
+  suscli_analyzer_shared_pdu_t *self,
+  struct suscan_remote_compressor *compressor);
+
+const struct suscli_analyzer_shared_pdu_variant *
+suscli_analyzer_shared_pdu_get_variant(
+  const suscli_analyzer_shared_pdu_t *self,
+  const struct suscan_remote_compression_params *params);
+
+void suscli_analyzer_shared_pdu_destroy(suscli_analyzer_shared_pdu_t *self);
+
+/* Queued PDUs coalesced into a single write */
+#define SUSCLI_ANALYZER_CLIENT_TX_BATCH_MAX      32
+#define SUSCLI_ANALYZER_CLIENT_TX_BATCH_MAX_SIZE (1 << 20)
+
+struct suscli_analyzer_client_tx_batch_entry {
+  uint32_t          type; /* Queue entry, released once sent */
+  void             *data;
+  struct suscan_analyzer_remote_pdu_header header; /* Network byte order */
+  const grow_buf_t *body;
+  const struct suscan_pdu_segments *segments; /* Of body, if any */
+  grow_buf_t        compressed; /* Kept between batches */
+};
+
 struct suscli_analyzer_client_tx_thread {
   unsigned int      compress_threshold;
+  struct suscan_remote_compressor compressor; /* TX thread only */
+
+  /* Protected by compression_mutex */
+  pthread_mutex_t   compression_mutex;
+  SUBOOL            compression_mutex_initialized;
+  struct suscan_remote_compression_params compression;
+  struct suscan_remote_compressor_stats   compression_stats;
+
   struct suscan_mq  pool;
   SUBOOL            pool_initialized;
   struct suscan_mq  queue;
@@ -78,6 +190,19 @@ struct suscli_analyzer_client_tx_thread {
   SUBOOL            thread_cancelled;
   SUBOOL            thread_finished;
   SUBOOL            thread_running;
+
+  /* Protected by resync_mutex (set by queue cleanup, read by the server) */
+  pthread_mutex_t   resync_mutex;
+  SUBOOL            resync_mutex_initialized;
+  SUBOOL            psd_resync; /* PSDs were discarded, client is out of sync */
+  SUBOOL            panorama_resync; /* Same, for panorama updates */
+
+  /* TX thread only */
+  struct suscli_analyzer_client_tx_batch_entry
+                    batch[SUSCLI_ANALYZER_CLIENT_TX_BATCH_MAX];
+  unsigned int      batch_count;
+  size_t            batch_size;
+  grow_buf_t        flat; /* Segmented PDUs, flattened for compression */
 };
 
 void suscli_analyzer_client_tx_thread_stop(
@@ -97,10 +222,41 @@ SUBOOL suscli_analyzer_client_tx_thread_push_zerocopy(
     struct suscli_analyzer_client_tx_thread *self,
     grow_buf_t *pdu);
 
+SUBOOL suscli_analyzer_client_tx_thread_push_shared(
+    struct suscli_analyzer_client_tx_thread *self,
+    suscli_analyzer_shared_pdu_t *pdu);
+
+SUINLINE SUBOOL
+suscli_analyzer_client_tx_thread_wants_compression(
+    const struct suscli_analyzer_client_tx_thread *self,
+    size_t size)
+{
+  return self->compress_threshold > 0 && size > self->compress_threshold;
+}
+
+void suscli_analyzer_client_tx_thread_get_compression(
+    struct suscli_analyzer_client_tx_thread *self,
+    struct suscan_remote_compression_params *params);
+
+SUBOOL suscli_analyzer_client_tx_thread_set_compression(
+    struct suscli_analyzer_client_tx_thread *self,
+    const struct suscan_remote_compression_params *params);
+
+SUBOOL suscli_analyzer_client_tx_thread_take_psd_resync(
+    struct suscli_analyzer_client_tx_thread *self);
+
+SUBOOL suscli_analyzer_client_tx_thread_take_panorama_resync(
+    struct suscli_analyzer_client_tx_thread *self);
+
+void suscli_analyzer_client_tx_thread_get_compression_stats(
+    struct suscli_analyzer_client_tx_thread *self,
+    struct suscan_remote_compressor_stats *stats);
+
 SUBOOL suscli_analyzer_client_tx_thread_initialize(
     struct suscli_analyzer_client_tx_thread *self,
     int fd,
-    unsigned int compress_threshold);
+    unsigned int compress_threshold,
+    const struct suscan_remote_compression_params *compression);
 
 /* 
  * This strucure relates global request IDs with per-client
@@ -177,7 +333,12 @@ struct suscli_analyzer_client {
   SUBOOL accepts_multicast;
   SUBOOL failed;
   SUBOOL closed;
+  SUBOOL tx_stalled;
   unsigned int epoch;
+  struct suscan_psd_codec_params psd_codec; /* Negotiated PSD encoding */
+  struct suscan_psd_stream psd_streams[SUSCAN_PSD_STREAM_MAX];
+  struct suscan_sample_codec_params sample_codec; /* Negotiated encodings */
+  SUBOOL le_arrays; /* Arrays may be sent in little endian order */
   unsigned int compress_threshold;
   struct timeval conntime;
   struct in_addr remote_addr;
@@ -274,6 +435,13 @@ suscli_analyzer_client_is_failed(const suscli_analyzer_client_t *self)
   return self->failed;
 }
 
+/* Malformed PDU found while taking calls */
+SUINLINE SUBOOL
+suscli_analyzer_client_has_rx_error(const suscli_analyzer_client_t *self)
+{
+  return suscan_remote_partial_pdu_state_is_failed(&self->pdu_state);
+}
+
 SUINLINE SUBOOL
 suscli_analyzer_client_is_closed(const suscli_analyzer_client_t *self)
 {
@@ -286,12 +454,64 @@ suscli_analyzer_client_accepts_multicast(const suscli_analyzer_client_t *self)
   return self->accepts_multicast;
 }
 
+SUINLINE const struct suscan_psd_codec_params *
+suscli_analyzer_client_get_psd_codec(const suscli_analyzer_client_t *self)
+{
+  return &self->psd_codec;
+}
+
+SUINLINE SUBOOL
+suscli_analyzer_client_accepts_le_arrays(const suscli_analyzer_client_t *self)
+{
+  return self->le_arrays;
+}
+
+SUINLINE enum suscan_sample_encoding
+suscli_analyzer_client_get_sample_encoding(
+  const suscli_analyzer_client_t *self,
+  SUBOOL audio)
+{
+  return audio ? self->sample_codec.audio : self->sample_codec.iq;
+}
+
 SUINLINE SUBOOL
 suscli_analyzer_client_can_write(const suscli_analyzer_client_t *self)
 {
   return !self->closed && !self->failed;
 }
 
+SUINLINE SUBOOL
+suscli_analyzer_client_is_tx_stalled(const suscli_analyzer_client_t *self)
+{
+  return self->tx_stalled;
+}
+
+/*
+ * Re-evaluates whether the client is keeping up with the data we send to
+ * it. Clients that are about to be closed are stalled too. Returns SU_TRUE
+ * if the stalled state changed.
+ */
+SUINLINE SUBOOL
+suscli_analyzer_client_update_tx_stalled(suscli_analyzer_client_t *self)
+{
+  unsigned int backlog = self->tx.queue.count;
+  SUBOOL stalled;
+
+  if (!suscli_analyzer_client_can_write(self))
+    stalled = SU_TRUE;
+  else if (self->tx_stalled)
+    stalled = backlog > SUSCLI_ANALYZER_CLIENT_TX_STALL_LOW_WATERMARK;
+  else
+    stalled = backlog >= SUSCLI_ANALYZER_CLIENT_TX_STALL_HIGH_WATERMARK;
+
+  if (stalled == self->tx_stalled)
+    return SU_FALSE;
+
+  self->tx_stalled = stalled;
+
+  return SU_TRUE;
+}
+
 SUINLINE SUBOOL
 suscli_analyzer_client_is_auth(const suscli_analyzer_client_t *self)
 {
@@ -338,7 +558,8 @@ suscli_analyzer_client_mark_failed(suscli_analyzer_client_t *self)
 
 suscli_analyzer_client_t *suscli_analyzer_client_new(
   int sfd,
-  unsigned int compress_threshold);
+  unsigned int compress_threshold,
+  const struct suscan_remote_compression_params *compression);
 
 SUINLINE void
 suscli_analyzer_client_set_analyzer_params(
@@ -390,6 +611,10 @@ SUBOOL suscli_analyzer_client_intercept_message(
 
 SUBOOL suscli_analyzer_client_shutdown(suscli_analyzer_client_t *self);
 SUBOOL suscli_analyzer_client_send_hello(suscli_analyzer_client_t *self);
+SUBOOL suscli_analyzer_client_serialize_call(
+    suscli_analyzer_client_t *self,
+    const struct suscan_analyzer_remote_call *call,
+    grow_buf_t *pdu);
 SUBOOL suscli_analyzer_client_deliver_call(
     suscli_analyzer_client_t *self,
     const struct suscan_analyzer_remote_call *call);
@@ -435,10 +660,14 @@ struct suscli_analyzer_itl_entry {
 
   SUHANDLE private_handle; /* Needed to close private handle */
   suscli_analyzer_client_t *client; /* Must be null if free */
+  SUBOOL audio; /* Inspector of the audio class */
 };
 
 struct suscli_multicast_manager;
 
+/* Distinct PSD encodings serialized once per broadcast */
+#define SUSCLI_ANALYZER_CLIENT_LIST_MAX_PDU_VARIANTS 4
+
 struct suscli_analyzer_client_list {
   pthread_mutex_t client_mutex;
   SUBOOL          client_mutex_initialized;
@@ -465,6 +694,13 @@ struct suscli_analyzer_client_list {
 
   /* Global request table */
   rbtree_t       *req_tree;
+
+  /* Accumulated compression stats of removed clients */
+  struct suscan_remote_compressor_stats compression_stats;
+
+  /* Compression of broadcast PDUs, one compressor per codec */
+  struct suscan_remote_compressor broadcast_compressors[
+    SUSCAN_REMOTE_COMPRESSION_COUNT];
 };
 
 uint32_t suscli_analyzer_client_list_alloc_global_id_unsafe(
@@ -473,6 +709,10 @@ uint32_t suscli_analyzer_client_list_alloc_global_id_unsafe(
 uint32_t suscli_analyzer_client_list_alloc_global_id(
   struct suscli_analyzer_client_list *self);
 
+void suscli_analyzer_client_list_get_compression_stats(
+  struct suscli_analyzer_client_list *self,
+  struct suscan_remote_compressor_stats *stats);
+
 struct suscli_analyzer_request_entry *
 suscli_analyzer_client_list_translate_request_unsafe(
   const struct suscli_analyzer_client_list *self,
@@ -517,9 +757,13 @@ SUBOOL suscli_analyzer_client_list_append_client(
     struct suscli_analyzer_client_list *self,
     suscli_analyzer_client_t *client);
 
+/*
+ * The message of the call may be taken by the PDUs referencing it, in
+ * which case its pointer is set to NULL.
+ */
 SUBOOL suscli_analyzer_client_list_broadcast_unsafe(
     struct suscli_analyzer_client_list *self,
-    const struct suscan_analyzer_remote_call *call,
+    struct suscan_analyzer_remote_call *call,
     SUBOOL (*on_client_error) (
         suscli_analyzer_client_t *client,
         void *userdata,
@@ -590,6 +834,7 @@ struct suscli_analyzer_server_params {
   uint16_t    port;
   const char *ifname;
   size_t      compress_threshold;
+  struct suscan_remote_compression_params compression; /* Unless negotiated */
 };
 
 #define SUSCLI_ANALYZER_DEFAULT_COMPRESS_THRESHOLD 1400
@@ -599,7 +844,8 @@ struct suscli_analyzer_server_params {
   NULL,        /* profile */                      \
   28001,       /* port */                         \
   NULL,        /* ifname */                       \
-  SUSCLI_ANALYZER_DEFAULT_COMPRESS_THRESHOLD      \
+  SUSCLI_ANALYZER_DEFAULT_COMPRESS_THRESHOLD,     \
+  suscan_remote_compression_params_INITIALIZER    \
 }
 
 struct suscli_analyzer_server {
@@ -626,6 +872,8 @@ struct suscli_analyzer_server {
   SUBOOL rx_thread_running;
   SUBOOL tx_thread_running;
   SUBOOL tx_halted;
+
+  uint64_t reported_pdus; /* Compressed PDUs in the last stats report */
 };
 
 typedef struct suscli_analyzer_server suscli_analyzer_server_t;
@@ -671,6 +919,12 @@ SUBOOL suscli_analyzer_server_add_user(
 
 SUBOOL suscli_analyzer_server_add_all_users(suscli_analyzer_server_t *server);
 
+void suscli_analyzer_server_get_compression_stats(
+  suscli_analyzer_server_t *self,
+  struct suscan_remote_compressor_stats *stats);
+
+void suscli_analyzer_server_report_stats(suscli_analyzer_server_t *self);
+
 void suscli_analyzer_server_destroy(suscli_analyzer_server_t *self);
 
 #endif /* _SUSCAN_CLI_DEVSERV_DEVSERV_H */
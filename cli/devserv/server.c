@@ -170,7 +170,16 @@ suscli_analyzer_server_intercept_message_unsafe(
               inspmsg->handle,
               itl_index,
               -1));
-          
+
+          /* Do not let it run if the client is not reading */
+          if (suscli_analyzer_client_is_tx_stalled(client))
+            SU_TRY(
+              suscan_analyzer_set_inspector_stalled_async(
+                self->analyzer,
+                inspmsg->handle,
+                SU_TRUE,
+                -1));
+
           entry = suscli_analyzer_client_list_get_itl_entry_unsafe(
               &self->client_list,
               itl_index);
@@ -182,6 +191,8 @@ suscli_analyzer_server_intercept_message_unsafe(
               itl_index);
 
           entry->private_handle = private_handle;
+          entry->audio = inspmsg->class_name != NULL
+            && strcmp(inspmsg->class_name, "audio") == 0;
 
           SU_INFO(
               "%s: inspector (handle 0x%x) opened\n",
@@ -234,6 +245,12 @@ suscli_analyzer_server_intercept_message_unsafe(
             suscli_analyzer_client_dec_inspector_open_request(client);
           break;
 
+        case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SET_STALLED:
+          /* Issued by us, nobody is waiting for it */
+          if (client == NULL)
+            *ignore = SU_TRUE;
+          break;
+
         case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_NOOP:
         case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_WRONG_KIND:
         case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_WRONG_HANDLE:
@@ -275,6 +292,13 @@ suscli_analyzer_server_intercept_message_unsafe(
       } else {
         client = entry->client;
         samplemsg->inspector_id = entry->local_inspector_id;
+
+        /* Samples go to a single client: encode them as it asked */
+        samplemsg->encoding = suscli_analyzer_client_get_sample_encoding(
+          client,
+          entry->audio);
+        samplemsg->little_endian =
+          suscli_analyzer_client_accepts_le_arrays(client);
       }
 
       break;
@@ -349,6 +373,89 @@ suscli_analyzer_server_on_broadcast_error(
   return SU_TRUE;
 }
 
+SUPRIVATE SUBOOL
+suscli_analyzer_server_on_stalled_inspector(
+    const suscli_analyzer_client_t *client,
+    void *userdata,
+    SUHANDLE private_handle,
+    SUHANDLE global_handle)
+{
+  suscli_analyzer_server_t *self = (suscli_analyzer_server_t *) userdata;
+
+  SU_TRYCATCH(
+      suscan_analyzer_set_inspector_stalled_async(
+          self->analyzer,
+          global_handle,
+          suscli_analyzer_client_is_tx_stalled(client),
+          -1),
+      return SU_FALSE);
+
+  return SU_TRUE;
+}
+
+/*
+ * Inspectors of clients that are not reading fast enough are suspended
+ * until their TX queue drains. Otherwise, they would keep on demodulating
+ * samples that end up being discarded (or, worse, piling up in memory).
+ */
+SUPRIVATE void
+suscli_analyzer_server_update_stalled_clients_unsafe(
+    suscli_analyzer_server_t *self)
+{
+  suscli_analyzer_client_t *this = self->client_list.client_head;
+
+  while (this != NULL) {
+    if (suscli_analyzer_client_update_tx_stalled(this)
+        && suscli_analyzer_client_has_outstanding_inspectors(this)) {
+      SU_INFO(
+          "%s: client %s, %s inspectors\n",
+          suscli_analyzer_client_get_name(this),
+          suscli_analyzer_client_is_tx_stalled(this)
+            ? "stalled"
+            : "back to normal",
+          suscli_analyzer_client_is_tx_stalled(this)
+            ? "suspending"
+            : "resuming");
+
+      if (!suscli_analyzer_client_for_each_inspector(
+          this,
+          suscli_analyzer_server_on_stalled_inspector,
+          self))
+        SU_WARNING(
+            "%s: failed to update inspector state\n",
+            suscli_analyzer_client_get_name(this));
+    }
+
+    this = this->next;
+  }
+}
+
+/*
+ * Panorama updates discarded from the queue of a client leave its
+ * panorama out of sync. Since panoramas are broadcast, the keyframe is
+ * requested to the analyzer, and every client gets it.
+ */
+SUPRIVATE void
+suscli_analyzer_server_resync_panorama_unsafe(
+    suscli_analyzer_server_t *self,
+    const struct suscan_analyzer_panorama_msg *msg)
+{
+  suscli_analyzer_client_t *this;
+  SUBOOL resync = SU_FALSE;
+
+  for (this = self->client_list.client_head; this != NULL; this = this->next)
+    if (suscli_analyzer_client_tx_thread_take_panorama_resync(&this->tx))
+      resync = SU_TRUE;
+
+  /* A keyframe resynchronizes everyone already */
+  if (resync && !msg->keyframe)
+    if (!suscan_analyzer_req_panorama_keyframe_async(
+        self->analyzer,
+        msg->epoch,
+        0))
+      SU_WARNING("Failed to request a panorama keyframe\n");
+}
+
 SUPRIVATE void *
 suscli_analyzer_server_tx_thread(void *ptr)
 {
@@ -389,6 +496,9 @@ suscli_analyzer_server_tx_thread(void *ptr)
       continue;
     }
 
+    if (type == SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA)
+      suscli_analyzer_server_resync_panorama_unsafe(self, message);
+
     call.type     = SUSCAN_ANALYZER_REMOTE_MESSAGE;
     call.msg.type = type;
     call.msg.ptr  = message;
@@ -400,15 +510,18 @@ suscli_analyzer_server_tx_thread(void *ptr)
           &call,
           suscli_analyzer_server_on_broadcast_error,
           self);
-    } else {
-      SU_TRYCATCH(suscan_analyzer_remote_call_serialize(&call, &pdu), goto done);
+    } else if (suscli_analyzer_client_can_write(client)) {
+      /* Serializing may advance the PSD stream of the client */
+      SU_TRYCATCH(
+          suscli_analyzer_client_serialize_call(client, &call, &pdu),
+          goto done);
 
-      if (suscli_analyzer_client_can_write(client)) {
-        if (!suscli_analyzer_client_write_buffer_zerocopy(client, &pdu))
-          suscli_analyzer_server_kick_client_unsafe(self, client);
-      }
+      if (!suscli_analyzer_client_write_buffer_zerocopy(client, &pdu))
+        suscli_analyzer_server_kick_client_unsafe(self, client);
     }
 
+    suscli_analyzer_server_update_stalled_clients_unsafe(self);
+
     /* ^^^^^^^^^^^^^^^^^^^^^ Client list mutex acquired ^^^^^^^^^^^^^^^^^^^^ */
     SU_TRYCATCH(
         pthread_mutex_unlock(&self->client_list.client_mutex) != -1,
@@ -515,6 +628,42 @@ suscli_analyzer_server_process_auth_message(
     client->auth = SU_TRUE;
     client->accepts_multicast = 
       !!(call->client_auth.flags & SUSCAN_REMOTE_FLAGS_MULTICAST);
+    client->le_arrays =
+      !!(call->client_auth.flags & SUSCAN_REMOTE_FLAGS_LE_ARRAYS);
+
+    if (call->client_auth.flags & SUSCAN_REMOTE_FLAGS_PSD_ENCODING) {
+      client->psd_codec = call->client_auth.psd_codec;
+      SU_INFO(
+          "%s: PSD encoding `%s' (%g to %g dB, keyframe interval %u)\n",
+          suscli_analyzer_client_get_name(client),
+          suscan_psd_encoding_to_string(client->psd_codec.encoding),
+          client->psd_codec.min_db,
+          client->psd_codec.max_db,
+          client->psd_codec.keyframe_int);
+    }
+
+    if (call->client_auth.flags & SUSCAN_REMOTE_FLAGS_SAMPLE_ENCODING) {
+      client->sample_codec = call->client_auth.sample_codec;
+      SU_INFO(
+          "%s: sample encoding `%s' (audio: `%s')\n",
+          suscli_analyzer_client_get_name(client),
+          suscan_sample_encoding_to_string(client->sample_codec.iq),
+          suscan_sample_encoding_to_string(client->sample_codec.audio));
+    }
+
+    if (call->client_auth.flags & SUSCAN_REMOTE_FLAGS_COMPRESSION) {
+      SU_TRYCATCH(
+          suscli_analyzer_client_tx_thread_set_compression(
+            &client->tx,
+            &call->client_auth.compression),
+          goto done);
+      SU_INFO(
+          "%s: compression `%s' (level %d)\n",
+          suscli_analyzer_client_get_name(client),
+          suscan_remote_compression_to_string(
+            call->client_auth.compression.codec),
+          call->client_auth.compression.level);
+    }
   }
 
   ok = SU_TRUE;
@@ -800,12 +949,95 @@ done:
   return ok;
 }
 
+/*
+ * Multi-calls are applied all or nothing: all their settings are checked
+ * before applying any, so that a setting the caller is not allowed to
+ * change does not leave the device half-configured.
+ */
+SUPRIVATE SUBOOL
+suscli_analyzer_server_check_multi_call(
+    suscli_analyzer_client_t *caller,
+    const struct suscan_analyzer_remote_call *call)
+{
+  const struct suscan_analyzer_remote_call *this;
+  uint64_t perm;
+  unsigned int i;
+
+  for (i = 0; i < call->multi.count; ++i) {
+    this = call->multi.calls + i;
+    perm = 0;
+
+    switch (this->type) {
+      case SUSCAN_ANALYZER_REMOTE_SET_FREQUENCY:
+        perm = SUSCAN_ANALYZER_PERM_SET_FREQ;
+        break;
+
+      case SUSCAN_ANALYZER_REMOTE_SET_GAIN:
+        if (this->gain.name == NULL)
+          goto invalid;
+        perm = SUSCAN_ANALYZER_PERM_SET_GAIN;
+        break;
+
+      case SUSCAN_ANALYZER_REMOTE_SET_ANTENNA:
+        if (this->antenna == NULL)
+          goto invalid;
+        perm = SUSCAN_ANALYZER_PERM_SET_ANTENNA;
+        break;
+
+      case SUSCAN_ANALYZER_REMOTE_SET_BANDWIDTH:
+        perm = SUSCAN_ANALYZER_PERM_SET_BW;
+        break;
+
+      case SUSCAN_ANALYZER_REMOTE_SET_PPM:
+        perm = SUSCAN_ANALYZER_PERM_SET_PPM;
+        break;
+
+      case SUSCAN_ANALYZER_REMOTE_SET_DC_REMOVE:
+        perm = SUSCAN_ANALYZER_PERM_SET_DC_REMOVE;
+        break;
+
+      case SUSCAN_ANALYZER_REMOTE_SET_IQ_REVERSE:
+        perm = SUSCAN_ANALYZER_PERM_SET_IQ_REVERSE;
+        break;
+
+      case SUSCAN_ANALYZER_REMOTE_SET_AGC:
+        perm = SUSCAN_ANALYZER_PERM_SET_AGC;
+        break;
+
+      default:
+        /* No permission required, but it must still be a setting */
+        if (!suscan_analyzer_remote_call_is_setting(this))
+          goto invalid;
+    }
+
+    if (perm != 0 && !suscli_analyzer_client_test_permission(caller, perm)) {
+      SU_WARNING(
+          "%s: client not allowed to apply setting %d, "
+          "multi-call ignored\n",
+          suscli_analyzer_client_get_name(caller),
+          this->type);
+      return SU_FALSE;
+    }
+  }
+
+  return SU_TRUE;
+
+invalid:
+  SU_WARNING(
+      "%s: invalid setting %d in multi-call, multi-call ignored\n",
+      suscli_analyzer_client_get_name(caller),
+      this->type);
+
+  return SU_FALSE;
+}
+
 SUPRIVATE SUBOOL
 suscli_analyzer_server_deliver_call(
     suscli_analyzer_server_t *self,
     suscli_analyzer_client_t *caller,
     struct suscan_analyzer_remote_call *call)
 {
+  unsigned int i;
   SUBOOL ok = SU_TRUE; /* Succeed by default */
 
   struct suscli_analyzer_client_interceptors interceptors = {
@@ -962,6 +1194,19 @@ suscli_analyzer_server_deliver_call(
       ok = SU_TRUE;
       break;
 
+    case SUSCAN_ANALYZER_REMOTE_MULTI_CALL:
+      /* Like single calls, disallowed settings are ignored, not fatal */
+      if (!suscli_analyzer_server_check_multi_call(caller, call))
+        break;
+
+      /* Settings of a multi-call are applied back to back */
+      for (i = 0; ok && i < call->multi.count; ++i)
+        ok = suscli_analyzer_server_deliver_call(
+            self,
+            caller,
+            call->multi.calls + i);
+      break;
+
     case SUSCAN_ANALYZER_REMOTE_REQ_HALT:
       /* TODO: Acknowledge something. */
       if (self->client_list.client_count == 1) {
@@ -1066,7 +1311,10 @@ suscli_analyzer_server_register_clients(suscli_analyzer_server_t *self)
       (struct sockaddr *) &inaddr,
       &len)) != -1) {
     SU_TRYCATCH(
-        client = suscli_analyzer_client_new(fd, self->params.compress_threshold),
+        client = suscli_analyzer_client_new(
+          fd,
+          self->params.compress_threshold,
+          &self->params.compression),
         goto done);
 
     suscli_analyzer_client_set_analyzer_params(
@@ -1175,12 +1423,19 @@ suscli_analyzer_server_rx_thread(void *userdata)
           if (!suscli_analyzer_client_is_failed(client)) {
             if (!suscli_analyzer_client_read(client)) {
               suscli_analyzer_server_kick_client(self, client);
-            } else if ((call = suscli_analyzer_client_take_call(client))
-                != NULL) {
-              /* Call completed from client, process it and do stuff */
-              SU_TRYCATCH(
-                  suscli_analyzer_server_process_call(self, client, call),
-                  goto done);
+            } else {
+              /* A single read may complete several calls */
+              while (!suscli_analyzer_client_is_failed(client)
+                && (call = suscli_analyzer_client_take_call(client))
+                  != NULL) {
+                /* Call completed from client, process it and do stuff */
+                SU_TRYCATCH(
+                    suscli_analyzer_server_process_call(self, client, call),
+                    goto done);
+              }
+
+              if (suscli_analyzer_client_has_rx_error(client))
+                suscli_analyzer_server_kick_client(self, client);
             }
           }
           --count;
@@ -1368,6 +1623,35 @@ done:
   return NULL;
 }
 
+void
+suscli_analyzer_server_get_compression_stats(
+  suscli_analyzer_server_t *self,
+  struct suscan_remote_compressor_stats *stats)
+{
+  suscli_analyzer_client_list_get_compression_stats(&self->client_list, stats);
+}
+
+/* Logs the server stats, if they changed since the last report */
+void
+suscli_analyzer_server_report_stats(suscli_analyzer_server_t *self)
+{
+  struct suscan_remote_compressor_stats stats;
+
+  suscli_analyzer_server_get_compression_stats(self, &stats);
+
+  if (stats.pdus == self->reported_pdus)
+    return;
+
+  self->reported_pdus = stats.pdus;
+
+  SU_INFO(
+      "Server on port %d: %lu PDUs compressed, ratio %.2f, %.1f us/PDU\n",
+      suscli_analyzer_server_get_port(self),
+      (unsigned long) stats.pdus,
+      suscan_remote_compressor_stats_get_ratio(&stats),
+      1e-3 * stats.time_ns / stats.pdus);
+}
+
 SUPRIVATE void
 suscli_analyzer_server_cancel_rx_thread(suscli_analyzer_server_t *self)
 {
@@ -24,7 +24,15 @@
 #include <sigutils/util/compat-socket.h>
 #include <analyzer/msg.h>
 #include <sys/fcntl.h>
-#include <zlib.h>
+
+#ifdef _WIN32
+struct iovec {
+  void  *iov_base;
+  size_t iov_len;
+};
+#else
+#  include <sys/uio.h>
+#endif /* _WIN32 */
 
 #ifndef MSG_NOSIGNAL
 #  define MSG_NOSIGNAL 0
@@ -59,6 +67,228 @@ suscli_analyzer_client_tx_thread_alloc_buffer(
   return new;
 }
 
+/* Releases a PDU that was queued but will never be sent */
+SUPRIVATE void
+suscli_analyzer_client_tx_release(uint32_t type, void *data)
+{
+  suscli_analyzer_shared_pdu_t *shared;
+  grow_buf_t *buffer;
+
+  /* Null messages are used to notify special conditions */
+  if (data == NULL)
+    return;
+
+  if (type == SUSCLI_ANALYZER_CLIENT_TX_SHARED) {
+    shared = data;
+    SU_DEREF(shared, tx_queue);
+  } else {
+    buffer = data;
+    grow_buf_finalize(buffer);
+    free(buffer);
+  }
+}
+
+/****************************** Shared PDUs ***********************************/
+enum suscli_analyzer_pdu_class
+suscli_analyzer_pdu_classify(grow_buf_t *pdu)
+{
+  struct suscan_analyzer_remote_call call;
+  enum suscli_analyzer_pdu_class pdu_class = SUSCLI_ANALYZER_PDU_CLASS_CRITICAL;
+  uint32_t msg_type, msg_kind;
+
+  suscan_analyzer_remote_call_init(&call, SUSCAN_ANALYZER_REMOTE_NONE);
+
+  /* Rewind */
+  grow_buf_seek(pdu, 0, SEEK_SET);
+
+  SU_TRY(suscan_analyzer_remote_call_deserialize_partial(&call, pdu));
+
+  /* Not an analyzer message. Assume critical */
+  if (call.type != SUSCAN_ANALYZER_REMOTE_MESSAGE)
+    goto done;
+
+  SU_TRY(suscan_analyzer_msg_deserialize_partial(&msg_type, pdu));
+
+  switch (msg_type) {
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_SOURCE_INFO:
+      pdu_class = SUSCLI_ANALYZER_PDU_CLASS_SOURCE_INFO;
+      break;
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PSD:
+      pdu_class = SUSCLI_ANALYZER_PDU_CLASS_PSD;
+      break;
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_PANORAMA:
+      pdu_class = SUSCLI_ANALYZER_PDU_CLASS_PANORAMA;
+      break;
+
+    case SUSCAN_ANALYZER_MESSAGE_TYPE_INSPECTOR:
+      /* Deserialize inspector message kind */
+      SU_TRYZ(cbor_unpack_uint32(pdu, &msg_kind));
+
+      /* Spectrum message. Discard */
+      if (msg_kind == SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SPECTRUM)
+        pdu_class = SUSCLI_ANALYZER_PDU_CLASS_DISCARDABLE;
+      break;
+  }
+
+done:
+  return pdu_class;
+}
+
+suscli_analyzer_shared_pdu_t *
+suscli_analyzer_shared_pdu_new(
+  grow_buf_t *pdu,
+  const struct suscan_pdu_segments *segments)
+{
+  suscli_analyzer_shared_pdu_t *new = NULL;
+
+  SU_ALLOCATE_FAIL(new, suscli_analyzer_shared_pdu_t);
+
+  SU_TRYCATCH(
+    SUSCAN_INIT_REFCOUNT(suscli_analyzer_shared_pdu, new),
+    goto fail);
+
+  grow_buf_transfer(&new->pdu, pdu);
+
+  if (segments != NULL)
+    new->segments = *segments;
+
+  /* Classified now, as tx threads may not seek shared PDUs */
+  new->pdu_class = suscli_analyzer_pdu_classify(&new->pdu);
+
+  return new;
+
+fail:
+  if (new != NULL)
+    suscli_analyzer_shared_pdu_destroy(new);
+
+  return NULL;
+}
+
+SUBOOL
+suscli_analyzer_shared_pdu_compress(
+  suscli_analyzer_shared_pdu_t *self,
+  struct suscan_remote_compressor *compressor)
+{
+  struct suscli_analyzer_shared_pdu_variant *variant;
+  const grow_buf_t *pdu = &self->pdu;
+  grow_buf_t flat = grow_buf_INITIALIZER;
+  SUBOOL ok = SU_FALSE;
+
+  if (suscli_analyzer_shared_pdu_get_variant(self, &compressor->params) != NULL)
+    return SU_TRUE;
+
+  if (self->variant_count == SUSCLI_ANALYZER_SHARED_PDU_MAX_VARIANTS)
+    return SU_TRUE;
+
+  variant = self->variants + self->variant_count;
+  variant->params = compressor->params;
+
+  /* Compressors need the whole PDU in one piece */
+  if (suscli_analyzer_shared_pdu_is_segmented(self)) {
+    SU_TRY(suscan_pdu_segments_flatten(&self->segments, &self->pdu, &flat));
+    pdu = &flat;
+  }
+
+  SU_TRYCATCH(
+    suscan_remote_compressor_compress(
+      compressor,
+      pdu,
+      &variant->data,
+      &variant->magic),
+    grow_buf_finalize(&variant->data);
+    goto done);
+
+  ++self->variant_count;
+
+  ok = SU_TRUE;
+
+done:
+  grow_buf_finalize(&flat);
+
+  return ok;
+}
+
+const struct suscli_analyzer_shared_pdu_variant *
+suscli_analyzer_shared_pdu_get_variant(
+  const suscli_analyzer_shared_pdu_t *self,
+  const struct suscan_remote_compression_params *params)
+{
+  unsigned int i;
+
+  for (i = 0; i < self->variant_count; ++i)
+    if (self->variants[i].params.codec == params->codec
+      && self->variants[i].params.level == params->level)
+      return self->variants + i;
+
+  return NULL;
+}
+
+void
+suscli_analyzer_shared_pdu_keep_message(
+  suscli_analyzer_shared_pdu_t *self,
+  uint32_t type,
+  void *msg)
+{
+  self->msg_type = type;
+  self->msg      = msg;
+}
+
+void
+suscli_analyzer_shared_pdu_destroy(suscli_analyzer_shared_pdu_t *self)
+{
+  unsigned int i;
+
+  for (i = 0; i < self->variant_count; ++i)
+    grow_buf_finalize(&self->variants[i].data);
+
+  grow_buf_finalize(&self->pdu);
+
+  if (self->msg != NULL)
+    suscan_analyzer_dispose_message(self->msg_type, self->msg);
+
+  SUSCAN_FINALIZE_REFCOUNT(self);
+
+  free(self);
+}
+
+/*
+ * Waits until the socket accepts more data. Fails if the thread was
+ * cancelled via the cancel pipe in the meantime.
+ */
+SUPRIVATE SUBOOL
+suscli_analyzer_client_tx_thread_wait_writable(
+    struct suscli_analyzer_client_tx_thread *self)
+{
+  struct pollfd pollfds[2];
+  char b;
+
+  pollfds[0].events  = POLLOUT | POLLERR | POLLHUP;
+  pollfds[0].fd      = self->fd;
+  pollfds[0].revents = 0;
+
+  pollfds[1].events  = POLLIN;
+  pollfds[1].fd      = self->cancel_pipefd[0];
+  pollfds[1].revents = 0;
+
+  if (poll(pollfds, 2, -1) == -1)
+    return errno == EINTR;
+
+  /* Cancelled via cancelfd */
+  if (pollfds[1].revents & POLLIN) {
+    IGNORE_RESULT(int, read(self->cancel_pipefd[0], &b, 1));
+    return SU_FALSE;
+  }
+
+  /* Impossible to write to this fd, give up */
+  if (pollfds[0].revents != 0 && !(pollfds[0].revents & POLLOUT))
+    return SU_FALSE;
+
+  return SU_TRUE;
+}
+
+#ifdef _WIN32
 SUINLINE SUBOOL
 suscli_analyzer_client_tx_thread_helper_send(
   int fd,
@@ -85,154 +315,321 @@ suscli_analyzer_client_tx_thread_helper_send(
   return SU_TRUE;
 }
 
-SUINLINE SUBOOL
-suscli_analyzer_client_tx_thread_write_buffer_internal(
+/* No sendmsg here. Send the chunks one by one. */
+SUPRIVATE SUBOOL
+suscli_analyzer_client_tx_thread_sendv(
     struct suscli_analyzer_client_tx_thread *self,
-    uint32_t magic,
-    const grow_buf_t *buffer)
+    struct iovec *iov,
+    unsigned int iovcnt)
 {
-  struct suscan_analyzer_remote_pdu_header header;
-  const uint8_t *data;
-  size_t size, chunksize;
-  SUBOOL ok = SU_FALSE;
+  unsigned int i;
+
+  for (i = 0; i < iovcnt && !self->thread_cancelled; ++i) {
+    if (!suscli_analyzer_client_tx_thread_wait_writable(self))
+      return SU_FALSE;
+
+    if (!suscli_analyzer_client_tx_thread_helper_send(
+      self->fd,
+      iov[i].iov_base,
+      iov[i].iov_len))
+      return SU_FALSE;
+  }
 
-  data = grow_buf_get_buffer(buffer);
-  size = grow_buf_get_size(buffer);
+  return !self->thread_cancelled;
+}
+#else
+/*
+ * Sends all chunks with as few syscalls as possible. Writes never block:
+ * if the socket buffer is full, we wait for it to drain (or for the
+ * thread to be cancelled) and carry on from where the last call stopped.
+ */
+SUPRIVATE SUBOOL
+suscli_analyzer_client_tx_thread_sendv(
+    struct suscli_analyzer_client_tx_thread *self,
+    struct iovec *iov,
+    unsigned int iovcnt)
+{
+  struct msghdr msg;
+  ssize_t got;
 
-  header.magic = htonl(magic);
-  header.size  = htonl(size);
+  while (iovcnt > 0) {
+    if (self->thread_cancelled)
+      return SU_FALSE;
 
-  chunksize = sizeof(struct suscan_analyzer_remote_pdu_header);
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = iovcnt;
 
-  if (!suscli_analyzer_client_tx_thread_helper_send(
-    self->fd,
-    &header,
-    chunksize))
-    goto done;
+    got = sendmsg(self->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
 
-  /*
-   * Calls can be extremely big, so we better send them in small chunks. Also,
-   * this loop may be slow and thread may have been cancelled in the
-   * meantime. Check for every chunk whether it was cancelled before
-   * continuing.
-   */
+    if (got == 0) {
+      SU_ERROR("sendmsg(): connection closed by foreign host\n");
+      return SU_FALSE;
+    } else if (got < 0) {
+      if (errno == EINTR)
+        continue;
 
-  while (size > 0 && !self->thread_cancelled) {
-    chunksize = size;
-    if (chunksize > SUSCAN_REMOTE_READ_BUFFER)
-      chunksize = SUSCAN_REMOTE_READ_BUFFER;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        SU_ERROR("sendmsg(): error: %s\n", strerror(errno));
+        return SU_FALSE;
+      }
 
-    if (!suscli_analyzer_client_tx_thread_helper_send(
-      self->fd,
-      data,
-      chunksize))
-      goto done;
+      if (!suscli_analyzer_client_tx_thread_wait_writable(self))
+        return SU_FALSE;
 
-    data += chunksize;
-    size -= chunksize;
-  }
+      continue;
+    }
 
-  ok = SU_TRUE;
+    /* Skip whatever was sent */
+    while (iovcnt > 0 && (size_t) got >= iov->iov_len) {
+      got -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
 
-done:
-  return ok;
+    if (iovcnt > 0) {
+      iov->iov_base  = (uint8_t *) iov->iov_base + got;
+      iov->iov_len  -= got;
+    }
+  }
+
+  return SU_TRUE;
 }
+#endif /* _WIN32 */
 
 SUINLINE SUBOOL
-suscli_analyzer_client_tx_thread_write_compressed_buffer(
+suscli_analyzer_client_tx_thread_compress(
     struct suscli_analyzer_client_tx_thread *self,
-    const grow_buf_t *buffer)
+    const grow_buf_t *pdu,
+    grow_buf_t *compressed,
+    uint32_t *magic)
 {
-  grow_buf_t compressed = grow_buf_INITIALIZER;
+  struct suscan_remote_compression_params params;
   SUBOOL ok = SU_FALSE;
-  
+
+  /* Pick up compression settings negotiated after the thread started */
+  suscli_analyzer_client_tx_thread_get_compression(self, &params);
+
+  if (params.codec != self->compressor.params.codec
+    || params.level != self->compressor.params.level)
+    SU_TRYCATCH(
+      suscan_remote_compressor_set_params(&self->compressor, &params),
+      goto done);
+
   SU_TRYCATCH(
-    suscan_remote_deflate_pdu((grow_buf_t *) buffer, &compressed),
+    suscan_remote_compressor_compress(
+      &self->compressor,
+      pdu,
+      compressed,
+      magic),
     goto done);
 
   SU_TRYCATCH(
-    suscli_analyzer_client_tx_thread_write_buffer_internal(
-      self, 
-      SUSCAN_REMOTE_COMPRESSED_PDU_HEADER_MAGIC, 
-      &compressed),
+    pthread_mutex_lock(&self->compression_mutex) == 0,
     goto done);
+  self->compression_stats = self->compressor.stats;
+  (void) pthread_mutex_unlock(&self->compression_mutex);
 
   ok = SU_TRUE;
 
 done:
-  grow_buf_finalize(&compressed);
-
   return ok;
 }
 
+/* Takes ownership of the queue entry, even on failure */
 SUPRIVATE SUBOOL
-suscli_analyzer_client_tx_thread_write_buffer(
+suscli_analyzer_client_tx_thread_batch_add(
     struct suscli_analyzer_client_tx_thread *self,
-    const grow_buf_t *buffer)
+    uint32_t type,
+    void *data)
 {
-  if (self->compress_threshold > 0 
-    && grow_buf_get_size(buffer) > self->compress_threshold)
-    return suscli_analyzer_client_tx_thread_write_compressed_buffer(
-      self, 
-      buffer);
-  else
-    return suscli_analyzer_client_tx_thread_write_buffer_internal(
-      self,
-      SUSCAN_REMOTE_PDU_HEADER_MAGIC,
-      buffer);
+  struct suscli_analyzer_client_tx_batch_entry *entry;
+  const struct suscli_analyzer_shared_pdu_variant *variant = NULL;
+  struct suscan_remote_compression_params params;
+  const suscli_analyzer_shared_pdu_t *shared = NULL;
+  const grow_buf_t *pdu;
+  size_t size;
+  uint32_t magic = SUSCAN_REMOTE_PDU_HEADER_MAGIC;
+
+  entry = self->batch + self->batch_count++;
+  entry->type     = type;
+  entry->data     = data;
+  entry->segments = NULL;
+
+  if (type == SUSCLI_ANALYZER_CLIENT_TX_SHARED) {
+    shared = data;
+    pdu    = &shared->pdu;
+    size   = suscli_analyzer_shared_pdu_get_size(shared);
+
+    if (suscli_analyzer_shared_pdu_is_segmented(shared))
+      entry->segments = &shared->segments;
+  } else {
+    pdu    = data;
+    size   = grow_buf_get_size(pdu);
+  }
+
+  entry->body = pdu;
+
+  if (suscli_analyzer_client_tx_thread_wants_compression(self, size)) {
+    /* Compressed by the broadcaster? */
+    if (shared != NULL) {
+      suscli_analyzer_client_tx_thread_get_compression(self, &params);
+      variant = suscli_analyzer_shared_pdu_get_variant(shared, &params);
+    }
+
+    if (variant != NULL) {
+      entry->body = &variant->data;
+      magic       = variant->magic;
+    } else {
+      if (entry->segments != NULL) {
+        grow_buf_shrink(&self->flat);
+        SU_TRYCATCH(
+          suscan_pdu_segments_flatten(entry->segments, pdu, &self->flat),
+          return SU_FALSE);
+        pdu = &self->flat;
+      }
+
+      grow_buf_shrink(&entry->compressed);
+      SU_TRYCATCH(
+        suscli_analyzer_client_tx_thread_compress(
+          self,
+          pdu,
+          &entry->compressed,
+          &magic),
+        return SU_FALSE);
+      entry->body = &entry->compressed;
+    }
+
+    size = grow_buf_get_size(entry->body);
+    entry->segments = NULL;
+  }
+
+  entry->header.magic = htonl(magic);
+  entry->header.size  = htonl(size);
+
+  self->batch_size += sizeof(struct suscan_analyzer_remote_pdu_header) + size;
+
+  return SU_TRUE;
 }
 
-SUPRIVATE void *
-suscli_analyzer_client_tx_thread_func(void *userdata)
+SUPRIVATE void
+suscli_analyzer_client_tx_thread_batch_clear(
+    struct suscli_analyzer_client_tx_thread *self)
 {
-  struct suscli_analyzer_client_tx_thread *self =
-      (struct suscli_analyzer_client_tx_thread *) userdata;
-  struct pollfd pollfds[2];
-  char b;
-  uint32_t type;
-  grow_buf_t *buffer = NULL;
+  struct suscli_analyzer_client_tx_batch_entry *entry;
+  unsigned int i;
+
+  for (i = 0; i < self->batch_count; ++i) {
+    entry = self->batch + i;
+
+    if (entry->type == SUSCLI_ANALYZER_CLIENT_TX_MESSAGE)
+      suscli_analyzer_client_tx_thread_dispose_buffer(self, entry->data);
+    else
+      suscli_analyzer_client_tx_release(entry->type, entry->data);
+
+    entry->data     = NULL;
+    entry->body     = NULL;
+    entry->segments = NULL;
+  }
 
-  while ((buffer = suscan_mq_read(&self->queue, &type)) != NULL) {
-    /* Cancelled via MQ. We should not reach this point in this impl. */
-    if (type == SUSCLI_ANALYZER_CLIENT_TX_CANCEL)
-      goto done;
+  self->batch_count = 0;
+  self->batch_size  = 0;
+}
 
-    pollfds[0].events  = POLLOUT | POLLERR | POLLHUP;
-    pollfds[0].fd      = self->fd;
-    pollfds[0].revents = 0;
+/* Chunks of a body, with its segments (if any) in place */
+SUPRIVATE unsigned int
+suscli_analyzer_client_tx_thread_body_to_iov(
+    const struct suscli_analyzer_client_tx_batch_entry *entry,
+    struct iovec *iov)
+{
+  uint8_t *bytes = grow_buf_get_buffer(entry->body);
+  size_t size = grow_buf_get_size(entry->body);
+  size_t p = 0;
+  unsigned int i, iovcnt = 0;
 
-    pollfds[1].events  = POLLIN;
-    pollfds[1].fd      = self->cancel_pipefd[0];
-    pollfds[1].revents = 0;
+  if (entry->segments != NULL) {
+    for (i = 0; i < entry->segments->count; ++i) {
+      if (entry->segments->segment[i].offset > p) {
+        iov[iovcnt].iov_base  = bytes + p;
+        iov[iovcnt++].iov_len = entry->segments->segment[i].offset - p;
+      }
 
-    SU_TRYCATCH(poll(pollfds, 2, -1) != -1, goto done);
+      iov[iovcnt].iov_base  = (void *) entry->segments->segment[i].data;
+      iov[iovcnt++].iov_len = entry->segments->segment[i].size;
 
-    /* Cancelled via cancelfd */
-    if (pollfds[1].revents & POLLIN) {
-      IGNORE_RESULT(int, read(self->cancel_pipefd[0], &b, 1));
-      goto done;
+      p = entry->segments->segment[i].offset;
     }
+  }
 
-    if (pollfds[0].revents != 0) {
-      if (pollfds[0].revents & POLLOUT) {
-        SU_TRYCATCH(
-            suscli_analyzer_client_tx_thread_write_buffer(self, buffer),
-            goto done);
-      } else {
-        /* Impossible to write to this fd, give up */
-        goto done;
+  if (size > p) {
+    iov[iovcnt].iov_base  = bytes + p;
+    iov[iovcnt++].iov_len = size - p;
+  }
+
+  return iovcnt;
+}
+
+/* Sends every PDU in the batch (headers and bodies) at once */
+SUPRIVATE SUBOOL
+suscli_analyzer_client_tx_thread_batch_flush(
+    struct suscli_analyzer_client_tx_thread *self)
+{
+  struct iovec iov[
+    (2 + 2 * SUSCAN_PDU_MAX_SEGMENTS) * SUSCLI_ANALYZER_CLIENT_TX_BATCH_MAX];
+  struct suscli_analyzer_client_tx_batch_entry *entry;
+  unsigned int i, iovcnt = 0;
+  SUBOOL ok;
+
+  for (i = 0; i < self->batch_count; ++i) {
+    entry = self->batch + i;
+
+    iov[iovcnt].iov_base = &entry->header;
+    iov[iovcnt++].iov_len = sizeof(struct suscan_analyzer_remote_pdu_header);
+
+    iovcnt += suscli_analyzer_client_tx_thread_body_to_iov(entry, iov + iovcnt);
+  }
+
+  ok = suscli_analyzer_client_tx_thread_sendv(self, iov, iovcnt);
+
+  suscli_analyzer_client_tx_thread_batch_clear(self);
+
+  return ok;
+}
+
+SUPRIVATE void *
+suscli_analyzer_client_tx_thread_func(void *userdata)
+{
+  struct suscli_analyzer_client_tx_thread *self =
+      (struct suscli_analyzer_client_tx_thread *) userdata;
+  uint32_t type;
+  void *data = NULL;
+  SUBOOL cancelled = SU_FALSE;
+
+  while (!cancelled && (data = suscan_mq_read(&self->queue, &type)) != NULL) {
+    SU_TRYCATCH(
+      suscli_analyzer_client_tx_thread_batch_add(self, type, data),
+      goto done);
+
+    /* Coalesce whatever else is already waiting in the queue */
+    while (self->batch_count < SUSCLI_ANALYZER_CLIENT_TX_BATCH_MAX
+      && self->batch_size < SUSCLI_ANALYZER_CLIENT_TX_BATCH_MAX_SIZE
+      && suscan_mq_poll(&self->queue, &type, &data)) {
+      /* Soft cancel: send what came before it, and leave */
+      if (data == NULL) {
+        cancelled = SU_TRUE;
+        break;
       }
+
+      SU_TRYCATCH(
+        suscli_analyzer_client_tx_thread_batch_add(self, type, data),
+        goto done);
     }
 
-    suscli_analyzer_client_tx_thread_dispose_buffer(self, buffer);
-    buffer = NULL;
+    SU_TRYCATCH(suscli_analyzer_client_tx_thread_batch_flush(self), goto done);
   }
 
 done:
-  if (buffer != NULL) {
-    grow_buf_finalize(buffer);
-    free(buffer);
-  }
+  suscli_analyzer_client_tx_thread_batch_clear(self);
 
   self->thread_finished = SU_TRUE;
 
@@ -267,15 +664,11 @@ suscli_analyzer_client_tx_thread_cancel_soft(
 SUPRIVATE void
 suscli_analyzer_client_tx_consume_buffer_mq(struct suscan_mq *mq)
 {
-  grow_buf_t *buffer;
+  uint32_t type;
+  void *data;
 
-  while (suscan_mq_poll(mq, NULL, (void **) &buffer)) {
-    /* Null messages are used to notify special conditions */
-    if (buffer != NULL) {
-      grow_buf_finalize(buffer);
-      free(buffer);
-    }
-  }
+  while (suscan_mq_poll(mq, &type, &data))
+    suscli_analyzer_client_tx_release(type, data);
 }
 
 void
@@ -310,6 +703,8 @@ void
 suscli_analyzer_client_tx_thread_finalize(
     struct suscli_analyzer_client_tx_thread *self)
 {
+  unsigned int i;
+
   suscli_analyzer_client_tx_thread_stop(self);
 
   if (self->pool_initialized)
@@ -322,6 +717,95 @@ suscli_analyzer_client_tx_thread_finalize(
     close(self->cancel_pipefd[0]);
     close(self->cancel_pipefd[1]);
   }
+
+  for (i = 0; i < SUSCLI_ANALYZER_CLIENT_TX_BATCH_MAX; ++i)
+    grow_buf_finalize(&self->batch[i].compressed);
+
+  grow_buf_finalize(&self->flat);
+
+  suscan_remote_compressor_finalize(&self->compressor);
+
+  if (self->compression_mutex_initialized)
+    pthread_mutex_destroy(&self->compression_mutex);
+
+  if (self->resync_mutex_initialized)
+    pthread_mutex_destroy(&self->resync_mutex);
+}
+
+SUBOOL
+suscli_analyzer_client_tx_thread_set_compression(
+    struct suscli_analyzer_client_tx_thread *self,
+    const struct suscan_remote_compression_params *params)
+{
+  SU_TRYCATCH(suscan_remote_compression_params_is_valid(params), return SU_FALSE);
+
+  SU_TRYCATCH(
+    pthread_mutex_lock(&self->compression_mutex) == 0,
+    return SU_FALSE);
+  self->compression = *params;
+  (void) pthread_mutex_unlock(&self->compression_mutex);
+
+  return SU_TRUE;
+}
+
+void
+suscli_analyzer_client_tx_thread_get_compression(
+    struct suscli_analyzer_client_tx_thread *self,
+    struct suscan_remote_compression_params *params)
+{
+  (void) pthread_mutex_lock(&self->compression_mutex);
+  *params = self->compression;
+  (void) pthread_mutex_unlock(&self->compression_mutex);
+}
+
+/* Returns whether PSDs were discarded since the last call, and clears it */
+SUBOOL
+suscli_analyzer_client_tx_thread_take_psd_resync(
+    struct suscli_analyzer_client_tx_thread *self)
+{
+  SUBOOL resync;
+
+  if (!self->resync_mutex_initialized)
+    return SU_FALSE;
+
+  (void) pthread_mutex_lock(&self->resync_mutex);
+  resync = self->psd_resync;
+  self->psd_resync = SU_FALSE;
+  (void) pthread_mutex_unlock(&self->resync_mutex);
+
+  return resync;
+}
+
+/* Same, for panorama updates */
+SUBOOL
+suscli_analyzer_client_tx_thread_take_panorama_resync(
+    struct suscli_analyzer_client_tx_thread *self)
+{
+  SUBOOL resync;
+
+  if (!self->resync_mutex_initialized)
+    return SU_FALSE;
+
+  (void) pthread_mutex_lock(&self->resync_mutex);
+  resync = self->panorama_resync;
+  self->panorama_resync = SU_FALSE;
+  (void) pthread_mutex_unlock(&self->resync_mutex);
+
+  return resync;
+}
+
+void
+suscli_analyzer_client_tx_thread_get_compression_stats(
+    struct suscli_analyzer_client_tx_thread *self,
+    struct suscan_remote_compressor_stats *stats)
+{
+  memset(stats, 0, sizeof(struct suscan_remote_compressor_stats));
+
+  if (self->compression_mutex_initialized) {
+    (void) pthread_mutex_lock(&self->compression_mutex);
+    *stats = self->compression_stats;
+    (void) pthread_mutex_unlock(&self->compression_mutex);
+  }
 }
 
 SUBOOL
@@ -381,11 +865,27 @@ done:
   return ok;
 }
 
+SUBOOL
+suscli_analyzer_client_tx_thread_push_shared(
+    struct suscli_analyzer_client_tx_thread *self,
+    suscli_analyzer_shared_pdu_t *pdu)
+{
+  SU_REF(pdu, tx_queue);
+
+  if (!suscan_mq_write(&self->queue, SUSCLI_ANALYZER_CLIENT_TX_SHARED, pdu)) {
+    SU_DEREF(pdu, tx_queue);
+    return SU_FALSE;
+  }
+
+  return SU_TRUE;
+}
+
 /* Cleanup callbacks */
 struct suscli_analyzer_client_tx_thread_cleanup_ctx
 {
   struct suscan_mq *mq;
-  grow_buf_t       *head_source_info;
+  void             *head_source_info;
+  uint32_t          head_source_info_type;
   SUBOOL            critical_reached;
   unsigned int      discarded;
 };
@@ -437,15 +937,16 @@ fail:
 SUPRIVATE void
 suscli_analyzer_client_tx_thread_cleanup_ctx_save_source_info(
   struct suscli_analyzer_client_tx_thread_cleanup_ctx *ctx,
-  grow_buf_t *buffer)
+  uint32_t type,
+  void *data)
 {
   /* These are the first source info messages */
-  if (ctx->head_source_info != NULL) {
-    grow_buf_finalize(ctx->head_source_info);
-    free(ctx->head_source_info);
-  }
+  suscli_analyzer_client_tx_release(
+    ctx->head_source_info_type,
+    ctx->head_source_info);
 
-  ctx->head_source_info = buffer;
+  ctx->head_source_info      = data;
+  ctx->head_source_info_type = type;
 }
 
 SUPRIVATE SUBOOL
@@ -455,75 +956,66 @@ suscli_analyzer_client_tx_thread_try_destroy(
   uint32_t type,
   void *data)
 {
+  struct suscli_analyzer_client_tx_thread *self = mq_user;
   struct suscli_analyzer_client_tx_thread_cleanup_ctx *ctx = cu_user;
-  struct suscan_analyzer_remote_call call;
-  uint32_t msg_type, msg_kind;
-  grow_buf_t *buffer;
+  const suscli_analyzer_shared_pdu_t *shared;
+  enum suscli_analyzer_pdu_class pdu_class;
 
-  suscan_analyzer_remote_call_init(&call, SUSCAN_ANALYZER_REMOTE_NONE);
+  switch (type) {
+    case SUSCLI_ANALYZER_CLIENT_TX_MESSAGE:
+      pdu_class = suscli_analyzer_pdu_classify(data);
+      break;
 
-  if (type == SUSCLI_ANALYZER_CLIENT_TX_MESSAGE) {
-    buffer = data;
+    case SUSCLI_ANALYZER_CLIENT_TX_SHARED:
+      shared = data;
+      pdu_class = shared->pdu_class;
+      break;
 
-    /* Rewind */
-    grow_buf_seek(buffer, 0, SEEK_SET);
-    
-    SU_TRY(suscan_analyzer_remote_call_deserialize_partial(&call, buffer));
-
-    if (call.type == SUSCAN_ANALYZER_REMOTE_MESSAGE) {
-      SU_TRY(
-        suscan_analyzer_msg_deserialize_partial(
-          &msg_type,
-          buffer));
-      
-      switch (msg_type) {
-        case SUSCAN_ANALYZER_MESSAGE_TYPE_SOURCE_INFO:
-          if (!ctx->critical_reached) {
-            suscli_analyzer_client_tx_thread_cleanup_ctx_save_source_info(
-              ctx,
-              buffer);
-            ++ctx->discarded;
-            return SU_TRUE;
-          }
-          break;
-
-        /*
-         * TODO: Maybe keep looped messages?
-         */
-        case SUSCAN_ANALYZER_MESSAGE_TYPE_PSD:
-          grow_buf_finalize(buffer);
-          free(buffer);
-          ++ctx->discarded;
-          return SU_TRUE;
-
-        case SUSCAN_ANALYZER_MESSAGE_TYPE_INSPECTOR:
-          /* Deserialize inspector message kind */
-          SU_TRYZ(cbor_unpack_uint32(buffer, &msg_kind));
-
-          /* Spectrum message. Discard */
-          if (msg_kind == SUSCAN_ANALYZER_INSPECTOR_MSGKIND_SPECTRUM) {
-            grow_buf_finalize(buffer);
-            free(buffer);
-            ++ctx->discarded;
-            return SU_TRUE;
-          }
-
-          /* Other message. Assume critical */
-          ctx->critical_reached = SU_TRUE;
-          break;
-        
-        default:
-          /* Other message. Assume critical */
-          ctx->critical_reached = SU_TRUE;
-          break;
+    default:
+      return SU_FALSE;
+  }
+
+  switch (pdu_class) {
+    case SUSCLI_ANALYZER_PDU_CLASS_SOURCE_INFO:
+      if (!ctx->critical_reached) {
+        suscli_analyzer_client_tx_thread_cleanup_ctx_save_source_info(
+          ctx,
+          type,
+          data);
+        ++ctx->discarded;
+        return SU_TRUE;
       }
-    } else {
-      /* Not an analyzer message. Assume critical */
+      break;
+
+    /*
+     * TODO: Maybe keep looped messages?
+     *
+     * PSD deltas built on the discarded frames are useless, so ask for
+     * keyframes too. Panorama keyframes are requested to the analyzer
+     * by the server (see suscli_analyzer_server_resync_panorama_unsafe).
+     */
+    case SUSCLI_ANALYZER_PDU_CLASS_PSD:
+    case SUSCLI_ANALYZER_PDU_CLASS_PANORAMA:
+    case SUSCLI_ANALYZER_PDU_CLASS_DISCARDABLE:
+      if (pdu_class != SUSCLI_ANALYZER_PDU_CLASS_DISCARDABLE) {
+        (void) pthread_mutex_lock(&self->resync_mutex);
+        if (pdu_class == SUSCLI_ANALYZER_PDU_CLASS_PSD)
+          self->psd_resync = SU_TRUE;
+        else
+          self->panorama_resync = SU_TRUE;
+        (void) pthread_mutex_unlock(&self->resync_mutex);
+      }
+
+      suscli_analyzer_client_tx_release(type, data);
+      ++ctx->discarded;
+      return SU_TRUE;
+
+    default:
+      /* Other message. Assume critical */
       ctx->critical_reached = SU_TRUE;
-    }
+      break;
   }
 
-done:
   return SU_FALSE;
 }
 
@@ -538,7 +1030,7 @@ suscli_analyzer_client_tx_thread_post_cleanup(
     /* Give ownership away */
     suscan_mq_write_urgent_unsafe(
       ctx->mq,
-      SUSCLI_ANALYZER_CLIENT_TX_MESSAGE,
+      ctx->head_source_info_type,
       ctx->head_source_info);
   }
 
@@ -554,11 +1046,12 @@ SUBOOL
 suscli_analyzer_client_tx_thread_initialize(
     struct suscli_analyzer_client_tx_thread *self,
     int fd,
-    unsigned int compress_threshold)
+    unsigned int compress_threshold,
+    const struct suscan_remote_compression_params *compression)
 {
   struct suscan_mq_callbacks callbacks = 
   {
-    NULL,
+    self,
     suscli_analyzer_client_tx_thread_pre_cleanup,
     suscli_analyzer_client_tx_thread_try_destroy,
     suscli_analyzer_client_tx_thread_post_cleanup
@@ -571,6 +1064,21 @@ suscli_analyzer_client_tx_thread_initialize(
   self->cancel_pipefd[0] = self->cancel_pipefd[1] = -1;
   self->fd = fd;
   self->compress_threshold = compress_threshold;
+  self->compression = *compression;
+
+  SU_TRYCATCH(
+    suscan_remote_compressor_init(&self->compressor, compression),
+    goto done);
+
+  SU_TRYCATCH(
+    pthread_mutex_init(&self->compression_mutex, NULL) == 0,
+    goto done);
+  self->compression_mutex_initialized = SU_TRUE;
+
+  SU_TRYCATCH(
+    pthread_mutex_init(&self->resync_mutex, NULL) == 0,
+    goto done);
+  self->resync_mutex_initialized = SU_TRUE;
 
   SU_TRYCATCH(suscan_mq_init(&self->pool), goto done);
   self->pool_initialized = SU_TRUE;
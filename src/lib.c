@@ -19,6 +19,7 @@
 
 #include <pthread.h>
 #include <string.h>
+#include <time.h>
 #include <sigutils/sigutils.h>
 #include <confdb.h>
 
@@ -27,6 +28,7 @@
 
 #define SUSCAN_MAX_MESSAGES 1024
 #define SUSCAN_WISDOM_FILE_NAME "wisdom.dat"
+#define SUSCAN_WISDOM_SYNC_INTERVAL 30 /* In seconds */
 
 struct suscan_message {
   enum sigutils_log_severity severity;
@@ -40,6 +42,12 @@ SUPRIVATE struct suscan_message *message_ring[SUSCAN_MAX_MESSAGES];
 SUPRIVATE unsigned int message_ptr;
 SUPRIVATE unsigned int message_count;
 
+SUPRIVATE pthread_once_t  g_fftw_once = PTHREAD_ONCE_INIT;
+SUPRIVATE pthread_mutex_t g_fftw_mutex;
+SUPRIVATE SUBOOL g_wisdom_enabled;
+SUPRIVATE SUBOOL g_wisdom_dirty;
+SUPRIVATE time_t g_wisdom_last_sync;
+
 SUPRIVATE xyz_t  g_qth;
 SUPRIVATE SUBOOL g_have_qth;
 SUPRIVATE SUBOOL g_qth_tested;
@@ -248,10 +256,120 @@ fail:
   return NULL;
 }
 
+/*
+ * FFTW's planner (plan creation and destruction, wisdom import and export)
+ * is not thread-safe, and FFT plans are created from many threads during
+ * the lifetime of an analyzer, mostly inside sigutils objects. FFTW lets
+ * us install hooks around every planner call: we use them to serialize
+ * all planning in the process with a single (recursive) mutex, which is
+ * also held while wisdom is saved.
+ */
+SUPRIVATE void
+suscan_fftw_mutex_init(void)
+{
+  pthread_mutexattr_t attr;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&g_fftw_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+SUPRIVATE void
+suscan_fftw_before_planner(void)
+{
+  pthread_mutex_lock(&g_fftw_mutex);
+}
+
+SUPRIVATE void
+suscan_fftw_after_planner(void)
+{
+  /* New plans may have produced new wisdom */
+  g_wisdom_dirty = SU_TRUE;
+  pthread_mutex_unlock(&g_fftw_mutex);
+}
+
+SUPRIVATE SUBOOL
+suscan_sync_fft_wisdom_unsafe(SUBOOL force)
+{
+  time_t now = time(NULL);
+  SUBOOL ok = SU_TRUE;
+
+  if (!g_wisdom_enabled || !g_wisdom_dirty)
+    return SU_TRUE;
+
+  if (!force && now - g_wisdom_last_sync < SUSCAN_WISDOM_SYNC_INTERVAL)
+    return SU_TRUE;
+
+  if ((ok = su_lib_save_wisdom())) {
+    g_wisdom_last_sync = now;
+    g_wisdom_dirty     = SU_FALSE;
+  }
+
+  return ok;
+}
+
+/*
+ * Saves FFT wisdom if new plans were created since the last save. Unless
+ * forced, this happens at most once per SUSCAN_WISDOM_SYNC_INTERVAL, so
+ * long-running processes can call it periodically.
+ */
+SUBOOL
+suscan_sync_fft_wisdom(SUBOOL force)
+{
+  SUBOOL ok;
+
+  pthread_once(&g_fftw_once, suscan_fftw_mutex_init);
+
+  pthread_mutex_lock(&g_fftw_mutex);
+  ok = suscan_sync_fft_wisdom_unsafe(force);
+  pthread_mutex_unlock(&g_fftw_mutex);
+
+  return ok;
+}
+
+/*
+ * Plans created in this tree (outside sigutils objects) go through these.
+ * As wisdom is persisted, they can afford FFTW_MEASURE: the planning cost
+ * is only paid the first time a size is seen.
+ */
+SU_FFTW(_plan)
+suscan_fft_plan_dft_1d(
+    int size,
+    SU_FFTW(_complex) *in,
+    SU_FFTW(_complex) *out,
+    int sign)
+{
+  SU_FFTW(_plan) plan;
+
+  pthread_once(&g_fftw_once, suscan_fftw_mutex_init);
+
+  pthread_mutex_lock(&g_fftw_mutex);
+  plan = SU_FFTW(_plan_dft_1d) (
+      size,
+      in,
+      out,
+      sign,
+      g_wisdom_enabled ? FFTW_MEASURE : FFTW_ESTIMATE);
+  pthread_mutex_unlock(&g_fftw_mutex);
+
+  return plan;
+}
+
+void
+suscan_fft_destroy_plan(SU_FFTW(_plan) plan)
+{
+  pthread_once(&g_fftw_once, suscan_fftw_mutex_init);
+
+  pthread_mutex_lock(&g_fftw_mutex);
+  SU_FFTW(_destroy_plan) (plan);
+  pthread_mutex_unlock(&g_fftw_mutex);
+}
+
 SUPRIVATE void
 suscan_atexit_handler(void)
 {
-  if (!su_lib_save_wisdom()) {
+  if (!suscan_sync_fft_wisdom(SU_TRUE)) {
     fprintf(stderr, "suscan: failed to save FFT wisdom, next run may be slow.\n");
   }
 }
@@ -297,8 +415,17 @@ suscan_sigutils_init(enum suscan_mode mode)
   SU_TRY(userpath = suscan_confdb_get_user_path());
   SU_TRY(wisdom_file = strbuild("%s/" SUSCAN_WISDOM_FILE_NAME, userpath));
 
-  SU_TRY(su_lib_set_wisdom_file(wisdom_file));
-  SU_TRY(su_lib_set_wisdom_enabled(SU_TRUE));
+  pthread_once(&g_fftw_once, suscan_fftw_mutex_init);
+  SU_FFTW(_set_planner_hooks) (
+    suscan_fftw_before_planner,
+    suscan_fftw_after_planner);
+
+  pthread_mutex_lock(&g_fftw_mutex);
+  g_wisdom_enabled = su_lib_set_wisdom_file(wisdom_file)
+    && su_lib_set_wisdom_enabled(SU_TRUE);
+  pthread_mutex_unlock(&g_fftw_mutex);
+
+  SU_TRY(g_wisdom_enabled);
 
   /* Save FFT wisdom on exit */
   atexit(suscan_atexit_handler);
@@ -58,6 +58,17 @@ char *suscan_log_get_last_messages(struct timeval since, unsigned int max);
 
 SUBOOL suscan_sigutils_init(enum suscan_mode mode);
 
+/* Saves FFT wisdom (rate-limited unless forced) if there is new wisdom */
+SUBOOL suscan_sync_fft_wisdom(SUBOOL force);
+
+/* Serialized FFTW planning. FFTW_MEASURE is used if wisdom is enabled */
+SU_FFTW(_plan) suscan_fft_plan_dft_1d(
+    int size,
+    SU_FFTW(_complex) *in,
+    SU_FFTW(_complex) *out,
+    int sign);
+void suscan_fft_destroy_plan(SU_FFTW(_plan) plan);
+
 SUBOOL suscan_get_qth(xyz_t *geo);
 void   suscan_set_qth(const xyz_t *geo);
 
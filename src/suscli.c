@@ -25,9 +25,6 @@
 #include <cli/cli.h>
 #include <analyzer/version.h>
 #include <analyzer/device/facade.h>
-#ifdef __unix__
-#  include <signal.h>
-#endif /* __unix__ */
 
 
 SUPRIVATE SUBOOL
@@ -73,14 +70,6 @@ help(const char *a0)
         "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n");
 }
 
-#ifdef __unix__
-void
-suscli_sigint_handler(int sig)
-{
-  exit(1);
-}
-#endif /* __unix__ */
-
 int
 main(int argc, const char *argv[], char *envp[])
 {
@@ -102,10 +91,10 @@ main(int argc, const char *argv[], char *envp[])
     goto done;
   }
 
-#ifdef __unix__
-  signal(SIGINT, suscli_sigint_handler);
-#endif /* __unix__ */
-
+  /*
+   * SIGINT and SIGTERM keep their default disposition: only commands
+   * that poll suscli_halt_requested() install a handler for them.
+   */
   if (suscli_run_command(argv[1], &argv[2]))
     ret = EXIT_SUCCESS;
 
@@ -180,6 +180,18 @@ cbor_alloc_blob(grow_buf_t *buffer, size_t size)
   return grow_buf_append_hollow(buffer, size);
 }
 
+int
+cbor_pack_blob_start(grow_buf_t *buffer, size_t size)
+{
+  return pack_cbor_type(buffer, CMT_BYTE, size);
+}
+
+int
+cbor_pack_tag(grow_buf_t *buffer, uint64_t tag)
+{
+  return pack_cbor_type(buffer, CMT_TAG, tag);
+}
+
 int
 cbor_pack_cstr_len(grow_buf_t *buffer, const char *str, size_t len)
 {
@@ -481,6 +493,25 @@ cbor_unpack_uint(grow_buf_t *buffer, uint64_t *v)
   return sync_buffers(buffer, &tmp);
 }
 
+int
+cbor_unpack_tag(grow_buf_t *buffer, uint64_t *tag)
+{
+  grow_buf_t tmp;
+  int ret;
+
+  grow_buf_init_loan(
+      &tmp,
+      grow_buf_current_data(buffer),
+      grow_buf_avail(buffer),
+      grow_buf_avail(buffer));
+
+  ret = unpack_cbor_int(&tmp, CMT_TAG, tag);
+  if (ret)
+    return ret;
+
+  return sync_buffers(buffer, &tmp);
+}
+
 int
 cbor_unpack_nint(grow_buf_t *buffer, uint64_t *v)
 {
@@ -620,6 +651,35 @@ cbor_unpack_blob(grow_buf_t *buffer, void **data, size_t *size)
   return sync_buffers(buffer, &tmp);
 }
 
+int
+cbor_unpack_blob_ref(grow_buf_t *buffer, const void **data, size_t *size)
+{
+  uint64_t parsed_len;
+  grow_buf_t tmp;
+  ssize_t ret;
+
+  grow_buf_init_loan(
+      &tmp,
+      grow_buf_current_data(buffer),
+      grow_buf_avail(buffer),
+      grow_buf_avail(buffer));
+
+  ret = unpack_cbor_int(&tmp, CMT_BYTE, &parsed_len);
+  if (ret)
+    return ret;
+
+  if (parsed_len >= SIZE_MAX)
+    return -EOVERFLOW;
+
+  if (parsed_len > grow_buf_avail(&tmp))
+    return -EILSEQ;
+
+  *size = parsed_len;
+  *data = parsed_len > 0 ? grow_buf_current_data(&tmp) : NULL;
+  grow_buf_seek(&tmp, parsed_len, SEEK_CUR);
+  return sync_buffers(buffer, &tmp);
+}
+
 int
 cbor_unpack_cstr_len(grow_buf_t *buffer, char **str, size_t *len)
 {
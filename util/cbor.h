@@ -47,6 +47,10 @@ extern "C" {
 
 #define CBOR_MEM_REUSE_SIZE_LIMIT (1 << 20)
 
+/* Typed array tags (RFC 8746) */
+#define CBOR_TAG_FLOAT32_LE 85
+#define CBOR_TAG_FLOAT64_LE 86
+
 enum cbor_major_type {
   CMT_UINT  = 0,
   CMT_NINT  = 1,
@@ -211,6 +215,10 @@ int cbor_pack_nint(grow_buf_t *buffer, uint64_t v);
 int cbor_pack_int(grow_buf_t *buffer, int64_t v);
 int cbor_pack_blob(grow_buf_t *buffer, const void *data, size_t size);
 void *cbor_alloc_blob(grow_buf_t *buffer, size_t size);
+
+/* Packs the header of a blob whose contents are appended separately */
+int cbor_pack_blob_start(grow_buf_t *buffer, size_t size);
+int cbor_pack_tag(grow_buf_t *buffer, uint64_t tag);
 int cbor_pack_cstr_len(grow_buf_t *buffer, const char *str, size_t len);
 int cbor_pack_str(grow_buf_t *buffer, const char *str);
 int cbor_pack_bool(grow_buf_t *buffer, SUBOOL b);
@@ -240,7 +248,11 @@ int cbor_peek_type(
 int cbor_unpack_uint(grow_buf_t *buffer, uint64_t *v);
 int cbor_unpack_nint(grow_buf_t *buffer, uint64_t *v);
 int cbor_unpack_int(grow_buf_t *buffer, int64_t *v);
+int cbor_unpack_tag(grow_buf_t *buffer, uint64_t *tag);
 int cbor_unpack_blob(grow_buf_t *buffer, void **data, size_t *size);
+
+/* Like the above, but data points to the blob inside the buffer */
+int cbor_unpack_blob_ref(grow_buf_t *buffer, const void **data, size_t *size);
 int cbor_unpack_cstr_len(grow_buf_t *buffer, char **str,
         size_t *len);
 int cbor_unpack_str(grow_buf_t *buffer, char **str);
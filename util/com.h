@@ -136,14 +136,17 @@ suscan_refcount_inc(suscan_refcount_t *ref)
 SUINLINE SUBOOL
 suscan_refcount_dec(suscan_refcount_t *ref)
 {
+  unsigned int counter;
+
   if (pthread_mutex_lock(&ref->mutex) != 0)
     return SU_FALSE;
   
-  --ref->counter;
+  /* Read under the lock, or concurrent decrements may both destroy */
+  counter = --ref->counter;
   
   pthread_mutex_unlock(&ref->mutex);
 
-  if (ref->counter == 0) {
+  if (counter == 0) {
 #ifdef SUSCAN_REFCOUNT_DEBUG
     fprintf(stderr, "%p: destructor called\n", ref->owner);
 #endif /* SUSCAN_RECOUNT_DEBUG */